@@ -0,0 +1,166 @@
+// Times NAM, the generic SIMD engines and the specialised engines on every specialised
+// architecture, using random weights (speed doesn't depend on the values).
+//
+//   NeuralAmpBenchmark [block size] [seconds of audio]
+#include <simd_engines.h>
+#include <specialised_engines.h>
+#include <NAM/get_dsp.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+#include <json.hpp>
+
+namespace {
+constexpr double sampleRate = 48000.0;
+
+struct Preset {
+  SpecialisedArchitecture architecture;
+  nlohmann::json model;
+};
+
+std::vector<float> randomWeights(size_t count) {
+  std::mt19937 rng(1);
+  std::normal_distribution<float> distribution(0.0f, 0.3f);
+  std::vector<float> weights(count);
+  for (auto& weight : weights)
+    weight = distribution(rng);
+  return weights;
+}
+
+nlohmann::json makeLstm(int numLayers, int hiddenSize) {
+  size_t count = static_cast<size_t>(hiddenSize + 1);
+  for (int i = 0; i < numLayers; ++i) {
+    const int inputSize = i == 0 ? 1 : hiddenSize;
+    count += static_cast<size_t>(4 * hiddenSize * (inputSize + hiddenSize) + 6 * hiddenSize);
+  }
+  return {{"version", "0.5.4"},
+          {"architecture", "LSTM"},
+          {"config", {{"num_layers", numLayers}, {"input_size", 1}, {"hidden_size", hiddenSize}}},
+          {"weights", randomWeights(count)},
+          {"sample_rate", sampleRate}};
+}
+
+// Two Tanh arrays as the trainer builds them: (channels, head size, dilations) each
+nlohmann::json makeWaveNet(int channels,
+                           const std::vector<int>& firstDilations,
+                           const std::vector<int>& secondDilations) {
+  nlohmann::json layers = nlohmann::json::array();
+  size_t count = 1;  // head_scale
+  int inputSize = 1;
+  for (const auto& dilations : {firstDilations, secondDilations}) {
+    const int headSize = inputSize == 1 ? channels / 2 : 1;
+    layers.push_back({{"input_size", inputSize},
+                      {"condition_size", 1},
+                      {"head_size", headSize},
+                      {"channels", channels},
+                      {"kernel_size", 3},
+                      {"dilations", dilations},
+                      {"activation", "Tanh"},
+                      {"gated", false},
+                      {"head_bias", headSize == 1}});
+    count += static_cast<size_t>(channels * inputSize);
+    count += dilations.size() * static_cast<size_t>(4 * channels * channels + 3 * channels);
+    count += static_cast<size_t>(headSize * channels + (headSize == 1 ? 1 : 0));
+    inputSize = channels;
+    channels = headSize == 1 ? channels : channels / 2;
+  }
+  return {{"version", "0.5.4"},
+          {"architecture", "WaveNet"},
+          {"config", {{"layers", layers}, {"head", nullptr}, {"head_scale", 0.02}}},
+          {"weights", randomWeights(count)},
+          {"sample_rate", sampleRate}};
+}
+
+std::vector<Preset> makePresets() {
+  const std::vector<int> standard{1, 2, 4, 8, 16, 32, 64, 128, 256, 512};
+  const std::vector<int> liteFirst{1, 2, 4, 8, 16, 32, 64};
+  const std::vector<int> liteSecond{128, 256, 512, 1, 2, 4, 8, 16, 32, 64, 128, 256, 512};
+  return {{SpecialisedArchitecture::wavenetStandard, makeWaveNet(16, standard, standard)},
+          {SpecialisedArchitecture::wavenetLite, makeWaveNet(12, liteFirst, liteSecond)},
+          {SpecialisedArchitecture::wavenetFeather, makeWaveNet(8, liteFirst, liteSecond)},
+          {SpecialisedArchitecture::wavenetNano, makeWaveNet(4, liteFirst, liteSecond)},
+          {SpecialisedArchitecture::lstm1x8, makeLstm(1, 8)},
+          {SpecialisedArchitecture::lstm1x12, makeLstm(1, 12)},
+          {SpecialisedArchitecture::lstm1x16, makeLstm(1, 16)},
+          {SpecialisedArchitecture::lstm1x24, makeLstm(1, 24)},
+          {SpecialisedArchitecture::lstm1x32, makeLstm(1, 32)},
+          {SpecialisedArchitecture::lstm2x8, makeLstm(2, 8)},
+          {SpecialisedArchitecture::lstm2x16, makeLstm(2, 16)}};
+}
+
+// Multiples of real time: seconds of audio processed per second of wall clock
+double measureRealTimeFactor(nam::DSP& model, int blockSize, double seconds) {
+  std::mt19937 rng(2);
+  std::uniform_real_distribution<double> distribution(-0.5, 0.5);
+  std::vector<NAM_SAMPLE> input(static_cast<size_t>(blockSize));
+  std::vector<NAM_SAMPLE> output(input.size());
+  for (auto& sample : input)
+    sample = distribution(rng);
+
+  // One second of warm-up so caches and branch predictors settle
+  const int warmUpBlocks = static_cast<int>(sampleRate) / blockSize;
+  for (int i = 0; i < warmUpBlocks; ++i)
+    model.process(input.data(), output.data(), blockSize);
+
+  const int blocks = static_cast<int>(seconds * sampleRate) / blockSize;
+  const auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < blocks; ++i)
+    model.process(input.data(), output.data(), blockSize);
+  const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+  return static_cast<double>(blocks) * blockSize / sampleRate / elapsed.count();
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+  const int blockSize = argc > 1 ? std::atoi(argv[1]) : 64;
+  const double seconds = argc > 2 ? std::atof(argv[2]) : 10.0;
+  if (blockSize <= 0 || seconds <= 0.0) {
+    std::fprintf(stderr, "Usage: %s [block size] [seconds of audio]\n", argv[0]);
+    return 1;
+  }
+
+  std::printf("Kernels: %s, block size %d, %.0f s of audio per engine\n\n", getSimdKernels().name,
+              blockSize, seconds);
+  std::printf("%-18s %10s %10s %14s %10s %10s\n", "architecture", "nam (xRT)", "simd (xRT)",
+              "special (xRT)", "vs nam", "vs simd");
+
+  const auto path = std::filesystem::temp_directory_path() / "neuralamp_benchmark.nam";
+  int status = 0;
+  for (const auto& [architecture, model] : makePresets()) {
+    std::ofstream(path) << model.dump();
+
+    auto nam = nam::get_dsp(path);
+    nam->Reset(sampleRate, blockSize);
+    std::unique_ptr<nam::DSP> generic;
+    std::unique_ptr<nam::DSP> specialised;
+    if (const auto lstm = LstmWeights::fromNamFile(path)) {
+      generic = std::make_unique<LstmEngine>(*lstm, sampleRate);
+      if (findSpecialisedArchitecture(*lstm) == architecture)
+        specialised = makeSpecialisedModel(*lstm, sampleRate);
+    } else if (const auto wavenet = WaveNetWeights::fromNamFile(path)) {
+      generic = std::make_unique<WaveNetEngine>(*wavenet, sampleRate);
+      if (findSpecialisedArchitecture(*wavenet) == architecture)
+        specialised = makeSpecialisedModel(*wavenet, sampleRate);
+    }
+    if (!generic || !specialised) {
+      std::fprintf(stderr, "%s: generated model wasn't recognised\n",
+                   getArchitectureName(architecture));
+      status = 1;
+      continue;
+    }
+
+    const double namSpeed = measureRealTimeFactor(*nam, blockSize, seconds);
+    const double genericSpeed = measureRealTimeFactor(*generic, blockSize, seconds);
+    const double specialisedSpeed = measureRealTimeFactor(*specialised, blockSize, seconds);
+    std::printf("%-18s %10.1f %10.1f %14.1f %9.2fx %9.2fx\n", getArchitectureName(architecture),
+                namSpeed, genericSpeed, specialisedSpeed, specialisedSpeed / namSpeed,
+                specialisedSpeed / genericSpeed);
+  }
+  std::filesystem::remove(path);
+  return status;
+}
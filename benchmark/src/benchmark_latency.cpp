@@ -0,0 +1,165 @@
+// What live monitoring trades for its latency. For the standard and live monitoring modes this
+// reports the latency the plugin gives the host, when the cabinet is first heard (the IR's own
+// onset, which minimum-phase conversion removes) and the cost of a block with a cab IR loaded.
+// The IR is synthetic: a decaying noise burst behind a millisecond of mic distance.
+//
+//   NeuralAmpLatencyBenchmark [block size] [IR length (ms)]
+#include <processor.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace {
+using Clock = std::chrono::steady_clock;
+
+constexpr double sampleRate = 48000.0;
+constexpr double micDistanceMs = 1.0;
+constexpr double measureSeconds = 5.0;
+constexpr int loadTimeoutMs = 10000;
+
+juce::AudioBuffer<float> makeImpulse(double lengthMs) {
+  const int delay = juce::roundToInt(micDistanceMs * 0.001 * sampleRate);
+  const int length = juce::jmax(delay + 1, juce::roundToInt(lengthMs * 0.001 * sampleRate));
+  juce::AudioBuffer<float> ir(1, length);
+  ir.clear();
+  std::mt19937 rng(1);
+  std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+  const double decaySamples = 0.01 * sampleRate;
+  for (int i = delay; i < length; ++i)
+    ir.setSample(0, i, unit(rng) * static_cast<float>(std::exp(-(i - delay) / decaySamples)));
+  return ir;
+}
+
+bool writeWav(const juce::File& file, const juce::AudioBuffer<float>& ir) {
+  file.deleteFile();
+  auto stream = file.createOutputStream();
+  if (stream == nullptr)
+    return false;
+  juce::WavAudioFormat format;
+  std::unique_ptr<juce::AudioFormatWriter> writer(
+      format.createWriterFor(stream.get(), sampleRate, 1, 24, {}, 0));
+  if (writer == nullptr)
+    return false;
+  stream.release();  // Owned by the writer
+  return writer->writeFromAudioSampleBuffer(ir, 0, ir.getNumSamples());
+}
+
+// Samples until an impulse through the convolver first reaches -40 dB of its peak
+int measureOnset(const juce::AudioBuffer<float>& ir, bool minimumPhase, int blockSize) {
+  DualIrConvolver convolver;
+  convolver.setMinimumPhase(minimumPhase);
+  convolver.loadIr(DualIrConvolver::slotA, ir, sampleRate, true);
+  convolver.prepare(sampleRate, blockSize, 1);
+
+  std::vector<float> response;
+  juce::AudioBuffer<float> buffer(1, blockSize);
+  for (int start = 0; start < ir.getNumSamples() + blockSize; start += blockSize) {
+    buffer.clear();
+    if (start == 0)
+      buffer.setSample(0, 0, 1.0f);
+    juce::dsp::AudioBlock<float> block(buffer);
+    convolver.process(block);
+    response.insert(response.end(), buffer.getReadPointer(0),
+                    buffer.getReadPointer(0) + blockSize);
+  }
+  float peak = 0.0f;
+  for (const float sample : response)
+    peak = std::max(peak, std::abs(sample));
+  const auto onset = std::find_if(response.begin(), response.end(), [peak](float sample) {
+    return std::abs(sample) >= 0.01f * peak;
+  });
+  return static_cast<int>(onset - response.begin());
+}
+
+struct Result {
+  int latency = 0;
+  int onset = 0;
+  double meanMs = 0.0;
+  double peakMs = 0.0;
+};
+
+Result measure(bool liveMonitoring, const juce::File& irFile, const juce::AudioBuffer<float>& ir,
+               int blockSize) {
+  Result result;
+  result.onset = measureOnset(ir, liveMonitoring, blockSize);
+
+  NeuralAmpProcessor processor;
+  processor.getParameters().getParameter("liveMonitoring")->setValueNotifyingHost(
+      liveMonitoring ? 1.0f : 0.0f);
+  processor.setPlayConfigDetails(2, 2, sampleRate, blockSize);
+  processor.prepareToPlay(sampleRate, blockSize);
+  result.latency = processor.getLatencySamples();
+
+  // The loader applies the (empty) IR selection first; load only after it has
+  const auto deadline = juce::Time::getMillisecondCounter() + loadTimeoutMs;
+  while (processor.getCurrentIrIndex() != 0 && juce::Time::getMillisecondCounter() < deadline)
+    juce::Thread::sleep(1);
+
+  juce::AudioBuffer<float> buffer(2, blockSize);
+  juce::MidiBuffer midi;
+  processor.loadIrFile(irFile);
+  while (!processor.isIrActive() && juce::Time::getMillisecondCounter() < deadline) {
+    buffer.clear();
+    processor.processBlock(buffer, midi);
+    juce::Thread::sleep(1);
+  }
+  if (!processor.isIrActive()) {
+    std::fprintf(stderr, "The IR never became active\n");
+    std::exit(1);
+  }
+
+  std::mt19937 rng(2);
+  std::uniform_real_distribution<float> unit(-0.1f, 0.1f);
+  const int numBlocks = juce::roundToInt(measureSeconds * sampleRate / blockSize);
+  double total = 0.0;
+  for (int i = 0; i < numBlocks; ++i) {
+    for (int channel = 0; channel < 2; ++channel)
+      for (int sample = 0; sample < blockSize; ++sample)
+        buffer.setSample(channel, sample, unit(rng));
+    const auto start = Clock::now();
+    processor.processBlock(buffer, midi);
+    const double ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    total += ms;
+    result.peakMs = std::max(result.peakMs, ms);
+  }
+  result.meanMs = total / numBlocks;
+  return result;
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+  const int blockSize = argc > 1 ? std::atoi(argv[1]) : 64;
+  const double irMs = argc > 2 ? std::atof(argv[2]) : 200.0;
+  if (blockSize <= 0 || irMs <= 0.0) {
+    std::fprintf(stderr, "Usage: %s [block size] [IR length (ms)]\n", argv[0]);
+    return 1;
+  }
+
+  const auto ir = makeImpulse(irMs);
+  const auto irFile = juce::File::getSpecialLocation(juce::File::tempDirectory)
+                          .getChildFile("neuralamp_latency_benchmark.wav");
+  if (!writeWav(irFile, ir)) {
+    std::fprintf(stderr, "Couldn't write %s\n", irFile.getFullPathName().toRawUTF8());
+    return 1;
+  }
+
+  std::printf("%.0f Hz, block size %d, %.0f ms IR\n\n", sampleRate, blockSize, irMs);
+  std::printf("%-16s %10s %10s %10s %10s %8s\n", "mode", "latency", "onset", "block (ms)",
+              "peak (ms)", "xRT");
+  const double blockMs = 1000.0 * blockSize / sampleRate;
+  for (const bool liveMonitoring : {false, true}) {
+    const auto result = measure(liveMonitoring, irFile, ir, blockSize);
+    std::printf("%-16s %10d %10d %10.4f %10.4f %8.1f\n", liveMonitoring ? "live" : "standard",
+                result.latency, result.onset, result.meanMs, result.peakMs,
+                blockMs / result.meanMs);
+  }
+  std::printf("\nLatency and onset in samples; the sub-block FIFO is %s in this build\n",
+              SubBlockScheduler::defaultUseFifo ? "on" : "off");
+  irFile.deleteFile();
+  return 0;
+}
@@ -0,0 +1,97 @@
+// Times what a host waits for when it creates the plugin: construction, prepareToPlay() and the
+// first processBlock(), plus destruction, which DAW plugin scans pay for too. The first instance
+// is reported apart from the rest because it also pays for static initialisation, and so is the
+// background scan of the library folders that the first instance's loader thread starts.
+//
+//   NeuralAmpStartupBenchmark [instances] [block size]
+#include <processor.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+namespace {
+using Clock = std::chrono::steady_clock;
+
+constexpr double sampleRate = 48000.0;
+constexpr int scanTimeoutMs = 60000;
+
+double millisecondsSince(Clock::time_point start) {
+  return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+struct Timings {
+  std::vector<double> construct;
+  std::vector<double> prepare;
+  std::vector<double> firstBlock;
+  std::vector<double> destroy;
+};
+
+void printStage(const char* name, std::vector<double> times) {
+  const double first = times.front();
+  times.erase(times.begin());
+  if (times.empty()) {
+    std::printf("%-16s %10.3f\n", name, first);
+    return;
+  }
+  std::sort(times.begin(), times.end());
+  std::printf("%-16s %10.3f %10.3f %10.3f %10.3f\n", name, first, times[times.size() / 2],
+              times.front(), times.back());
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+  const int instances = argc > 1 ? std::atoi(argv[1]) : 20;
+  const int blockSize = argc > 2 ? std::atoi(argv[2]) : 128;
+  if (instances <= 0 || blockSize <= 0) {
+    std::fprintf(stderr, "Usage: %s [instances] [block size]\n", argv[0]);
+    return 1;
+  }
+
+  juce::AudioBuffer<float> buffer(2, blockSize);
+  juce::MidiBuffer midi;
+  Timings timings;
+  double scanMs = -1.0;
+  for (int i = 0; i < instances; ++i) {
+    auto start = Clock::now();
+    auto processor = std::make_unique<NeuralAmpProcessor>();
+    timings.construct.push_back(millisecondsSince(start));
+
+    const auto prepareStart = Clock::now();
+    start = prepareStart;
+    processor->setPlayConfigDetails(2, 2, sampleRate, blockSize);
+    processor->prepareToPlay(sampleRate, blockSize);
+    timings.prepare.push_back(millisecondsSince(start));
+
+    buffer.clear();
+    start = Clock::now();
+    processor->processBlock(buffer, midi);
+    timings.firstBlock.push_back(millisecondsSince(start));
+
+    // Measured from the first prepareToPlay(), which starts the loader thread
+    if (i == 0) {
+      while (NeuralAmpProcessor::getListingGeneration() == 0 &&
+             millisecondsSince(prepareStart) < scanTimeoutMs) {
+        juce::Thread::sleep(1);
+      }
+      scanMs = millisecondsSince(prepareStart);
+    }
+
+    start = Clock::now();
+    processor.reset();
+    timings.destroy.push_back(millisecondsSince(start));
+  }
+
+  std::printf("%d instance(s), %.0f Hz, block size %d\n\n", instances, sampleRate, blockSize);
+  std::printf("%-16s %10s %10s %10s %10s\n", "stage (ms)", "first", "median", "min", "max");
+  printStage("construct", timings.construct);
+  printStage("prepareToPlay", timings.prepare);
+  printStage("first block", timings.firstBlock);
+  printStage("destroy", timings.destroy);
+  std::printf("\nLibrary scan (background): %.1f ms, %d models, %d IRs\n", scanMs,
+              NeuralAmpProcessor::getModelListing()->names.size() - 1,
+              NeuralAmpProcessor::getIrListing()->names.size() - 1);
+  return 0;
+}
@@ -0,0 +1,62 @@
+// Times every model in the library the way the plugin will run it, at the device's sample rate and
+// block size, and records real-time factor and peak block time in the library index the plugin
+// reads. Models without headroom are flagged over budget: the UI warns about them, and builds with
+// NEURALAMP_REFUSE_OVER_BUDGET won't load them. Run it on the device with the audio engine
+// stopped, so nothing else competes for the CPU.
+//
+//   NeuralAmpLibraryProfiler [sample rate] [block size] [--force]
+//
+// Models already profiled at these settings are skipped unless --force. Exits with 2 if any model
+// is over budget.
+#include <processor.h>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+int main(int argc, char** argv) {
+  double sampleRate = 48000.0;
+  int blockSize = 64;
+  bool force = false;
+  int position = 0;
+  for (int i = 1; i < argc; ++i) {
+    if (std::strcmp(argv[i], "--force") == 0)
+      force = true;
+    else if (position++ == 0)
+      sampleRate = std::atof(argv[i]);
+    else
+      blockSize = std::atoi(argv[i]);
+  }
+  if (sampleRate <= 0.0 || blockSize <= 0) {
+    std::fprintf(stderr, "Usage: %s [sample rate] [block size] [--force]\n", argv[0]);
+    return 1;
+  }
+
+  // The processor's loader scans the library and loads the index, then has a worker profile it
+  NeuralAmpProcessor processor;
+  processor.setPlayConfigDetails(2, 2, sampleRate, blockSize);
+  processor.prepareToPlay(sampleRate, blockSize);
+  processor.requestLibraryProfiling(force);
+  while (processor.isProfilingLibrary())
+    juce::Thread::sleep(100);
+
+  std::printf("\n%.0f Hz, block size %d\n\n", sampleRate, blockSize);
+  std::printf("%-40s %8s %10s %10s %8s\n", "model", "xRT", "peak (ms)", "block (ms)", "status");
+  int overBudget = 0;
+  const auto names = processor.getModelNames();
+  const auto paths = processor.getModelPaths();
+  for (size_t i = 1; i < paths.size(); ++i) {
+    const auto name = names[static_cast<int>(i)].toStdString();
+    const auto profile = processor.getLibraryIndex().getCpuProfile(juce::File(paths[i]));
+    if (!profile || std::abs(profile->sampleRate - sampleRate) >= 0.5) {
+      std::printf("%-40s %8s %10s %10s %8s\n", name.c_str(), "-", "-", "-", "failed");
+      continue;
+    }
+    overBudget += profile->overBudget ? 1 : 0;
+    std::printf("%-40s %8.1f %10.3f %10.3f %8s\n", name.c_str(), profile->realTimeFactor,
+                profile->peakBlockMs, 1000.0 * profile->blockSize / profile->sampleRate,
+                profile->overBudget ? "OVER" : "ok");
+  }
+  std::printf("\n%d of %d model(s) over budget\n", overBudget, static_cast<int>(paths.size()) - 1);
+  return overBudget > 0 ? 2 : 0;
+}
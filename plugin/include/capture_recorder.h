@@ -0,0 +1,79 @@
+#pragma once
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <juce_audio_formats/juce_audio_formats.h>
+#include <atomic>
+#include <memory>
+#include "thread_manager.h"
+
+// Records the raw DI, and optionally the processed output, for re-amping. The audio thread copies
+// each block into a preallocated ring and never waits: a block that doesn't fit is dropped and
+// counted. A low-priority writer thread drains the ring to WAV or FLAC files in large sequential
+// writes, so memory stays bounded at ringSeconds of audio however slow the disk is.
+class CaptureRecorder : private juce::Thread {
+public:
+  enum class Format { wav, flac };
+
+  struct Status {
+    bool recording = false;
+    juce::File diFile;
+    juce::File outputFile;
+    double seconds = 0.0;
+    juce::int64 droppedSamples = 0;
+    juce::String error;
+  };
+
+  explicit CaptureRecorder(const juce::File& folder);
+  ~CaptureRecorder() override;
+
+  // Audio stopped. Sizes the ring and (re)starts the writer; any open files are finished first.
+  void prepare(double sampleRate, int numChannels);
+  void release();
+
+  // Audio thread. Recording starts at the next block after shouldRecord turns on; the format and
+  // output choice are taken when the files are opened.
+  void setRecording(bool shouldRecord, bool includeOutput, Format format);
+  // Call with the host buffer before anything modifies it, then after processing
+  void pushInput(const juce::AudioBuffer<float>& buffer);
+  void pushOutput(const juce::AudioBuffer<float>& buffer);
+
+  Status getStatus() const;
+
+private:
+  static constexpr double ringSeconds = 4.0;
+  static constexpr int writerPollMs = 50;
+  static constexpr int bitsPerSample = 24;
+
+  void run() override;
+  void openWriters();
+  void closeWriters();
+  void drain();
+  std::unique_ptr<juce::AudioFormatWriter> createWriter(const juce::File& file, int numChannels);
+
+  const juce::File folder;
+  juce::SharedResourcePointer<ThreadManager> threads;
+  double sampleRate = 48000.0;
+  int numChannels = 0;
+
+  // Channels [0, numChannels) hold the DI, [numChannels, 2 * numChannels) the output
+  juce::AudioBuffer<float> ring;
+  std::unique_ptr<juce::AbstractFifo> fifo;
+  int pendingStart1 = 0, pendingSize1 = 0, pendingStart2 = 0, pendingSize2 = 0;
+  bool pendingBlock = false;  // Audio thread only
+
+  std::atomic<bool> recording{false};
+  std::atomic<bool> recordOutput{false};
+  std::atomic<Format> format{Format::wav};
+  std::atomic<juce::int64> droppedSamples{0};
+  std::atomic<juce::int64> writtenSamples{0};
+
+  // Writer thread; status readers take the lock
+  mutable juce::CriticalSection statusLock;
+  std::unique_ptr<juce::AudioFormatWriter> diWriter;
+  std::unique_ptr<juce::AudioFormatWriter> outputWriter;
+  juce::File diFile;
+  juce::File outputFile;
+  juce::String error;
+  bool writersOpen = false;
+
+  JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(CaptureRecorder)
+};
@@ -0,0 +1,111 @@
+#pragma once
+#include <juce_audio_processors/juce_audio_processors.h>
+#include <array>
+#include <atomic>
+#include <vector>
+#include "telemetry.h"
+#include "thread_manager.h"
+
+#ifndef NEURALAMP_CONTROL_SOCKET
+#define NEURALAMP_CONTROL_SOCKET 0
+#endif
+
+class NeuralAmpProcessor;
+
+// Local control for builds without an editor: a Unix domain socket taking one JSON request per
+// line and answering each with one JSON line.
+//
+//   {"command": "set", "parameters": {"inputLevel": -12, "toneStackModel": 1, "eqToggle": true}}
+//   {"command": "load", "model": "Marshall/Plexi.nam", "ir": "/home/mind/IR/V30.wav", "slot": "B"}
+//   {"command": "preset", "preset": {"parameters": {...}, "models": [...], "irs": [...]}}
+//   {"command": "preset", "file": "Lead.json"}
+//   {"command": "status"}
+//
+// Parameter values are in the parameter's own units (dB, knob positions, choice indices). A
+// request's parameters are checked together and queued as one batch, which the audio thread
+// applies at the start of a block, so they all take effect on the same sample. Models and IRs are
+// given as library catalogue IDs or absolute paths, and are loaded by the loader thread. Replies
+// carry "ok" (and "error" when false); any "id" in the request is echoed back. Preset files are
+// only read from the processor's preset folder.
+//
+// The socket lives in $XDG_RUNTIME_DIR, or else in a folder only this user can enter, and is
+// readable and writable by this user alone. Clients are non-blocking: replies wait in a buffer
+// for a client that is slow to read, and one that lets too much pile up is dropped.
+//
+// Requests are parsed on the server's own thread, which only ever hands the audio thread a
+// lock-free queue of parameter changes; the host hears about them on the message thread. Status
+// meters are the telemetry frames since the last status request, so the server is the telemetry
+// reader and shouldn't run next to the editor.
+class ControlServer : private juce::Thread, private juce::AsyncUpdater {
+public:
+  // Further instances in the process take neuralamp-2.sock, neuralamp-3.sock, ...
+  static constexpr const char* socketName = "neuralamp.sock";
+  static constexpr int maxInstances = 16;
+  static constexpr int queueCapacity = 256;
+  static constexpr int maxRequestBytes = 65536;
+  // Replies waiting for one client
+  static constexpr int maxPendingReplyBytes = 1 << 20;
+
+  // $XDG_RUNTIME_DIR, or /tmp/neuralamp-<uid> created with mode 0700. Invalid when that folder
+  // can't be made, belongs to someone else or others can enter it.
+  static juce::File getSocketFolder();
+
+  explicit ControlServer(NeuralAmpProcessor& processor);
+  ~ControlServer() override;
+
+  // Listens on socketFile, or on the first free socketName in getSocketFolder() when it is
+  // invalid. Does nothing when already listening.
+  void start(const juce::File& socketFile = {});
+  void stop();
+  // Empty until listening
+  juce::File getSocketFile() const;
+
+  // Server thread, or anywhere in tests. One request line in, one reply line out.
+  juce::String handleRequest(const juce::String& request);
+
+  // Audio thread, at the start of a block. Returns the number of parameter changes applied.
+  int applyPendingChanges();
+
+private:
+  struct ParameterChange {
+    std::atomic<float>* value = nullptr;
+    float newValue = 0.0f;
+  };
+  // A change the audio thread has applied but the host hasn't been told about yet
+  struct Announcement {
+    juce::RangedAudioParameter* parameter = nullptr;
+    float normalisedValue = 0.0f;
+  };
+
+  static constexpr int pollIntervalMs = 50;
+
+  void run() override;
+  int listen(const juce::File& socketFile);
+  // Server thread. Has the message thread tell the host once the audio thread has applied
+  // everything queued.
+  void announceAppliedChanges();
+  void handleAsyncUpdate() override;
+
+  juce::var setParameters(const juce::var& values);
+  juce::var load(const juce::var& request);
+  juce::var applyPreset(const juce::var& preset);
+  juce::var applyPresetFile(const juce::String& name);
+  juce::var getStatus();
+
+  NeuralAmpProcessor& processor;
+  juce::SharedResourcePointer<ThreadManager> threads;
+
+  mutable juce::CriticalSection socketLock;
+  juce::File socketFile;
+  int listenFd = -1;
+
+  // Server thread to audio thread; a batch is published with one finishedWrite()
+  juce::AbstractFifo queue{queueCapacity};
+  std::array<ParameterChange, queueCapacity> changes;
+  juce::CriticalSection requestLock;  // Serialises writers: the server thread and tests
+  std::vector<Announcement> announcements;
+
+  TelemetryFrame meters;  // Merged since the last status request
+
+  JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ControlServer)
+};
@@ -0,0 +1,105 @@
+#pragma once
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <juce_dsp/juce_dsp.h>
+#include <array>
+#include <atomic>
+#include <memory>
+#include <vector>
+#include "memory_arena.h"
+
+// Cabinet stage mixing two IRs (e.g. two mics on one cab) for roughly the cost of one.
+//
+// Uniformly partitioned zero-latency convolution: each input block is transformed once into a
+// frequency-domain delay line shared by both IRs, multiplied against the blended partition
+// spectra and brought back with a single inverse FFT. While a blend move ramps, the products are
+// summed against both IRs' precomputed partition spectra and the two sums crossfaded, stepping
+// once per partition block; the blended spectra are rebuilt once, when the ramp settles.
+//
+// Loading an IR or changing the alignment builds a new engine on the calling (loader) thread. The
+// audio thread picks it up lock-free and crossfades to it; engines it has finished with are freed
+// by freeRetiredEngines(). Engines are allocated from the memory arena, when there is one, and
+// the IRs are cut short to the partitions its cap leaves room for.
+//
+// In minimum-phase mode (live monitoring) the engines run minimum-phase versions of the IRs, cut
+// to minimumPhaseSeconds: same magnitude response, but the sound starts on the first sample
+// instead of after the mic's distance from the speaker, and the short IRs take fewer partitions.
+// Alignment is ignored there, since it would only add back the delay.
+class DualIrConvolver {
+public:
+  enum Slot : int { slotA, slotB, numSlots };
+
+  static constexpr int maxIrLength = 32768;  // Reduced for RPi4 memory efficiency
+  static constexpr double crossfadeSeconds = 0.05;
+  static constexpr double blendRampSeconds = 0.05;
+  static constexpr double minimumPhaseSeconds = 0.05;
+
+  explicit DualIrConvolver(MemoryArena* memory = nullptr);
+  ~DualIrConvolver();
+
+  // Audio stopped. Rebuilds the engine for the new block size; IRs recorded for another sample
+  // rate are dropped and need loading again.
+  void prepare(double sampleRate, int maxBlockSize, int numChannels);
+
+  // Any thread but the audio thread. Uses the first channel of the IR.
+  void loadIr(Slot slot, const juce::AudioBuffer<float>& ir, double irSampleRate, bool normalise);
+  void clearIr(Slot slot);
+  bool hasIr(Slot slot) const;
+  bool hasAnyIr() const;
+  // Delays IR B by this many samples, or IR A when negative, to line up the two mics
+  void setAlignment(int samples);
+  // Rebuilds the engine from the loaded IRs when the mode changes
+  void setMinimumPhase(bool shouldUseMinimumPhase);
+  bool isMinimumPhase() const;
+  void freeRetiredEngines();
+
+  // The minimum-phase IR with the magnitude response of ir (homomorphic, via the real cepstrum),
+  // at most maxLength samples long and faded out at the cut
+  static std::vector<float> makeMinimumPhase(const std::vector<float>& ir, int maxLength);
+
+  // Audio thread. 0 plays IR A only, 1 IR B only; ignored unless both are loaded.
+  void setBlend(float blend) { targetBlend.store(juce::jlimit(0.0f, 1.0f, blend)); }
+  void process(juce::dsp::AudioBlock<float>& block);
+  void reset();
+  // True once an engine has reached the audio thread
+  bool isActive() const { return current != nullptr; }
+
+private:
+  class Engine;
+
+  std::unique_ptr<Engine> buildEngine() const;
+  void updateMinimumPhaseIr(size_t slot);
+  int getMaxPartitions(int numIrs) const;
+  void publish(std::unique_ptr<Engine> engine);
+  bool retire(Engine* engine);
+  void freeRetiredEnginesLocked();
+
+  MemoryArena* const memory;
+
+  // Loader and message threads
+  mutable juce::CriticalSection buildLock;
+  std::array<std::vector<float>, numSlots> irs;  // Trimmed and normalised; empty if not loaded
+  std::array<double, numSlots> irSampleRates{};
+  std::array<std::vector<float>, numSlots> minimumPhaseIrs;  // Only kept in minimum-phase mode
+  bool minimumPhase = false;
+  double sampleRate = 48000.0;
+  int blockSize = 128;
+  int numChannels = 2;
+  int alignmentSamples = 0;
+
+  std::atomic<Engine*> pending{nullptr};
+
+  // Audio thread
+  Engine* current = nullptr;
+  Engine* fading = nullptr;  // Previous engine, crossfaded out over fadeLength samples
+  int fadeRemaining = 0;
+  int fadeLength = 1;
+  std::atomic<float> targetBlend{0.0f};  // Also read by buildEngine() for the starting blend
+  juce::AudioBuffer<float> fadeBuffer;
+
+  // Engines the audio thread has let go of, waiting to be freed off the audio thread
+  static constexpr int retiredCapacity = 8;
+  juce::AbstractFifo retiredFifo{retiredCapacity};
+  std::array<Engine*, retiredCapacity> retired{};
+
+  JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(DualIrConvolver)
+};
@@ -3,7 +3,7 @@
 #include <juce_gui_basics/juce_gui_basics.h>
 #include <juce_gui_extra/juce_gui_extra.h>
 #include "processor.h"
-#include "BinaryData.h"  // Contains embedded Web UI assets (HTML/CSS/JS)
+#include "web_resources.h"
 
 // Restricts WebView loading to internal resources only
 struct SinglePageBrowser : juce::WebBrowserComponent {
@@ -13,7 +13,7 @@ struct SinglePageBrowser : juce::WebBrowserComponent {
   }
 };
 
-class NeuralAmpEditor : public juce::AudioProcessorEditor {
+class NeuralAmpEditor : public juce::AudioProcessorEditor, private juce::Timer {
 public:
   explicit NeuralAmpEditor(NeuralAmpProcessor&);
   ~NeuralAmpEditor() override;
@@ -28,6 +28,13 @@ public:
 private:
   NeuralAmpProcessor& processor;
 
+  // Telemetry frames queued since the last tick go to the WebView as one "telemetry" event
+  static constexpr int telemetryRateHz = 30;
+  void timerCallback() override;
+  // The library folders are scanned after construction; "libraryChanged" tells the WebView to
+  // fetch the model and IR choices again
+  int listingGeneration = NeuralAmpProcessor::getListingGeneration();
+
   //==============================================================================
   // WebView UI
   //==============================================================================
@@ -41,15 +48,22 @@ private:
   juce::WebSliderRelay midRelay{"toneMid"};
   juce::WebSliderRelay trebleRelay{"toneTreble"};
   juce::WebSliderRelay noiseGateThresholdRelay{"noiseGateThreshold"};
+  juce::WebSliderRelay modelBlendRelay{"modelBlend"};
+  juce::WebSliderRelay irBlendRelay{"irBlend"};
+  juce::WebSliderRelay irAlignRelay{"irAlign"};
 
   juce::WebToggleButtonRelay noiseGateToggleRelay{"noiseGateToggle"};
   juce::WebToggleButtonRelay eqToggleRelay{"eqToggle"};
   juce::WebToggleButtonRelay irToggleRelay{"irToggle"};
   juce::WebToggleButtonRelay normalizeNamOutputRelay{"normalizeNamOutput"};
   juce::WebToggleButtonRelay normalizeIrOutputRelay{"normalizeIrOutput"};
+  juce::WebToggleButtonRelay liveMonitoringRelay{"liveMonitoring"};
 
   juce::WebComboBoxRelay modelDropdownRelay{"selectedNamModel"};
+  juce::WebComboBoxRelay modelBDropdownRelay{"selectedNamModelB"};
   juce::WebComboBoxRelay irDropdownRelay{"selectedIR"};
+  juce::WebComboBoxRelay irBDropdownRelay{"selectedIRB"};
+  juce::WebComboBoxRelay toneStackRelay{"toneStackModel"};
 
   // Attachments
   juce::WebSliderParameterAttachment inputLevelWebAttachment{
@@ -64,6 +78,12 @@ private:
       *processor.parameters.getParameter("toneTreble"), trebleRelay, nullptr};
   juce::WebSliderParameterAttachment noiseGateThresholdWebAttachment{
       *processor.parameters.getParameter("noiseGateThreshold"), noiseGateThresholdRelay, nullptr};
+  juce::WebSliderParameterAttachment modelBlendWebAttachment{
+      *processor.parameters.getParameter("modelBlend"), modelBlendRelay, nullptr};
+  juce::WebSliderParameterAttachment irBlendWebAttachment{
+      *processor.parameters.getParameter("irBlend"), irBlendRelay, nullptr};
+  juce::WebSliderParameterAttachment irAlignWebAttachment{
+      *processor.parameters.getParameter("irAlign"), irAlignRelay, nullptr};
   juce::WebToggleButtonParameterAttachment noiseGateToggleWebAttachment{
       *processor.parameters.getParameter("noiseGateToggle"), noiseGateToggleRelay, nullptr};
   juce::WebToggleButtonParameterAttachment eqActiveWebAttachment{
@@ -74,14 +94,19 @@ private:
       *processor.parameters.getParameter("normalizeNamOutput"), normalizeNamOutputRelay, nullptr};
   juce::WebToggleButtonParameterAttachment normalizeIrOutputWebAttachment{
       *processor.parameters.getParameter("normalizeIrOutput"), normalizeIrOutputRelay, nullptr};
+  juce::WebToggleButtonParameterAttachment liveMonitoringWebAttachment{
+      *processor.parameters.getParameter("liveMonitoring"), liveMonitoringRelay, nullptr};
 
   juce::WebComboBoxParameterAttachment modelDropdownWebAttachment{
       *processor.parameters.getParameter("selectedNamModel"), modelDropdownRelay, nullptr};
+  juce::WebComboBoxParameterAttachment modelBDropdownWebAttachment{
+      *processor.parameters.getParameter("selectedNamModelB"), modelBDropdownRelay, nullptr};
   juce::WebComboBoxParameterAttachment irDropdownWebAttachment{
       *processor.parameters.getParameter("selectedIR"), irDropdownRelay, nullptr};
-
-  std::optional<juce::WebBrowserComponent::Resource> getResource(const juce::String& url);
-  juce::String getMimeForExtension(const juce::String& extension);
+  juce::WebComboBoxParameterAttachment irBDropdownWebAttachment{
+      *processor.parameters.getParameter("selectedIRB"), irBDropdownRelay, nullptr};
+  juce::WebComboBoxParameterAttachment toneStackWebAttachment{
+      *processor.parameters.getParameter("toneStackModel"), toneStackRelay, nullptr};
 
   //==============================================================================
   // Native JUCE UI
@@ -0,0 +1,69 @@
+#pragma once
+#include <juce_core/juce_core.h>
+#include <functional>
+#include <vector>
+#include "library_index.h"
+
+// Listing of the models or IRs in a folder, for UIs that page and search through them instead of
+// receiving the whole library at once. Items are identified by their path relative to the folder,
+// which stays valid as files are added, unlike the frozen choice indices of the selection
+// parameters. Header facts come from the library index, so each file is only opened once per
+// version.
+class LibraryCatalogue {
+public:
+  enum class Kind { model, impulseResponse };
+
+  struct Item {
+    juce::String id;
+    juce::String name;
+    juce::String architecture;
+    double sampleRate = 0.0;
+    juce::int64 modificationTime = 0;
+    std::optional<LibraryIndex::CpuProfile> cpu;  // Models that have been profiled
+  };
+
+  enum class Sort { name, newest };
+
+  struct Query {
+    juce::String text;          // Case-insensitive substring of the name
+    juce::String architecture;  // Exact match, ignoring case; empty matches everything
+    double sampleRate = 0.0;    // 0 matches everything
+    Sort sort = Sort::name;
+    int offset = 0;
+    int limit = 50;
+  };
+
+  struct Page {
+    int total = 0;  // Matches before paging
+    std::vector<Item> items;
+  };
+
+  static constexpr int maxLimit = 500;
+
+  LibraryCatalogue(Kind kind, juce::File folder, LibraryIndex& index);
+
+  // Rescans the folder. Only call from the loader thread or a worker, since reading headers of new
+  // files can take a while. Gives up, keeping the previous listing, as soon as shouldExit returns
+  // true; returns false if it did.
+  bool refresh(const std::function<bool()>& shouldExit = {});
+
+  Page query(const Query& query) const;
+  // The file for an ID, or an invalid File if the ID isn't in the catalogue
+  juce::File getFile(const juce::String& id) const;
+
+  // Conversions for the WebView bridge
+  static Query queryFromVar(const juce::var& object);
+  static juce::var pageToVar(const Page& page);
+
+private:
+  LibraryIndex::FileInfo readFileInfo(const juce::File& file) const;
+
+  const Kind kind;
+  const juce::File folder;
+  LibraryIndex& index;
+
+  std::vector<Item> items;  // Sorted by name
+  juce::CriticalSection lock;
+
+  JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(LibraryCatalogue)
+};
@@ -0,0 +1,78 @@
+#pragma once
+#include <juce_core/juce_core.h>
+#include <cmath>
+#include <map>
+#include <optional>
+
+// Persistent per-file metadata for the model library, so values that are expensive to compute
+// (e.g. measured loudness) are known immediately the next time a model is loaded. Entries are
+// keyed by full path and dropped when the file's modification time changes.
+class LibraryIndex {
+public:
+  explicit LibraryIndex(juce::File indexFile = getDefaultFile());
+
+  static juce::File getDefaultFile();
+
+  void load();
+  // Writes the index back to disk if anything changed since the last load/save
+  void saveIfNeeded();
+
+  // The model's measured output loudness (LUFS) before any IR, comparable to its .nam metadata
+  std::optional<float> getLoudness(const juce::File& model) const;
+  void setLoudness(const juce::File& model, float loudness);
+
+  // Requested inference backend: "float" (default), "int16", "int8" or "auto"
+  juce::String getInferenceMode(const juce::File& model) const;
+  void setInferenceMode(const juce::File& model, const juce::String& mode);
+
+  // Error-to-signal ratio of an alternative backend ("int8", "int16" or "simd") against NAM's
+  // float model
+  std::optional<double> getBackendEsr(const juce::File& model, const juce::String& backend) const;
+  void setBackendEsr(const juce::File& model, const juce::String& backend, double esr);
+
+  // Header facts the catalogue filters on, read once per file version. Sample rate is 0 when the
+  // file doesn't state one; architecture is empty for IRs.
+  struct FileInfo {
+    juce::String architecture;
+    double sampleRate = 0.0;
+  };
+  std::optional<FileInfo> getFileInfo(const juce::File& file) const;
+  void setFileInfo(const juce::File& file, const FileInfo& info);
+
+  // What running a model costs at one sample rate and block size, as timed by ModelProfiler.
+  // Dropped when the model's inference mode changes, since another engine will run it.
+  struct CpuProfile {
+    double sampleRate = 0.0;
+    int blockSize = 0;
+    double realTimeFactor = 0.0;  // Seconds of audio per second of processing
+    double peakBlockMs = 0.0;
+    bool overBudget = false;
+
+    bool matches(double rate, int size) const {
+      return std::abs(sampleRate - rate) < 0.5 && blockSize == size;
+    }
+  };
+  std::optional<CpuProfile> getCpuProfile(const juce::File& model) const;
+  void setCpuProfile(const juce::File& model, const CpuProfile& profile);
+
+private:
+  struct Entry {
+    juce::int64 modificationTime = 0;
+    std::optional<float> loudness;
+    juce::String inferenceMode;
+    std::map<juce::String, double> backendEsr;
+    std::optional<FileInfo> info;
+    std::optional<CpuProfile> cpu;
+  };
+
+  Entry* findEntry(const juce::File& model);
+  const Entry* findEntry(const juce::File& model) const;
+  Entry& getOrCreateEntry(const juce::File& model);
+
+  const juce::File file;
+  std::map<juce::String, Entry> entries;
+  bool dirty = false;
+  juce::CriticalSection lock;
+
+  JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(LibraryIndex)
+};
@@ -0,0 +1,63 @@
+#pragma once
+#include <juce_core/juce_core.h>
+#include <atomic>
+#include "thread_manager.h"
+
+class NeuralAmpProcessor;
+
+// Background thread that picks up model/IR selection changes and loads them off the audio thread
+class LoaderThread : public juce::Thread {
+public:
+  explicit LoaderThread(NeuralAmpProcessor& processor);
+  ~LoaderThread() override;
+
+  void run() override;
+  // Stops the thread and any refresh or profile it started, waiting as long as they take
+  void stop();
+
+  // Profiles the library's models on a worker once the library has been scanned and its index
+  // loaded; only those without a profile for the current sample rate and block size unless force.
+  // NEURALAMP_PROFILE_LIBRARY does this for new models whenever the library is rescanned.
+  void requestProfiling(bool force);
+  // Requested, queued or running
+  bool isProfiling() const;
+
+private:
+  static constexpr int pollIntervalMs = 50;
+  // Picks up files added to or removed from the library folders
+  static constexpr juce::uint32 catalogueRefreshIntervalMs = 10000;
+
+  // Rescans the library folders on a worker, so a slow disk never holds up a load
+  class CatalogueRefreshJob : public juce::ThreadPoolJob {
+  public:
+    CatalogueRefreshJob(NeuralAmpProcessor& processor, const ThreadManager& threads);
+    JobStatus runJob() override;
+
+  private:
+    NeuralAmpProcessor& processor;
+    const ThreadManager& threads;
+  };
+
+  class LibraryProfileJob : public juce::ThreadPoolJob {
+  public:
+    LibraryProfileJob(NeuralAmpProcessor& processor, const ThreadManager& threads);
+    JobStatus runJob() override;
+
+    std::atomic<bool> force{false};
+
+  private:
+    NeuralAmpProcessor& processor;
+    const ThreadManager& threads;
+  };
+
+  enum ProfilingRequest : int { noProfiling, profileNewModels, profileAllModels };
+  void startRequestedProfiling();
+
+  NeuralAmpProcessor& processor;
+  juce::SharedResourcePointer<ThreadManager> threads;
+  CatalogueRefreshJob catalogueRefreshJob{processor, *threads};
+  LibraryProfileJob libraryProfileJob{processor, *threads};
+  std::atomic<int> profilingRequest{NEURALAMP_PROFILE_LIBRARY ? profileNewModels : noProfiling};
+
+  JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(LoaderThread)
+};
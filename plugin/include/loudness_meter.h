@@ -0,0 +1,61 @@
+#pragma once
+#include <array>
+#include <limits>
+#include <vector>
+
+// Gated integrated loudness meter in the style of ITU-R BS.1770 (K-weighting, 400 ms blocks with
+// 75% overlap, -70 LUFS absolute and -10 LU relative gates) over a sliding window.
+//
+// To stay cheap on the audio thread the input is decimated by boxcar averaging before the
+// K-weighting, so the reading is an approximation that slightly under-weights content above a
+// quarter of the sample rate. That is fine for driving a slow normaliser, not for compliance.
+class LoudnessMeter {
+public:
+  static constexpr int maxChannels = 2;
+  static constexpr int decimationFactor = 4;
+  static constexpr double windowSeconds = 20.0;
+
+  void prepare(double sampleRate);
+  void reset();
+
+  void process(const float* const* channels, int numChannels, int numSamples);
+
+  // Integrated loudness in LUFS over the window, or -inf if nothing passed the gates yet
+  float getIntegratedLoudness() const { return integratedLoudness; }
+  // Seconds of audio that contributed to the integrated loudness
+  float getGatedSeconds() const { return gatedSeconds; }
+
+private:
+  struct Biquad {
+    float b0 = 1.0f, b1 = 0.0f, b2 = 0.0f, a1 = 0.0f, a2 = 0.0f;
+  };
+  struct BiquadState {
+    float z1 = 0.0f, z2 = 0.0f;
+  };
+
+  static float processBiquad(const Biquad& c, BiquadState& s, float x);
+  void finishStep();
+  void updateIntegratedLoudness();
+
+  Biquad preFilter;
+  Biquad rlbFilter;
+  std::array<BiquadState, maxChannels> preState{};
+  std::array<BiquadState, maxChannels> rlbState{};
+  std::array<float, maxChannels> decimationSum{};
+  int decimationCount = 0;
+
+  // 100 ms steps; four consecutive steps make one 400 ms gating block
+  int samplesPerStep = 1;
+  int stepSampleCount = 0;
+  double stepSum = 0.0;
+  std::array<double, 4> stepMeanSquares{};
+  int stepsSeen = 0;
+
+  double absoluteGate = 0.0;             // Mean square, computed in prepare()
+  std::vector<double> blockMeanSquares;  // Ring buffer of gating blocks in the window
+  int blockWriteIndex = 0;
+  int numBlocks = 0;
+
+  float integratedLoudness = -std::numeric_limits<float>::infinity();
+  float gatedSeconds = 0.0f;
+};
@@ -0,0 +1,148 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+// One instance's audio-path memory, under one cap. Convolution partitions and scratch buffers are
+// allocated from a single page-aligned region; model engines keep their own buffers, which are
+// pinned in place and counted against the same cap.
+//
+// With lockPages (embedded builds) every page is faulted in and mlock()ed before anything can
+// use it: the region grows in commitGranularity steps on the allocating (loader) thread, so a
+// model or IR swap never page-faults on the audio thread. Never allocate or free from the audio
+// thread; the bookkeeping takes a lock.
+class MemoryArena {
+public:
+  enum Subsystem : int { modelWeights, modelBuffers, convolution, scratch, numSubsystems };
+  static const char* getSubsystemName(Subsystem subsystem);
+
+  static constexpr size_t commitGranularity = size_t{1} << 20;
+
+  MemoryArena(size_t capacityBytes, bool lockPages);
+  ~MemoryArena();
+
+  MemoryArena(const MemoryArena&) = delete;
+  MemoryArena& operator=(const MemoryArena&) = delete;
+
+  // Throws std::bad_alloc when the request doesn't fit under the cap
+  void* allocate(Subsystem subsystem, size_t bytes, size_t alignment);
+  void deallocate(Subsystem subsystem, void* pointer, size_t bytes);
+
+  // What the cap leaves for new allocations and pins. Committed pages that were freed count as
+  // available: the arena reuses them first.
+  size_t getAvailableBytes() const;
+  size_t getCapacity() const { return capacity; }
+
+  struct Usage {
+    std::array<size_t, numSubsystems> bytes{};  // Allocated or pinned, exactly
+    size_t committedBytes = 0;  // Region pages faulted in so far
+    size_t capacityBytes = 0;
+    bool locked = false;  // Whether every page is mlock()ed; false if locking was off or refused
+
+    std::string toString() const;
+  };
+  Usage getUsage() const;
+
+  // Calls visit(subsystem, data, bytes) for each buffer an engine owns
+  using BufferVisitor = std::function<void(Subsystem, const void*, size_t)>;
+  template <typename T, typename A>
+  static void visitVector(const BufferVisitor& visit,
+                          Subsystem subsystem,
+                          const std::vector<T, A>& vector) {
+    visit(subsystem, vector.data(), vector.capacity() * sizeof(T));
+  }
+
+  // Counts memory owned elsewhere against the cap under owner, faulting it in and locking it with
+  // lockPages. Returns false, pinning nothing, when it doesn't fit.
+  bool pin(const void* owner, const std::function<void(const BufferVisitor&)>& forEachBuffer);
+  void unpin(const void* owner);
+
+  // std::allocator replacement drawing from an arena. A default-constructed one uses the heap, so
+  // containers work the same without an arena.
+  template <typename T>
+  class Allocator {
+  public:
+    using value_type = T;
+    using propagate_on_container_copy_assignment = std::true_type;
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap = std::true_type;
+
+    Allocator() = default;
+    Allocator(MemoryArena* arena, Subsystem subsystem) : arena(arena), subsystem(subsystem) {}
+    template <typename U>
+    Allocator(const Allocator<U>& other) : arena(other.arena), subsystem(other.subsystem) {}
+
+    T* allocate(size_t n) {
+      if (arena == nullptr)
+        return static_cast<T*>(::operator new(n * sizeof(T)));
+      return static_cast<T*>(arena->allocate(subsystem, n * sizeof(T), alignof(T)));
+    }
+    void deallocate(T* pointer, size_t n) {
+      if (arena == nullptr)
+        ::operator delete(pointer);
+      else
+        arena->deallocate(subsystem, pointer, n * sizeof(T));
+    }
+
+    template <typename U>
+    bool operator==(const Allocator<U>& other) const {
+      return arena == other.arena && subsystem == other.subsystem;
+    }
+    template <typename U>
+    bool operator!=(const Allocator<U>& other) const {
+      return !(*this == other);
+    }
+
+  private:
+    template <typename U>
+    friend class Allocator;
+
+    MemoryArena* arena = nullptr;
+    Subsystem subsystem = scratch;
+  };
+
+  template <typename T>
+  using Vector = std::vector<T, Allocator<T>>;
+
+private:
+  void commit(size_t end);
+  bool lockRange(const void* start, size_t bytes);
+  void unlockRange(const void* start, size_t bytes);
+
+  const size_t capacity;
+  const bool lockPages;
+  const size_t pageSize;
+  const size_t regionSize;
+
+  mutable std::mutex mutex;
+  std::byte* region = nullptr;
+  size_t committed = 0;
+  size_t top = 0;                       // Everything from here up is free
+  std::map<size_t, size_t> freeBlocks;  // Offset -> size, below top, coalesced
+  size_t allocatedBytes = 0;            // Region bytes handed out
+  bool locked;
+
+  std::array<size_t, numSubsystems> subsystemBytes{};
+
+  struct Pin {
+    Subsystem subsystem;
+    const void* data;
+    size_t bytes;
+  };
+  std::map<const void*, std::vector<Pin>> pins;
+  std::map<std::uintptr_t, int> pinnedPages;  // Pin count per page, since mlock() doesn't nest
+  size_t pinnedBytes = 0;
+};
+
+// Model engines that can list their buffers, so an arena can count and pin them in place
+class ResidentModel {
+public:
+  virtual ~ResidentModel() = default;
+  virtual void forEachBuffer(const MemoryArena::BufferVisitor& visit) const = 0;
+};
@@ -0,0 +1,58 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <vector>
+#include "NAM/dsp.h"
+#include "memory_arena.h"
+
+// Plays two NAM models (e.g. a clean and a crunch capture of one amp) side by side and
+// crossfades their outputs. The mono input is converted to NAM_SAMPLE once per chunk and both
+// models run on that shared buffer back to back.
+//
+// A model whose weight has been zero for idleSeconds stops being evaluated. When the blend moves
+// back towards it, it is first run unheard for wakeSeconds so its state (LSTM cells, WaveNet
+// receptive field) catches up with the input; the blend ramp holds still until then.
+class ModelBlender {
+public:
+  enum Slot : int { slotA, slotB, numSlots };
+  using Models = std::array<nam::DSP*, numSlots>;
+
+  static constexpr double blendRampSeconds = 0.05;
+  static constexpr double idleSeconds = 0.1;
+  static constexpr double wakeSeconds = 0.1;
+
+  // Buffers come from memory when given, as scratch
+  void prepare(double sampleRate, int maxBlockSize, MemoryArena* memory = nullptr);
+  void reset();
+
+  // 0 plays model A only, 1 model B only; a model loaded on its own always plays at full level
+  void setBlend(float value) { targetBlend = std::clamp(value, 0.0f, 1.0f); }
+  float getBlend() const { return blend; }
+
+  // Audio thread. Writes the mix of the models' responses to input into output, which may alias
+  // input. Null models are left out; with only one loaded it plays at full level.
+  void process(const float* input, float* output, int numSamples, const Models& models);
+
+  // Whether the slot's model was evaluated for the last chunk
+  bool isRunning(Slot slot) const { return states[static_cast<size_t>(slot)] != State::idle; }
+
+private:
+  enum class State { running, idle, waking };
+
+  float getWeight(Slot slot, float value) const { return slot == slotA ? 1.0f - value : value; }
+  void updateStates(const Models& models, int numSamples);
+
+  float blend = 0.0f;
+  float targetBlend = 0.0f;
+  float rampTarget = 0.0f;  // targetBlend, or the end of the only model loaded
+  float blendStep = 1.0f;  // Per sample
+  int idleSamples = 1;
+  int wakeSamples = 1;
+
+  std::array<State, numSlots> states{State::idle, State::idle};
+  std::array<int, numSlots> stateSamples{};  // Silent for, or still waking for
+  std::array<nam::DSP*, numSlots> lastModels{};
+
+  MemoryArena::Vector<NAM_SAMPLE> inputBuffer;
+  std::array<MemoryArena::Vector<NAM_SAMPLE>, numSlots> outputBuffers;
+};
@@ -0,0 +1,30 @@
+#pragma once
+#include "NAM/dsp.h"
+#include "library_index.h"
+
+// Times a model the way the audio thread runs it: chunks of the processing block size at the
+// device's sample rate, after a warm-up, on the calling thread. Models that can't run with
+// headroom are flagged over budget, so the UI can warn about them and the loader can refuse them
+// (NEURALAMP_REFUSE_OVER_BUDGET).
+//
+// Timings are only as quiet as the thread taking them. NeuralAmpLibraryProfiler on an idle device
+// gives the truest figures; profiling in the plugin's background workers, next to live audio,
+// errs on the slow side.
+class ModelProfiler {
+public:
+  // Share of each block a model may take on average; the rest is for the IR, filters and host
+  static constexpr double maxAverageLoad = 0.5;
+  static constexpr double warmUpSeconds = 0.5;
+  static constexpr double measureSeconds = 2.0;
+
+  // The model must have been Reset() for sampleRate and blockSize
+  static LibraryIndex::CpuProfile measure(nam::DSP& model,
+                                          double sampleRate,
+                                          int blockSize,
+                                          double seconds = measureSeconds);
+
+  // Over on average, or a single block took longer than the block lasts
+  static bool isOverBudget(const LibraryIndex::CpuProfile& profile);
+
+  static juce::String describe(const LibraryIndex::CpuProfile& profile);
+};
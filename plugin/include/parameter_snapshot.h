@@ -0,0 +1,55 @@
+#pragma once
+#include <juce_audio_processors/juce_audio_processors.h>
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+// The parameters the audio thread reads, bound to their atomics once at construction so a block
+// costs one relaxed load per parameter instead of a string-keyed lookup. update() also reports
+// which of them moved, so work derived from a parameter (coefficients, gains, thresholds) only
+// runs when that parameter changes.
+class ParameterSnapshot {
+public:
+  enum Id : int {
+    inputLevel,
+    outputLevel,
+    toneBass,
+    toneMid,
+    toneTreble,
+    eqToggle,
+    toneStackModel,
+    noiseGateToggle,
+    noiseGateThreshold,
+    irToggle,
+    normalizeNamOutput,
+    targetLoudness,
+    irBlend,
+    modelBlend,
+    liveMonitoring,
+    numParameters
+  };
+
+  using Mask = std::uint32_t;
+  static constexpr Mask maskOf(Id id) { return Mask{1} << id; }
+  static constexpr Mask allParameters = (Mask{1} << numParameters) - 1;
+
+  // Every ID must exist in the parameter layout
+  explicit ParameterSnapshot(juce::AudioProcessorValueTreeState& parameters);
+
+  // Loads every parameter and returns the mask of those that changed since the last call
+  Mask update();
+  // Loads every parameter and reports all of them as changed
+  Mask reset();
+
+  float get(Id id) const { return values[static_cast<size_t>(id)]; }
+  bool isOn(Id id) const { return get(id) > 0.5f; }
+
+  static const char* getParameterId(Id id);
+
+private:
+  // Smaller moves are host jitter, not automation
+  static constexpr float epsilon = 1e-5f;
+
+  std::array<std::atomic<float>*, numParameters> sources{};
+  std::array<float, numParameters> values{};
+};
@@ -5,7 +5,9 @@
 #include <juce_audio_formats/juce_audio_formats.h>
 #include <map>
 #include <atomic>
+#include <functional>
 #include <memory>
+#include <optional>
 #include "NAM/dsp.h"
 #include "NAM/get_dsp.h"
 #include "NAM/activations.h"
@@ -13,10 +15,41 @@
 #include "NAM/lstm.h"
 #include "NAM/util.h"
 #include "NAM/wavenet.h"
+#include "capture_recorder.h"
+#include "control_server.h"
+#include "dual_ir_convolver.h"
+#include "library_catalogue.h"
+#include "library_index.h"
+#include "loader_thread.h"
+#include "loudness_meter.h"
+#include "memory_arena.h"
+#include "model_blender.h"
+#include "model_profiler.h"
+#include "parameter_snapshot.h"
+#include "quantised_lstm.h"
+#include "realtime_audit.h"
+#include "signal_guard.h"
+#include "simd_engines.h"
+#include "smoothed_gain.h"
+#include "sub_block_scheduler.h"
+#include "telemetry.h"
+#include "tone_stack.h"
 
 class NeuralAmpProcessor : public juce::AudioProcessor {
 public:
+  // Where an instance reads its library and presets and keeps its library index and captures.
+  // Tests point these at temporary folders rather than the device's.
+  struct Locations {
+    juce::File namFolder;
+    juce::File irFolder;
+    juce::File captureFolder;
+    juce::File libraryIndexFile;
+    juce::File presetFolder;  // The only place the control socket reads preset files from
+  };
+  static Locations getDefaultLocations();
+
   NeuralAmpProcessor();
+  explicit NeuralAmpProcessor(Locations locations);
   ~NeuralAmpProcessor() override;
 
   void prepareToPlay(double sampleRate, int samplesPerBlock) override;
@@ -49,90 +82,307 @@ public:
 
   juce::AudioProcessorValueTreeState& getParameters() { return parameters; }
 
-  void loadNamFile(const juce::String& filePath);
-  void loadIrFile(const juce::File& irFile);
+  // True once the model is playing; false if it couldn't be read or was refused, when the
+  // previous model keeps playing
+  bool loadNamFile(const juce::String& filePath, ModelBlender::Slot slot = ModelBlender::slotA);
+  void loadIrFile(const juce::File& irFile, DualIrConvolver::Slot slot = DualIrConvolver::slotA);
+  void loadModelAtIndex(int index, ModelBlender::Slot slot = ModelBlender::slotA);
+  void loadIrAtIndex(int index, DualIrConvolver::Slot slot = DualIrConvolver::slotA);
+
+  // Sorted library folder contents, shared by every instance in the process. Entry 0 is the
+  // "nothing selected" choice, and the selection parameters index into these. Scanned once and
+  // never refreshed, so an index can't change meaning while the process runs; the catalogues are
+  // what follow the folders.
+  struct LibraryListing {
+    juce::StringArray names;
+    std::vector<juce::String> paths;
+  };
+  static std::shared_ptr<const LibraryListing> getModelListing();
+  static std::shared_ptr<const LibraryListing> getIrListing();
+  // Bumped whenever scanned listings are published
+  static int getListingGeneration() { return listingGeneration.load(); }
+  // Blocking; the first loader thread to start does it so construction never touches the disk.
+  // The listing comes from that instance's folders.
+  static void scanLibraryFolders(const juce::File& namFolder, const juce::File& irFolder);
 
-  const juce::StringArray& getModelNames() const;
-  const juce::StringArray& getIrNames() const;
-  const std::vector<juce::String>& getModelPaths() const;
-  const std::vector<juce::String>& getIrPaths() const;
+  juce::StringArray getModelNames() const { return getModelListing()->names; }
+  juce::StringArray getIrNames() const { return getIrListing()->names; }
+  std::vector<juce::String> getModelPaths() const { return getModelListing()->paths; }
+  std::vector<juce::String> getIrPaths() const { return getIrListing()->paths; }
 
-  int getCurrentModelIndex() const { return currentModelIndex; }
-  int getCurrentIrIndex() const { return currentIrIndex; }
+  // The playing model's selection index; a selection that failed to load leaves it unchanged
+  int getCurrentModelIndex(ModelBlender::Slot slot = ModelBlender::slotA) const {
+    return currentModelIndices[static_cast<size_t>(slot)].load();
+  }
+  // The selection the loader last acted on, loaded or not, so a refused one isn't retried
+  int getAttemptedModelIndex(ModelBlender::Slot slot = ModelBlender::slotA) const {
+    return attemptedModelIndices[static_cast<size_t>(slot)].load();
+  }
+  // The last model loaded into the slot was refused for being over the CPU budget
+  // (NEURALAMP_REFUSE_OVER_BUDGET) or the memory cap
+  bool isModelRefused(ModelBlender::Slot slot = ModelBlender::slotA) const {
+    return (refusedModelSlots.load() & (1 << slot)) != 0;
+  }
+  int getCurrentIrIndex(DualIrConvolver::Slot slot = DualIrConvolver::slotA) const {
+    return currentIrIndices[static_cast<size_t>(slot)].load();
+  }
+  // As getAttemptedModelIndex()
+  int getAttemptedIrIndex(DualIrConvolver::Slot slot = DualIrConvolver::slotA) const {
+    return attemptedIrIndices[static_cast<size_t>(slot)].load();
+  }
 
-  bool isModelLoaded() const { return modelLoaded; }
+  bool isModelLoaded(ModelBlender::Slot slot = ModelBlender::slotA) const {
+    return modelLoaded[static_cast<size_t>(slot)].load();
+  }
   bool isIrLoaded() const { return irLoaded; }
+  // The convolver swaps IRs in asynchronously; true once the loaded IR is running. Audio thread
+  // only.
+  bool isIrActive() const { return irLoaded && irConvolver.isActive(); }
+  // Loader thread. Applies the irAlign parameter and frees engines the convolver swapped out.
+  void updateIrAlignment();
+  // Loader thread. Applies the liveMonitoring parameter to the IRs and reports the new latency;
+  // the audio thread switches the sub-block FIFO itself, and the oversampler's filters follow on
+  // the next prepareToPlay().
+  void updateLatencyMode();
+  bool isLiveMonitoring() const;
+
+  const Locations& getLocations() const { return locations; }
+  LibraryIndex& getLibraryIndex() { return libraryIndex; }
+  void updateLibraryIndex();
+
+  // Paged listings for the UI. Loading by catalogue ID works for files added after the selection
+  // parameters' choice lists were frozen; the request is served by the loader thread. Requests
+  // also take absolute paths, for files outside the library folders.
+  LibraryCatalogue& getModelCatalogue() { return modelCatalogue; }
+  LibraryCatalogue& getIrCatalogue() { return irCatalogue; }
+  // Loader thread or a worker; stops early once shouldExit returns true
+  void refreshCatalogues(const std::function<bool()>& shouldExit = {});
+  void requestModel(const juce::String& id, ModelBlender::Slot slot = ModelBlender::slotA);
+  void requestIr(const juce::String& id, DualIrConvolver::Slot slot = DualIrConvolver::slotA);
+  void loadRequestedFiles();
+
+  // DI (and optionally output) recording, switched by the capture* parameters
+  CaptureRecorder::Status getCaptureStatus() const { return captureRecorder.getStatus(); }
+
+  // Meter, gate and load frames from the audio thread; drain from one thread only
+  Telemetry& getTelemetry() { return telemetry; }
+
+  // Started by prepareToPlay() in NEURALAMP_CONTROL_SOCKET builds
+  ControlServer& getControlServer() { return controlServer; }
+
+  // Selects "float", "int16", "int8" or "auto" inference for a model and reloads it if active
+  void setModelInferenceMode(int index, const juce::String& mode);
+  bool consumeModelReloadRequest(ModelBlender::Slot slot) {
+    return consumeSlotFlag(modelReloadPending, slot);
+  }
+  // A model that produced NaN or infinity, or threw, is reloaded from its file to start from
+  // clean state
+  bool consumeModelResetRequest(ModelBlender::Slot slot) {
+    return consumeSlotFlag(modelResetPending, slot);
+  }
+  void reloadCurrentModel(ModelBlender::Slot slot);
+  // Loader thread, every poll. Counts a reported fault and reloads the model once its backoff has
+  // passed; the delay doubles with each fault in a row. After maxModelFaults in a row the slot is
+  // left muted and reported as faulted until another model is loaded into it.
+  static constexpr int maxModelFaults = 4;
+  static constexpr juce::uint32 modelResetBackoffMs = 250;
+  // A reloaded model that runs this long without a fault starts counting afresh
+  static constexpr juce::uint32 modelFaultMemoryMs = 10000;
+  void handleModelFault(ModelBlender::Slot slot, bool faultReported);
+  bool isModelFaulted(ModelBlender::Slot slot = ModelBlender::slotA) const {
+    return (faultedModelSlots.load() & (1 << slot)) != 0;
+  }
+
+  // Blocks silenced because the model or the filter chain produced NaN or infinity, or a model
+  // threw
+  juce::uint32 getNonFiniteRecoveries() const;
+
+  // Bytes held per subsystem under the instance's memory cap
+  MemoryArena::Usage getMemoryUsage() const { return memoryArena.getUsage(); }
+
+  // Times the library's models at the current sample rate and chunk size and keeps the results
+  // in the library index; models already profiled there are skipped unless force. Blocking, and
+  // never on the audio thread: requestLibraryProfiling() has a background worker run it once the
+  // loader has scanned the library. Returns the number of models profiled.
+  int profileLibrary(bool force, const std::function<bool()>& shouldExit = {});
+  void requestLibraryProfiling(bool force = false);
+  bool isProfilingLibrary() const;
 
 private:
-  // Path to NAM and IR folder
+  // Default library, IR, capture and preset folders
   static constexpr const char* NamFolder = "/home/mind/NAM";
   static constexpr const char* IrFolder = "/home/mind/IR";
+  static constexpr const char* CaptureFolder = "/home/mind/Captures";
+  static constexpr const char* PresetFolder = "/home/mind/Presets";
 
-  juce::AudioProcessorValueTreeState::ParameterLayout createParameterLayout();
+  // The layout doesn't depend on the folders: selections are indices into the listings, which
+  // may hold up to maxLibrarySelections entries after "nothing selected"
+  static constexpr int maxLibrarySelections = 1024;
+  static juce::AudioProcessorValueTreeState::ParameterLayout createParameterLayout();
 
-  static void initModelNamesAndPaths();
-  static void initIrNamesAndPaths();
   static juce::StringArray getSortedNamModelNames(const juce::File& namFolder,
                                                   std::vector<juce::String>& modelPaths);
   static juce::StringArray getSortedIrNames(const juce::File& irFolder,
                                             std::vector<juce::String>& irPaths);
-  std::shared_ptr<nam::DSP> dsp;
-  std::mutex dspMutex;
-  std::atomic<bool> modelLoaded{false};
+
+  // Silence fed through a new model before it is swapped in. Long enough to settle the receptive
+  // field of the standard WaveNet presets (~4k samples) at 48 kHz.
+  static constexpr double modelWarmUpSeconds = 0.25;
+  void warmUpModel(nam::DSP& model, int blockSize) const;
+  std::unique_ptr<nam::DSP> createModel(const juce::File& file);
+
+  const Locations locations;  // Declared before the index, catalogues and recorder that use it
+
+  // Models, IR engines and scratch buffers, under NEURALAMP_MEMORY_CAP_MB; pre-faulted and locked
+  // with NEURALAMP_LOCK_MEMORY (embedded builds). Declared before everything that uses it.
+  static constexpr size_t memoryCapBytes = size_t{NEURALAMP_MEMORY_CAP_MB} << 20;
+  MemoryArena memoryArena{memoryCapBytes, NEURALAMP_LOCK_MEMORY != 0};
+  bool pinModel(const nam::DSP& model);
+  void logMemoryUsage() const;
+
+  // One model per blend slot. The audio thread only ever reads activeDsps, so it takes no lock. A
+  // model replaced by publishModel() is freed on the publishing thread once no block can still be
+  // running it.
+  static constexpr size_t numModelSlots = ModelBlender::numSlots;
+  std::array<std::unique_ptr<nam::DSP>, numModelSlots> dsps;
+  std::mutex dspMutex;  // Between non-audio threads only
+  std::array<std::atomic<nam::DSP*>, numModelSlots> activeDsps{};
+  std::atomic<juce::uint32> audioBlockSequence{0};  // Odd while processBlock runs
+  void publishModel(std::unique_ptr<nam::DSP> model, ModelBlender::Slot slot);
+  std::array<std::atomic<bool>, numModelSlots> modelLoaded{};
+  ModelBlender modelBlender;
   std::atomic<bool> irLoaded{false};
   std::atomic<bool> normalizeIr{true};
 
-  // cache
-  float cInputLevel;
-  float cOutputLevel;
-  float cToneBass;
-  float cToneMid;
-  float cToneTreble;
-  bool cEqToggle;
-  bool cNoiseGateToggle;
-  float cNoiseGateThreshold;
-  int cSelectedNamModel;
-  int cSelectedIR;
-  bool cIrToggle;
-  bool cNormalizeNamOutput;
-  bool cNormalizeIrOutput;
-  float cTargetLoudness;
-
-  void updateCachedParameters();
-
-  juce::LinearSmoothedValue<float> normalizationGainSmoother;
+  ParameterSnapshot parameterSnapshot;
+  float noiseGateThresholdGain = 1.0f;
+  void applyParameterChanges(ParameterSnapshot::Mask changed);
+
+  // Continuous parameters ramp to each new value instead of stepping once per block
+  static constexpr double levelRampSeconds = 0.02;
+  static constexpr double toneRampSeconds = 0.05;
+  static constexpr double normalizationRampSeconds = 0.05;
+  SmoothedGain inputGain;
+  SmoothedGain outputGain;
+  juce::LinearSmoothedValue<float> bassKnob;
+  juce::LinearSmoothedValue<float> midKnob;
+  juce::LinearSmoothedValue<float> trebleKnob;
+  void updateToneStack();
+  void resetFilterChain();
+  void processChunk(juce::dsp::AudioBlock<float>& block, const ModelBlender::Models& models);
+
+  SubBlockScheduler subBlockScheduler;
+  std::atomic<int> modelBlockSize{SubBlockScheduler::defaultChunkSize};
+
+  SmoothedGain normalizationGain;
+
+  static constexpr double recoveryRampSeconds = 0.05;
+  SignalGuard modelGuard;
+  SignalGuard chainGuard;
+  ModelBlender::Models faultedDsps{};  // Muted until the loader replaces them. Audio thread only.
+  std::atomic<int> modelResetPending{0};  // One bit per slot
+  // Faults in a row for the model in each slot; guarded by modelLoadLock
+  struct ModelFaults {
+    int count = 0;
+    bool retryPending = false;
+    juce::uint32 retryAtMs = 0;
+    juce::uint32 reloadedAtMs = 0;
+  };
+  std::array<ModelFaults, numModelSlots> modelFaults;
+  std::atomic<int> faultedModelSlots{0};  // Given up on; one bit per slot
+  void clearModelFaults(ModelBlender::Slot slot);
+
+  CaptureRecorder captureRecorder{locations.captureFolder};
+  std::atomic<float>* captureEnabled = nullptr;
+  std::atomic<float>* captureOutput = nullptr;
+  std::atomic<float>* captureFormat = nullptr;
+
+  Telemetry telemetry;
+  juce::AudioProcessLoadMeasurer loadMeasurer;
+
+  // Measured-output loudness normalisation
+  static constexpr float minMeasuredLoudnessSeconds = 3.0f;
+  static constexpr float cacheLoudnessAfterSeconds = 10.0f;
+  static constexpr double loudnessConvergenceSeconds = 2.0;
+  static constexpr float maxNormalizationDb = 24.0f;
+  static constexpr juce::uint32 libraryIndexSaveIntervalMs = 30000;
+
+  float getInitialLoudness(const juce::File& modelFile, nam::DSP& model);
+  // The slot heard on its own, when only one model is loaded or the blend sits at one end. Only
+  // then does the measured loudness belong to one model file.
+  std::optional<ModelBlender::Slot> getSoloModelSlot() const;
+
+  // Quantised models must match the float model to within this error-to-signal ratio
+  static constexpr double maxQuantisationEsr = 1e-3;
+  std::unique_ptr<nam::DSP> applyInferenceMode(const juce::File& modelFile,
+                                               std::unique_ptr<nam::DSP> model);
+  // The SIMD engines only differ from NAM's Eigen path by rounding
+  static constexpr double maxSimdEsr = 1e-6;
+  std::unique_ptr<nam::DSP> applySimdEngine(const juce::File& modelFile,
+                                            std::unique_ptr<nam::DSP> model);
+  std::atomic<int> modelReloadPending{0};  // One bit per slot
+  static bool consumeSlotFlag(std::atomic<int>& flags, ModelBlender::Slot slot) {
+    const int bit = 1 << slot;
+    return (flags.fetch_and(~bit) & bit) != 0;
+  }
+
+  LoudnessMeter outputLoudnessMeter;
+  LoudnessMeter modelLoudnessMeter;  // Before the IR, for the library index
+  float loudnessEstimate = std::numeric_limits<float>::quiet_NaN();  // Audio thread only
+  std::atomic<float> pendingModelLoudness{std::numeric_limits<float>::quiet_NaN()};
+  std::atomic<bool> modelLoudnessPending{false};
+  std::atomic<bool> loudnessResetPending{false};
+  std::atomic<float> publishedLoudness{-std::numeric_limits<float>::infinity()};
+  std::atomic<float> publishedLoudnessSeconds{0.0f};
+
+  LibraryIndex libraryIndex{locations.libraryIndexFile};
+  LibraryCatalogue modelCatalogue{LibraryCatalogue::Kind::model, locations.namFolder,
+                                  libraryIndex};
+  LibraryCatalogue irCatalogue{LibraryCatalogue::Kind::impulseResponse, locations.irFolder,
+                               libraryIndex};
+  juce::CriticalSection requestLock;
+  std::array<std::optional<juce::String>, numModelSlots> requestedModelIds;
+  std::array<std::optional<juce::String>, DualIrConvolver::numSlots> requestedIrIds;
+  std::array<juce::File, numModelSlots> currentModelFiles;  // Loader thread only
+  juce::uint32 lastLibraryIndexSave = 0;
 
   juce::dsp::ProcessorDuplicator<juce::dsp::IIR::Filter<float>, juce::dsp::IIR::Coefficients<float>>
       dcBlockerLeft;
   juce::dsp::ProcessorDuplicator<juce::dsp::IIR::Filter<float>, juce::dsp::IIR::Coefficients<float>>
       dcBlockerRight;
 
-  juce::dsp::Convolution irConvolverLeft;
-  juce::dsp::Convolution irConvolverRight;
+  // Both cabinet IRs, blended by irBlend and lined up by irAlign
+  DualIrConvolver irConvolver{&memoryArena};
   bool irEnabled = true;
 
-  static juce::StringArray modelNames;
-  static juce::StringArray irNames;
-  static std::vector<juce::String> modelPathsByIndex;
-  static std::vector<juce::String> irPathsByIndex;
-  static bool modelPathsInitialized;
-  static bool irPathsInitialized;
-  int currentModelIndex = -1;  // -1 = "No Model"
-  int currentIrIndex = -1;     // -1 = "No Model"
+  static juce::CriticalSection listingLock;  // Guards the pointers, not the listings
+  static std::shared_ptr<const LibraryListing> modelListing;
+  static std::shared_ptr<const LibraryListing> irListing;
+  static std::atomic<int> listingGeneration;
+  static juce::CriticalSection scanLock;
+  static bool librariesScanned;
+  std::array<std::atomic<int>, numModelSlots> currentModelIndices{-1, -1};  // -1 = "No Model"
+  std::array<std::atomic<int>, numModelSlots> attemptedModelIndices{-1, -1};
+  std::atomic<int> refusedModelSlots{0};  // One bit per slot
+  std::array<std::atomic<int>, DualIrConvolver::numSlots> currentIrIndices{-1, -1};  // -1 = "No IR"
+  std::array<std::atomic<int>, DualIrConvolver::numSlots> attemptedIrIndices{-1, -1};
   juce::CriticalSection modelLoadLock;
   juce::CriticalSection irLoadLock;
 
-  juce::dsp::ProcessorDuplicator<juce::dsp::IIR::Filter<float>, juce::dsp::IIR::Coefficients<float>>
-      bassFilter;
-  juce::dsp::ProcessorDuplicator<juce::dsp::IIR::Filter<float>, juce::dsp::IIR::Coefficients<float>>
-      midFilter;
-  juce::dsp::ProcessorDuplicator<juce::dsp::IIR::Filter<float>, juce::dsp::IIR::Coefficients<float>>
-      trebleFilter;
+  // Bass, mid and treble, voiced by toneStackModel
+  ToneStack toneStack;
 
   std::unique_ptr<juce::dsp::Oversampling<float>> oversampler;
+  static std::unique_ptr<juce::dsp::Oversampling<float>> createOversampler(bool liveMonitoring);
+  int getChainLatencyInSamples(bool liveMonitoring) const;
   juce::AudioBuffer<float> oversampleBuffer;
   double modelSampleRate = 48000.0;  // Default, updated dynamically in prepareToPlay
   bool bypassResampling = true;      // Default to bypass unless model requires specific rate
 
+  ControlServer controlServer{*this};
+
+  // Declared last so it is stopped before anything it touches is destroyed
+  LoaderThread loaderThread{*this};
+
   JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(NeuralAmpProcessor)
 };
\ No newline at end of file
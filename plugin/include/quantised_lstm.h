@@ -0,0 +1,97 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <vector>
+#include "NAM/dsp.h"
+#include "memory_arena.h"
+
+// Float LSTM weights in the order NAM serialises them in a .nam file
+struct LstmWeights {
+  struct Layer {
+    int inputSize = 0;
+    int hiddenSize = 0;
+    std::vector<float> weights;  // (4 * hiddenSize) x (inputSize + hiddenSize), row-major
+    std::vector<float> bias;     // 4 * hiddenSize, gates ordered i, f, g, o
+    std::vector<float> initialHidden;
+    std::vector<float> initialCell;
+  };
+
+  std::vector<Layer> layers;
+  std::vector<float> headWeight;
+  float headBias = 0.0f;
+
+  // Returns std::nullopt for other architectures or malformed files
+  static std::optional<LstmWeights> fromNamFile(const std::filesystem::path& path);
+};
+
+enum class WeightFormat { int8, int16 };
+
+// Building blocks shared by the quantised models. Matrices are quantised with one float scale per
+// row, so row r of the matrix is about scales[r] * weights[r]; activation vectors get one int16
+// scale for the whole vector, which quantiseActivations() returns.
+template <typename WeightType>
+void quantiseRows(const std::vector<float>& matrix,
+                  int rows,
+                  int columns,
+                  std::vector<WeightType>& weights,
+                  std::vector<float>& scales);
+float quantiseActivations(const float* x, int n, std::int16_t* quantised);
+// Integer dot products; NEON widening multiply-accumulates on aarch64
+std::int64_t quantisedDot(const std::int8_t* weights, const std::int16_t* x, int n);
+std::int64_t quantisedDot(const std::int16_t* weights, const std::int16_t* x, int n);
+
+extern template void quantiseRows<std::int8_t>(const std::vector<float>&, int, int,
+                                               std::vector<std::int8_t>&, std::vector<float>&);
+extern template void quantiseRows<std::int16_t>(const std::vector<float>&, int, int,
+                                                std::vector<std::int16_t>&, std::vector<float>&);
+
+// LSTM inference with weights quantised per gate row (int8 or int16 with a float scale per row)
+// and the [x, h] activations quantised to int16 per step. The matmuls run as integer dot products,
+// which halves (int16) or quarters (int8) the weight memory traffic that dominates on the
+// Cortex-A72. Gate nonlinearities and the cell state stay in float.
+template <typename WeightType>
+class QuantisedLstm : public nam::DSP, public ResidentModel {
+public:
+  QuantisedLstm(const LstmWeights& weights, double expectedSampleRate);
+
+  void process(NAM_SAMPLE* input, NAM_SAMPLE* output, const int num_frames) override;
+  void forEachBuffer(const MemoryArena::BufferVisitor& visit) const override;
+
+private:
+  struct Layer {
+    int inputSize = 0;
+    int hiddenSize = 0;
+    std::vector<WeightType> weights;
+    std::vector<float> rowScales;
+    std::vector<float> bias;
+    std::vector<float> xh;  // [input, hidden]
+    std::vector<float> cell;
+    std::vector<std::int16_t> xhQuantised;
+    std::vector<float> gates;
+  };
+
+  float processSample(float x);
+  static void processLayer(Layer& layer, const float* input);
+
+  std::vector<Layer> layers;
+  std::vector<float> headWeight;
+  float headBias = 0.0f;
+};
+
+extern template class QuantisedLstm<std::int8_t>;
+extern template class QuantisedLstm<std::int16_t>;
+
+// Error-to-signal ratio of candidate against reference on a fixed guitar-like test signal, after
+// settling both on silence. Both models are run from their current state; reset them afterwards.
+double measureEsr(nam::DSP& reference, nam::DSP& candidate);
+
+// Builds a quantised version of an LSTM or WaveNet .nam file (see QuantisedWaveNet) and checks it
+// against the float reference. Returns nullptr (and leaves the measured ESR in esr, or NaN) if the
+// architecture isn't covered or the quantised model doesn't match the reference within maxEsr.
+std::unique_ptr<nam::DSP> makeQuantisedModel(const std::filesystem::path& path,
+                                             WeightFormat format,
+                                             nam::DSP& reference,
+                                             double maxEsr,
+                                             double& esr);
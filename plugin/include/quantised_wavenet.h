@@ -0,0 +1,67 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <vector>
+#include "NAM/dsp.h"
+#include "memory_arena.h"
+#include "quantised_lstm.h"
+#include "simd_engines.h"
+
+// WaveNet inference with the dilated convs and 1x1s quantised per output row (int8 or int16 with a
+// float scale per row). Each layer's conv taps are gathered into one int16 vector per sample, so a
+// conv row is a single integer dot product across every tap. The rechannels, the input mixin, the
+// activations and the head stay in float; they are a small share of the weights.
+template <typename WeightType>
+class QuantisedWaveNet : public nam::DSP, public ResidentModel {
+public:
+  QuantisedWaveNet(const WaveNetWeights& weights, double expectedSampleRate);
+
+  void process(NAM_SAMPLE* input, NAM_SAMPLE* output, const int num_frames) override;
+  void forEachBuffer(const MemoryArena::BufferVisitor& visit) const override;
+
+private:
+  struct Layer {
+    int dilation = 1;
+    int historyLength = 1;  // (kernelSize - 1) * dilation + 1
+    int position = 0;
+    std::vector<WeightType> conv;  // convRows x (kernelSize x channels), oldest tap first
+    std::vector<float> convScales;
+    std::vector<float> convBias;
+    std::vector<float> mixin;
+    std::vector<WeightType> conv1x1;
+    std::vector<float> scales1x1;
+    std::vector<float> bias1x1;
+    std::vector<float> history;  // historyLength x channels ring of the layer's inputs
+  };
+
+  struct LayerArray {
+    WaveNetWeights::LayerArray config;
+    std::vector<Layer> layers;
+    std::vector<float> taps;  // kernelSize x channels
+    std::vector<std::int16_t> tapsQuantised;
+    std::vector<float> z;  // convRows
+    std::vector<std::int16_t> zQuantised;
+    std::vector<float> head;    // channels
+    std::vector<float> output;  // channels; each layer's input, then the array's output
+    std::vector<float> headOutput;
+  };
+
+  float processSample(float x);
+  void processArray(LayerArray& array, const float* input, const float* headInput, float x);
+  static void processLayer(LayerArray& array, Layer& layer, float x);
+  static void applyActivation(const WaveNetWeights::LayerArray& config, float* z);
+
+  std::vector<LayerArray> arrays;
+  float headScale = 1.0f;
+};
+
+extern template class QuantisedWaveNet<std::int8_t>;
+extern template class QuantisedWaveNet<std::int16_t>;
+
+// makeQuantisedModel() for WaveNet files
+std::unique_ptr<nam::DSP> makeQuantisedWaveNet(const std::filesystem::path& path,
+                                               WeightFormat format,
+                                               nam::DSP& reference,
+                                               double maxEsr,
+                                               double& esr);
@@ -0,0 +1,64 @@
+#pragma once
+#include <array>
+#include <string>
+#include <vector>
+
+// Catches what the audio thread must never do: allocate or free memory, block on a mutex or touch
+// files. Linking neuralamp_realtime_audit replaces malloc/free, pthread_mutex_lock and open/read/
+// write for the whole executable, and every call made inside a ScopedSection is counted against
+// the call site that made it. That works for executables on glibc, such as the tests and soak
+// runs; elsewhere, or when the library ends up inside a dlopen()ed plugin, nothing is counted.
+//
+// Configure with NEURALAMP_RT_AUDIT=ON to have processBlock() open a section itself.
+enum class RealtimeViolation { allocation, deallocation, lock, fileIo };
+
+class RealtimeAudit {
+public:
+  static constexpr int numViolationKinds = 4;
+
+  enum class Mode {
+    count,  // Record and carry on
+    trap    // Record, then raise SIGTRAP so a debugger stops at the offending call
+  };
+
+  struct CallSite {
+    RealtimeViolation kind;
+    int hits = 0;
+    std::vector<std::string> frames;  // Innermost first
+  };
+
+  struct Report {
+    std::array<int, numViolationKinds> counts{};
+    std::vector<CallSite> callSites;
+
+    int getTotal() const;
+    std::string toString() const;
+  };
+
+  static bool isSupported();
+  static void setMode(Mode mode);
+  static void reset();
+  // Symbolises the recorded call sites, which allocates: call it outside any section
+  static Report getReport();
+
+  static const char* getViolationName(RealtimeViolation kind);
+
+  // Marks the calling thread as realtime for the lifetime of the object. Sections nest.
+  class ScopedSection {
+  public:
+    ScopedSection();
+    ~ScopedSection();
+
+    ScopedSection(const ScopedSection&) = delete;
+    ScopedSection& operator=(const ScopedSection&) = delete;
+
+  private:
+    bool wasInSection;
+  };
+};
+
+#if NEURALAMP_RT_AUDIT
+#define NEURALAMP_REALTIME_SECTION RealtimeAudit::ScopedSection realtimeAuditSection
+#else
+#define NEURALAMP_REALTIME_SECTION
+#endif
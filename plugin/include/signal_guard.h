@@ -0,0 +1,31 @@
+#pragma once
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <juce_dsp/juce_dsp.h>
+#include <atomic>
+#include "smoothed_gain.h"
+
+// Catches NaN and infinity leaving a processing stage before recursive state downstream (IIR
+// filters, convolver history) can recirculate it forever. A faulty block is silenced and the
+// stage muted; the owner resets the stage's state and calls recover() to fade it back in.
+class SignalGuard {
+public:
+  void prepare(double sampleRate, double rampSeconds);
+
+  // Audio thread. Silences the block and mutes the stage if any sample is NaN or infinite.
+  bool clearIfNonFinite(juce::dsp::AudioBlock<float>& block);
+  // Audio thread. The same for a stage that failed some other way, such as by throwing.
+  void clear(juce::dsp::AudioBlock<float>& block);
+  void recover() { gain.setTargetGain(1.0f); }
+  // Applies the mute or fade-in; free once the stage has fully recovered
+  void apply(juce::dsp::AudioBlock<float>& block);
+
+  juce::uint32 getFaultCount() const { return faults.load(std::memory_order_relaxed); }
+
+  // Tests the exponent bits with integer operations, so the loop vectorises and still works
+  // when the build enables -ffast-math
+  static bool containsNonFinite(const float* samples, size_t numSamples);
+
+private:
+  SmoothedGain gain;
+  std::atomic<juce::uint32> faults{0};
+};
@@ -0,0 +1,138 @@
+#pragma once
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <vector>
+#include "NAM/dsp.h"
+#include "memory_arena.h"
+#include "quantised_lstm.h"
+#include "simd_kernels.h"
+
+// Float LSTM running its gate matmuls and cell updates on the dispatched SIMD kernels
+class LstmEngine : public nam::DSP, public ResidentModel {
+public:
+  LstmEngine(const LstmWeights& weights,
+             double expectedSampleRate,
+             const SimdKernels& kernels = getSimdKernels());
+
+  void process(NAM_SAMPLE* input, NAM_SAMPLE* output, const int num_frames) override;
+  void forEachBuffer(const MemoryArena::BufferVisitor& visit) const override;
+
+private:
+  struct Layer {
+    int inputSize = 0;
+    int hiddenSize = 0;
+    std::vector<float> weights;  // Column-major, for SimdKernels::gemv
+    std::vector<float> bias;
+    std::vector<float> xh;  // [input, hidden]
+    std::vector<float> cell;
+    std::vector<float> gates;
+  };
+
+  float processSample(float x);
+
+  const SimdKernels& kernels;
+  std::vector<Layer> layers;
+  std::vector<float> headWeight;
+  float headBias = 0.0f;
+};
+
+// WaveNet weights in the order NAM serialises them in a .nam file. Conv taps are stored as one
+// row-major (out x in) matrix per tap, like NAM's Conv1D.
+struct WaveNetWeights {
+  enum class Activation { tanh, sigmoid, relu, hardtanh };
+
+  struct Layer {
+    int dilation = 1;
+    std::vector<float> conv;  // kernelSize x (convRows x channels)
+    std::vector<float> convBias;
+    std::vector<float> mixin;  // convRows x conditionSize
+    std::vector<float> conv1x1;
+    std::vector<float> bias1x1;
+  };
+
+  struct LayerArray {
+    int inputSize = 0;
+    int conditionSize = 0;
+    int headSize = 0;
+    int channels = 0;
+    int kernelSize = 0;
+    bool gated = false;
+    Activation activation = Activation::tanh;
+    std::vector<float> rechannel;  // channels x inputSize
+    std::vector<Layer> layers;
+    std::vector<float> headRechannel;  // headSize x channels
+    std::vector<float> headBias;       // Empty if the array has no head bias
+
+    int convRows() const { return gated ? 2 * channels : channels; }
+  };
+
+  std::vector<LayerArray> arrays;
+  float headScale = 1.0f;
+
+  // Returns std::nullopt for other architectures, configurations this engine doesn't cover (a
+  // post-head network, other activations) or malformed files
+  static std::optional<WaveNetWeights> fromNamFile(const std::filesystem::path& path);
+};
+
+// WaveNet with runtime-sized layers. Signals are kept channel-major so every conv tap, input mixin
+// and 1x1 is one SimdKernels::matmulAccumulate across the whole block.
+class WaveNetEngine : public nam::DSP, public ResidentModel {
+public:
+  WaveNetEngine(const WaveNetWeights& weights,
+                double expectedSampleRate,
+                const SimdKernels& kernels = getSimdKernels());
+
+  void process(NAM_SAMPLE* input, NAM_SAMPLE* output, const int num_frames) override;
+  void forEachBuffer(const MemoryArena::BufferVisitor& visit) const override;
+
+  // Samples of history the output depends on
+  int getReceptiveField() const { return receptiveField; }
+
+private:
+  // Frames per internal pass; longer host blocks are split
+  static constexpr int maxFrames = 256;
+  // Columns each layer's input history can advance before it is rewound to the start
+  static constexpr int historyLength = 2048;
+
+  struct Layer {
+    WaveNetWeights::Layer weights;
+    int lookBack = 0;  // (kernelSize - 1) * dilation
+    int stride = 0;    // lookBack + historyLength
+    std::vector<float> input;  // channels x stride
+  };
+
+  struct LayerArray {
+    WaveNetWeights::LayerArray config;
+    std::vector<Layer> layers;
+    int position = 0;
+    std::vector<float> z;       // convRows x maxFrames
+    std::vector<float> head;    // channels x maxFrames
+    std::vector<float> output;  // channels x maxFrames
+    std::vector<float> headOutput;  // headSize x maxFrames
+  };
+
+  void processFrames(const NAM_SAMPLE* input, NAM_SAMPLE* output, int frames);
+  void processArray(LayerArray& array,
+                    const float* input,
+                    const float* headInput,
+                    int headInputRows,
+                    int frames);
+  void processLayer(LayerArray& array, Layer& layer, float* next, int nextStride, int frames);
+  void applyActivation(const WaveNetWeights::LayerArray& config, float* z, int frames) const;
+
+  const SimdKernels& kernels;
+  std::vector<LayerArray> arrays;
+  float headScale = 1.0f;
+  int receptiveField = 1;
+  std::vector<float> condition;  // 1 x maxFrames
+};
+
+// Builds the SIMD engine for an LSTM or WaveNet .nam file (the specialised engine when the file
+// is one of the standard trainer architectures) and checks it against NAM's own model. Returns
+// nullptr (and leaves the measured ESR in esr, or NaN) if the architecture isn't covered or the
+// outputs don't match within maxEsr.
+std::unique_ptr<nam::DSP> makeSimdModel(const std::filesystem::path& path,
+                                        nam::DSP& reference,
+                                        double maxEsr,
+                                        double& esr);
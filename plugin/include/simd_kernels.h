@@ -0,0 +1,43 @@
+#pragma once
+#include <vector>
+
+// Hot loops of the NAM layers, compiled once per instruction set and picked at runtime from the
+// features of the CPU we are running on, so one binary runs the best variant on any machine.
+//
+// Matrices are row-major. Signals are channel-major: each channel is a contiguous run of frames
+// and consecutive channels are `stride` floats apart, so every kernel vectorises across frames or
+// rows regardless of how few channels a layer has.
+struct SimdKernels {
+  const char* name;
+
+  // y = bias + W x for a column-major W (rows contiguous per column), as used by the LSTM gates.
+  // bias may be nullptr.
+  void (*gemv)(const float* w, const float* x, const float* bias, float* y, int rows, int cols);
+
+  // out[r][f] += sum_c W[r][c] * in[c][f] for f in [0, frames). One call per dilated conv tap,
+  // input mixin or 1x1.
+  void (*matmulAccumulate)(const float* w,
+                           int rows,
+                           int cols,
+                           const float* in,
+                           int inStride,
+                           float* out,
+                           int outStride,
+                           int frames);
+
+  // LSTM cell update from pre-activation gates ordered [i, f, g, o]
+  void (*lstmPointwise)(const float* gates, float* cell, float* hidden, int hiddenSize);
+
+  // In-place activations
+  void (*tanh)(float* x, int n);
+  void (*sigmoid)(float* x, int n);
+};
+
+const SimdKernels& getScalarKernels();
+
+// Variants compiled into this binary and supported by the running CPU, scalar first and the
+// preferred one last
+std::vector<const SimdKernels*> getSupportedKernels();
+
+// The preferred supported variant, detected once
+const SimdKernels& getSimdKernels();
@@ -0,0 +1,34 @@
+#pragma once
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <juce_dsp/juce_dsp.h>
+#include <array>
+
+// Gain stage that ramps linearly to each new target. Level parameters are converted from dB once
+// per change, and apply() multiplies whole segments with vector operations: the ramp for a
+// segment is written to a buffer first, and once it's done the rest of the block is a constant
+// multiply. Nothing in apply() branches per sample.
+class SmoothedGain {
+public:
+  // A change of target takes rampSeconds to arrive
+  void prepare(double sampleRate, double rampSeconds);
+
+  void setTargetDecibels(float decibels);
+  void setTargetGain(float gain);
+  void snapToTarget();
+
+  float getTargetGain() const { return target; }
+  bool isSmoothing() const { return remaining > 0; }
+
+  void apply(juce::dsp::AudioBlock<float>& block);
+
+private:
+  // Ramp samples computed per segment; longer blocks ramp in several segments
+  static constexpr int maxSegmentLength = 256;
+
+  float current = 1.0f;
+  float target = 1.0f;
+  float step = 0.0f;
+  int rampLength = 0;
+  int remaining = 0;
+  std::array<float, maxSegmentLength> ramp{};
+};
@@ -0,0 +1,37 @@
+#pragma once
+#include <memory>
+#include "NAM/dsp.h"
+#include "quantised_lstm.h"
+#include "simd_engines.h"
+
+// The standard NAM trainer architectures, which cover most captures in the wild
+enum class SpecialisedArchitecture {
+  none,
+  wavenetStandard,
+  wavenetLite,
+  wavenetFeather,
+  wavenetNano,
+  lstm1x8,
+  lstm1x12,
+  lstm1x16,
+  lstm1x24,
+  lstm1x32,
+  lstm2x8,
+  lstm2x16,
+};
+
+const char* getArchitectureName(SpecialisedArchitecture architecture);
+
+// The architecture the weights match exactly (every size, dilation, activation and bias), or none
+SpecialisedArchitecture findSpecialisedArchitecture(const WaveNetWeights& weights);
+SpecialisedArchitecture findSpecialisedArchitecture(const LstmWeights& weights);
+
+// Engines with every channel count, dilation and kernel size fixed at compile time, so the layer
+// loops unroll completely and each layer's conv output for a block of frames stays in registers.
+// They are built once per instruction set, like the SIMD kernels, and the variant matching
+// getSimdKernels() is used. Return nullptr when the weights aren't one of the specialised
+// architectures.
+std::unique_ptr<nam::DSP> makeSpecialisedModel(const WaveNetWeights& weights,
+                                               double expectedSampleRate);
+std::unique_ptr<nam::DSP> makeSpecialisedModel(const LstmWeights& weights,
+                                               double expectedSampleRate);
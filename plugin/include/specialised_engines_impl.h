@@ -0,0 +1,581 @@
+#pragma once
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <utility>
+#include "specialised_engines.h"
+
+#if defined(__AVX512F__) || defined(__AVX2__) || defined(__SSE2__) || defined(_M_X64)
+#include <immintrin.h>
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#include <arm_neon.h>
+#endif
+
+// Compile-time sized engines behind makeSpecialisedModel(). This header is compiled once per
+// instruction set (src/specialised_engines*.cpp) and picks its vector type from the flags that
+// translation unit is built with. Everything lives in an unnamed namespace so each translation
+// unit gets its own copy and the linker can never merge an AVX-512 build of a function into the
+// baseline one; for the same reason the hot code sticks to intrinsics and plain arrays rather than
+// inline library templates.
+namespace {
+namespace specialised {
+#if defined(__AVX512F__)
+using Vec = __m512;
+constexpr int width = 16;
+inline Vec load(const float* p) { return _mm512_loadu_ps(p); }
+inline void store(float* p, Vec v) { _mm512_storeu_ps(p, v); }
+inline Vec broadcast(float x) { return _mm512_set1_ps(x); }
+inline Vec add(Vec a, Vec b) { return _mm512_add_ps(a, b); }
+inline Vec sub(Vec a, Vec b) { return _mm512_sub_ps(a, b); }
+inline Vec mul(Vec a, Vec b) { return _mm512_mul_ps(a, b); }
+inline Vec div(Vec a, Vec b) { return _mm512_div_ps(a, b); }
+inline Vec fmadd(Vec a, Vec b, Vec c) { return _mm512_fmadd_ps(a, b, c); }
+inline Vec minimum(Vec a, Vec b) { return _mm512_min_ps(a, b); }
+inline Vec maximum(Vec a, Vec b) { return _mm512_max_ps(a, b); }
+inline Vec roundNearest(Vec x) {
+  return _mm512_roundscale_ps(x, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+}
+inline Vec scaleByPow2(Vec x, Vec n) { return _mm512_scalef_ps(x, n); }
+#elif defined(__AVX2__)
+using Vec = __m256;
+constexpr int width = 8;
+inline Vec load(const float* p) { return _mm256_loadu_ps(p); }
+inline void store(float* p, Vec v) { _mm256_storeu_ps(p, v); }
+inline Vec broadcast(float x) { return _mm256_set1_ps(x); }
+inline Vec add(Vec a, Vec b) { return _mm256_add_ps(a, b); }
+inline Vec sub(Vec a, Vec b) { return _mm256_sub_ps(a, b); }
+inline Vec mul(Vec a, Vec b) { return _mm256_mul_ps(a, b); }
+inline Vec div(Vec a, Vec b) { return _mm256_div_ps(a, b); }
+inline Vec fmadd(Vec a, Vec b, Vec c) { return _mm256_fmadd_ps(a, b, c); }
+inline Vec minimum(Vec a, Vec b) { return _mm256_min_ps(a, b); }
+inline Vec maximum(Vec a, Vec b) { return _mm256_max_ps(a, b); }
+inline Vec roundNearest(Vec x) {
+  return _mm256_round_ps(x, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+}
+inline Vec scaleByPow2(Vec x, Vec n) {
+  const __m256i exponent =
+      _mm256_slli_epi32(_mm256_add_epi32(_mm256_cvtps_epi32(n), _mm256_set1_epi32(127)), 23);
+  return _mm256_mul_ps(x, _mm256_castsi256_ps(exponent));
+}
+#elif defined(__SSE2__) || defined(_M_X64)
+using Vec = __m128;
+constexpr int width = 4;
+inline Vec load(const float* p) { return _mm_loadu_ps(p); }
+inline void store(float* p, Vec v) { _mm_storeu_ps(p, v); }
+inline Vec broadcast(float x) { return _mm_set1_ps(x); }
+inline Vec add(Vec a, Vec b) { return _mm_add_ps(a, b); }
+inline Vec sub(Vec a, Vec b) { return _mm_sub_ps(a, b); }
+inline Vec mul(Vec a, Vec b) { return _mm_mul_ps(a, b); }
+inline Vec div(Vec a, Vec b) { return _mm_div_ps(a, b); }
+inline Vec fmadd(Vec a, Vec b, Vec c) { return _mm_add_ps(_mm_mul_ps(a, b), c); }
+inline Vec minimum(Vec a, Vec b) { return _mm_min_ps(a, b); }
+inline Vec maximum(Vec a, Vec b) { return _mm_max_ps(a, b); }
+// SSE2 has no round instruction; the conversion rounds to nearest under the default MXCSR
+inline Vec roundNearest(Vec x) { return _mm_cvtepi32_ps(_mm_cvtps_epi32(x)); }
+inline Vec scaleByPow2(Vec x, Vec n) {
+  const __m128i exponent =
+      _mm_slli_epi32(_mm_add_epi32(_mm_cvtps_epi32(n), _mm_set1_epi32(127)), 23);
+  return _mm_mul_ps(x, _mm_castsi128_ps(exponent));
+}
+#elif defined(__aarch64__) || defined(_M_ARM64)
+using Vec = float32x4_t;
+constexpr int width = 4;
+inline Vec load(const float* p) { return vld1q_f32(p); }
+inline void store(float* p, Vec v) { vst1q_f32(p, v); }
+inline Vec broadcast(float x) { return vdupq_n_f32(x); }
+inline Vec add(Vec a, Vec b) { return vaddq_f32(a, b); }
+inline Vec sub(Vec a, Vec b) { return vsubq_f32(a, b); }
+inline Vec mul(Vec a, Vec b) { return vmulq_f32(a, b); }
+inline Vec div(Vec a, Vec b) { return vdivq_f32(a, b); }
+inline Vec fmadd(Vec a, Vec b, Vec c) { return vfmaq_f32(c, a, b); }
+inline Vec minimum(Vec a, Vec b) { return vminq_f32(a, b); }
+inline Vec maximum(Vec a, Vec b) { return vmaxq_f32(a, b); }
+inline Vec roundNearest(Vec x) { return vrndnq_f32(x); }
+inline Vec scaleByPow2(Vec x, Vec n) {
+  const int32x4_t exponent = vshlq_n_s32(vaddq_s32(vcvtq_s32_f32(n), vdupq_n_s32(127)), 23);
+  return vmulq_f32(x, vreinterpretq_f32_s32(exponent));
+}
+#else
+using Vec = float;
+constexpr int width = 1;
+inline Vec load(const float* p) { return *p; }
+inline void store(float* p, Vec v) { *p = v; }
+inline Vec broadcast(float x) { return x; }
+inline Vec add(Vec a, Vec b) { return a + b; }
+inline Vec sub(Vec a, Vec b) { return a - b; }
+inline Vec mul(Vec a, Vec b) { return a * b; }
+inline Vec div(Vec a, Vec b) { return a / b; }
+inline Vec fmadd(Vec a, Vec b, Vec c) { return a * b + c; }
+inline Vec minimum(Vec a, Vec b) { return a < b ? a : b; }
+inline Vec maximum(Vec a, Vec b) { return a > b ? a : b; }
+inline Vec roundNearest(Vec x) { return (x + 12582912.0f) - 12582912.0f; }  // 1.5 * 2^23
+inline Vec scaleByPow2(Vec x, Vec n) {
+  const int bits = (static_cast<int>(n) + 127) << 23;
+  float scale;
+  std::memcpy(&scale, &bits, sizeof(scale));
+  return x * scale;
+}
+#endif
+
+// Same expf approximation as the SIMD kernels
+inline Vec exp(Vec x) {
+  x = minimum(maximum(x, broadcast(-87.3f)), broadcast(88.3f));
+  const Vec n = roundNearest(mul(x, broadcast(1.44269504088896341f)));
+  x = sub(x, mul(n, broadcast(0.693359375f)));
+  x = sub(x, mul(n, broadcast(-2.12194440e-4f)));
+
+  Vec y = broadcast(1.9875691500e-4f);
+  y = fmadd(y, x, broadcast(1.3981999507e-3f));
+  y = fmadd(y, x, broadcast(8.3334519073e-3f));
+  y = fmadd(y, x, broadcast(4.1665795894e-2f));
+  y = fmadd(y, x, broadcast(1.6666665459e-1f));
+  y = fmadd(y, x, broadcast(5.0000001201e-1f));
+  y = fmadd(y, mul(x, x), add(x, broadcast(1.0f)));
+  return scaleByPow2(y, n);
+}
+
+inline Vec sigmoid(Vec x) {
+  const Vec one = broadcast(1.0f);
+  return div(one, add(one, exp(sub(broadcast(0.0f), x))));
+}
+
+// tanh(x) = 2 * sigmoid(2x) - 1
+inline Vec tanh(Vec x) {
+  const Vec two = broadcast(2.0f);
+  return sub(mul(two, sigmoid(mul(two, x))), broadcast(1.0f));
+}
+
+constexpr int kernelSize = 3;
+// Frames per fused pass through a layer, sized so a layer's conv output for the block stays in
+// registers
+constexpr int blockFrames = width >= 8 ? width : 8;
+constexpr int blockVectors = blockFrames / width;
+// Frames per pass through the network; longer host blocks are split
+constexpr int maxFrames = 256;
+// Columns each layer's input history can advance before it is rewound to the start
+constexpr int historyLength = 2048;
+
+// One WaveNet layer array: Tanh, ungated, kernel size 3, as the NAM trainer presets use
+template <int Channels, int HeadSize, bool HeadBias, int... Dilations>
+struct ArraySpec {
+  static constexpr int channels = Channels;
+  static constexpr int headSize = HeadSize;
+  static constexpr bool headBias = HeadBias;
+  static constexpr int numLayers = static_cast<int>(sizeof...(Dilations));
+  static constexpr int dilations[] = {Dilations...};
+
+  static bool matches(const WaveNetWeights::LayerArray& array, int inputSize) {
+    if (array.inputSize != inputSize || array.conditionSize != 1 || array.channels != channels ||
+        array.headSize != headSize || array.kernelSize != kernelSize || array.gated ||
+        array.activation != WaveNetWeights::Activation::tanh ||
+        array.headBias.empty() == headBias ||
+        static_cast<int>(array.layers.size()) != numLayers) {
+      return false;
+    }
+    for (int l = 0; l < numLayers; ++l) {
+      if (array.layers[static_cast<std::size_t>(l)].dilation != dilations[l])
+        return false;
+    }
+    return true;
+  }
+};
+
+template <typename Spec, int InputSize>
+class LayerArray {
+public:
+  static constexpr int channels = Spec::channels;
+  static constexpr int headSize = Spec::headSize;
+  static constexpr int numLayers = Spec::numLayers;
+
+  void setWeights(const WaveNetWeights::LayerArray& source) {
+    std::memcpy(rechannel, source.rechannel.data(), sizeof(rechannel));
+    for (int l = 0; l < numLayers; ++l) {
+      const auto& from = source.layers[static_cast<std::size_t>(l)];
+      auto& to = layers[l];
+      std::memcpy(to.conv, from.conv.data(), sizeof(to.conv));
+      std::memcpy(to.convBias, from.convBias.data(), sizeof(to.convBias));
+      std::memcpy(to.mixin, from.mixin.data(), sizeof(to.mixin));
+      std::memcpy(to.conv1x1, from.conv1x1.data(), sizeof(to.conv1x1));
+      std::memcpy(to.bias1x1, from.bias1x1.data(), sizeof(to.bias1x1));
+    }
+    std::memcpy(headRechannel, source.headRechannel.data(), sizeof(headRechannel));
+    if constexpr (Spec::headBias)
+      std::memcpy(headBias, source.headBias.data(), sizeof(headBias));
+  }
+
+  // input is InputSize x maxFrames and headInput channels x maxFrames (nullptr for the first
+  // array). paddedFrames is frames rounded up to blockFrames; the padding is computed but unused.
+  void process(const float* input,
+               const float* headInput,
+               const float* condition,
+               int paddedFrames,
+               int frames) {
+    if (position + paddedFrames > historyLength)
+      rewind();
+
+    float* first = history + offset(0) + lookBack(0) + position;
+    for (int c = 0; c < channels; ++c) {
+      float* row = first + c * stride(0);
+      for (int f = 0; f < paddedFrames; f += width) {
+        Vec acc = broadcast(0.0f);
+        for (int i = 0; i < InputSize; ++i)
+          acc = fmadd(broadcast(rechannel[c][i]), load(input + i * maxFrames + f), acc);
+        store(row + f, acc);
+      }
+    }
+
+    for (int c = 0; c < channels; ++c) {
+      for (int f = 0; f < paddedFrames; f += width)
+        store(&head[c][f], headInput != nullptr ? load(headInput + c * maxFrames + f)
+                                                : broadcast(0.0f));
+    }
+
+    processLayers(condition, paddedFrames, std::make_index_sequence<numLayers>{});
+
+    for (int h = 0; h < headSize; ++h) {
+      for (int f = 0; f < paddedFrames; f += width) {
+        Vec acc = broadcast(headBias[h]);
+        for (int c = 0; c < channels; ++c)
+          acc = fmadd(broadcast(headRechannel[h][c]), load(&head[c][f]), acc);
+        store(&headOutput[h][f], acc);
+      }
+    }
+
+    position += frames;
+  }
+
+  const float* getOutput() const { return &output[0][0]; }
+  const float* getHeadOutput() const { return &headOutput[0][0]; }
+
+  void forEachBuffer(const MemoryArena::BufferVisitor& visit) const {
+    visit(MemoryArena::modelWeights, rechannel, sizeof(rechannel));
+    visit(MemoryArena::modelWeights, layers, sizeof(layers));
+    visit(MemoryArena::modelWeights, headRechannel, sizeof(headRechannel));
+    visit(MemoryArena::modelWeights, headBias, sizeof(headBias));
+    visit(MemoryArena::modelBuffers, history, sizeof(history));
+    visit(MemoryArena::modelBuffers, head, sizeof(head));
+    visit(MemoryArena::modelBuffers, output, sizeof(output));
+    visit(MemoryArena::modelBuffers, headOutput, sizeof(headOutput));
+  }
+
+private:
+  struct LayerWeights {
+    float conv[kernelSize][channels][channels];
+    float convBias[channels];
+    float mixin[channels];
+    float conv1x1[channels][channels];
+    float bias1x1[channels];
+  };
+
+  static constexpr int lookBack(int layer) { return (kernelSize - 1) * Spec::dilations[layer]; }
+  static constexpr int stride(int layer) { return lookBack(layer) + historyLength; }
+  static constexpr std::size_t offset(int layer) {
+    std::size_t total = 0;
+    for (int l = 0; l < layer; ++l)
+      total += static_cast<std::size_t>(channels * stride(l));
+    return total;
+  }
+
+  void rewind() {
+    for (int l = 0; l < numLayers; ++l) {
+      for (int c = 0; c < channels; ++c) {
+        float* row = history + offset(l) + static_cast<std::size_t>(c * stride(l));
+        std::memmove(row, row + position, static_cast<std::size_t>(lookBack(l)) * sizeof(float));
+      }
+    }
+    position = 0;
+  }
+
+  template <std::size_t... Layers>
+  void processLayers(const float* condition, int frames, std::index_sequence<Layers...>) {
+    (processLayer<static_cast<int>(Layers)>(condition, frames), ...);
+  }
+
+  // Conv, input mixin, activation, head accumulation and 1x1 residual, fused per block of frames
+  template <int Layer>
+  void processLayer(const float* condition, int frames) {
+    constexpr int dilation = Spec::dilations[Layer];
+    constexpr int inputStride = stride(Layer);
+    constexpr bool isLast = Layer + 1 == numLayers;
+    constexpr int nextStride = isLast ? maxFrames : stride(isLast ? Layer : Layer + 1);
+    const LayerWeights& w = layers[Layer];
+    const float* input = history + offset(Layer) + lookBack(Layer) + position;
+    float* next = isLast ? &output[0][0]
+                         : history + offset(Layer + 1) + lookBack(isLast ? Layer : Layer + 1) +
+                               position;
+
+    for (int f0 = 0; f0 < frames; f0 += blockFrames) {
+      Vec z[channels][blockVectors];
+      for (int v = 0; v < blockVectors; ++v) {
+        const Vec x = load(condition + f0 + v * width);
+        for (int r = 0; r < channels; ++r)
+          z[r][v] = fmadd(broadcast(w.mixin[r]), x, broadcast(w.convBias[r]));
+      }
+
+      // Tap k reads dilation * (kernelSize - 1 - k) frames back
+      for (int k = 0; k < kernelSize; ++k) {
+        const float* tap = input + f0 - dilation * (kernelSize - 1 - k);
+        for (int c = 0; c < channels; ++c) {
+          for (int v = 0; v < blockVectors; ++v) {
+            const Vec x = load(tap + c * inputStride + v * width);
+            for (int r = 0; r < channels; ++r)
+              z[r][v] = fmadd(broadcast(w.conv[k][r][c]), x, z[r][v]);
+          }
+        }
+      }
+
+      for (int r = 0; r < channels; ++r) {
+        for (int v = 0; v < blockVectors; ++v) {
+          float* h = &head[r][f0 + v * width];
+          z[r][v] = tanh(z[r][v]);
+          store(h, add(load(h), z[r][v]));
+        }
+      }
+
+      // next = input + 1x1(z)
+      for (int r = 0; r < channels; ++r) {
+        for (int v = 0; v < blockVectors; ++v) {
+          Vec y = add(load(input + r * inputStride + f0 + v * width), broadcast(w.bias1x1[r]));
+          for (int c = 0; c < channels; ++c)
+            y = fmadd(broadcast(w.conv1x1[r][c]), z[c][v], y);
+          store(next + r * nextStride + f0 + v * width, y);
+        }
+      }
+    }
+  }
+
+  float rechannel[channels][InputSize];
+  LayerWeights layers[numLayers];
+  float headRechannel[headSize][channels];
+  float headBias[headSize] = {};
+  int position = 0;
+  alignas(64) float history[offset(numLayers)] = {};
+  alignas(64) float head[channels][maxFrames] = {};
+  alignas(64) float output[channels][maxFrames] = {};
+  alignas(64) float headOutput[headSize][maxFrames] = {};
+};
+
+// Two-array WaveNet, the shape of every trainer preset
+template <typename FirstSpec, typename SecondSpec>
+class WaveNet final : public nam::DSP, public ResidentModel {
+public:
+  WaveNet(const WaveNetWeights& weights, double expectedSampleRate)
+      : nam::DSP(expectedSampleRate), headScale(weights.headScale) {
+    first.setWeights(weights.arrays[0]);
+    second.setWeights(weights.arrays[1]);
+  }
+
+  static bool matches(const WaveNetWeights& weights) {
+    return weights.arrays.size() == 2 && FirstSpec::matches(weights.arrays[0], 1) &&
+           SecondSpec::matches(weights.arrays[1], FirstSpec::channels) &&
+           FirstSpec::headSize == SecondSpec::channels && SecondSpec::headSize == 1;
+  }
+
+  void process(NAM_SAMPLE* input, NAM_SAMPLE* output, const int num_frames) override {
+    for (int offset = 0; offset < num_frames; offset += maxFrames) {
+      const int frames = num_frames - offset < maxFrames ? num_frames - offset : maxFrames;
+      const int paddedFrames = (frames + blockFrames - 1) / blockFrames * blockFrames;
+      for (int f = 0; f < paddedFrames; ++f)
+        condition[f] = f < frames ? static_cast<float>(input[offset + f]) : 0.0f;
+
+      first.process(condition, nullptr, condition, paddedFrames, frames);
+      second.process(first.getOutput(), first.getHeadOutput(), condition, paddedFrames, frames);
+
+      const float* head = second.getHeadOutput();
+      for (int f = 0; f < frames; ++f)
+        output[offset + f] = static_cast<NAM_SAMPLE>(headScale * head[f]);
+    }
+  }
+
+  void forEachBuffer(const MemoryArena::BufferVisitor& visit) const override {
+    first.forEachBuffer(visit);
+    second.forEachBuffer(visit);
+    visit(MemoryArena::modelBuffers, condition, sizeof(condition));
+  }
+
+private:
+  LayerArray<FirstSpec, 1> first;
+  LayerArray<SecondSpec, FirstSpec::channels> second;
+  float headScale;
+  alignas(64) float condition[maxFrames] = {};
+};
+
+// The hidden state is padded to whole vectors. Padded units have zero weights, bias and initial
+// state, so they stay at zero and don't change the output.
+template <int NumLayers, int HiddenSize>
+class Lstm final : public nam::DSP, public ResidentModel {
+public:
+  Lstm(const LstmWeights& weights, double expectedSampleRate)
+      : nam::DSP(expectedSampleRate), headBias(weights.headBias) {
+    setLayerWeights(first, weights.layers[0]);
+    for (int l = 1; l < NumLayers; ++l)
+      setLayerWeights(rest[l - 1], weights.layers[static_cast<std::size_t>(l)]);
+    std::memcpy(headWeight, weights.headWeight.data(), sizeof(headWeight));
+  }
+
+  static bool matches(const LstmWeights& weights) {
+    if (static_cast<int>(weights.layers.size()) != NumLayers)
+      return false;
+    for (std::size_t l = 0; l < weights.layers.size(); ++l) {
+      if (weights.layers[l].hiddenSize != HiddenSize ||
+          weights.layers[l].inputSize != (l == 0 ? 1 : HiddenSize))
+        return false;
+    }
+    return true;
+  }
+
+  void process(NAM_SAMPLE* input, NAM_SAMPLE* output, const int num_frames) override {
+    for (int i = 0; i < num_frames; ++i) {
+      const auto x = static_cast<float>(input[i]);
+      step(first, &x);
+      const float* hidden = first.hidden;
+      for (int l = 0; l < NumLayers - 1; ++l) {
+        step(rest[l], hidden);
+        hidden = rest[l].hidden;
+      }
+
+      float y = headBias;
+      for (int h = 0; h < HiddenSize; ++h)
+        y += headWeight[h] * hidden[h];
+      output[i] = static_cast<NAM_SAMPLE>(y);
+    }
+  }
+
+  void forEachBuffer(const MemoryArena::BufferVisitor& visit) const override {
+    visitLayer(visit, first);
+    for (int l = 0; l < NumLayers - 1; ++l)
+      visitLayer(visit, rest[l]);
+    visit(MemoryArena::modelWeights, headWeight, sizeof(headWeight));
+  }
+
+private:
+  static constexpr int paddedHidden = (HiddenSize + width - 1) / width * width;
+  static constexpr int hiddenVectors = paddedHidden / width;
+  static constexpr int gateRows = 4 * paddedHidden;  // i, f, g, o, each paddedHidden long
+
+  template <int InputSize>
+  struct Layer {
+    static constexpr int columns = InputSize + HiddenSize;
+    alignas(64) float weights[columns][gateRows] = {};  // Column-major: one column per input
+    alignas(64) float bias[gateRows] = {};
+    alignas(64) float hidden[paddedHidden] = {};
+    alignas(64) float cell[paddedHidden] = {};
+  };
+
+  template <int InputSize>
+  static void visitLayer(const MemoryArena::BufferVisitor& visit, const Layer<InputSize>& layer) {
+    visit(MemoryArena::modelWeights, layer.weights, sizeof(layer.weights));
+    visit(MemoryArena::modelWeights, layer.bias, sizeof(layer.bias));
+    visit(MemoryArena::modelBuffers, layer.hidden, sizeof(layer.hidden));
+    visit(MemoryArena::modelBuffers, layer.cell, sizeof(layer.cell));
+  }
+
+  template <int InputSize>
+  static void setLayerWeights(Layer<InputSize>& layer, const LstmWeights::Layer& source) {
+    constexpr int columns = Layer<InputSize>::columns;
+    for (int gate = 0; gate < 4; ++gate) {
+      for (int unit = 0; unit < HiddenSize; ++unit) {
+        const int row = gate * HiddenSize + unit;
+        const int paddedRow = gate * paddedHidden + unit;
+        for (int c = 0; c < columns; ++c)
+          layer.weights[c][paddedRow] = source.weights[static_cast<std::size_t>(row * columns + c)];
+        layer.bias[paddedRow] = source.bias[static_cast<std::size_t>(row)];
+      }
+    }
+    std::memcpy(layer.hidden, source.initialHidden.data(), sizeof(float) * HiddenSize);
+    std::memcpy(layer.cell, source.initialCell.data(), sizeof(float) * HiddenSize);
+  }
+
+  template <int InputSize>
+  static void step(Layer<InputSize>& layer, const float* input) {
+    Vec gates[4 * hiddenVectors];
+    for (int v = 0; v < 4 * hiddenVectors; ++v)
+      gates[v] = load(layer.bias + v * width);
+    for (int c = 0; c < InputSize; ++c) {
+      const Vec x = broadcast(input[c]);
+      for (int v = 0; v < 4 * hiddenVectors; ++v)
+        gates[v] = fmadd(load(layer.weights[c] + v * width), x, gates[v]);
+    }
+    for (int c = 0; c < HiddenSize; ++c) {
+      const Vec h = broadcast(layer.hidden[c]);
+      for (int v = 0; v < 4 * hiddenVectors; ++v)
+        gates[v] = fmadd(load(layer.weights[InputSize + c] + v * width), h, gates[v]);
+    }
+
+    for (int v = 0; v < hiddenVectors; ++v) {
+      const Vec inputGate = sigmoid(gates[v]);
+      const Vec forgetGate = sigmoid(gates[v + hiddenVectors]);
+      const Vec candidate = tanh(gates[v + 2 * hiddenVectors]);
+      const Vec outputGate = sigmoid(gates[v + 3 * hiddenVectors]);
+      const Vec cell = fmadd(forgetGate, load(layer.cell + v * width), mul(inputGate, candidate));
+      store(layer.cell + v * width, cell);
+      store(layer.hidden + v * width, mul(outputGate, tanh(cell)));
+    }
+  }
+
+  Layer<1> first;
+  Layer<HiddenSize> rest[NumLayers > 1 ? NumLayers - 1 : 1];
+  float headWeight[HiddenSize];
+  float headBias;
+};
+
+// NAM trainer presets (nam.models.wavenet "standard", "lite", "feather" and "nano")
+using StandardWaveNet =
+    WaveNet<ArraySpec<16, 8, false, 1, 2, 4, 8, 16, 32, 64, 128, 256, 512>,
+            ArraySpec<8, 1, true, 1, 2, 4, 8, 16, 32, 64, 128, 256, 512>>;
+
+template <int FirstChannels, int SecondChannels>
+using LiteShapedWaveNet =
+    WaveNet<ArraySpec<FirstChannels, SecondChannels, false, 1, 2, 4, 8, 16, 32, 64>,
+            ArraySpec<SecondChannels, 1, true, 128, 256, 512, 1, 2, 4, 8, 16, 32, 64, 128,
+                      256, 512>>;
+using LiteWaveNet = LiteShapedWaveNet<12, 6>;
+using FeatherWaveNet = LiteShapedWaveNet<8, 4>;
+using NanoWaveNet = LiteShapedWaveNet<4, 2>;
+
+template <typename Engine, typename Weights>
+std::unique_ptr<nam::DSP> makeEngine(const Weights& weights, double expectedSampleRate) {
+  return std::make_unique<Engine>(weights, expectedSampleRate);
+}
+
+inline std::unique_ptr<nam::DSP> makeModel(SpecialisedArchitecture architecture,
+                                           const WaveNetWeights& weights,
+                                           double expectedSampleRate) {
+  switch (architecture) {
+    case SpecialisedArchitecture::wavenetStandard:
+      return makeEngine<StandardWaveNet>(weights, expectedSampleRate);
+    case SpecialisedArchitecture::wavenetLite:
+      return makeEngine<LiteWaveNet>(weights, expectedSampleRate);
+    case SpecialisedArchitecture::wavenetFeather:
+      return makeEngine<FeatherWaveNet>(weights, expectedSampleRate);
+    case SpecialisedArchitecture::wavenetNano:
+      return makeEngine<NanoWaveNet>(weights, expectedSampleRate);
+    default:
+      return nullptr;
+  }
+}
+
+inline std::unique_ptr<nam::DSP> makeModel(SpecialisedArchitecture architecture,
+                                           const LstmWeights& weights,
+                                           double expectedSampleRate) {
+  switch (architecture) {
+    case SpecialisedArchitecture::lstm1x8:
+      return makeEngine<Lstm<1, 8>>(weights, expectedSampleRate);
+    case SpecialisedArchitecture::lstm1x12:
+      return makeEngine<Lstm<1, 12>>(weights, expectedSampleRate);
+    case SpecialisedArchitecture::lstm1x16:
+      return makeEngine<Lstm<1, 16>>(weights, expectedSampleRate);
+    case SpecialisedArchitecture::lstm1x24:
+      return makeEngine<Lstm<1, 24>>(weights, expectedSampleRate);
+    case SpecialisedArchitecture::lstm1x32:
+      return makeEngine<Lstm<1, 32>>(weights, expectedSampleRate);
+    case SpecialisedArchitecture::lstm2x8:
+      return makeEngine<Lstm<2, 8>>(weights, expectedSampleRate);
+    case SpecialisedArchitecture::lstm2x16:
+      return makeEngine<Lstm<2, 16>>(weights, expectedSampleRate);
+    default:
+      return nullptr;
+  }
+}
+}  // namespace specialised
+}  // namespace
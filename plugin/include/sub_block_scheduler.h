@@ -0,0 +1,76 @@
+#pragma once
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <juce_dsp/juce_dsp.h>
+
+#ifndef NEURALAMP_SUB_BLOCK_SIZE
+#define NEURALAMP_SUB_BLOCK_SIZE 128
+#endif
+
+#ifndef NEURALAMP_SUB_BLOCK_FIFO
+#define NEURALAMP_SUB_BLOCK_FIFO 0
+#endif
+
+// Splits host blocks of any size into chunks of at most chunkSize samples, so the model and
+// convolvers always see the block size they were prepared for. With the FIFO enabled every chunk
+// is exactly chunkSize samples, at the cost of chunkSize samples of added latency.
+class SubBlockScheduler {
+public:
+  static constexpr int defaultChunkSize = NEURALAMP_SUB_BLOCK_SIZE;
+  static constexpr bool defaultUseFifo = NEURALAMP_SUB_BLOCK_FIFO != 0;
+
+  void prepare(int numChannels, int chunkSize, bool useFifo);
+  void reset();
+  // Audio thread; the FIFOs were sized by prepare(). Switching drops what is in them.
+  void setUseFifo(bool shouldUseFifo);
+
+  int getChunkSize() const { return chunkSize; }
+  bool isUsingFifo() const { return useFifo; }
+  int getLatencyInSamples() const { return useFifo ? chunkSize : 0; }
+
+  // Calls processChunk(juce::dsp::AudioBlock<float>) once per chunk, in place on the host buffer
+  template <typename ProcessChunk>
+  void process(juce::AudioBuffer<float>& buffer, ProcessChunk&& processChunk) {
+    const int numSamples = buffer.getNumSamples();
+    const int numChannels = juce::jmin(buffer.getNumChannels(), inputFifo.getNumChannels());
+    juce::dsp::AudioBlock<float> hostBlock(buffer.getArrayOfWritePointers(),
+                                           static_cast<size_t>(numChannels),
+                                           static_cast<size_t>(numSamples));
+
+    if (!useFifo) {
+      for (int offset = 0; offset < numSamples; offset += chunkSize) {
+        const int n = juce::jmin(chunkSize, numSamples - offset);
+        processChunk(hostBlock.getSubBlock(static_cast<size_t>(offset), static_cast<size_t>(n)));
+      }
+      return;
+    }
+
+    for (int offset = 0; offset < numSamples;) {
+      const int n = juce::jmin(chunkSize - fifoPosition, numSamples - offset);
+      for (int ch = 0; ch < numChannels; ++ch) {
+        auto* host = buffer.getWritePointer(ch, offset);
+        juce::FloatVectorOperations::copy(inputFifo.getWritePointer(ch, fifoPosition), host, n);
+        juce::FloatVectorOperations::copy(host, outputFifo.getReadPointer(ch, fifoPosition), n);
+      }
+      fifoPosition += n;
+      offset += n;
+
+      if (fifoPosition == chunkSize) {
+        juce::dsp::AudioBlock<float> chunk(inputFifo.getArrayOfWritePointers(),
+                                           static_cast<size_t>(numChannels),
+                                           static_cast<size_t>(chunkSize));
+        processChunk(chunk);
+        std::swap(inputFifo, outputFifo);
+        fifoPosition = 0;
+      }
+    }
+  }
+
+private:
+  int chunkSize = defaultChunkSize;
+  bool useFifo = defaultUseFifo;
+
+  // Host input collects in inputFifo while the previous chunk's output drains from outputFifo
+  juce::AudioBuffer<float> inputFifo;
+  juce::AudioBuffer<float> outputFifo;
+  int fifoPosition = 0;
+};
@@ -0,0 +1,73 @@
+#pragma once
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <juce_dsp/juce_dsp.h>
+#include <array>
+
+// Meter readings for one telemetry interval. Levels are linear, load is the proportion of the
+// block's real-time budget spent processing it.
+struct TelemetryFrame {
+  static constexpr int maxChannels = 2;
+
+  std::array<float, maxChannels> inputPeak{};
+  std::array<float, maxChannels> inputRms{};
+  std::array<float, maxChannels> outputPeak{};
+  std::array<float, maxChannels> outputRms{};
+  int numSamples = 0;
+  bool gateOpen = false;
+  float load = 0.0f;
+  int xruns = 0;
+  int recoveries = 0;  // Blocks silenced for NaN or infinity since the processor was created
+  int faultedModels = 0;  // Model slots left muted after faulting repeatedly, one bit each
+  int refusedModels = 0;  // Model slots whose last load was refused, one bit each
+};
+
+// Single-producer/single-consumer channel from the audio thread to a reader such as the editor.
+// The audio thread accumulates peaks and sums of squares as it goes and pushes one frame per
+// interval, so a reader polling at UI rate never sees more than a handful of frames and never
+// takes a lock. Frames are dropped, not blocked on, when nobody is reading.
+class Telemetry {
+public:
+  static constexpr int capacity = 64;
+  static constexpr double frameSeconds = 1.0 / 60.0;
+
+  void prepare(double sampleRate);
+
+  // Audio thread only
+  void measureInput(const juce::dsp::AudioBlock<float>& block);
+  void measureOutput(const juce::dsp::AudioBlock<float>& block);
+  void setGateOpen(bool open) { pending.gateOpen = pending.gateOpen || open; }
+  void finishBlock(int numSamples, float load, int xruns, int recoveries, int faultedModels,
+                   int refusedModels);
+
+  // Reader thread only. Calls callback(const TelemetryFrame&) for every queued frame, oldest
+  // first, and returns how many there were.
+  template <typename Callback>
+  int drain(Callback&& callback) {
+    const auto scope = fifo.read(fifo.getNumReady());
+    for (int i = 0; i < scope.blockSize1; ++i)
+      callback(frames[static_cast<size_t>(scope.startIndex1 + i)]);
+    for (int i = 0; i < scope.blockSize2; ++i)
+      callback(frames[static_cast<size_t>(scope.startIndex2 + i)]);
+    return scope.blockSize1 + scope.blockSize2;
+  }
+
+  // Folds later frames into an earlier one: peaks take the maximum, RMS the power mean
+  static void merge(TelemetryFrame& into, const TelemetryFrame& frame);
+
+private:
+  struct Levels {
+    std::array<float, TelemetryFrame::maxChannels> peak{};
+    std::array<float, TelemetryFrame::maxChannels> sumSquares{};
+  };
+
+  static void measure(const juce::dsp::AudioBlock<float>& block, Levels& levels);
+  void reset();
+
+  juce::AbstractFifo fifo{capacity};
+  std::array<TelemetryFrame, capacity> frames;
+
+  int frameSamples = 800;
+  TelemetryFrame pending;
+  Levels input;
+  Levels output;
+};
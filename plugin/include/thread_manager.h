@@ -0,0 +1,70 @@
+#pragma once
+#include <juce_core/juce_core.h>
+#include <array>
+#include <functional>
+#include <memory>
+
+// Where the plugin's background threads run and how they are scheduled: the loader (model and IR
+// loading, library scans, freeing swapped-out engines), the capture writer and a small worker
+// pool for heavy one-offs. One instance is shared by every plugin instance in the process; hold a
+// juce::SharedResourcePointer<ThreadManager>.
+//
+// No background thread is ever placed on the audio cores: those listed as audioCores in the config
+// file, else the kernel's isolated cores (where Elk runs Sushi's realtime threads). Headless builds
+// read the config from configPath, e.g.
+//
+//   {"audioCores": "3", "workers": 1,
+//    "loader": {"cores": "0-2", "policy": "other", "nice": 5},
+//    "writer": {"cores": "2", "policy": "other", "nice": 10},
+//    "worker": {"cores": "0-1", "policy": "fifo", "priority": 5}}
+//
+// Anything left out keeps the default sized from the core count.
+class ThreadManager {
+public:
+  enum class Role { loader, writer, worker };
+  static constexpr int numRoles = 3;
+  static constexpr const char* configPath = "/home/mind/neuralamp_threads.json";
+
+  using CoreMask = juce::uint64;  // Bit n is core n
+
+  struct Placement {
+    CoreMask cores = 0;  // Never empty once resolved
+    bool fifo = false;   // SCHED_FIFO instead of SCHED_OTHER
+    int priority = 1;    // SCHED_FIFO priority
+    int nice = 0;        // SCHED_OTHER only
+  };
+
+  // Reads the config file (headless builds) and the kernel's isolated cores
+  ThreadManager();
+  // config is the parsed config file, or void for the defaults
+  ThreadManager(const juce::var& config, int numCores, CoreMask isolatedCores);
+  ~ThreadManager();
+
+  const Placement& getPlacement(Role role) const { return placements[static_cast<size_t>(role)]; }
+  CoreMask getAudioCores() const { return audioCores; }
+  int getNumWorkers() const { return numWorkers; }
+
+  // Call first thing in a background thread's run(), and it is moved to its role's cores and
+  // policy. Returns false if the OS refused part of it (SCHED_FIFO needs rtprio rights).
+  bool placeCurrentThread(Role role) const;
+
+  // Shared by every instance, started on first use. Jobs call placeCurrentThread(Role::worker)
+  // before their work, since the pool's threads are created without a role.
+  juce::ThreadPool& getWorkers();
+
+  static CoreMask parseCoreList(const juce::String& list);  // "0-2,5"
+  static juce::String formatCoreList(CoreMask cores);
+  juce::String describe() const;
+
+private:
+  static Placement parsePlacement(const juce::var& config, Placement placement);
+
+  CoreMask audioCores = 0;
+  int numWorkers = 1;
+  std::array<Placement, numRoles> placements;
+
+  juce::CriticalSection workersLock;
+  std::unique_ptr<juce::ThreadPool> workers;
+
+  JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ThreadManager)
+};
@@ -0,0 +1,66 @@
+#pragma once
+#include <array>
+#include "memory_arena.h"
+
+// The passive bass/mid/treble network of a guitar amp as one third-order IIR section, so the
+// controls interact the way they do on the amp (mids scoop as bass and treble come up, the bass
+// knob shifts the treble corner). Every model shares the Fender/Marshall/Vox ("FMV") topology
+// with its own component values; the response is Yeh's analytic solution of the circuit,
+// bilinear transformed.
+//
+// prepare() solves the circuit at every point of a gridSize^3 grid of knob positions for the
+// sample rate. setControls() then only interpolates that table trilinearly, so knob moves cost a
+// few multiply-adds on the audio thread. The unnormalised coefficients are interpolated: they are
+// linear in the treble and bass pot positions (the bass axis is weighted in pot rather than knob
+// units for that), so between grid points the section is still a real circuit, and stable.
+class ToneStack {
+public:
+  enum Model : int { fender, marshall, vox, numModels };
+  static const char* getModelName(Model model);
+
+  static constexpr int order = 3;
+  static constexpr int gridSize = 11;  // Knob positions 0, 1, ... 10 on each axis
+  static constexpr float maxKnob = 10.0f;
+  static constexpr int maxChannels = 2;
+
+  // Normalised, a[0] == 1. Passes the signal through until prepared.
+  struct Coefficients {
+    std::array<double, order + 1> b{1.0};
+    std::array<double, order + 1> a{1.0};
+  };
+
+  // The table comes from memory when given, as scratch. Not on the audio thread.
+  void prepare(double sampleRate, MemoryArena* memory = nullptr);
+  void reset();
+
+  // Audio thread. Knobs run from 0 to maxKnob, 5 being noon.
+  void setModel(Model model);
+  void setControls(float bass, float mid, float treble);
+  void process(float* const* channels, int numChannels, int numSamples);
+
+  Model getModel() const { return model; }
+  const Coefficients& getCoefficients() const { return coefficients; }
+
+  // Solves the circuit directly, as prepare() does at each grid point. Includes the model's
+  // make-up gain, which brings its loudest frequency at noon to unity.
+  static Coefficients design(Model model, double sampleRate, float bass, float mid, float treble);
+
+private:
+  // b0..b3 then a0..a3, before dividing by a0
+  static constexpr size_t numTerms = 2 * (order + 1);
+  using Terms = std::array<double, numTerms>;
+  static Terms solve(Model model, double sampleRate, double bassPot, double midPot,
+                     double treblePot);
+  static double getBassPot(float knob);
+  static double getMakeupGain(Model model);
+
+  void updateCoefficients();
+
+  double sampleRate = 0.0;
+  MemoryArena::Vector<double> table;  // [model][bass][mid][treble][term]
+
+  Model model = fender;
+  std::array<float, 3> controls{5.0f, 5.0f, 5.0f};  // Bass, mid, treble
+  Coefficients coefficients;
+  std::array<std::array<double, order>, maxChannels> state{};  // Transposed direct form II
+};
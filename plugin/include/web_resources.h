@@ -0,0 +1,23 @@
+#pragma once
+#include <juce_gui_extra/juce_gui_extra.h>
+#include <optional>
+#include <unordered_map>
+
+// The WebView assets embedded in BinaryData, indexed by their URL path under plugin/webview (e.g.
+// "assets/index.js") the first time the editor asks for one. Each asset's response is built once;
+// a lookup is a single hash probe plus the copy the provider's by-value Resource requires.
+class WebResources {
+public:
+  static const WebResources& getInstance();
+
+  // Takes the path the provider is asked for; "/" and "" resolve to index.html, and any query or
+  // fragment is ignored
+  std::optional<juce::WebBrowserComponent::Resource> find(const juce::String& url) const;
+
+private:
+  WebResources();
+
+  static const char* getMimeType(const juce::String& fileName);
+
+  std::unordered_map<juce::String, juce::WebBrowserComponent::Resource> entries;
+};
@@ -0,0 +1,199 @@
+#include "capture_recorder.h"
+#include <utility>
+
+CaptureRecorder::CaptureRecorder(const juce::File& captureFolder)
+    : juce::Thread("NeuralAmp Capture"), folder(captureFolder) {}
+
+CaptureRecorder::~CaptureRecorder() {
+  release();
+}
+
+void CaptureRecorder::prepare(double newSampleRate, int newNumChannels) {
+  release();
+
+  sampleRate = newSampleRate;
+  numChannels = juce::jmax(1, newNumChannels);
+  const int capacity = juce::roundToInt(sampleRate * ringSeconds);
+  ring.setSize(2 * numChannels, capacity);
+  fifo = std::make_unique<juce::AbstractFifo>(capacity);
+  pendingBlock = false;
+  droppedSamples = 0;
+
+  startThread(juce::Thread::Priority::low);
+}
+
+void CaptureRecorder::release() {
+  stopThread(5000);
+  if (fifo != nullptr && fifo->getNumReady() > 0 && !writersOpen)
+    openWriters();
+  drain();
+  closeWriters();
+}
+
+void CaptureRecorder::setRecording(bool shouldRecord, bool includeOutput, Format newFormat) {
+  recording.store(shouldRecord, std::memory_order_relaxed);
+  recordOutput.store(includeOutput, std::memory_order_relaxed);
+  format.store(newFormat, std::memory_order_relaxed);
+}
+
+void CaptureRecorder::pushInput(const juce::AudioBuffer<float>& buffer) {
+  pendingBlock = false;
+  if (!recording.load(std::memory_order_relaxed) || fifo == nullptr)
+    return;
+
+  const int numSamples = buffer.getNumSamples();
+  if (fifo->getFreeSpace() < numSamples) {
+    droppedSamples.fetch_add(numSamples, std::memory_order_relaxed);
+    return;
+  }
+
+  fifo->prepareToWrite(numSamples, pendingStart1, pendingSize1, pendingStart2, pendingSize2);
+  for (int channel = 0; channel < numChannels; ++channel) {
+    const int source = juce::jmin(channel, buffer.getNumChannels() - 1);
+    ring.copyFrom(channel, pendingStart1, buffer, source, 0, pendingSize1);
+    if (pendingSize2 > 0)
+      ring.copyFrom(channel, pendingStart2, buffer, source, pendingSize1, pendingSize2);
+  }
+  pendingBlock = true;
+}
+
+void CaptureRecorder::pushOutput(const juce::AudioBuffer<float>& buffer) {
+  if (!pendingBlock)
+    return;
+
+  if (recordOutput.load(std::memory_order_relaxed)) {
+    for (int channel = 0; channel < numChannels; ++channel) {
+      const int source = juce::jmin(channel, buffer.getNumChannels() - 1);
+      ring.copyFrom(numChannels + channel, pendingStart1, buffer, source, 0, pendingSize1);
+      if (pendingSize2 > 0)
+        ring.copyFrom(numChannels + channel, pendingStart2, buffer, source, pendingSize1,
+                      pendingSize2);
+    }
+  }
+  fifo->finishedWrite(pendingSize1 + pendingSize2);
+  pendingBlock = false;
+}
+
+CaptureRecorder::Status CaptureRecorder::getStatus() const {
+  Status status;
+  status.seconds = static_cast<double>(writtenSamples.load()) / sampleRate;
+  status.droppedSamples = droppedSamples.load();
+
+  const juce::ScopedLock lock(statusLock);
+  status.recording = writersOpen;
+  status.diFile = diFile;
+  status.outputFile = outputFile;
+  status.error = error;
+  return status;
+}
+
+void CaptureRecorder::run() {
+  threads->placeCurrentThread(ThreadManager::Role::writer);
+  bool closePending = false;
+  while (!threadShouldExit()) {
+    // Blocks pushed before a quick stop still get a file
+    const bool shouldRecord = recording.load(std::memory_order_relaxed);
+    if ((shouldRecord || fifo->getNumReady() > 0) && !writersOpen)
+      openWriters();
+
+    drain();
+
+    // Close one pass after recording stops, so a block that was mid-push when it stopped still
+    // lands in these files
+    if (shouldRecord || !writersOpen)
+      closePending = false;
+    else if (std::exchange(closePending, true))
+      closeWriters();
+
+    wait(writerPollMs);
+  }
+}
+
+void CaptureRecorder::openWriters() {
+  const auto stamp = juce::Time::getCurrentTime().formatted("%Y%m%d_%H%M%S");
+  const auto extension = format.load() == Format::flac ? ".flac" : ".wav";
+  const auto newDiFile = folder.getChildFile("capture_" + stamp + "_di" + extension);
+  const auto newOutputFile = folder.getChildFile("capture_" + stamp + "_output" + extension);
+
+  std::unique_ptr<juce::AudioFormatWriter> newDiWriter;
+  std::unique_ptr<juce::AudioFormatWriter> newOutputWriter;
+  juce::String newError;
+  if (!folder.createDirectory()) {
+    newError = "Can't create " + folder.getFullPathName();
+  } else {
+    newDiWriter = createWriter(newDiFile, numChannels);
+    if (recordOutput.load())
+      newOutputWriter = createWriter(newOutputFile, numChannels);
+    if (newDiWriter == nullptr)
+      newError = "Can't write " + newDiFile.getFullPathName();
+  }
+
+  writtenSamples = 0;
+  const juce::ScopedLock lock(statusLock);
+  diWriter = std::move(newDiWriter);
+  outputWriter = std::move(newOutputWriter);
+  diFile = diWriter != nullptr ? newDiFile : juce::File();
+  outputFile = outputWriter != nullptr ? newOutputFile : juce::File();
+  error = newError;
+  // Even without files, so the ring keeps draining instead of overrunning
+  writersOpen = true;
+}
+
+void CaptureRecorder::closeWriters() {
+  // Writers flush and finish their headers when deleted
+  std::unique_ptr<juce::AudioFormatWriter> finishedDi;
+  std::unique_ptr<juce::AudioFormatWriter> finishedOutput;
+  const juce::ScopedLock lock(statusLock);
+  finishedDi = std::move(diWriter);
+  finishedOutput = std::move(outputWriter);
+  writersOpen = false;
+}
+
+void CaptureRecorder::drain() {
+  if (fifo == nullptr)
+    return;
+
+  const int numReady = fifo->getNumReady();
+  if (numReady == 0)
+    return;
+
+  int start1, size1, start2, size2;
+  fifo->prepareToRead(numReady, start1, size1, start2, size2);
+  auto write = [this](int start, int size) {
+    if (size <= 0)
+      return;
+    if (diWriter != nullptr) {
+      const juce::AudioBuffer<float> di(ring.getArrayOfWritePointers(), numChannels, start, size);
+      diWriter->writeFromAudioSampleBuffer(di, 0, size);
+    }
+    if (outputWriter != nullptr) {
+      const juce::AudioBuffer<float> output(ring.getArrayOfWritePointers() + numChannels,
+                                            numChannels, start, size);
+      outputWriter->writeFromAudioSampleBuffer(output, 0, size);
+    }
+  };
+  write(start1, size1);
+  write(start2, size2);
+  fifo->finishedRead(size1 + size2);
+  writtenSamples += size1 + size2;
+}
+
+std::unique_ptr<juce::AudioFormatWriter> CaptureRecorder::createWriter(const juce::File& file,
+                                                                        int channels) {
+  std::unique_ptr<juce::AudioFormat> audioFormat;
+  if (format.load() == Format::flac)
+    audioFormat = std::make_unique<juce::FlacAudioFormat>();
+  else
+    audioFormat = std::make_unique<juce::WavAudioFormat>();
+
+  // Large buffered writes keep the SD card streaming sequentially
+  auto stream = std::make_unique<juce::FileOutputStream>(file, 1 << 18);
+  if (stream->failedToOpen())
+    return nullptr;
+
+  std::unique_ptr<juce::AudioFormatWriter> writer(audioFormat->createWriterFor(
+      stream.get(), sampleRate, static_cast<unsigned int>(channels), bitsPerSample, {}, 0));
+  if (writer != nullptr)
+    stream.release();  // Owned by the writer
+  return writer;
+}
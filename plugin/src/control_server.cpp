@@ -0,0 +1,582 @@
+#include "control_server.h"
+#include <optional>
+#include "processor.h"
+
+#if JUCE_LINUX || JUCE_BSD || JUCE_MAC
+#define NEURALAMP_UNIX_SOCKETS 1
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#else
+#define NEURALAMP_UNIX_SOCKETS 0
+#endif
+
+namespace {
+juce::var makeError(const juce::String& message) {
+  auto* reply = new juce::DynamicObject();
+  reply->setProperty("ok", false);
+  reply->setProperty("error", message);
+  return reply;
+}
+
+juce::var makeReply() {
+  auto* reply = new juce::DynamicObject();
+  reply->setProperty("ok", true);
+  return reply;
+}
+
+bool isError(const juce::var& reply) {
+  return !static_cast<bool>(reply.getProperty("ok", false));
+}
+
+// "A", "B", 0 or 1
+std::optional<int> parseSlot(const juce::var& slot) {
+  if (slot.isVoid())
+    return 0;
+  if (slot.isString()) {
+    const auto name = slot.toString().toUpperCase();
+    if (name == "A" || name == "B")
+      return name == "A" ? 0 : 1;
+    return std::nullopt;
+  }
+  if (slot.isInt() || slot.isInt64()) {
+    const int index = static_cast<int>(slot);
+    if (index == 0 || index == 1)
+      return index;
+  }
+  return std::nullopt;
+}
+
+// Catalogue IDs are relative to the library folder; anything absolute is a path
+juce::File resolveFile(const LibraryCatalogue& catalogue, const juce::String& idOrPath) {
+  return juce::File::isAbsolutePath(idOrPath) ? juce::File(idOrPath) : catalogue.getFile(idOrPath);
+}
+
+juce::var toDecibels(const std::array<float, TelemetryFrame::maxChannels>& levels) {
+  juce::Array<juce::var> result;
+  for (const float level : levels)
+    result.add(juce::Decibels::gainToDecibels(level));
+  return result;
+}
+
+// The file with symlinks, "." and ".." resolved; invalid when it doesn't exist
+juce::File getRealFile(const juce::File& file) {
+#if NEURALAMP_UNIX_SOCKETS
+  char* resolved = ::realpath(file.getFullPathName().toRawUTF8(), nullptr);
+  if (resolved == nullptr)
+    return {};
+  const juce::File result(juce::String::fromUTF8(resolved));
+  std::free(resolved);
+  return result;
+#else
+  return file.exists() ? file.getLinkedTarget() : juce::File();
+#endif
+}
+
+// A preset named relative to the folder, or by an absolute path inside it. Paths are resolved
+// first, so neither ".." nor a symlink reaches outside. Invalid when missing or elsewhere.
+juce::File findPresetFile(const juce::File& folder, const juce::String& name) {
+  const auto root = getRealFile(folder);
+  const auto file = getRealFile(juce::File::isAbsolutePath(name) ? juce::File(name)
+                                                                 : folder.getChildFile(name));
+  if (root == juce::File() || !file.isAChildOf(root) || !file.existsAsFile())
+    return {};
+  return file;
+}
+
+#if NEURALAMP_UNIX_SOCKETS
+// A socket file left by a process that died answers nothing, and can be replaced
+bool isAnswering(const sockaddr_un& address) {
+  const int probe = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  if (probe < 0)
+    return false;
+  const bool answering =
+      ::connect(probe, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) == 0;
+  ::close(probe);
+  return answering;
+}
+
+// Sends as much of pending as the socket takes without blocking, and drops that from the front.
+// False once the client has gone.
+bool sendPending(int fd, std::string& pending) {
+  size_t sent = 0;
+  while (sent < pending.size()) {
+#ifdef MSG_NOSIGNAL
+    const auto n = ::send(fd, pending.data() + sent, pending.size() - sent, MSG_NOSIGNAL);
+#else
+    const auto n = ::send(fd, pending.data() + sent, pending.size() - sent, 0);
+#endif
+    if (n < 0 && errno == EINTR)
+      continue;
+    if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+      break;
+    if (n <= 0)
+      return false;
+    sent += static_cast<size_t>(n);
+  }
+  pending.erase(0, sent);
+  return true;
+}
+#endif
+}  // namespace
+
+ControlServer::ControlServer(NeuralAmpProcessor& processorToControl)
+    : juce::Thread("NeuralAmp Control"), processor(processorToControl) {
+  announcements.reserve(queueCapacity);
+}
+
+ControlServer::~ControlServer() {
+  stop();
+  cancelPendingUpdate();
+}
+
+juce::File ControlServer::getSocketFolder() {
+#if NEURALAMP_UNIX_SOCKETS
+  const char* runtime = std::getenv("XDG_RUNTIME_DIR");
+  if (runtime != nullptr && juce::File::isAbsolutePath(runtime) &&
+      juce::File(runtime).isDirectory())
+    return juce::File(runtime);
+
+  const auto uid = ::getuid();
+  const auto folder = juce::File("/tmp/neuralamp-" + juce::String(static_cast<unsigned int>(uid)));
+  const auto path = folder.getFullPathName();
+  ::mkdir(path.toRawUTF8(), 0700);
+  struct stat info{};
+  if (::lstat(path.toRawUTF8(), &info) != 0 || !S_ISDIR(info.st_mode) || info.st_uid != uid ||
+      (info.st_mode & 077) != 0)
+    return {};
+  return folder;
+#else
+  return {};
+#endif
+}
+
+void ControlServer::start(const juce::File& requestedFile) {
+  const juce::ScopedLock lock(socketLock);
+  if (listenFd >= 0)
+    return;
+
+  std::vector<juce::File> candidates;
+  if (requestedFile != juce::File()) {
+    candidates.push_back(requestedFile);
+  } else {
+    const auto folder = getSocketFolder();
+    if (folder == juce::File()) {
+      juce::Logger::writeToLog("[Control] No private folder for the socket; remote control is off");
+      return;
+    }
+    const auto first = folder.getChildFile(socketName);
+    candidates.push_back(first);
+    for (int i = 2; i <= maxInstances; ++i)
+      candidates.push_back(first.getSiblingFile(first.getFileNameWithoutExtension() + "-" +
+                                                juce::String(i) + first.getFileExtension()));
+  }
+
+  for (const auto& candidate : candidates) {
+    listenFd = listen(candidate);
+    if (listenFd >= 0) {
+      socketFile = candidate;
+      juce::Logger::writeToLog("[Control] Listening on " + socketFile.getFullPathName());
+      startThread(juce::Thread::Priority::low);
+      return;
+    }
+  }
+  juce::Logger::writeToLog("[Control] No socket to listen on; remote control is off");
+}
+
+void ControlServer::stop() {
+  stopThread(2000);
+  const juce::ScopedLock lock(socketLock);
+  if (listenFd < 0)
+    return;
+#if NEURALAMP_UNIX_SOCKETS
+  ::close(listenFd);
+  ::unlink(socketFile.getFullPathName().toRawUTF8());
+#endif
+  listenFd = -1;
+  socketFile = juce::File();
+}
+
+juce::File ControlServer::getSocketFile() const {
+  const juce::ScopedLock lock(socketLock);
+  return socketFile;
+}
+
+int ControlServer::listen(const juce::File& file) {
+#if NEURALAMP_UNIX_SOCKETS
+  const std::string path = file.getFullPathName().toStdString();
+  sockaddr_un address{};
+  if (path.size() >= sizeof(address.sun_path))
+    return -1;
+  address.sun_family = AF_UNIX;
+  std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+
+  const int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0)
+    return -1;
+  ::fcntl(fd, F_SETFD, FD_CLOEXEC);
+  const auto* generic = reinterpret_cast<const sockaddr*>(&address);
+  bool bound = ::bind(fd, generic, sizeof(address)) == 0;
+  if (!bound && errno == EADDRINUSE && !isAnswering(address)) {
+    ::unlink(path.c_str());
+    bound = ::bind(fd, generic, sizeof(address)) == 0;
+  }
+  // Nobody can connect before listen(), so the mode is set before anyone else could get in
+  if (bound && ::chmod(path.c_str(), 0600) != 0) {
+    ::unlink(path.c_str());
+    bound = false;
+  }
+  if (!bound || ::listen(fd, 4) != 0) {
+    ::close(fd);
+    return -1;
+  }
+  ::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL) | O_NONBLOCK);
+  return fd;
+#else
+  juce::ignoreUnused(file);
+  return -1;
+#endif
+}
+
+void ControlServer::run() {
+  threads->placeCurrentThread(ThreadManager::Role::loader);  // Light enough to share its cores
+#if NEURALAMP_UNIX_SOCKETS
+  struct Client {
+    int fd;
+    std::string input;
+    std::string output;  // Replies the client hasn't read yet
+  };
+  std::vector<Client> clients;
+  std::vector<pollfd> fds;
+
+  while (!threadShouldExit()) {
+    announceAppliedChanges();
+
+    fds.assign(1, pollfd{listenFd, POLLIN, 0});
+    for (const auto& client : clients) {
+      const auto events = static_cast<short>(client.output.empty() ? POLLIN : POLLIN | POLLOUT);
+      fds.push_back(pollfd{client.fd, events, 0});
+    }
+    if (::poll(fds.data(), static_cast<nfds_t>(fds.size()), pollIntervalMs) <= 0)
+      continue;
+
+    for (size_t i = clients.size(); i-- > 0;) {
+      const auto events = fds[i + 1].revents;
+      if (events == 0)
+        continue;
+      auto& client = clients[i];
+      bool open = (events & (POLLERR | POLLNVAL)) == 0;
+      if (open && (events & (POLLIN | POLLHUP)) != 0) {
+        char chunk[4096];
+        const auto n = ::read(client.fd, chunk, sizeof(chunk));
+        if (n > 0)
+          client.input.append(chunk, static_cast<size_t>(n));
+        else if (n == 0 || (errno != EINTR && errno != EAGAIN && errno != EWOULDBLOCK))
+          open = false;
+      }
+
+      for (auto end = client.input.find('\n'); open && end != std::string::npos;
+           end = client.input.find('\n')) {
+        const auto line = juce::String::fromUTF8(client.input.data(), static_cast<int>(end));
+        client.input.erase(0, end + 1);
+        if (line.trim().isNotEmpty())
+          client.output += (handleRequest(line) + "\n").toStdString();
+      }
+      if (client.input.size() > static_cast<size_t>(maxRequestBytes)) {
+        client.output +=
+            (juce::JSON::toString(makeError("Request too long"), true) + "\n").toStdString();
+        sendPending(client.fd, client.output);  // Best effort; the client goes either way
+        open = false;
+      }
+      open = open && sendPending(client.fd, client.output) &&
+             client.output.size() <= static_cast<size_t>(maxPendingReplyBytes);
+      if (!open) {
+        ::close(client.fd);
+        clients.erase(clients.begin() + static_cast<std::ptrdiff_t>(i));
+      }
+    }
+
+    if ((fds[0].revents & POLLIN) != 0) {
+      const int fd = ::accept(listenFd, nullptr, nullptr);
+      if (fd >= 0) {
+        ::fcntl(fd, F_SETFD, FD_CLOEXEC);
+        ::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL) | O_NONBLOCK);
+        clients.push_back({fd, {}, {}});
+      }
+    }
+  }
+
+  for (const auto& client : clients)
+    ::close(client.fd);
+#endif
+}
+
+juce::String ControlServer::handleRequest(const juce::String& line) {
+  const juce::ScopedLock lock(requestLock);
+  announceAppliedChanges();
+
+  juce::var request;
+  const auto parsed = juce::JSON::parse(line, request);
+  juce::var reply;
+  if (parsed.failed() || !request.isObject()) {
+    reply = makeError("Expected a JSON object: " + parsed.getErrorMessage());
+  } else {
+    const auto command = request.getProperty("command", {}).toString();
+    if (command == "set")
+      reply = setParameters(request.getProperty("parameters", {}));
+    else if (command == "load")
+      reply = load(request);
+    else if (command == "preset" && request.hasProperty("file"))
+      reply = applyPresetFile(request.getProperty("file", {}).toString());
+    else if (command == "preset")
+      reply = applyPreset(request.getProperty("preset", {}));
+    else if (command == "status")
+      reply = getStatus();
+    else
+      reply = makeError("Unknown command: " + command);
+
+    if (request.hasProperty("id"))
+      reply.getDynamicObject()->setProperty("id", request.getProperty("id", {}));
+  }
+  return juce::JSON::toString(reply, true);
+}
+
+juce::var ControlServer::setParameters(const juce::var& values) {
+  auto* object = values.getDynamicObject();
+  if (object == nullptr)
+    return makeError("\"parameters\" must be an object");
+
+  // Checked as a whole first, so a bad entry leaves every parameter as it was
+  auto& state = processor.getParameters();
+  std::vector<std::pair<ParameterChange, Announcement>> batch;
+  for (const auto& property : object->getProperties()) {
+    const auto id = property.name.toString();
+    auto* parameter = state.getParameter(id);
+    auto* value = state.getRawParameterValue(id);
+    if (parameter == nullptr || value == nullptr)
+      return makeError("Unknown parameter: " + id);
+    if (!property.value.isBool() && !property.value.isInt() && !property.value.isInt64() &&
+        !property.value.isDouble())
+      return makeError(id + " must be a number");
+
+    // Clamped and snapped to the parameter's range and step, as the host would
+    const float normalised = parameter->convertTo0to1(static_cast<float>(property.value));
+    batch.push_back({{value, parameter->convertFrom0to1(normalised)}, {parameter, normalised}});
+  }
+
+  const int size = static_cast<int>(batch.size());
+  if (size > queue.getFreeSpace())
+    return makeError("Too many parameter changes pending; is the audio running?");
+  if (size > 0) {
+    const auto scope = queue.write(size);
+    for (int i = 0; i < scope.blockSize1; ++i)
+      changes[static_cast<size_t>(scope.startIndex1 + i)] = batch[static_cast<size_t>(i)].first;
+    for (int i = 0; i < scope.blockSize2; ++i)
+      changes[static_cast<size_t>(scope.startIndex2 + i)] =
+          batch[static_cast<size_t>(scope.blockSize1 + i)].first;
+  }
+  for (const auto& change : batch)
+    announcements.push_back(change.second);
+
+  auto reply = makeReply();
+  reply.getDynamicObject()->setProperty("queued", size);
+  return reply;
+}
+
+int ControlServer::applyPendingChanges() {
+  const auto scope = queue.read(queue.getNumReady());
+  for (int i = 0; i < scope.blockSize1; ++i) {
+    const auto& change = changes[static_cast<size_t>(scope.startIndex1 + i)];
+    change.value->store(change.newValue);
+  }
+  for (int i = 0; i < scope.blockSize2; ++i) {
+    const auto& change = changes[static_cast<size_t>(scope.startIndex2 + i)];
+    change.value->store(change.newValue);
+  }
+  return scope.blockSize1 + scope.blockSize2;
+}
+
+// The audio thread writes the values the DSP reads directly. Once it has, the parameters
+// themselves are set to match, which is what hosts and attachments listen to.
+void ControlServer::announceAppliedChanges() {
+  const juce::ScopedLock lock(requestLock);
+  if (!announcements.empty() && queue.getNumReady() == 0)
+    triggerAsyncUpdate();
+}
+
+// Message thread. A batch queued since the trigger leaves everything for the server thread's
+// next poll, which triggers again.
+void ControlServer::handleAsyncUpdate() {
+  std::vector<Announcement> applied;
+  {
+    const juce::ScopedLock lock(requestLock);
+    if (queue.getNumReady() > 0)
+      return;
+    applied.swap(announcements);
+    announcements.reserve(queueCapacity);
+  }
+  for (const auto& announcement : applied)
+    announcement.parameter->setValueNotifyingHost(announcement.normalisedValue);
+}
+
+juce::var ControlServer::load(const juce::var& request) {
+  const auto slot = parseSlot(request.getProperty("slot", {}));
+  if (!slot)
+    return makeError("\"slot\" must be \"A\" or \"B\"");
+
+  const auto model = request.getProperty("model", {}).toString();
+  const auto ir = request.getProperty("ir", {}).toString();
+  if (model.isEmpty() && ir.isEmpty())
+    return makeError("Nothing to load: give \"model\" and/or \"ir\"");
+  if (model.isNotEmpty() && !resolveFile(processor.getModelCatalogue(), model).existsAsFile())
+    return makeError("No such model: " + model);
+  if (ir.isNotEmpty() && !resolveFile(processor.getIrCatalogue(), ir).existsAsFile())
+    return makeError("No such IR: " + ir);
+
+  if (model.isNotEmpty())
+    processor.requestModel(model, static_cast<ModelBlender::Slot>(*slot));
+  if (ir.isNotEmpty())
+    processor.requestIr(ir, static_cast<DualIrConvolver::Slot>(*slot));
+  return makeReply();
+}
+
+// {"parameters": {...}, "models": [A, B], "irs": [A, B]}; null or missing entries are left as
+// they are
+juce::var ControlServer::applyPreset(const juce::var& preset) {
+  if (!preset.isObject())
+    return makeError("A preset must be a JSON object");
+
+  std::array<juce::String, 2> models;
+  std::array<juce::String, 2> irs;
+  for (auto [key, files] : {std::pair{"models", &models}, std::pair{"irs", &irs}}) {
+    const auto entries = preset.getProperty(key, {});
+    if (entries.isVoid())
+      continue;
+    if (!entries.isArray() || entries.size() > 2)
+      return makeError(juce::String("\"") + key + "\" must be an array of up to two entries");
+    for (int slot = 0; slot < entries.size(); ++slot) {
+      if (!entries[slot].isVoid())
+        (*files)[static_cast<size_t>(slot)] = entries[slot].toString();
+    }
+  }
+
+  // Files are checked before any parameter is queued, so a bad preset changes nothing
+  for (size_t slot = 0; slot < 2; ++slot) {
+    if (models[slot].isNotEmpty() &&
+        !resolveFile(processor.getModelCatalogue(), models[slot]).existsAsFile())
+      return makeError("No such model: " + models[slot]);
+    if (irs[slot].isNotEmpty() &&
+        !resolveFile(processor.getIrCatalogue(), irs[slot]).existsAsFile())
+      return makeError("No such IR: " + irs[slot]);
+  }
+
+  const auto parameters = preset.getProperty("parameters", {});
+  auto reply = parameters.isVoid() ? makeReply() : setParameters(parameters);
+  if (isError(reply))
+    return reply;
+  for (size_t slot = 0; slot < 2; ++slot) {
+    if (models[slot].isNotEmpty())
+      processor.requestModel(models[slot], static_cast<ModelBlender::Slot>(slot));
+    if (irs[slot].isNotEmpty())
+      processor.requestIr(irs[slot], static_cast<DualIrConvolver::Slot>(slot));
+  }
+  return reply;
+}
+
+juce::var ControlServer::applyPresetFile(const juce::String& name) {
+  const auto folder = processor.getLocations().presetFolder;
+  const auto file = findPresetFile(folder, name);
+  if (file == juce::File())
+    return makeError("No preset " + name + " in " + folder.getFullPathName());
+  return applyPreset(juce::JSON::parse(file.loadFileAsString()));
+}
+
+juce::var ControlServer::getStatus() {
+  auto reply = makeReply();
+  auto* status = reply.getDynamicObject();
+  status->setProperty("sampleRate", processor.getSampleRate());
+  status->setProperty("blockSize", processor.getBlockSize());
+  status->setProperty("latencySamples", processor.getLatencySamples());
+
+  juce::Array<juce::var> models;
+  const auto modelNames = processor.getModelNames();
+  for (const auto slot : {ModelBlender::slotA, ModelBlender::slotB}) {
+    auto* model = new juce::DynamicObject();
+    const int index = processor.getCurrentModelIndex(slot);
+    model->setProperty("loaded", processor.isModelLoaded(slot));
+    model->setProperty("faulted", processor.isModelFaulted(slot));
+    model->setProperty("refused", processor.isModelRefused(slot));
+    model->setProperty("index", index);
+    model->setProperty("name", index > 0 ? modelNames[index] : juce::String());
+    models.add(model);
+  }
+  status->setProperty("models", models);
+
+  juce::Array<juce::var> irs;
+  const auto irNames = processor.getIrNames();
+  for (const auto slot : {DualIrConvolver::slotA, DualIrConvolver::slotB}) {
+    auto* ir = new juce::DynamicObject();
+    const int index = processor.getCurrentIrIndex(slot);
+    ir->setProperty("index", index);
+    ir->setProperty("name", index > 0 ? irNames[index] : juce::String());
+    irs.add(ir);
+  }
+  status->setProperty("irs", irs);
+  status->setProperty("irLoaded", processor.isIrLoaded());
+
+  auto* parameters = new juce::DynamicObject();
+  for (auto* parameter : processor.AudioProcessor::getParameters()) {
+    if (auto* ranged = dynamic_cast<juce::RangedAudioParameter*>(parameter)) {
+      if (const auto* value = processor.getParameters().getRawParameterValue(ranged->paramID))
+        parameters->setProperty(ranged->paramID, value->load());
+    }
+  }
+  status->setProperty("parameters", parameters);
+
+  // Everything the audio thread measured since the last status request
+  processor.getTelemetry().drain(
+      [this](const TelemetryFrame& frame) { Telemetry::merge(meters, frame); });
+  auto* meterReadings = new juce::DynamicObject();
+  meterReadings->setProperty("seconds",
+                             meters.numSamples / juce::jmax(1.0, processor.getSampleRate()));
+  meterReadings->setProperty("inputPeakDb", toDecibels(meters.inputPeak));
+  meterReadings->setProperty("inputRmsDb", toDecibels(meters.inputRms));
+  meterReadings->setProperty("outputPeakDb", toDecibels(meters.outputPeak));
+  meterReadings->setProperty("outputRmsDb", toDecibels(meters.outputRms));
+  meterReadings->setProperty("gateOpen", meters.gateOpen);
+  meterReadings->setProperty("load", meters.load);
+  meterReadings->setProperty("xruns", meters.xruns);
+  meterReadings->setProperty("recoveries", static_cast<int>(processor.getNonFiniteRecoveries()));
+  status->setProperty("meters", meterReadings);
+  const int xruns = meters.xruns;
+  meters = TelemetryFrame();
+  meters.xruns = xruns;
+
+  const auto usage = processor.getMemoryUsage();
+  auto* memory = new juce::DynamicObject();
+  for (int index = 0; index < MemoryArena::numSubsystems; ++index) {
+    const auto subsystem = static_cast<MemoryArena::Subsystem>(index);
+    memory->setProperty(MemoryArena::getSubsystemName(subsystem),
+                        static_cast<juce::int64>(usage.bytes[static_cast<size_t>(subsystem)]));
+  }
+  memory->setProperty("committed", static_cast<juce::int64>(usage.committedBytes));
+  memory->setProperty("capacity", static_cast<juce::int64>(usage.capacityBytes));
+  memory->setProperty("locked", usage.locked);
+  status->setProperty("memory", memory);
+
+  const auto capture = processor.getCaptureStatus();
+  auto* captureStatus = new juce::DynamicObject();
+  captureStatus->setProperty("recording", capture.recording);
+  captureStatus->setProperty("seconds", capture.seconds);
+  captureStatus->setProperty("droppedSamples", capture.droppedSamples);
+  captureStatus->setProperty("error", capture.error);
+  status->setProperty("capture", captureStatus);
+  return reply;
+}
@@ -0,0 +1,598 @@
+#include "dual_ir_convolver.h"
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <limits>
+
+namespace {
+// Spectra are stored split: the real parts of all bins, then the imaginary parts, so the
+// multiply-accumulate below vectorises
+void multiplyAccumulate(const float* x, const float* h, float* accumulator, int numBins) {
+  const float* xIm = x + numBins;
+  const float* hIm = h + numBins;
+  float* accumulatorIm = accumulator + numBins;
+  for (int k = 0; k < numBins; ++k) {
+    accumulator[k] += x[k] * h[k] - xIm[k] * hIm[k];
+    accumulatorIm[k] += x[k] * hIm[k] + xIm[k] * h[k];
+  }
+}
+
+// from + amount * (to - from), in place in from
+void crossfade(float* from, const float* to, float amount, int count) {
+  for (int i = 0; i < count; ++i)
+    from[i] += amount * (to[i] - from[i]);
+}
+
+// Trailing silence only costs partitions
+int getAudibleLength(const float* samples, int length) {
+  const float threshold = juce::Decibels::decibelsToGain(-80.0f);
+  while (length > 0 && std::abs(samples[length - 1]) < threshold)
+    --length;
+  return length;
+}
+
+std::vector<float> conditionImpulse(const juce::AudioBuffer<float>& ir, bool normalise) {
+  if (ir.getNumChannels() == 0)
+    return {};
+
+  // Leading silence is kept: it is the mic distance the two IRs line up by
+  const float* samples = ir.getReadPointer(0);
+  const int length =
+      getAudibleLength(samples, juce::jmin(ir.getNumSamples(), DualIrConvolver::maxIrLength));
+  std::vector<float> impulse(samples, samples + length);
+
+  // Same scaling as juce::dsp::Convolution, so normalised IRs keep the level they had
+  double energy = 0.0;
+  for (const float sample : impulse)
+    energy += static_cast<double>(sample) * sample;
+  if (normalise && energy > 0.0) {
+    const auto factor = static_cast<float>(0.125 / std::sqrt(energy));
+    for (auto& sample : impulse)
+      sample *= factor;
+  }
+  return impulse;
+}
+}  // namespace
+
+// One set of partition spectra plus the per-channel delay lines running against it
+class DualIrConvolver::Engine {
+public:
+  // The IRs are cut to maxPartitions
+  Engine(const std::vector<float>& irA,
+         const std::vector<float>& irB,
+         int partitionSize,
+         int numChannels,
+         float initialBlend,
+         float blendStepPerPartition,
+         int maxPartitions,
+         MemoryArena* memory)
+      : blockSize(partitionSize),
+        fftSize(2 * partitionSize),
+        numBins(partitionSize + 1),
+        stride(2 * (partitionSize + 1)),
+        fft(juce::roundToInt(std::log2(2 * partitionSize))),
+        allocator(memory, MemoryArena::convolution),
+        work(allocator),
+        accumulator(allocator),
+        accumulatorB(allocator),
+        spectraA(allocator),
+        spectraB(allocator),
+        mixed(allocator),
+        blend(initialBlend),
+        blendStep(blendStepPerPartition) {
+    numPartitions = juce::jlimit(1, juce::jmax(1, maxPartitions),
+                                 getNumPartitions(std::max(irA.size(), irB.size()), blockSize));
+    work.resize(static_cast<size_t>(2 * fftSize));
+    accumulator.resize(static_cast<size_t>(stride));
+
+    spectraA = computePartitionSpectra(irA);
+    spectraB = computePartitionSpectra(irB);
+    blending = !irA.empty() && !irB.empty();
+    if (blending) {
+      accumulatorB.resize(static_cast<size_t>(stride));
+      mixed.resize(spectraA.size());
+      mixSpectra();
+      kernel = mixed.data();
+    } else {
+      kernel = irA.empty() ? spectraB.data() : spectraA.data();
+    }
+
+    channels.reserve(static_cast<size_t>(numChannels));
+    for (int i = 0; i < numChannels; ++i)
+      channels.emplace_back(allocator);
+    for (auto& channel : channels) {
+      channel.delayLine.resize(static_cast<size_t>(numPartitions * stride));
+      channel.input.resize(static_cast<size_t>(blockSize));
+      channel.overlap.resize(static_cast<size_t>(blockSize));
+      channel.tail.resize(static_cast<size_t>(stride));
+      if (blending)
+        channel.tailB.resize(static_cast<size_t>(stride));
+    }
+    reset();
+  }
+
+  static int getNumPartitions(size_t length, int partitionSize) {
+    const auto size = static_cast<size_t>(partitionSize);
+    return juce::jmax(1, static_cast<int>((length + size - 1) / size));
+  }
+
+  // Arena bytes an engine with these dimensions allocates, rounding included
+  static size_t getBytes(int partitionSize, int numChannels, int numIrs, int partitions) {
+    const auto stride = static_cast<size_t>(2 * (partitionSize + 1));
+    const auto kernels = static_cast<size_t>(numIrs > 1 ? numIrs + 1 : numIrs);
+    // Blending keeps a second accumulator and tail for IR B's products
+    const auto accumulators = static_cast<size_t>(numIrs > 1 ? 2 : 1);
+    const auto channelFloats = static_cast<size_t>(partitions) * stride +
+                               static_cast<size_t>(2 * partitionSize) + accumulators * stride;
+    const size_t floats = kernels * static_cast<size_t>(partitions) * stride +
+                          static_cast<size_t>(4 * partitionSize) + accumulators * stride +
+                          static_cast<size_t>(numChannels) * channelFloats;
+    const auto numVectors = static_cast<size_t>(6 + 5 * numChannels);
+    return floats * sizeof(float) + numVectors * alignof(std::max_align_t);
+  }
+
+  void reset() {
+    for (auto& channel : channels) {
+      std::fill(channel.delayLine.begin(), channel.delayLine.end(), 0.0f);
+      std::fill(channel.input.begin(), channel.input.end(), 0.0f);
+      std::fill(channel.overlap.begin(), channel.overlap.end(), 0.0f);
+      std::fill(channel.tail.begin(), channel.tail.end(), 0.0f);
+      std::fill(channel.tailB.begin(), channel.tailB.end(), 0.0f);
+      channel.slot = 0;
+      channel.inputPos = 0;
+    }
+  }
+
+  void process(juce::dsp::AudioBlock<float>& block, float targetBlend) {
+    const int numSamples = static_cast<int>(block.getNumSamples());
+    const size_t numChannels = juce::jmin(block.getNumChannels(), channels.size());
+    int done = 0;
+    while (done < numSamples) {
+      // The kernel only changes between partitions, so every segment of one uses the same
+      if (channels[0].inputPos == 0)
+        updateBlend(targetBlend);
+      const int count = juce::jmin(numSamples - done, blockSize - channels[0].inputPos);
+      for (size_t channel = 0; channel < numChannels; ++channel)
+        processSegment(channels[channel], block.getChannelPointer(channel) + done, count);
+      done += count;
+    }
+  }
+
+private:
+  struct Channel {
+    explicit Channel(const MemoryArena::Allocator<float>& allocator)
+        : delayLine(allocator),
+          input(allocator),
+          overlap(allocator),
+          tail(allocator),
+          tailB(allocator) {}
+
+    MemoryArena::Vector<float> delayLine;  // Spectra of the last numPartitions input blocks
+    MemoryArena::Vector<float> input;      // Current input block, filled as samples arrive
+    MemoryArena::Vector<float> overlap;    // Second half of the previous block's output
+    MemoryArena::Vector<float> tail;       // Older blocks' contribution to the current one
+    MemoryArena::Vector<float> tailB;      // The same against IR B alone, during a blend ramp
+    int slot = 0;                  // Delay line slot of the current block
+    int inputPos = 0;
+  };
+
+  // Zero-latency overlap-add: the current block is transformed again each time samples arrive,
+  // while older blocks' products are summed once, when the block starts. During a blend ramp the
+  // products are summed against IR A and IR B separately and the two sums crossfaded, since the
+  // products are linear in the kernel; the mixed kernel is only rebuilt once the ramp settles.
+  void processSegment(Channel& channel, float* samples, int count) {
+    std::copy(samples, samples + count, channel.input.begin() + channel.inputPos);
+    float* spectrum = channel.delayLine.data() + channel.slot * stride;
+    computeSpectrum(channel.input.data(), blockSize, spectrum);
+
+    const float* kernelA = ramping ? spectraA.data() : kernel;
+    if (channel.inputPos == 0) {
+      std::fill(channel.tail.begin(), channel.tail.end(), 0.0f);
+      if (ramping)
+        std::fill(channel.tailB.begin(), channel.tailB.end(), 0.0f);
+      for (int partition = 1; partition < numPartitions; ++partition) {
+        const int slot = (channel.slot + partition) % numPartitions;
+        const float* input = channel.delayLine.data() + slot * stride;
+        multiplyAccumulate(input, kernelA + partition * stride, channel.tail.data(), numBins);
+        if (ramping)
+          multiplyAccumulate(input, spectraB.data() + partition * stride, channel.tailB.data(),
+                             numBins);
+      }
+    }
+    std::copy(channel.tail.begin(), channel.tail.end(), accumulator.begin());
+    multiplyAccumulate(spectrum, kernelA, accumulator.data(), numBins);
+    if (ramping) {
+      std::copy(channel.tailB.begin(), channel.tailB.end(), accumulatorB.begin());
+      multiplyAccumulate(spectrum, spectraB.data(), accumulatorB.data(), numBins);
+      crossfade(accumulator.data(), accumulatorB.data(), blend, stride);
+    }
+
+    // Back to JUCE's interleaved layout, with the negative frequencies mirrored
+    for (int k = 0; k < numBins; ++k) {
+      work[static_cast<size_t>(2 * k)] = accumulator[static_cast<size_t>(k)];
+      work[static_cast<size_t>(2 * k + 1)] = accumulator[static_cast<size_t>(numBins + k)];
+    }
+    for (int k = numBins; k < fftSize; ++k) {
+      work[static_cast<size_t>(2 * k)] = work[static_cast<size_t>(2 * (fftSize - k))];
+      work[static_cast<size_t>(2 * k + 1)] = -work[static_cast<size_t>(2 * (fftSize - k) + 1)];
+    }
+    fft.performRealOnlyInverseTransform(work.data());
+
+    for (int i = 0; i < count; ++i) {
+      const auto index = static_cast<size_t>(channel.inputPos + i);
+      samples[i] = work[index] + channel.overlap[index];
+    }
+
+    channel.inputPos += count;
+    if (channel.inputPos == blockSize) {
+      std::copy(work.begin() + blockSize, work.begin() + fftSize, channel.overlap.begin());
+      std::fill(channel.input.begin(), channel.input.end(), 0.0f);
+      channel.inputPos = 0;
+      channel.slot = (channel.slot + numPartitions - 1) % numPartitions;
+    }
+  }
+
+  void computeSpectrum(const float* samples, int count, float* spectrum) {
+    std::fill(work.begin(), work.end(), 0.0f);
+    std::copy(samples, samples + count, work.begin());
+    fft.performRealOnlyForwardTransform(work.data(), true);
+    for (int k = 0; k < numBins; ++k) {
+      spectrum[k] = work[static_cast<size_t>(2 * k)];
+      spectrum[numBins + k] = work[static_cast<size_t>(2 * k + 1)];
+    }
+  }
+
+  MemoryArena::Vector<float> computePartitionSpectra(const std::vector<float>& ir) {
+    if (ir.empty())
+      return MemoryArena::Vector<float>(allocator);
+    MemoryArena::Vector<float> spectra(static_cast<size_t>(numPartitions * stride), 0.0f,
+                                       allocator);
+    for (int partition = 0; partition < numPartitions; ++partition) {
+      const auto start = static_cast<size_t>(partition * blockSize);
+      const auto count = start < ir.size() ? juce::jmin(ir.size() - start, size_t(blockSize)) : 0;
+      computeSpectrum(ir.data() + start, static_cast<int>(count),
+                      spectra.data() + partition * stride);
+    }
+    return spectra;
+  }
+
+  void updateBlend(float target) {
+    if (!blending)
+      return;
+    if (blend != target)
+      blend = target > blend ? juce::jmin(target, blend + blendStep)
+                             : juce::jmax(target, blend - blendStep);
+    // Settled: one remix, then a single kernel again
+    if (blend == target && mixedBlend != blend)
+      mixSpectra();
+    ramping = mixedBlend != blend;
+  }
+
+  void mixSpectra() {
+    for (size_t i = 0; i < mixed.size(); ++i)
+      mixed[i] = spectraA[i] + blend * (spectraB[i] - spectraA[i]);
+    mixedBlend = blend;
+  }
+
+  const int blockSize;
+  const int fftSize;
+  const int numBins;
+  const int stride;  // Floats per spectrum
+  int numPartitions = 1;
+  juce::dsp::FFT fft;
+  const MemoryArena::Allocator<float> allocator;
+  MemoryArena::Vector<float> work;
+  MemoryArena::Vector<float> accumulator;
+  MemoryArena::Vector<float> accumulatorB;  // IR B's products during a blend ramp
+
+  MemoryArena::Vector<float> spectraA;
+  MemoryArena::Vector<float> spectraB;
+  MemoryArena::Vector<float> mixed;
+  const float* kernel = nullptr;
+  bool blending = false;
+  bool ramping = false;  // blend has moved away from the blend the mixed kernel was built for
+  float blend;
+  float mixedBlend = 0.0f;
+  const float blendStep;
+
+  std::vector<Channel> channels;
+};
+
+DualIrConvolver::DualIrConvolver(MemoryArena* arena) : memory(arena) {}
+
+DualIrConvolver::~DualIrConvolver() {
+  delete pending.exchange(nullptr);
+  delete current;
+  delete fading;
+  freeRetiredEnginesLocked();
+}
+
+void DualIrConvolver::prepare(double newSampleRate, int maxBlockSize, int newNumChannels) {
+  const juce::ScopedLock lock(buildLock);
+
+  // Audio is stopped, so every engine can go now
+  delete pending.exchange(nullptr);
+  delete current;
+  delete fading;
+  current = nullptr;
+  fading = nullptr;
+  fadeRemaining = 0;
+  freeRetiredEnginesLocked();
+
+  sampleRate = newSampleRate;
+  blockSize = juce::nextPowerOfTwo(juce::jmax(1, maxBlockSize));
+  numChannels = juce::jmax(1, newNumChannels);
+  fadeLength = juce::jmax(1, juce::roundToInt(crossfadeSeconds * sampleRate));
+  fadeBuffer.setSize(numChannels, juce::jmax(1, maxBlockSize));
+
+  for (size_t slot = 0; slot < irs.size(); ++slot) {
+    if (std::abs(irSampleRates[slot] - sampleRate) > 0.1) {
+      irs[slot].clear();
+      minimumPhaseIrs[slot].clear();
+    }
+  }
+  // Nothing to crossfade from
+  if (hasAnyIr())
+    current = buildEngine().release();
+}
+
+void DualIrConvolver::loadIr(Slot slot,
+                             const juce::AudioBuffer<float>& ir,
+                             double irSampleRate,
+                             bool normalise) {
+  auto impulse = conditionImpulse(ir, normalise);
+  const juce::ScopedLock lock(buildLock);
+  irs[static_cast<size_t>(slot)] = std::move(impulse);
+  irSampleRates[static_cast<size_t>(slot)] = irSampleRate;
+  updateMinimumPhaseIr(static_cast<size_t>(slot));
+  if (hasAnyIr())
+    publish(buildEngine());
+}
+
+void DualIrConvolver::clearIr(Slot slot) {
+  const juce::ScopedLock lock(buildLock);
+  if (irs[static_cast<size_t>(slot)].empty())
+    return;
+  irs[static_cast<size_t>(slot)].clear();
+  minimumPhaseIrs[static_cast<size_t>(slot)].clear();
+  // With neither loaded the owner stops calling process(), so the last engine can stay
+  if (hasAnyIr())
+    publish(buildEngine());
+}
+
+bool DualIrConvolver::hasIr(Slot slot) const {
+  const juce::ScopedLock lock(buildLock);
+  return !irs[static_cast<size_t>(slot)].empty();
+}
+
+bool DualIrConvolver::hasAnyIr() const {
+  const juce::ScopedLock lock(buildLock);
+  return !irs[slotA].empty() || !irs[slotB].empty();
+}
+
+void DualIrConvolver::setAlignment(int samples) {
+  const juce::ScopedLock lock(buildLock);
+  if (samples == alignmentSamples)
+    return;
+  alignmentSamples = samples;
+  if (!minimumPhase && !irs[slotA].empty() && !irs[slotB].empty())
+    publish(buildEngine());
+}
+
+void DualIrConvolver::setMinimumPhase(bool shouldUseMinimumPhase) {
+  const juce::ScopedLock lock(buildLock);
+  if (shouldUseMinimumPhase == minimumPhase)
+    return;
+  minimumPhase = shouldUseMinimumPhase;
+  for (size_t slot = 0; slot < irs.size(); ++slot)
+    updateMinimumPhaseIr(slot);
+  if (hasAnyIr())
+    publish(buildEngine());
+}
+
+bool DualIrConvolver::isMinimumPhase() const {
+  const juce::ScopedLock lock(buildLock);
+  return minimumPhase;
+}
+
+void DualIrConvolver::updateMinimumPhaseIr(size_t slot) {
+  if (!minimumPhase || irs[slot].empty()) {
+    minimumPhaseIrs[slot].clear();
+    return;
+  }
+  minimumPhaseIrs[slot] =
+      makeMinimumPhase(irs[slot], juce::roundToInt(minimumPhaseSeconds * sampleRate));
+}
+
+std::vector<float> DualIrConvolver::makeMinimumPhase(const std::vector<float>& ir, int maxLength) {
+  if (ir.empty() || maxLength <= 0)
+    return {};
+
+  // Padded to four times the IR, so the folded cepstrum barely aliases
+  const int irSize = juce::nextPowerOfTwo(static_cast<int>(ir.size()));
+  const int irOrder = juce::roundToInt(std::log2(irSize));
+  const int order = juce::jlimit(10, 17, irOrder + 2);
+  const int size = 1 << order;
+  juce::dsp::FFT fft(order);
+  std::vector<std::complex<float>> spectrum(static_cast<size_t>(size));
+  std::vector<std::complex<float>> work(static_cast<size_t>(size));
+  std::copy_n(ir.begin(), juce::jmin(ir.size(), work.size()), work.begin());
+  fft.perform(work.data(), spectrum.data(), false);
+
+  // Real cepstrum of the magnitude, floored 120 dB under the peak so that notches stay finite
+  float peak = 0.0f;
+  for (const auto& bin : spectrum)
+    peak = juce::jmax(peak, std::abs(bin));
+  if (peak <= 0.0f)
+    return {};
+  for (auto& bin : spectrum)
+    bin = std::log(juce::jmax(std::abs(bin), peak * 1e-6f));
+  fft.perform(spectrum.data(), work.data(), true);
+
+  // Folding the anticausal half of the cepstrum onto the causal half makes it minimum phase
+  const size_t half = work.size() / 2;
+  work[0] = work[0].real();
+  for (size_t n = 1; n < half; ++n)
+    work[n] = 2.0f * work[n].real();
+  work[half] = work[half].real();
+  std::fill(work.begin() + static_cast<std::ptrdiff_t>(half) + 1, work.end(),
+            std::complex<float>{});
+  fft.perform(work.data(), spectrum.data(), false);
+  for (auto& bin : spectrum)
+    bin = std::exp(bin);
+  fft.perform(spectrum.data(), work.data(), true);
+
+  std::vector<float> impulse(static_cast<size_t>(juce::jmin(maxLength, size)));
+  for (size_t i = 0; i < impulse.size(); ++i)
+    impulse[i] = work[i].real();
+  impulse.resize(static_cast<size_t>(
+      getAudibleLength(impulse.data(), static_cast<int>(impulse.size()))));
+
+  // Raised-cosine fade over the last few milliseconds, so the cut doesn't click
+  const int length = static_cast<int>(impulse.size());
+  const int fade = juce::jmin(256, length / 4);
+  for (int i = 0; i < fade; ++i) {
+    const float phase = juce::MathConstants<float>::pi * static_cast<float>(i + 1) / fade;
+    impulse[static_cast<size_t>(length - fade + i)] *= 0.5f * (1.0f + std::cos(phase));
+  }
+  return impulse;
+}
+
+void DualIrConvolver::freeRetiredEngines() {
+  const juce::ScopedLock lock(buildLock);
+  freeRetiredEnginesLocked();
+}
+
+void DualIrConvolver::freeRetiredEnginesLocked() {
+  int start1, size1, start2, size2;
+  retiredFifo.prepareToRead(retiredFifo.getNumReady(), start1, size1, start2, size2);
+  for (int i = 0; i < size1 + size2; ++i) {
+    auto& engine = retired[static_cast<size_t>(i < size1 ? start1 + i : start2 + i - size1)];
+    delete engine;
+    engine = nullptr;
+  }
+  retiredFifo.finishedRead(size1 + size2);
+}
+
+std::unique_ptr<DualIrConvolver::Engine> DualIrConvolver::buildEngine() const {
+  std::array<std::vector<float>, numSlots> impulses;
+  int numIrs = 0;
+  size_t length = 0;
+  for (size_t slot = 0; slot < irs.size(); ++slot) {
+    if (irs[slot].empty())
+      continue;
+    const auto& ir = minimumPhase ? minimumPhaseIrs[slot] : irs[slot];
+    const int alignment = minimumPhase ? 0 : alignmentSamples;
+    const int delay = static_cast<int>(slot) == slotB ? alignment : -alignment;
+    impulses[slot].assign(static_cast<size_t>(juce::jmax(0, delay)), 0.0f);
+    impulses[slot].insert(impulses[slot].end(), ir.begin(), ir.end());
+    length = std::max(length, impulses[slot].size());
+    ++numIrs;
+  }
+
+  const int maxPartitions = getMaxPartitions(numIrs);
+  if (maxPartitions < 1) {
+    juce::Logger::writeToLog("[Convolver] No room under the memory cap for an IR");
+    return nullptr;
+  }
+  if (maxPartitions < Engine::getNumPartitions(length, blockSize))
+    juce::Logger::writeToLog("[Convolver] IR cut to " + juce::String(maxPartitions * blockSize) +
+                             " samples to stay under the memory cap");
+
+  const auto blendStep = static_cast<float>(blockSize / (blendRampSeconds * sampleRate));
+  try {
+    return std::make_unique<Engine>(impulses[slotA], impulses[slotB], blockSize, numChannels,
+                                    targetBlend.load(), blendStep, maxPartitions, memory);
+  } catch (const std::bad_alloc&) {
+    juce::Logger::writeToLog("[Convolver] Out of memory building an engine");
+    return nullptr;
+  }
+}
+
+// The partitions per IR that fit next to the engines still running. Old engines are only freed
+// once the new one has faded in, so the new one has to fit beside them.
+int DualIrConvolver::getMaxPartitions(int numIrs) const {
+  if (memory == nullptr)
+    return std::numeric_limits<int>::max();
+  const size_t available = memory->getAvailableBytes();
+  const size_t fixed = Engine::getBytes(blockSize, numChannels, numIrs, 0);
+  const size_t perPartition = Engine::getBytes(blockSize, numChannels, numIrs, 1) - fixed;
+  if (available < fixed + perPartition)
+    return 0;
+  return static_cast<int>(juce::jmin(static_cast<size_t>(std::numeric_limits<int>::max()),
+                                     (available - fixed) / perPartition));
+}
+
+void DualIrConvolver::publish(std::unique_ptr<Engine> engine) {
+  // Whoever exchanges an engine out of pending owns it, so one the audio thread never took is ours
+  delete pending.exchange(engine.release());
+}
+
+bool DualIrConvolver::retire(Engine* engine) {
+  if (engine == nullptr)
+    return true;
+  if (retiredFifo.getFreeSpace() == 0) {
+    jassertfalse;
+    return false;
+  }
+  int start1, size1, start2, size2;
+  retiredFifo.prepareToWrite(1, start1, size1, start2, size2);
+  retired[static_cast<size_t>(size1 > 0 ? start1 : start2)] = engine;
+  retiredFifo.finishedWrite(1);
+  return true;
+}
+
+void DualIrConvolver::process(juce::dsp::AudioBlock<float>& block) {
+  // Swapping retires up to two engines (one now, one when the crossfade ends), so only take a
+  // new one when both fit
+  if (pending.load() != nullptr && retiredFifo.getFreeSpace() >= 2) {
+    if (auto* next = pending.exchange(nullptr)) {
+      retire(fading);
+      fading = current;
+      current = next;
+      fadeRemaining = fading != nullptr ? fadeLength : 0;
+    }
+  }
+  if (current == nullptr)
+    return;
+
+  const auto numSamples = block.getNumSamples();
+  jassert(numSamples <= static_cast<size_t>(fadeBuffer.getNumSamples()));
+  juce::dsp::AudioBlock<float> fadeBlock(fadeBuffer);
+  fadeBlock = fadeBlock.getSubsetChannelBlock(0, juce::jmin(block.getNumChannels(),
+                                                            fadeBlock.getNumChannels()))
+                  .getSubBlock(0, numSamples);
+  if (fadeRemaining > 0)
+    fadeBlock.copyFrom(block);
+
+  const float blend = targetBlend.load(std::memory_order_relaxed);
+  current->process(block, blend);
+  if (fadeRemaining == 0)
+    return;
+
+  fading->process(fadeBlock, blend);
+  for (size_t channel = 0; channel < fadeBlock.getNumChannels(); ++channel) {
+    float* output = block.getChannelPointer(channel);
+    const float* previous = fadeBlock.getChannelPointer(channel);
+    for (size_t i = 0; i < numSamples; ++i) {
+      const float previousGain =
+          juce::jmax(0.0f, static_cast<float>(fadeRemaining - static_cast<int>(i)) /
+                               static_cast<float>(fadeLength));
+      output[i] += (previous[i] - output[i]) * previousGain;
+    }
+  }
+  fadeRemaining = juce::jmax(0, fadeRemaining - static_cast<int>(numSamples));
+  if (fadeRemaining == 0) {
+    retire(fading);
+    fading = nullptr;
+  }
+}
+
+void DualIrConvolver::reset() {
+  if (current != nullptr)
+    current->reset();
+  if (fading != nullptr && retire(fading)) {
+    fading = nullptr;
+    fadeRemaining = 0;
+  }
+}
@@ -15,8 +15,9 @@ NeuralAmpEditor::NeuralAmpEditor(NeuralAmpProcessor& p) : AudioProcessorEditor(&
                   juce::File::getSpecialLocation(juce::File::tempDirectory)))
 
           // Provide WebView UI resources from JUCE BinaryData (HTML/CSS/JS, etc.)
-          .withResourceProvider([this](const auto& url) { return getResource(url); },
-                                juce::URL{"http://localhost:5173/"}.getOrigin())
+          .withResourceProvider(
+              [](const auto& url) { return WebResources::getInstance().find(url); },
+              juce::URL{"http://localhost:5173/"}.getOrigin())
 
           // Add support for control focus tracking in the WebView (parameter automation)
           .withOptionsFrom(controlParameterIndexReceiver)
@@ -28,13 +29,20 @@ NeuralAmpEditor::NeuralAmpEditor(NeuralAmpProcessor& p) : AudioProcessorEditor(&
           .withOptionsFrom(midRelay)
           .withOptionsFrom(trebleRelay)
           .withOptionsFrom(noiseGateThresholdRelay)
+          .withOptionsFrom(modelBlendRelay)
+          .withOptionsFrom(irBlendRelay)
+          .withOptionsFrom(irAlignRelay)
           .withOptionsFrom(noiseGateToggleRelay)
           .withOptionsFrom(eqToggleRelay)
           .withOptionsFrom(irToggleRelay)
           .withOptionsFrom(normalizeNamOutputRelay)
           .withOptionsFrom(normalizeIrOutputRelay)
+          .withOptionsFrom(liveMonitoringRelay)
           .withOptionsFrom(modelDropdownRelay)
+          .withOptionsFrom(modelBDropdownRelay)
           .withOptionsFrom(irDropdownRelay)
+          .withOptionsFrom(irBDropdownRelay)
+          .withOptionsFrom(toneStackRelay)
 
           .withNativeFunction(
               "getModelChoices",
@@ -62,6 +70,98 @@ NeuralAmpEditor::NeuralAmpEditor(NeuralAmpProcessor& p) : AudioProcessorEditor(&
                 // "));
                 completion(result);
               })
+          .withNativeFunction(
+              "queryModels",
+              [this](const juce::Array<juce::var>& args,
+                     juce::WebBrowserComponent::NativeFunctionCompletion completion) {
+                // args: {query, architecture, sampleRate, sort: "name" | "newest", offset, limit}
+                const auto query =
+                    LibraryCatalogue::queryFromVar(args.isEmpty() ? juce::var() : args[0]);
+                completion(
+                    LibraryCatalogue::pageToVar(processor.getModelCatalogue().query(query)));
+              })
+          .withNativeFunction(
+              "queryIRs",
+              [this](const juce::Array<juce::var>& args,
+                     juce::WebBrowserComponent::NativeFunctionCompletion completion) {
+                const auto query =
+                    LibraryCatalogue::queryFromVar(args.isEmpty() ? juce::var() : args[0]);
+                completion(LibraryCatalogue::pageToVar(processor.getIrCatalogue().query(query)));
+              })
+          .withNativeFunction(
+              "loadModel",
+              [this](const juce::Array<juce::var>& args,
+                     juce::WebBrowserComponent::NativeFunctionCompletion completion) {
+                // args: catalogue ID, optional slot (0 = first model, 1 = second)
+                const auto slot = args.size() > 1 && static_cast<int>(args[1]) == 1
+                                      ? ModelBlender::slotB
+                                      : ModelBlender::slotA;
+                if (!args.isEmpty())
+                  processor.requestModel(args[0].toString(), slot);
+                completion(juce::var());
+              })
+          .withNativeFunction(
+              "loadIR",
+              [this](const juce::Array<juce::var>& args,
+                     juce::WebBrowserComponent::NativeFunctionCompletion completion) {
+                // args: catalogue ID, optional slot (0 = first IR, 1 = second)
+                const auto slot = args.size() > 1 && static_cast<int>(args[1]) == 1
+                                      ? DualIrConvolver::slotB
+                                      : DualIrConvolver::slotA;
+                if (!args.isEmpty())
+                  processor.requestIr(args[0].toString(), slot);
+                completion(juce::var());
+              })
+          .withNativeFunction(
+              "setModelInference",
+              [this](const juce::Array<juce::var>& args,
+                     juce::WebBrowserComponent::NativeFunctionCompletion completion) {
+                // args: model index, "float" | "int16" | "int8" | "auto"
+                if (args.size() >= 2)
+                  processor.setModelInferenceMode(static_cast<int>(args[0]), args[1].toString());
+                completion(juce::var());
+              })
+          .withNativeFunction(
+              "profileModels",
+              [this](const juce::Array<juce::var>& args,
+                     juce::WebBrowserComponent::NativeFunctionCompletion completion) {
+                // args: optional force (re-time models already profiled). Results appear in the
+                // catalogue's "cpu" fields once the library is next rescanned.
+                processor.requestLibraryProfiling(!args.isEmpty() && static_cast<bool>(args[0]));
+                completion(juce::var());
+              })
+
+          .withNativeFunction(
+              "getCaptureStatus",
+              [this](const juce::Array<juce::var>& args,
+                     juce::WebBrowserComponent::NativeFunctionCompletion completion) {
+                const auto status = processor.getCaptureStatus();
+                auto* result = new juce::DynamicObject();
+                result->setProperty("recording", status.recording);
+                result->setProperty("diFile", status.diFile.getFullPathName());
+                result->setProperty("outputFile", status.outputFile.getFullPathName());
+                result->setProperty("seconds", status.seconds);
+                result->setProperty("droppedSamples", status.droppedSamples);
+                result->setProperty("error", status.error);
+                completion(juce::var(result));
+              })
+          .withNativeFunction(
+              "getMemoryUsage",
+              [this](const juce::Array<juce::var>& args,
+                     juce::WebBrowserComponent::NativeFunctionCompletion completion) {
+                // Bytes per subsystem, plus the arena's committed size and cap
+                const auto usage = processor.getMemoryUsage();
+                auto* result = new juce::DynamicObject();
+                const auto bytes = [](size_t value) { return static_cast<juce::int64>(value); };
+                result->setProperty("modelWeights", bytes(usage.bytes[MemoryArena::modelWeights]));
+                result->setProperty("modelBuffers", bytes(usage.bytes[MemoryArena::modelBuffers]));
+                result->setProperty("convolution", bytes(usage.bytes[MemoryArena::convolution]));
+                result->setProperty("scratch", bytes(usage.bytes[MemoryArena::scratch]));
+                result->setProperty("committed", bytes(usage.committedBytes));
+                result->setProperty("capacity", bytes(usage.capacityBytes));
+                result->setProperty("locked", usage.locked);
+                completion(juce::var(result));
+              })
 
           // Inject debug message into browser console on load
           .withUserScript(R"(console.log("JUCE C++ Backend is running!");)"));
@@ -75,6 +175,8 @@ NeuralAmpEditor::NeuralAmpEditor(NeuralAmpProcessor& p) : AudioProcessorEditor(&
     webView->goToURL(juce::WebBrowserComponent::getResourceProviderRoot() + "index.html");
   });
 
+  startTimerHz(telemetryRateHz);
+
   // !!!
   /*
   // Attach Sliders
@@ -190,7 +292,44 @@ NeuralAmpEditor::NeuralAmpEditor(NeuralAmpProcessor& p) : AudioProcessorEditor(&
   */
 }
 
-NeuralAmpEditor::~NeuralAmpEditor() {}
+NeuralAmpEditor::~NeuralAmpEditor() {
+  stopTimer();
+}
+
+void NeuralAmpEditor::timerCallback() {
+  if (const int generation = NeuralAmpProcessor::getListingGeneration();
+      generation != listingGeneration) {
+    listingGeneration = generation;
+    webView->emitEventIfBrowserIsVisible("libraryChanged", juce::var());
+  }
+
+  TelemetryFrame frame;
+  const int numFrames = processor.getTelemetry().drain(
+      [&frame](const TelemetryFrame& next) { Telemetry::merge(frame, next); });
+  if (numFrames == 0)
+    return;
+
+  auto toDecibels = [](float gain) { return juce::Decibels::gainToDecibels(gain, -100.0f); };
+  auto levels = [&toDecibels](const std::array<float, TelemetryFrame::maxChannels>& values) {
+    juce::Array<juce::var> result;
+    for (float value : values)
+      result.add(toDecibels(value));
+    return result;
+  };
+
+  auto* payload = new juce::DynamicObject();
+  payload->setProperty("inputPeak", levels(frame.inputPeak));
+  payload->setProperty("inputRms", levels(frame.inputRms));
+  payload->setProperty("outputPeak", levels(frame.outputPeak));
+  payload->setProperty("outputRms", levels(frame.outputRms));
+  payload->setProperty("gateOpen", frame.gateOpen);
+  payload->setProperty("load", frame.load);
+  payload->setProperty("xruns", frame.xruns);
+  payload->setProperty("recoveries", frame.recoveries);
+  payload->setProperty("faultedModels", frame.faultedModels);
+  payload->setProperty("refusedModels", frame.refusedModels);
+  webView->emitEventIfBrowserIsVisible("telemetry", juce::var(payload));
+}
 
 void NeuralAmpEditor::paint(juce::Graphics& g) {
   // g.fillAll(getLookAndFeel().findColour(juce::ResizableWindow::backgroundColourId));
@@ -324,58 +463,3 @@ void NeuralAmpEditor::updateIrDropdown() {
   }
 }
 */
-
-// Get the WebView UI resources from BinaryData
-std::optional<juce::WebBrowserComponent::Resource> NeuralAmpEditor::getResource(
-    const juce::String& url) {
-  juce::Logger::writeToLog("Requested URL: " + url);
-
-  // Extract filename and normalize to match BinaryData naming
-  juce::String filename = juce::URL(url).getFileName().trim();
-  juce::String resourceName = filename.removeCharacters("-").replaceCharacter('.', '_');
-
-  int size = 0;
-  const char* data = BinaryData::getNamedResource(resourceName.toRawUTF8(), size);
-
-  if (data == nullptr || size <= 0) {
-    juce::Logger::writeToLog("Resource not found or empty: " + resourceName);
-    return std::nullopt;
-  }
-
-  std::vector<std::byte> content(static_cast<size_t>(size));
-  std::memcpy(content.data(), data, static_cast<size_t>(size));
-
-  juce::String ext = filename.fromLastOccurrenceOf(".", false, false).toLowerCase();
-  juce::String mime = getMimeForExtension(ext);
-  if (mime.isEmpty())
-    mime = "application/octet-stream";
-
-  juce::Logger::writeToLog("Returning resource: " + resourceName + " (" + mime + ")");
-  return juce::WebBrowserComponent::Resource{std::move(content), mime};
-}
-
-// Map file extensions to MIME types for serving embedded resources in the WebView UI
-juce::String NeuralAmpEditor::getMimeForExtension(const juce::String& extension) {
-  static const std::unordered_map<juce::String, juce::String> mimeMap = {
-      {"htm", "text/html"},
-      {"html", "text/html"},
-      {"txt", "text/plain"},
-      {"jpg", "image/jpeg"},
-      {"jpeg", "image/jpeg"},
-      {"svg", "image/svg+xml"},
-      {"ico", "image/vnd.microsoft.icon"},
-      {"json", "application/json"},
-      {"png", "image/png"},
-      {"css", "text/css"},
-      {"map", "application/json"},
-      {"js", "text/javascript"},
-      {"woff2", "font/woff2"}};
-
-  const auto lower = extension.toLowerCase();
-
-  if (const auto it = mimeMap.find(lower); it != mimeMap.end())
-    return it->second;
-
-  jassertfalse;
-  return "application/octet-stream";
-}
\ No newline at end of file
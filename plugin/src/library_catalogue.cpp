@@ -0,0 +1,233 @@
+#include "library_catalogue.h"
+#include <juce_audio_formats/juce_audio_formats.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <optional>
+
+namespace {
+// Offset of key's opening quote among the outer object's keys in text, which may be cut short
+std::optional<size_t> findTopLevelKey(const juce::MemoryBlock& text, const char* key) {
+  const auto* data = static_cast<const char*>(text.getData());
+  const size_t size = text.getSize();
+  const size_t keyLength = std::strlen(key);
+  int depth = 0;
+  bool inString = false;
+  for (size_t i = 0; i < size; ++i) {
+    const char c = data[i];
+    if (inString) {
+      if (c == '\\')
+        ++i;
+      else if (c == '"')
+        inString = false;
+    } else if (c == '"') {
+      const size_t end = i + 1 + keyLength;
+      if (depth == 1 && end < size && data[end] == '"' &&
+          std::memcmp(data + i + 1, key, keyLength) == 0) {
+        size_t next = end + 1;
+        while (next < size && juce::CharacterFunctions::isWhitespace(data[next]))
+          ++next;
+        if (next < size && data[next] == ':')
+          return i;
+      }
+      inString = true;
+    } else if (c == '{' || c == '[') {
+      ++depth;
+    } else if (c == '}' || c == ']') {
+      --depth;
+    }
+  }
+  return std::nullopt;
+}
+
+// Closes the members in text (a run of "key": value pairs) into an object and parses it
+juce::var parseMembers(juce::String members) {
+  members = members.trim();
+  if (members.endsWithChar(','))
+    members = members.dropLastCharacters(1);
+  if (members.startsWithChar(','))
+    members = members.substring(1);
+  return juce::JSON::parse("{" + members + "}");
+}
+
+// A .nam file is mostly its weights array, which comes after the header keys; newer exports put
+// sample_rate straight after it. Parses the keys before "weights" from a bounded head of the file
+// and those after it from a bounded tail, so the weights are never read or parsed.
+juce::var readNamHeader(const juce::File& file) {
+  constexpr juce::int64 headBytes = 65536;
+  constexpr juce::int64 tailBytes = 4096;
+  juce::FileInputStream stream(file);
+  if (!stream.openedOk())
+    return {};
+  const auto size = stream.getTotalLength();
+  if (size <= headBytes + tailBytes)
+    return juce::JSON::parse(stream.readEntireStreamAsString());
+
+  juce::MemoryBlock head;
+  stream.readIntoMemoryBlock(head, headBytes);
+  const auto weights = findTopLevelKey(head, "weights");
+  if (!weights) {
+    DBG("No weights near the start of " << file.getFullPathName() << "; parsing all of it");
+    stream.setPosition(0);
+    return juce::JSON::parse(stream.readEntireStreamAsString());
+  }
+  const auto* headText = static_cast<const char*>(head.getData());
+  const auto* open = static_cast<const char*>(std::memchr(headText, '{', *weights));
+  if (open == nullptr)
+    return {};
+  auto header = parseMembers(
+      juce::String::fromUTF8(open + 1, static_cast<int>(headText + *weights - open - 1)));
+  auto* headerObject = header.getDynamicObject();
+  if (headerObject == nullptr)
+    return {};
+
+  // The weights are a flat array of numbers, so the tail's first ']' closes them
+  juce::MemoryBlock tail;
+  stream.setPosition(size - tailBytes);
+  stream.readIntoMemoryBlock(tail, tailBytes);
+  const auto* tailText = static_cast<const char*>(tail.getData());
+  const auto* close = static_cast<const char*>(std::memchr(tailText, ']', tail.getSize()));
+  if (close != nullptr) {
+    const auto length = static_cast<int>(tailText + tail.getSize() - (close + 1));
+    auto trailing = juce::String::fromUTF8(close + 1, length).trimEnd();
+    if (trailing.endsWithChar('}'))
+      trailing = trailing.dropLastCharacters(1);
+    if (const auto* trailingObject = parseMembers(trailing).getDynamicObject()) {
+      for (const auto& property : trailingObject->getProperties())
+        headerObject->setProperty(property.name, property.value);
+    }
+  }
+  return header;
+}
+}  // namespace
+
+LibraryCatalogue::LibraryCatalogue(Kind k, juce::File f, LibraryIndex& i)
+    : kind(k), folder(std::move(f)), index(i) {}
+
+bool LibraryCatalogue::refresh(const std::function<bool()>& shouldExit) {
+  if (!folder.isDirectory())
+    return true;
+
+  const auto files = folder.findChildFiles(juce::File::findFiles, false,
+                                           kind == Kind::model ? "*.nam" : "*.wav");
+  std::vector<Item> scanned;
+  scanned.reserve(static_cast<size_t>(files.size()));
+  for (const auto& file : files) {
+    if (shouldExit && shouldExit())
+      return false;
+    auto info = index.getFileInfo(file);
+    if (!info) {
+      info = readFileInfo(file);
+      index.setFileInfo(file, *info);
+    }
+
+    Item item;
+    item.id = file.getRelativePathFrom(folder);
+    item.name = file.getFileNameWithoutExtension();
+    item.architecture = info->architecture;
+    item.sampleRate = info->sampleRate;
+    item.modificationTime = file.getLastModificationTime().toMilliseconds();
+    if (kind == Kind::model)
+      item.cpu = index.getCpuProfile(file);
+    scanned.push_back(std::move(item));
+  }
+
+  std::sort(scanned.begin(), scanned.end(), [](const Item& a, const Item& b) {
+    return a.name.compareIgnoreCase(b.name) < 0;
+  });
+
+  const juce::ScopedLock sl(lock);
+  items.swap(scanned);
+  return true;
+}
+
+LibraryIndex::FileInfo LibraryCatalogue::readFileInfo(const juce::File& file) const {
+  LibraryIndex::FileInfo info;
+  if (kind == Kind::model) {
+    const juce::var root = readNamHeader(file);
+    info.architecture = root["architecture"].toString();
+    if (root.hasProperty("sample_rate"))
+      info.sampleRate = static_cast<double>(root["sample_rate"]);
+  } else {
+    juce::AudioFormatManager formatManager;
+    formatManager.registerBasicFormats();
+    if (std::unique_ptr<juce::AudioFormatReader> reader{formatManager.createReaderFor(file)})
+      info.sampleRate = reader->sampleRate;
+  }
+  return info;
+}
+
+LibraryCatalogue::Page LibraryCatalogue::query(const Query& q) const {
+  const juce::ScopedLock sl(lock);
+
+  std::vector<const Item*> matches;
+  matches.reserve(items.size());
+  for (const auto& item : items) {
+    if (q.text.isNotEmpty() && !item.name.containsIgnoreCase(q.text))
+      continue;
+    if (q.architecture.isNotEmpty() && !item.architecture.equalsIgnoreCase(q.architecture))
+      continue;
+    if (q.sampleRate > 0.0 && std::abs(item.sampleRate - q.sampleRate) > 0.5)
+      continue;
+    matches.push_back(&item);
+  }
+
+  if (q.sort == Sort::newest) {
+    std::stable_sort(matches.begin(), matches.end(), [](const Item* a, const Item* b) {
+      return a->modificationTime > b->modificationTime;
+    });
+  }
+
+  Page page;
+  page.total = static_cast<int>(matches.size());
+  const int begin = juce::jlimit(0, page.total, q.offset);
+  const int end = juce::jmin(page.total, begin + juce::jlimit(0, maxLimit, q.limit));
+  page.items.reserve(static_cast<size_t>(end - begin));
+  for (int i = begin; i < end; ++i)
+    page.items.push_back(*matches[static_cast<size_t>(i)]);
+  return page;
+}
+
+juce::File LibraryCatalogue::getFile(const juce::String& id) const {
+  const juce::ScopedLock sl(lock);
+  const bool known = std::any_of(items.begin(), items.end(),
+                                 [&id](const Item& item) { return item.id == id; });
+  return known ? folder.getChildFile(id) : juce::File();
+}
+
+LibraryCatalogue::Query LibraryCatalogue::queryFromVar(const juce::var& object) {
+  Query q;
+  q.text = object.getProperty("query", {}).toString();
+  q.architecture = object.getProperty("architecture", {}).toString();
+  q.sampleRate = static_cast<double>(object.getProperty("sampleRate", 0.0));
+  q.sort = object.getProperty("sort", {}).toString() == "newest" ? Sort::newest : Sort::name;
+  q.offset = static_cast<int>(object.getProperty("offset", 0));
+  q.limit = static_cast<int>(object.getProperty("limit", q.limit));
+  return q;
+}
+
+juce::var LibraryCatalogue::pageToVar(const Page& page) {
+  juce::Array<juce::var> items;
+  for (const auto& item : page.items) {
+    juce::DynamicObject::Ptr object = new juce::DynamicObject();
+    object->setProperty("id", item.id);
+    object->setProperty("name", item.name);
+    object->setProperty("architecture", item.architecture);
+    object->setProperty("sampleRate", item.sampleRate);
+    if (item.cpu) {
+      juce::DynamicObject::Ptr cpu = new juce::DynamicObject();
+      cpu->setProperty("sampleRate", item.cpu->sampleRate);
+      cpu->setProperty("blockSize", item.cpu->blockSize);
+      cpu->setProperty("realTimeFactor", item.cpu->realTimeFactor);
+      cpu->setProperty("peakBlockMs", item.cpu->peakBlockMs);
+      cpu->setProperty("overBudget", item.cpu->overBudget);
+      object->setProperty("cpu", juce::var(cpu.get()));
+    }
+    items.add(juce::var(object.get()));
+  }
+
+  juce::DynamicObject::Ptr result = new juce::DynamicObject();
+  result->setProperty("total", page.total);
+  result->setProperty("items", items);
+  return juce::var(result.get());
+}
@@ -0,0 +1,202 @@
+#include "library_index.h"
+
+LibraryIndex::LibraryIndex(juce::File indexFile) : file(std::move(indexFile)) {}
+
+juce::File LibraryIndex::getDefaultFile() {
+  return juce::File::getSpecialLocation(juce::File::userApplicationDataDirectory)
+      .getChildFile("TonalFlex")
+      .getChildFile("NeuralAmp")
+      .getChildFile("library-index.json");
+}
+
+void LibraryIndex::load() {
+  const juce::ScopedLock sl(lock);
+  entries.clear();
+  dirty = false;
+
+  if (!file.existsAsFile())
+    return;
+
+  const juce::var root = juce::JSON::parse(file);
+  const auto* models = root["models"].getDynamicObject();
+  if (models == nullptr) {
+    DBG("Library index is empty or unreadable: " << file.getFullPathName());
+    return;
+  }
+
+  for (const auto& property : models->getProperties()) {
+    Entry entry;
+    entry.modificationTime = static_cast<juce::int64>(property.value["modified"]);
+    // "loudness" was measured after the IR and is ignored; "modelLoudness" is the model's own
+    if (property.value.hasProperty("modelLoudness"))
+      entry.loudness = static_cast<float>(property.value["modelLoudness"]);
+    entry.inferenceMode = property.value["inference"].toString();
+    if (const auto* esr = property.value["backendEsr"].getDynamicObject()) {
+      for (const auto& backend : esr->getProperties())
+        entry.backendEsr[backend.name.toString()] = static_cast<double>(backend.value);
+    }
+    if (property.value.hasProperty("sampleRate")) {
+      entry.info = FileInfo{property.value["architecture"].toString(),
+                            static_cast<double>(property.value["sampleRate"])};
+    }
+    if (const auto& cpu = property.value["cpu"]; cpu.isObject()) {
+      entry.cpu = CpuProfile{static_cast<double>(cpu["sampleRate"]),
+                             static_cast<int>(cpu["blockSize"]),
+                             static_cast<double>(cpu["realTimeFactor"]),
+                             static_cast<double>(cpu["peakBlockMs"]),
+                             static_cast<bool>(cpu["overBudget"])};
+    }
+    entries[property.name.toString()] = entry;
+  }
+  DBG("Library index loaded with " << static_cast<int>(entries.size()) << " entries");
+}
+
+void LibraryIndex::saveIfNeeded() {
+  const juce::ScopedLock sl(lock);
+  if (!dirty)
+    return;
+
+  juce::DynamicObject::Ptr models = new juce::DynamicObject();
+  for (const auto& [path, entry] : entries) {
+    juce::DynamicObject::Ptr object = new juce::DynamicObject();
+    object->setProperty("modified", entry.modificationTime);
+    if (entry.loudness)
+      object->setProperty("modelLoudness", *entry.loudness);
+    if (entry.inferenceMode.isNotEmpty())
+      object->setProperty("inference", entry.inferenceMode);
+    if (!entry.backendEsr.empty()) {
+      juce::DynamicObject::Ptr esr = new juce::DynamicObject();
+      for (const auto& [backend, value] : entry.backendEsr)
+        esr->setProperty(backend, value);
+      object->setProperty("backendEsr", juce::var(esr.get()));
+    }
+    if (entry.info) {
+      object->setProperty("architecture", entry.info->architecture);
+      object->setProperty("sampleRate", entry.info->sampleRate);
+    }
+    if (entry.cpu) {
+      juce::DynamicObject::Ptr cpu = new juce::DynamicObject();
+      cpu->setProperty("sampleRate", entry.cpu->sampleRate);
+      cpu->setProperty("blockSize", entry.cpu->blockSize);
+      cpu->setProperty("realTimeFactor", entry.cpu->realTimeFactor);
+      cpu->setProperty("peakBlockMs", entry.cpu->peakBlockMs);
+      cpu->setProperty("overBudget", entry.cpu->overBudget);
+      object->setProperty("cpu", juce::var(cpu.get()));
+    }
+    models->setProperty(path, juce::var(object.get()));
+  }
+
+  juce::DynamicObject::Ptr root = new juce::DynamicObject();
+  root->setProperty("version", 1);
+  root->setProperty("models", juce::var(models.get()));
+
+  file.getParentDirectory().createDirectory();
+  if (file.replaceWithText(juce::JSON::toString(juce::var(root.get()))))
+    dirty = false;
+  else
+    DBG("Failed to write library index: " << file.getFullPathName());
+}
+
+LibraryIndex::Entry* LibraryIndex::findEntry(const juce::File& model) {
+  auto it = entries.find(model.getFullPathName());
+  if (it == entries.end())
+    return nullptr;
+
+  // A changed file invalidates everything we measured about it
+  if (it->second.modificationTime != model.getLastModificationTime().toMilliseconds())
+    return nullptr;
+
+  return &it->second;
+}
+
+const LibraryIndex::Entry* LibraryIndex::findEntry(const juce::File& model) const {
+  return const_cast<LibraryIndex*>(this)->findEntry(model);
+}
+
+LibraryIndex::Entry& LibraryIndex::getOrCreateEntry(const juce::File& model) {
+  if (auto* entry = findEntry(model))
+    return *entry;
+
+  auto& entry = entries[model.getFullPathName()];
+  entry = Entry{};
+  entry.modificationTime = model.getLastModificationTime().toMilliseconds();
+  dirty = true;
+  return entry;
+}
+
+std::optional<float> LibraryIndex::getLoudness(const juce::File& model) const {
+  const juce::ScopedLock sl(lock);
+  if (const auto* entry = findEntry(model))
+    return entry->loudness;
+  return std::nullopt;
+}
+
+void LibraryIndex::setLoudness(const juce::File& model, float loudness) {
+  const juce::ScopedLock sl(lock);
+  auto& entry = getOrCreateEntry(model);
+  if (entry.loudness && std::abs(*entry.loudness - loudness) < 0.1f)
+    return;
+
+  entry.loudness = loudness;
+  dirty = true;
+}
+
+juce::String LibraryIndex::getInferenceMode(const juce::File& model) const {
+  const juce::ScopedLock sl(lock);
+  if (const auto* entry = findEntry(model); entry != nullptr && entry->inferenceMode.isNotEmpty())
+    return entry->inferenceMode;
+  return "float";
+}
+
+void LibraryIndex::setInferenceMode(const juce::File& model, const juce::String& mode) {
+  const juce::ScopedLock sl(lock);
+  auto& entry = getOrCreateEntry(model);
+  if (entry.inferenceMode == mode)
+    return;
+
+  entry.inferenceMode = mode;
+  entry.cpu.reset();
+  dirty = true;
+}
+
+std::optional<double> LibraryIndex::getBackendEsr(const juce::File& model,
+                                                  const juce::String& backend) const {
+  const juce::ScopedLock sl(lock);
+  if (const auto* entry = findEntry(model)) {
+    if (auto it = entry->backendEsr.find(backend); it != entry->backendEsr.end())
+      return it->second;
+  }
+  return std::nullopt;
+}
+
+void LibraryIndex::setBackendEsr(const juce::File& model, const juce::String& backend, double esr) {
+  const juce::ScopedLock sl(lock);
+  getOrCreateEntry(model).backendEsr[backend] = esr;
+  dirty = true;
+}
+
+std::optional<LibraryIndex::FileInfo> LibraryIndex::getFileInfo(const juce::File& file) const {
+  const juce::ScopedLock sl(lock);
+  if (const auto* entry = findEntry(file))
+    return entry->info;
+  return std::nullopt;
+}
+
+void LibraryIndex::setFileInfo(const juce::File& file, const FileInfo& info) {
+  const juce::ScopedLock sl(lock);
+  getOrCreateEntry(file).info = info;
+  dirty = true;
+}
+
+std::optional<LibraryIndex::CpuProfile> LibraryIndex::getCpuProfile(const juce::File& model) const {
+  const juce::ScopedLock sl(lock);
+  if (const auto* entry = findEntry(model))
+    return entry->cpu;
+  return std::nullopt;
+}
+
+void LibraryIndex::setCpuProfile(const juce::File& model, const CpuProfile& profile) {
+  const juce::ScopedLock sl(lock);
+  getOrCreateEntry(model).cpu = profile;
+  dirty = true;
+}
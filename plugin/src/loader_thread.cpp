@@ -0,0 +1,125 @@
+#include "loader_thread.h"
+#include "processor.h"
+
+LoaderThread::LoaderThread(NeuralAmpProcessor& p)
+    : juce::Thread("NeuralAmp Loader"), processor(p) {}
+
+LoaderThread::~LoaderThread() {
+  stop();
+}
+
+// The jobs are members and use the processor, so they must have finished before either goes.
+// Neither is ever abandoned: both are told to exit, then waited for, and check between files.
+void LoaderThread::stop() {
+  signalThreadShouldExit();
+  catalogueRefreshJob.signalJobShouldExit();
+  libraryProfileJob.signalJobShouldExit();
+  stopThread(-1);
+  threads->getWorkers().removeJob(&catalogueRefreshJob, true, -1);
+  threads->getWorkers().removeJob(&libraryProfileJob, true, -1);
+}
+
+LoaderThread::CatalogueRefreshJob::CatalogueRefreshJob(NeuralAmpProcessor& p,
+                                                       const ThreadManager& manager)
+    : juce::ThreadPoolJob("NeuralAmp Catalogue Refresh"), processor(p), threads(manager) {}
+
+juce::ThreadPoolJob::JobStatus LoaderThread::CatalogueRefreshJob::runJob() {
+  threads.placeCurrentThread(ThreadManager::Role::worker);
+  processor.refreshCatalogues([this] { return shouldExit(); });
+  return jobHasFinished;
+}
+
+LoaderThread::LibraryProfileJob::LibraryProfileJob(NeuralAmpProcessor& p,
+                                                   const ThreadManager& manager)
+    : juce::ThreadPoolJob("NeuralAmp Library Profile"), processor(p), threads(manager) {}
+
+juce::ThreadPoolJob::JobStatus LoaderThread::LibraryProfileJob::runJob() {
+  threads.placeCurrentThread(ThreadManager::Role::worker);
+  const int profiled = processor.profileLibrary(force.load(), [this] { return shouldExit(); });
+  juce::Logger::writeToLog("[Profiler] Profiled " + juce::String(profiled) + " model(s)");
+  return jobHasFinished;
+}
+
+// A forced request upgrades a pending one; an unforced one never downgrades it
+void LoaderThread::requestProfiling(bool force) {
+  int expected = noProfiling;
+  if (force)
+    profilingRequest.store(profileAllModels);
+  else
+    profilingRequest.compare_exchange_strong(expected, profileNewModels);
+}
+
+bool LoaderThread::isProfiling() const {
+  return profilingRequest.load() != noProfiling ||
+         threads->getWorkers().contains(&libraryProfileJob);
+}
+
+// A request made while a profile is running waits for the next poll. The request is only cleared
+// once the job is queued, so isProfiling() never reads false in between.
+void LoaderThread::startRequestedProfiling() {
+  auto& workers = threads->getWorkers();
+  int request = profilingRequest.load();
+  if (request == noProfiling || workers.contains(&libraryProfileJob))
+    return;
+  libraryProfileJob.force.store(request == profileAllModels);
+  workers.addJob(&libraryProfileJob, false);
+  profilingRequest.compare_exchange_strong(request, noProfiling);
+}
+
+void LoaderThread::run() {
+  threads->placeCurrentThread(ThreadManager::Role::loader);
+  auto& parameters = processor.getParameters();
+  const std::array<std::atomic<float>*, ModelBlender::numSlots> selectedModels{
+      parameters.getRawParameterValue("selectedNamModel"),
+      parameters.getRawParameterValue("selectedNamModelB")};
+  auto* selectedIr = parameters.getRawParameterValue("selectedIR");
+  auto* selectedIrB = parameters.getRawParameterValue("selectedIRB");
+
+  // A host may destroy the instance while a large library is still being read
+  const auto& locations = processor.getLocations();
+  NeuralAmpProcessor::scanLibraryFolders(locations.namFolder, locations.irFolder);
+  if (!threadShouldExit()) {
+    processor.getLibraryIndex().load();
+    processor.refreshCatalogues([this] { return threadShouldExit(); });
+  }
+  auto lastCatalogueRefresh = juce::Time::getMillisecondCounter();
+
+  while (!threadShouldExit()) {
+    for (const auto slot : {ModelBlender::slotA, ModelBlender::slotB}) {
+      const int modelIndex = static_cast<int>(selectedModels[static_cast<size_t>(slot)]->load());
+      const bool faultReported = processor.consumeModelResetRequest(slot);
+      if (modelIndex != processor.getAttemptedModelIndex(slot) ||
+          processor.consumeModelReloadRequest(slot))
+        processor.loadModelAtIndex(modelIndex, slot);
+      else
+        processor.handleModelFault(slot, faultReported);
+    }
+
+    const int irIndex = static_cast<int>(selectedIr->load());
+    if (irIndex != processor.getAttemptedIrIndex())
+      processor.loadIrAtIndex(irIndex);
+    const int irBIndex = static_cast<int>(selectedIrB->load());
+    if (irBIndex != processor.getAttemptedIrIndex(DualIrConvolver::slotB))
+      processor.loadIrAtIndex(irBIndex, DualIrConvolver::slotB);
+    processor.updateIrAlignment();
+    processor.updateLatencyMode();
+
+    processor.loadRequestedFiles();
+
+    const auto now = juce::Time::getMillisecondCounter();
+    if (now - lastCatalogueRefresh >= catalogueRefreshIntervalMs) {
+      auto& workers = threads->getWorkers();
+      if (!workers.contains(&catalogueRefreshJob))
+        workers.addJob(&catalogueRefreshJob, false);
+      if (NEURALAMP_PROFILE_LIBRARY)
+        requestProfiling(false);
+      lastCatalogueRefresh = now;
+    }
+    startRequestedProfiling();
+
+    processor.updateLibraryIndex();
+    wait(pollIntervalMs);
+  }
+
+  processor.getLibraryIndex().saveIfNeeded();
+}
@@ -0,0 +1,160 @@
+#include "loudness_meter.h"
+#include <cmath>
+
+namespace {
+constexpr double stepSeconds = 0.1;
+constexpr double absoluteGateLufs = -70.0;
+constexpr double relativeGateLu = -10.0;
+
+double loudnessToMeanSquare(double lufs) {
+  return std::pow(10.0, (lufs + 0.691) / 10.0);
+}
+
+float meanSquareToLoudness(double meanSquare) {
+  return static_cast<float>(-0.691 + 10.0 * std::log10(meanSquare));
+}
+}  // namespace
+
+void LoudnessMeter::prepare(double sampleRate) {
+  const double fs = sampleRate / decimationFactor;
+  const double pi = 3.14159265358979323846;
+
+  // BS.1770 stage 1: high shelf modelling the acoustic effect of the head, redesigned for fs
+  {
+    const double f0 = 1681.974450955533;
+    const double gainDb = 3.999843853973347;
+    const double q = 0.7071752369554196;
+    const double k = std::tan(pi * f0 / fs);
+    const double vh = std::pow(10.0, gainDb / 20.0);
+    const double vb = std::pow(vh, 0.4996667741545416);
+    const double a0 = 1.0 + k / q + k * k;
+    preFilter.b0 = static_cast<float>((vh + vb * k / q + k * k) / a0);
+    preFilter.b1 = static_cast<float>(2.0 * (k * k - vh) / a0);
+    preFilter.b2 = static_cast<float>((vh - vb * k / q + k * k) / a0);
+    preFilter.a1 = static_cast<float>(2.0 * (k * k - 1.0) / a0);
+    preFilter.a2 = static_cast<float>((1.0 - k / q + k * k) / a0);
+  }
+
+  // BS.1770 stage 2: RLB high-pass
+  {
+    const double f0 = 38.13547087602444;
+    const double q = 0.5003270373238773;
+    const double k = std::tan(pi * f0 / fs);
+    const double a0 = 1.0 + k / q + k * k;
+    rlbFilter.b0 = 1.0f;
+    rlbFilter.b1 = -2.0f;
+    rlbFilter.b2 = 1.0f;
+    rlbFilter.a1 = static_cast<float>(2.0 * (k * k - 1.0) / a0);
+    rlbFilter.a2 = static_cast<float>((1.0 - k / q + k * k) / a0);
+  }
+
+  absoluteGate = loudnessToMeanSquare(absoluteGateLufs);
+  samplesPerStep = std::max(1, static_cast<int>(std::lround(fs * stepSeconds)));
+  blockMeanSquares.assign(static_cast<size_t>(windowSeconds / stepSeconds), 0.0);
+  reset();
+}
+
+void LoudnessMeter::reset() {
+  preState.fill({});
+  rlbState.fill({});
+  decimationSum.fill(0.0f);
+  decimationCount = 0;
+  stepSampleCount = 0;
+  stepSum = 0.0;
+  stepMeanSquares.fill(0.0);
+  stepsSeen = 0;
+  blockWriteIndex = 0;
+  numBlocks = 0;
+  integratedLoudness = -std::numeric_limits<float>::infinity();
+  gatedSeconds = 0.0f;
+}
+
+float LoudnessMeter::processBiquad(const Biquad& c, BiquadState& s, float x) {
+  const float y = c.b0 * x + s.z1;
+  s.z1 = c.b1 * x - c.a1 * y + s.z2;
+  s.z2 = c.b2 * x - c.a2 * y;
+  return y;
+}
+
+void LoudnessMeter::process(const float* const* channels, int numChannels, int numSamples) {
+  if (blockMeanSquares.empty())
+    return;
+
+  numChannels = std::min(numChannels, maxChannels);
+  const float decimationScale = 1.0f / decimationFactor;
+
+  for (int i = 0; i < numSamples; ++i) {
+    for (int ch = 0; ch < numChannels; ++ch)
+      decimationSum[static_cast<size_t>(ch)] += channels[ch][i];
+
+    if (++decimationCount < decimationFactor)
+      continue;
+    decimationCount = 0;
+
+    // Channel powers are summed, as BS.1770 does for left/right with unity weights
+    for (int ch = 0; ch < numChannels; ++ch) {
+      const auto c = static_cast<size_t>(ch);
+      const float x = decimationSum[c] * decimationScale;
+      decimationSum[c] = 0.0f;
+      const float k = processBiquad(preFilter, preState[c], x);
+      const float y = processBiquad(rlbFilter, rlbState[c], k);
+      stepSum += static_cast<double>(y) * y;
+    }
+
+    if (++stepSampleCount == samplesPerStep)
+      finishStep();
+  }
+}
+
+void LoudnessMeter::finishStep() {
+  stepMeanSquares[static_cast<size_t>(stepsSeen % 4)] = stepSum / samplesPerStep;
+  stepSum = 0.0;
+  stepSampleCount = 0;
+
+  if (++stepsSeen < 4)
+    return;
+
+  // A new 400 ms block completes every 100 ms
+  double blockMeanSquare = 0.0;
+  for (double ms : stepMeanSquares)
+    blockMeanSquare += ms;
+  blockMeanSquare *= 0.25;
+
+  blockMeanSquares[static_cast<size_t>(blockWriteIndex)] = blockMeanSquare;
+  blockWriteIndex = (blockWriteIndex + 1) % static_cast<int>(blockMeanSquares.size());
+  numBlocks = std::min(numBlocks + 1, static_cast<int>(blockMeanSquares.size()));
+
+  updateIntegratedLoudness();
+}
+
+void LoudnessMeter::updateIntegratedLoudness() {
+  double sum = 0.0;
+  int count = 0;
+  for (int i = 0; i < numBlocks; ++i) {
+    const double ms = blockMeanSquares[static_cast<size_t>(i)];
+    if (ms > absoluteGate) {
+      sum += ms;
+      ++count;
+    }
+  }
+
+  if (count == 0) {
+    integratedLoudness = -std::numeric_limits<float>::infinity();
+    gatedSeconds = 0.0f;
+    return;
+  }
+
+  const double relativeGate = (sum / count) * std::pow(10.0, relativeGateLu / 10.0);
+  double gatedSum = 0.0;
+  int gatedCount = 0;
+  for (int i = 0; i < numBlocks; ++i) {
+    const double ms = blockMeanSquares[static_cast<size_t>(i)];
+    if (ms > absoluteGate && ms > relativeGate) {
+      gatedSum += ms;
+      ++gatedCount;
+    }
+  }
+
+  integratedLoudness = meanSquareToLoudness(gatedSum / gatedCount);
+  gatedSeconds = static_cast<float>(gatedCount * stepSeconds);
+}
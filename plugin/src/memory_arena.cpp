@@ -0,0 +1,269 @@
+#include "memory_arena.h"
+#include <algorithm>
+#include <cstring>
+#include <iomanip>
+#include <new>
+#include <sstream>
+
+#if __has_include(<sys/mman.h>) && __has_include(<unistd.h>)
+#include <sys/mman.h>
+#include <unistd.h>
+#define NEURALAMP_HAVE_MLOCK 1
+#else
+#define NEURALAMP_HAVE_MLOCK 0
+#endif
+
+namespace {
+// Every block is a multiple of this, so freed blocks always fit a later small request
+constexpr size_t minimumAlignment = alignof(std::max_align_t);
+
+size_t alignUp(size_t value, size_t alignment) {
+  return (value + alignment - 1) / alignment * alignment;
+}
+
+size_t getPageSize() {
+#if NEURALAMP_HAVE_MLOCK
+  const long size = sysconf(_SC_PAGESIZE);
+  if (size > 0)
+    return static_cast<size_t>(size);
+#endif
+  return 4096;
+}
+
+std::string formatBytes(size_t bytes) {
+  std::ostringstream out;
+  out << std::fixed << std::setprecision(1);
+  if (bytes >= (size_t{1} << 20))
+    out << static_cast<double>(bytes) / (1 << 20) << " MB";
+  else
+    out << static_cast<double>(bytes) / (1 << 10) << " kB";
+  return out.str();
+}
+}  // namespace
+
+const char* MemoryArena::getSubsystemName(Subsystem subsystem) {
+  switch (subsystem) {
+    case modelWeights:
+      return "model weights";
+    case modelBuffers:
+      return "model buffers";
+    case convolution:
+      return "convolution";
+    case scratch:
+      return "scratch";
+    case numSubsystems:
+      break;
+  }
+  return "unknown";
+}
+
+MemoryArena::MemoryArena(size_t capacityBytes, bool lockPages)
+    : capacity(capacityBytes),
+      lockPages(lockPages),
+      pageSize(getPageSize()),
+      regionSize(alignUp(std::max<size_t>(capacityBytes, 1), pageSize)),
+      locked(lockPages) {
+  // Address space only: nothing is faulted in until commit()
+  region = static_cast<std::byte*>(::operator new(regionSize, std::align_val_t{pageSize}));
+}
+
+MemoryArena::~MemoryArena() {
+  if (lockPages && committed > 0)
+    unlockRange(region, committed);
+  for (const auto& [page, count] : pinnedPages) {
+    if (lockPages)
+      unlockRange(reinterpret_cast<const void*>(page), pageSize);
+  }
+  ::operator delete(region, std::align_val_t{pageSize});
+}
+
+void* MemoryArena::allocate(Subsystem subsystem, size_t bytes, size_t alignment) {
+  bytes = alignUp(std::max<size_t>(bytes, 1), minimumAlignment);
+  alignment = std::max(alignment, minimumAlignment);
+
+  const std::lock_guard<std::mutex> lock(mutex);
+  if (allocatedBytes + pinnedBytes + bytes > capacity)
+    throw std::bad_alloc();
+
+  // First fit among the freed blocks, then the untouched space above top
+  size_t offset = top;
+  for (auto block = freeBlocks.begin(); block != freeBlocks.end(); ++block) {
+    const auto [start, size] = *block;
+    const size_t aligned = alignUp(start, alignment);
+    if (aligned + bytes > start + size)
+      continue;
+    freeBlocks.erase(block);
+    if (aligned > start)
+      freeBlocks.emplace(start, aligned - start);
+    if (aligned + bytes < start + size)
+      freeBlocks.emplace(aligned + bytes, start + size - aligned - bytes);
+    offset = aligned;
+    break;
+  }
+  if (offset == top) {
+    offset = alignUp(top, alignment);
+    if (offset + bytes + pinnedBytes > capacity)
+      throw std::bad_alloc();
+    if (offset > top)
+      freeBlocks.emplace(top, offset - top);
+    top = offset + bytes;
+    commit(top);
+  }
+
+  allocatedBytes += bytes;
+  subsystemBytes[static_cast<size_t>(subsystem)] += bytes;
+  return region + offset;
+}
+
+void MemoryArena::deallocate(Subsystem subsystem, void* pointer, size_t bytes) {
+  if (pointer == nullptr)
+    return;
+  bytes = alignUp(std::max<size_t>(bytes, 1), minimumAlignment);
+
+  const std::lock_guard<std::mutex> lock(mutex);
+  allocatedBytes -= bytes;
+  subsystemBytes[static_cast<size_t>(subsystem)] -= bytes;
+
+  // Merge with the free neighbours on either side, and give the space back to top if it ends there
+  size_t start = static_cast<size_t>(static_cast<std::byte*>(pointer) - region);
+  size_t size = bytes;
+  auto next = freeBlocks.lower_bound(start);
+  if (next != freeBlocks.end() && next->first == start + size) {
+    size += next->second;
+    next = freeBlocks.erase(next);
+  }
+  if (next != freeBlocks.begin()) {
+    const auto previous = std::prev(next);
+    if (previous->first + previous->second == start) {
+      start = previous->first;
+      size += previous->second;
+      freeBlocks.erase(previous);
+    }
+  }
+  if (start + size == top)
+    top = start;
+  else
+    freeBlocks.emplace(start, size);
+}
+
+// Faults pages in up to end (rounded up to commitGranularity) and locks them. Committed pages stay
+// resident after they are freed, ready for the next swap.
+void MemoryArena::commit(size_t end) {
+  if (end <= committed)
+    return;
+  // Grow a step at a time, but not into what the pins already hold of the cap
+  const size_t headroom = capacity - std::min(capacity, pinnedBytes);
+  end = std::max(end, std::min(alignUp(end, commitGranularity), headroom));
+  end = std::min(alignUp(end, pageSize), regionSize);
+
+  std::memset(region + committed, 0, end - committed);
+  if (lockPages && !lockRange(region + committed, end - committed))
+    locked = false;
+  committed = end;
+}
+
+bool MemoryArena::lockRange(const void* start, size_t bytes) {
+#if NEURALAMP_HAVE_MLOCK
+  return mlock(start, bytes) == 0;
+#else
+  (void)start;
+  (void)bytes;
+  return false;
+#endif
+}
+
+void MemoryArena::unlockRange(const void* start, size_t bytes) {
+#if NEURALAMP_HAVE_MLOCK
+  munlock(start, bytes);
+#else
+  (void)start;
+  (void)bytes;
+#endif
+}
+
+size_t MemoryArena::getAvailableBytes() const {
+  const std::lock_guard<std::mutex> lock(mutex);
+  const size_t used = allocatedBytes + pinnedBytes;
+  return used < capacity ? capacity - used : 0;
+}
+
+MemoryArena::Usage MemoryArena::getUsage() const {
+  const std::lock_guard<std::mutex> lock(mutex);
+  Usage usage;
+  usage.bytes = subsystemBytes;
+  usage.committedBytes = committed;
+  usage.capacityBytes = capacity;
+  usage.locked = locked;
+  return usage;
+}
+
+std::string MemoryArena::Usage::toString() const {
+  std::ostringstream out;
+  for (int subsystem = 0; subsystem < numSubsystems; ++subsystem) {
+    out << getSubsystemName(static_cast<Subsystem>(subsystem)) << " "
+        << formatBytes(bytes[static_cast<size_t>(subsystem)]) << ", ";
+  }
+  out << formatBytes(committedBytes) << " of " << formatBytes(capacityBytes) << " arena committed"
+      << (locked ? ", locked" : ", not locked");
+  return out.str();
+}
+
+bool MemoryArena::pin(const void* owner,
+                      const std::function<void(const BufferVisitor&)>& forEachBuffer) {
+  std::vector<Pin> buffers;
+  size_t bytes = 0;
+  forEachBuffer([&](Subsystem subsystem, const void* data, size_t size) {
+    if (size > 0) {
+      buffers.push_back({subsystem, data, size});
+      bytes += size;
+    }
+  });
+
+  const std::lock_guard<std::mutex> lock(mutex);
+  if (pins.count(owner) > 0 || allocatedBytes + pinnedBytes + bytes > capacity)
+    return false;
+
+  for (const auto& buffer : buffers) {
+    const auto first = reinterpret_cast<std::uintptr_t>(buffer.data) / pageSize * pageSize;
+    const auto last = (reinterpret_cast<std::uintptr_t>(buffer.data) + buffer.bytes - 1) /
+                      pageSize * pageSize;
+    for (auto page = first; page <= last; page += pageSize) {
+      if (pinnedPages[page]++ > 0)
+        continue;
+      // Touch the page, so it is resident even where it can't be locked
+      const auto* touch = reinterpret_cast<const volatile std::byte*>(
+          std::max(page, reinterpret_cast<std::uintptr_t>(buffer.data)));
+      (void)*touch;
+      if (lockPages && !lockRange(reinterpret_cast<const void*>(page), pageSize))
+        locked = false;
+    }
+    subsystemBytes[static_cast<size_t>(buffer.subsystem)] += buffer.bytes;
+  }
+  pinnedBytes += bytes;
+  pins.emplace(owner, std::move(buffers));
+  return true;
+}
+
+void MemoryArena::unpin(const void* owner) {
+  const std::lock_guard<std::mutex> lock(mutex);
+  const auto entry = pins.find(owner);
+  if (entry == pins.end())
+    return;
+
+  for (const auto& buffer : entry->second) {
+    const auto first = reinterpret_cast<std::uintptr_t>(buffer.data) / pageSize * pageSize;
+    const auto last = (reinterpret_cast<std::uintptr_t>(buffer.data) + buffer.bytes - 1) /
+                      pageSize * pageSize;
+    for (auto page = first; page <= last; page += pageSize) {
+      const auto count = pinnedPages.find(page);
+      if (--count->second > 0)
+        continue;
+      pinnedPages.erase(count);
+      if (lockPages)
+        unlockRange(reinterpret_cast<const void*>(page), pageSize);
+    }
+    subsystemBytes[static_cast<size_t>(buffer.subsystem)] -= buffer.bytes;
+    pinnedBytes -= buffer.bytes;
+  }
+  pins.erase(entry);
+}
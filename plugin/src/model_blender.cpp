@@ -0,0 +1,106 @@
+#include "model_blender.h"
+#include <algorithm>
+#include <cmath>
+
+void ModelBlender::prepare(double sampleRate, int maxBlockSize, MemoryArena* memory) {
+  blendStep = static_cast<float>(1.0 / (blendRampSeconds * sampleRate));
+  idleSamples = std::max(1, static_cast<int>(std::lround(idleSeconds * sampleRate)));
+  wakeSamples = std::max(1, static_cast<int>(std::lround(wakeSeconds * sampleRate)));
+  const MemoryArena::Allocator<NAM_SAMPLE> allocator(memory, MemoryArena::scratch);
+  const auto size = static_cast<size_t>(maxBlockSize);
+  inputBuffer = MemoryArena::Vector<NAM_SAMPLE>(size, 0.0, allocator);
+  for (auto& buffer : outputBuffers)
+    buffer = MemoryArena::Vector<NAM_SAMPLE>(size, 0.0, allocator);
+  reset();
+}
+
+void ModelBlender::reset() {
+  blend = targetBlend;
+  states.fill(State::idle);
+  stateSamples.fill(0);
+  lastModels.fill(nullptr);
+}
+
+void ModelBlender::updateStates(const Models& models, int numSamples) {
+  // A model playing alone ramps to full level; the other end of the blend is then silence
+  rampTarget = models[slotA] == nullptr ? 1.0f : (models[slotB] == nullptr ? 0.0f : targetBlend);
+
+  for (const auto slot : {slotA, slotB}) {
+    const auto index = static_cast<size_t>(slot);
+    auto& state = states[index];
+    auto& samples = stateSamples[index];
+    nam::DSP* model = models[index];
+    if (model == nullptr) {
+      state = State::idle;
+      lastModels[index] = nullptr;
+      continue;
+    }
+
+    const bool audible = getWeight(slot, blend) > 0.0f;
+    const bool wanted = audible || getWeight(slot, rampTarget) > 0.0f;
+    if (model != lastModels[index]) {
+      // Swapped in by the loader, warmed up on silence
+      lastModels[index] = model;
+      state = audible ? State::running : (wanted ? State::waking : State::idle);
+      samples = state == State::waking ? wakeSamples : 0;
+      continue;
+    }
+
+    switch (state) {
+      case State::running:
+        samples = wanted ? 0 : samples + numSamples;
+        if (samples >= idleSamples)
+          state = State::idle;
+        break;
+      case State::idle:
+        if (wanted) {
+          state = State::waking;
+          samples = wakeSamples;
+        }
+        break;
+      case State::waking:
+        samples -= numSamples;
+        if (!wanted)
+          state = State::idle;
+        else if (samples <= 0)
+          state = State::running;
+        break;
+    }
+  }
+}
+
+void ModelBlender::process(const float* input,
+                           float* output,
+                           int numSamples,
+                           const Models& models) {
+  updateStates(models, numSamples);
+
+  for (int i = 0; i < numSamples; ++i)
+    inputBuffer[static_cast<size_t>(i)] = static_cast<NAM_SAMPLE>(input[i]);
+
+  for (const auto slot : {slotA, slotB}) {
+    const auto index = static_cast<size_t>(slot);
+    if (models[index] != nullptr && states[index] != State::idle)
+      models[index]->process(inputBuffer.data(), outputBuffers[index].data(), numSamples);
+  }
+
+  // A waking model is run but not heard, and holds the blend where it is
+  const bool playA = states[slotA] == State::running;
+  const bool playB = states[slotB] == State::running;
+  const bool ramping = states[slotA] != State::waking && states[slotB] != State::waking;
+  const NAM_SAMPLE* outputA = outputBuffers[slotA].data();
+  const NAM_SAMPLE* outputB = outputBuffers[slotB].data();
+
+  for (int i = 0; i < numSamples; ++i) {
+    if (ramping && blend != rampTarget) {
+      blend = rampTarget > blend ? std::min(rampTarget, blend + blendStep)
+                                 : std::max(rampTarget, blend - blendStep);
+    }
+    NAM_SAMPLE mixed = 0;
+    if (playA)
+      mixed += static_cast<NAM_SAMPLE>(1.0f - blend) * outputA[i];
+    if (playB)
+      mixed += static_cast<NAM_SAMPLE>(blend) * outputB[i];
+    output[i] = static_cast<float>(mixed);
+  }
+}
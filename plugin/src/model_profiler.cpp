@@ -0,0 +1,58 @@
+#include "model_profiler.h"
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <vector>
+
+LibraryIndex::CpuProfile ModelProfiler::measure(nam::DSP& model,
+                                                double sampleRate,
+                                                int blockSize,
+                                                double seconds) {
+  using Clock = std::chrono::steady_clock;
+  blockSize = std::max(1, blockSize);
+
+  // Quiet noise, like a guitar DI; some activations cost more away from zero
+  std::mt19937 rng(1);
+  std::uniform_real_distribution<double> distribution(-0.1, 0.1);
+  std::vector<NAM_SAMPLE> input(static_cast<size_t>(blockSize));
+  std::vector<NAM_SAMPLE> output(input.size());
+  for (auto& sample : input)
+    sample = static_cast<NAM_SAMPLE>(distribution(rng));
+
+  const int warmUpBlocks = static_cast<int>(warmUpSeconds * sampleRate) / blockSize + 1;
+  for (int i = 0; i < warmUpBlocks; ++i)
+    model.process(input.data(), output.data(), blockSize);
+
+  const int blocks = std::max(1, static_cast<int>(seconds * sampleRate) / blockSize);
+  Clock::duration total{};
+  Clock::duration peak{};
+  for (int i = 0; i < blocks; ++i) {
+    const auto start = Clock::now();
+    model.process(input.data(), output.data(), blockSize);
+    const auto elapsed = Clock::now() - start;
+    total += elapsed;
+    peak = std::max(peak, elapsed);
+  }
+
+  LibraryIndex::CpuProfile profile;
+  profile.sampleRate = sampleRate;
+  profile.blockSize = blockSize;
+  const double totalSeconds = std::chrono::duration<double>(total).count();
+  const double audioSeconds = static_cast<double>(blocks) * blockSize / sampleRate;
+  profile.realTimeFactor = totalSeconds > 0.0 ? audioSeconds / totalSeconds : 1e6;
+  profile.peakBlockMs = std::chrono::duration<double, std::milli>(peak).count();
+  profile.overBudget = isOverBudget(profile);
+  return profile;
+}
+
+bool ModelProfiler::isOverBudget(const LibraryIndex::CpuProfile& profile) {
+  const double blockMs = 1000.0 * profile.blockSize / profile.sampleRate;
+  return profile.realTimeFactor * maxAverageLoad < 1.0 || profile.peakBlockMs > blockMs;
+}
+
+juce::String ModelProfiler::describe(const LibraryIndex::CpuProfile& profile) {
+  const double blockMs = 1000.0 * profile.blockSize / profile.sampleRate;
+  return juce::String(profile.realTimeFactor, 1) + "x realtime, peak " +
+         juce::String(profile.peakBlockMs, 3) + " ms of " + juce::String(blockMs, 3) + " ms" +
+         (profile.overBudget ? " (over budget)" : "");
+}
@@ -0,0 +1,53 @@
+#include "parameter_snapshot.h"
+#include <cmath>
+
+namespace {
+// In the order of ParameterSnapshot::Id
+constexpr std::array<const char*, ParameterSnapshot::numParameters> parameterIds{
+    "inputLevel",
+    "outputLevel",
+    "toneBass",
+    "toneMid",
+    "toneTreble",
+    "eqToggle",
+    "toneStackModel",
+    "noiseGateToggle",
+    "noiseGateThreshold",
+    "irToggle",
+    "normalizeNamOutput",
+    "targetLoudness",
+    "irBlend",
+    "modelBlend",
+    "liveMonitoring",
+};
+}  // namespace
+
+ParameterSnapshot::ParameterSnapshot(juce::AudioProcessorValueTreeState& parameters) {
+  for (size_t i = 0; i < sources.size(); ++i) {
+    sources[i] = parameters.getRawParameterValue(parameterIds[i]);
+    jassert(sources[i] != nullptr);
+  }
+  reset();
+}
+
+const char* ParameterSnapshot::getParameterId(Id id) {
+  return parameterIds[static_cast<size_t>(id)];
+}
+
+ParameterSnapshot::Mask ParameterSnapshot::update() {
+  Mask changed = 0;
+  for (size_t i = 0; i < sources.size(); ++i) {
+    const float value = sources[i]->load(std::memory_order_relaxed);
+    if (std::abs(value - values[i]) > epsilon) {
+      values[i] = value;
+      changed |= Mask{1} << i;
+    }
+  }
+  return changed;
+}
+
+ParameterSnapshot::Mask ParameterSnapshot::reset() {
+  for (size_t i = 0; i < sources.size(); ++i)
+    values[i] = sources[i]->load(std::memory_order_relaxed);
+  return allParameters;
+}
@@ -4,10 +4,15 @@
 #endif
 #include <cmath>
 
-// Static member initialization
-juce::StringArray NeuralAmpProcessor::modelNames;
-std::vector<juce::String> NeuralAmpProcessor::modelPathsByIndex;
-bool NeuralAmpProcessor::modelPathsInitialized = false;
+// Static member initialization. Until the folders are scanned, only "nothing selected" exists.
+juce::CriticalSection NeuralAmpProcessor::listingLock;
+std::shared_ptr<const NeuralAmpProcessor::LibraryListing> NeuralAmpProcessor::modelListing =
+    std::make_shared<const LibraryListing>(LibraryListing{{"Select model..."}, {""}});
+std::shared_ptr<const NeuralAmpProcessor::LibraryListing> NeuralAmpProcessor::irListing =
+    std::make_shared<const LibraryListing>(LibraryListing{{"Select IR..."}, {""}});
+std::atomic<int> NeuralAmpProcessor::listingGeneration{0};
+juce::CriticalSection NeuralAmpProcessor::scanLock;
+bool NeuralAmpProcessor::librariesScanned = false;
 
 juce::StringArray NeuralAmpProcessor::getSortedNamModelNames(
     const juce::File& namFolder,
@@ -45,10 +50,6 @@ juce::StringArray NeuralAmpProcessor::getSortedNamModelNames(
   return modelNames;
 }
 
-juce::StringArray NeuralAmpProcessor::irNames;
-std::vector<juce::String> NeuralAmpProcessor::irPathsByIndex;
-bool NeuralAmpProcessor::irPathsInitialized = false;
-
 juce::StringArray NeuralAmpProcessor::getSortedIrNames(const juce::File& irFolder,
                                                        std::vector<juce::String>& irPaths) {
   juce::StringArray names;
@@ -77,58 +78,68 @@ juce::StringArray NeuralAmpProcessor::getSortedIrNames(const juce::File& irFolde
   return names;
 }
 
-const juce::StringArray& NeuralAmpProcessor::getModelNames() const {
-  return modelNames;
+std::shared_ptr<const NeuralAmpProcessor::LibraryListing> NeuralAmpProcessor::getModelListing() {
+  const juce::ScopedLock lock(listingLock);
+  return modelListing;
 }
 
-const std::vector<juce::String>& NeuralAmpProcessor::getModelPaths() const {
-  return modelPathsByIndex;
+std::shared_ptr<const NeuralAmpProcessor::LibraryListing> NeuralAmpProcessor::getIrListing() {
+  const juce::ScopedLock lock(listingLock);
+  return irListing;
 }
 
-const juce::StringArray& NeuralAmpProcessor::getIrNames() const {
-  return irNames;
-}
+void NeuralAmpProcessor::scanLibraryFolders(const juce::File& namFolder,
+                                            const juce::File& irFolder) {
+  const juce::ScopedLock lock(scanLock);
+  if (librariesScanned)
+    return;
 
-const std::vector<juce::String>& NeuralAmpProcessor::getIrPaths() const {
-  return irPathsByIndex;
-}
+  auto models = std::make_shared<LibraryListing>();
+  models->names = getSortedNamModelNames(namFolder, models->paths);
+  auto irs = std::make_shared<LibraryListing>();
+  irs->names = getSortedIrNames(irFolder, irs->paths);
+  DBG("Scanned " << models->names.size() - 1 << " models and " << irs->names.size() - 1 << " IRs");
+
+  // Entries past the last selectable index can still be loaded through the catalogues
+  for (auto* listing : {models.get(), irs.get()}) {
+    if (listing->names.size() > maxLibrarySelections + 1) {
+      listing->names.removeRange(maxLibrarySelections + 1, listing->names.size());
+      listing->paths.resize(static_cast<size_t>(maxLibrarySelections + 1));
+    }
+  }
 
-void NeuralAmpProcessor::initModelNamesAndPaths() {
-  if (!modelPathsInitialized) {
-    juce::File namDir(NamFolder);
-    modelNames = getSortedNamModelNames(namDir, modelPathsByIndex);
-    modelPathsInitialized = true;
-    DBG("Initialized with " << modelNames.size() << " Nam choices");
+  {
+    const juce::ScopedLock listingScope(listingLock);
+    modelListing = std::move(models);
+    irListing = std::move(irs);
   }
+  librariesScanned = true;
+  ++listingGeneration;
 }
 
-void NeuralAmpProcessor::initIrNamesAndPaths() {
-  if (!irPathsInitialized) {
-    juce::File irDir(IrFolder);
-    irNames = getSortedIrNames(irDir, irPathsByIndex);
-    irPathsInitialized = true;
-  }
+NeuralAmpProcessor::Locations NeuralAmpProcessor::getDefaultLocations() {
+  return {juce::File(NamFolder), juce::File(IrFolder), juce::File(CaptureFolder),
+          LibraryIndex::getDefaultFile(), juce::File(PresetFolder)};
 }
 
-NeuralAmpProcessor::NeuralAmpProcessor()
+NeuralAmpProcessor::NeuralAmpProcessor() : NeuralAmpProcessor(getDefaultLocations()) {}
+
+NeuralAmpProcessor::NeuralAmpProcessor(Locations libraryLocations)
     : AudioProcessor(BusesProperties()
                          .withInput("Input", juce::AudioChannelSet::stereo(), true)
                          .withOutput("Output", juce::AudioChannelSet::stereo(), true)),
       parameters(*this, nullptr, juce::Identifier("PARAMETERS"), createParameterLayout()),
-      bassFilter(juce::dsp::IIR::Coefficients<float>::makeLowShelf(48000, 100.0f, 1.0f, 1.0f)),
-      midFilter(juce::dsp::IIR::Coefficients<float>::makePeakFilter(48000, 1000.0f, 1.0f, 1.0f)),
-      trebleFilter(juce::dsp::IIR::Coefficients<float>::makeHighShelf(48000, 4000.0f, 1.0f, 1.0f)),
-      oversampler(std::make_unique<juce::dsp::Oversampling<float>>(
-          2,
-          0,
-          juce::dsp::Oversampling<float>::filterHalfBandFIREquiripple)) {
-  normalizationGainSmoother.reset(48000, 0.05f);
+      locations(std::move(libraryLocations)),
+      parameterSnapshot(parameters),
+      oversampler(createOversampler(false)) {
+  normalizationGain.prepare(48000.0, normalizationRampSeconds);
+  captureEnabled = parameters.getRawParameterValue("captureEnabled");
+  captureOutput = parameters.getRawParameterValue("captureOutput");
+  captureFormat = parameters.getRawParameterValue("captureFormat");
   DBG("NeuralAmpProcessor constructed");
 }
 
 juce::AudioProcessorValueTreeState::ParameterLayout NeuralAmpProcessor::createParameterLayout() {
-  initModelNamesAndPaths();
-  initIrNamesAndPaths();
   juce::AudioProcessorValueTreeState::ParameterLayout layout;
 
   layout.add(std::make_unique<juce::AudioParameterFloat>(
@@ -147,28 +158,74 @@ juce::AudioProcessorValueTreeState::ParameterLayout NeuralAmpProcessor::createPa
       "noiseGateThreshold", "noiseGateThreshold",
       juce::NormalisableRange<float>(-100.0f, 0.0f, 0.1f), -80.0f));
   layout.add(std::make_unique<juce::AudioParameterBool>("eqToggle", "eqToggle", true));
+  // Which amp's tone stack the bass, mid and treble knobs belong to, in ToneStack::Model order
+  juce::StringArray toneStackModels;
+  for (int model = 0; model < ToneStack::numModels; ++model)
+    toneStackModels.add(ToneStack::getModelName(static_cast<ToneStack::Model>(model)));
+  layout.add(std::make_unique<juce::AudioParameterChoice>("toneStackModel", "toneStackModel",
+                                                          toneStackModels, ToneStack::fender));
   layout.add(std::make_unique<juce::AudioParameterBool>("irToggle", "irToggle", true));
   layout.add(
       std::make_unique<juce::AudioParameterBool>("normalizeNamOutput", "normalizeNamOutput", true));
   layout.add(std::make_unique<juce::AudioParameterFloat>(
       "targetLoudness", "targetLoudness", juce::NormalisableRange<float>(-30.0f, -6.0f, 0.1f),
       -18.0f));
+  // 0 plays the first model only, 1 the second
+  layout.add(std::make_unique<juce::AudioParameterFloat>(
+      "modelBlend", "modelBlend", juce::NormalisableRange<float>(0.0f, 1.0f, 0.01f), 0.0f));
   layout.add(
       std::make_unique<juce::AudioParameterBool>("normalizeIrOutput", "normalizeIrOutput", true));
+  // 0 plays the first IR only, 1 the second; irAlign (ms) delays the second IR, or the first when
+  // negative, to line up two mics
+  layout.add(std::make_unique<juce::AudioParameterFloat>(
+      "irBlend", "irBlend", juce::NormalisableRange<float>(0.0f, 1.0f, 0.01f), 0.0f));
+  layout.add(std::make_unique<juce::AudioParameterFloat>(
+      "irAlign", "irAlign", juce::NormalisableRange<float>(-2.0f, 2.0f, 0.01f), 0.0f));
+  // Zero added latency: minimum-phase IRs, no sub-block FIFO, IIR oversampling filters
+  layout.add(std::make_unique<juce::AudioParameterBool>("liveMonitoring", "liveMonitoring", false));
+  layout.add(std::make_unique<juce::AudioParameterBool>("captureEnabled", "captureEnabled", false));
+  layout.add(std::make_unique<juce::AudioParameterBool>("captureOutput", "captureOutput", true));
+  layout.add(std::make_unique<juce::AudioParameterChoice>(
+      "captureFormat", "captureFormat", juce::StringArray{"WAV", "FLAC"}, 0));
+
+  // Hosts show the listing's name for each index once the folders have been scanned. The listing
+  // is scanned once per process and not refreshed, and holds at most maxLibrarySelections files:
+  // files added later, or past the cap, are loaded through the catalogues (by ID or path) instead.
+  // A selection past the end of the listing is ignored.
+  juce::StringArray selections;
+  for (int i = 0; i <= maxLibrarySelections; ++i)
+    selections.add(juce::String(i));
+  auto selectionName = [](std::shared_ptr<const LibraryListing> (*getListing)()) {
+    return [getListing](int index, int) {
+      const auto listing = getListing();
+      return juce::isPositiveAndBelow(index, listing->names.size()) ? listing->names[index]
+                                                                    : juce::String(index);
+    };
+  };
+  layout.add(std::make_unique<juce::AudioParameterChoice>(
+      "selectedNamModel", "selectedNamModel", selections, 0,
+      juce::AudioParameterChoiceAttributes().withStringFromValueFunction(
+          selectionName(&NeuralAmpProcessor::getModelListing))));
+  layout.add(std::make_unique<juce::AudioParameterChoice>(
+      "selectedNamModelB", "selectedNamModelB", selections, 0,
+      juce::AudioParameterChoiceAttributes().withStringFromValueFunction(
+          selectionName(&NeuralAmpProcessor::getModelListing))));
+  layout.add(std::make_unique<juce::AudioParameterChoice>(
+      "selectedIR", "selectedIR", selections, 0,
+      juce::AudioParameterChoiceAttributes().withStringFromValueFunction(
+          selectionName(&NeuralAmpProcessor::getIrListing))));
+  layout.add(std::make_unique<juce::AudioParameterChoice>(
+      "selectedIRB", "selectedIRB", selections, 0,
+      juce::AudioParameterChoiceAttributes().withStringFromValueFunction(
+          selectionName(&NeuralAmpProcessor::getIrListing))));
 
-  juce::StringArray Namchoices = modelNames.isEmpty() ? juce::StringArray("No Model") : modelNames;
-  DBG("Total irChoices = " << Namchoices.size());
-  layout.add(std::make_unique<juce::AudioParameterChoice>("selectedNamModel", "selectedNamModel",
-                                                          Namchoices, 0));
-  juce::StringArray irChoices = irNames.isEmpty() ? juce::StringArray("No IR") : irNames;
-  layout.add(
-      std::make_unique<juce::AudioParameterChoice>("selectedIR", "selectedIR", irChoices, 0));
-
-  DBG("Parameter layout created with " << Namchoices.size() << " model Namchoices");
   return layout;
 }
 
 NeuralAmpProcessor::~NeuralAmpProcessor() {
+  controlServer.stop();
+  // Never killed: the loader checks for exit between files, and a kill could leave locks held
+  loaderThread.stop();
   releaseResources();
   juce::Logger::writeToLog("[Processor] Destructor called");
 }
@@ -213,58 +270,53 @@ void NeuralAmpProcessor::prepareToPlay(double sampleRate, int samplesPerBlock) {
   DBG("Preparing to play: sampleRate=" << sampleRate << ", samplesPerBlock=" << samplesPerBlock);
   DBG("Model sample rate set to: " << modelSampleRate);
 
-  cInputLevel = parameters.getRawParameterValue("inputLevel")->load();
-  cOutputLevel = parameters.getRawParameterValue("outputLevel")->load();
-  cToneBass = parameters.getRawParameterValue("toneBass")->load();
-  cToneMid = parameters.getRawParameterValue("toneMid")->load();
-  cToneTreble = parameters.getRawParameterValue("toneTreble")->load();
-  cEqToggle = parameters.getRawParameterValue("eqToggle")->load() > 0.5f;
-  cNoiseGateToggle = parameters.getRawParameterValue("noiseGateToggle")->load() > 0.5f;
-  cNoiseGateThreshold = parameters.getRawParameterValue("noiseGateThreshold")->load();
-  cSelectedNamModel = static_cast<int>(*parameters.getRawParameterValue("selectedNamModel"));
-  cSelectedIR = static_cast<int>(*parameters.getRawParameterValue("selectedIR"));
-  cIrToggle = parameters.getRawParameterValue("irToggle")->load() > 0.5f;
-  cNormalizeNamOutput = parameters.getRawParameterValue("normalizeNamOutput")->load() > 0.5f;
-  cNormalizeIrOutput = parameters.getRawParameterValue("normalizeIrOutput")->load() > 0.5f;
-  cTargetLoudness = parameters.getRawParameterValue("targetLoudness")->load();
-
-  std::shared_ptr<nam::DSP> localDsp;
-  {
-    std::lock_guard<std::mutex> lock(dspMutex);
-    localDsp = dsp;
-  }
+  std::unique_lock<std::mutex> dspLock(dspMutex);
+
+  // Everything downstream is fed in chunks of at most chunkSize samples, so size it for that
+  const bool liveMonitoring = isLiveMonitoring();
+  subBlockScheduler.prepare(getTotalNumOutputChannels(), SubBlockScheduler::defaultChunkSize,
+                            SubBlockScheduler::defaultUseFifo && !liveMonitoring);
+  const int chunkSize = subBlockScheduler.getChunkSize();
+  modelBlockSize.store(chunkSize);
 
-  if (localDsp) {
-    localDsp->Reset(modelSampleRate, samplesPerBlock);
-    DBG("DSP reset successfully");
+  for (auto& dsp : dsps) {
+    if (dsp) {
+      dsp->Reset(modelSampleRate, chunkSize);
+      DBG("DSP reset successfully");
+    }
   }
+  dspLock.unlock();
 
-  juce::dsp::ProcessSpec spec{sampleRate, static_cast<juce::uint32>(samplesPerBlock), 2};
-  bassFilter.prepare(spec);
-  midFilter.prepare(spec);
-  trebleFilter.prepare(spec);
+  juce::dsp::ProcessSpec spec{sampleRate, static_cast<juce::uint32>(chunkSize), 2};
+  toneStack.prepare(sampleRate, &memoryArena);
   dcBlockerLeft.prepare(spec);
   dcBlockerRight.prepare(spec);
 
-  *bassFilter.state =
-      *juce::dsp::IIR::Coefficients<float>::makeLowShelf(sampleRate, 100.0f, 1.0f, 1.0f);
-  *midFilter.state =
-      *juce::dsp::IIR::Coefficients<float>::makePeakFilter(sampleRate, 1000.0f, 1.0f, 1.0f);
-  *trebleFilter.state =
-      *juce::dsp::IIR::Coefficients<float>::makeHighShelf(sampleRate, 4000.0f, 1.0f, 1.0f);
+  // Start every ramp at the current parameter values
+  inputGain.prepare(sampleRate, levelRampSeconds);
+  outputGain.prepare(sampleRate, levelRampSeconds);
+  modelGuard.prepare(sampleRate, recoveryRampSeconds);
+  chainGuard.prepare(sampleRate, recoveryRampSeconds);
+  faultedDsps.fill(nullptr);
+  for (auto* smoother : {&bassKnob, &midKnob, &trebleKnob})
+    smoother->reset(sampleRate, toneRampSeconds);
+  applyParameterChanges(parameterSnapshot.reset());
+  inputGain.snapToTarget();
+  outputGain.snapToTarget();
+  modelBlender.prepare(sampleRate, chunkSize, &memoryArena);
+  for (auto* smoother : {&bassKnob, &midKnob, &trebleKnob})
+    smoother->setCurrentAndTargetValue(smoother->getTargetValue());
+  updateToneStack();
   *dcBlockerLeft.state = *juce::dsp::IIR::Coefficients<float>::makeHighPass(sampleRate, 20.0f);
   *dcBlockerRight.state = *juce::dsp::IIR::Coefficients<float>::makeHighPass(sampleRate, 20.0f);
 
   // Reset filters to clear state
-  bassFilter.reset();
-  midFilter.reset();
-  trebleFilter.reset();
+  toneStack.reset();
   dcBlockerLeft.reset();
   dcBlockerRight.reset();
 
   // Initialize oversampler (used only if model requires specific rate)
-  oversampler = std::make_unique<juce::dsp::Oversampling<float>>(
-      2, 0, juce::dsp::Oversampling<float>::filterHalfBandFIREquiripple);
+  oversampler = createOversampler(liveMonitoring);
   oversampler->initProcessing(static_cast<size_t>(samplesPerBlock));
   oversampler->reset();
 
@@ -273,18 +325,43 @@ void NeuralAmpProcessor::prepareToPlay(double sampleRate, int samplesPerBlock) {
   oversampleBuffer.setSize(2, maxOversampledFrames, false, false, true);
   oversampleBuffer.clear();
 
-  irConvolverLeft.prepare(spec);
-  irConvolverRight.prepare(spec);
-
-  normalizationGainSmoother.reset(sampleRate, 0.05f);  // Update smoother for current sample rate
-  setLatencySamples(bypassResampling ? 0 : static_cast<int>(oversampler->getLatencyInSamples()));
+  irConvolver.setMinimumPhase(liveMonitoring);
+  irConvolver.prepare(sampleRate, chunkSize, 2);
+  // IRs recorded for another sample rate were dropped; have the loader read the selections again
+  for (auto slot : {DualIrConvolver::slotA, DualIrConvolver::slotB}) {
+    if (!irConvolver.hasIr(slot)) {
+      currentIrIndices[static_cast<size_t>(slot)].store(-1);
+      attemptedIrIndices[static_cast<size_t>(slot)].store(-1);
+    }
+  }
+  irLoaded = irConvolver.hasAnyIr();
+  logMemoryUsage();
+
+  normalizationGain.prepare(sampleRate, normalizationRampSeconds);
+  outputLoudnessMeter.prepare(sampleRate);
+  modelLoudnessMeter.prepare(sampleRate);
+  telemetry.prepare(sampleRate);
+  loadMeasurer.reset(sampleRate, samplesPerBlock);
+  captureRecorder.prepare(sampleRate, getTotalNumInputChannels());
+  setLatencySamples(getChainLatencyInSamples(liveMonitoring));
+
+  // Model/IR loading needs the sample rate and block size, so only start servicing selections now
+  if (!loaderThread.isThreadRunning())
+    loaderThread.startThread(juce::Thread::Priority::low);
+  if (NEURALAMP_CONTROL_SOCKET)
+    controlServer.start();
 }
 
 void NeuralAmpProcessor::releaseResources() {
   juce::Logger::writeToLog("[Processor] releaseResources() called");
-  bassFilter.reset();
-  midFilter.reset();
-  trebleFilter.reset();
+  captureRecorder.release();
+  toneStack.reset();
+
+#if NEURALAMP_RT_AUDIT
+  const auto auditReport = RealtimeAudit::getReport();
+  if (auditReport.getTotal() > 0)
+    juce::Logger::writeToLog("[Processor] " + juce::String(auditReport.toString()));
+#endif
 }
 
 bool NeuralAmpProcessor::isBusesLayoutSupported(const BusesLayout& layouts) const {
@@ -300,67 +377,42 @@ bool NeuralAmpProcessor::isBusesLayoutSupported(const BusesLayout& layouts) cons
   return true;
 }
 
-void NeuralAmpProcessor::updateCachedParameters() {
-  constexpr float epsilon = 1e-5f;
-
-  auto input = parameters.getRawParameterValue("inputLevel")->load();
-  if (std::abs(input - cInputLevel) > epsilon)
-    cInputLevel = input;
-
-  auto output = parameters.getRawParameterValue("outputLevel")->load();
-  if (std::abs(output - cOutputLevel) > epsilon)
-    cOutputLevel = output;
-
-  auto bass = parameters.getRawParameterValue("toneBass")->load();
-  if (std::abs(bass - cToneBass) > epsilon)
-    cToneBass = bass;
-
-  auto mid = parameters.getRawParameterValue("toneMid")->load();
-  if (std::abs(mid - cToneMid) > epsilon)
-    cToneMid = mid;
-
-  auto treble = parameters.getRawParameterValue("toneTreble")->load();
-  if (std::abs(treble - cToneTreble) > epsilon)
-    cToneTreble = treble;
-
-  bool eq = parameters.getRawParameterValue("eqToggle")->load() > 0.5f;
-  if (eq != cEqToggle)
-    cEqToggle = eq;
-
-  bool ng = parameters.getRawParameterValue("noiseGateToggle")->load() > 0.5f;
-  if (ng != cNoiseGateToggle)
-    cNoiseGateToggle = ng;
-
-  auto ngThresh = parameters.getRawParameterValue("noiseGateThreshold")->load();
-  if (std::abs(ngThresh - cNoiseGateThreshold) > epsilon)
-    cNoiseGateThreshold = ngThresh;
-
-  int modelIndex = static_cast<int>(*parameters.getRawParameterValue("selectedNamModel"));
-  if (modelIndex != cSelectedNamModel)
-    cSelectedNamModel = modelIndex;
-
-  int irIndex = static_cast<int>(*parameters.getRawParameterValue("selectedIR"));
-  if (irIndex != cSelectedIR)
-    cSelectedIR = irIndex;
-
-  bool irToggle = parameters.getRawParameterValue("irToggle")->load() > 0.5f;
-  if (irToggle != cIrToggle)
-    cIrToggle = irToggle;
-
-  bool normalizeNam = parameters.getRawParameterValue("normalizeNamOutput")->load() > 0.5f;
-  if (normalizeNam != cNormalizeNamOutput)
-    cNormalizeNamOutput = normalizeNam;
-
-  bool normalizeIr = parameters.getRawParameterValue("normalizeIrOutput")->load() > 0.5f;
-  if (normalizeIr != cNormalizeNamOutput)
-    cNormalizeIrOutput = normalizeIr;
+void NeuralAmpProcessor::applyParameterChanges(ParameterSnapshot::Mask changed) {
+  using P = ParameterSnapshot;
+  if ((changed & P::maskOf(P::inputLevel)) != 0)
+    inputGain.setTargetDecibels(parameterSnapshot.get(P::inputLevel));
+  if ((changed & P::maskOf(P::outputLevel)) != 0)
+    outputGain.setTargetDecibels(parameterSnapshot.get(P::outputLevel));
+  if ((changed & P::maskOf(P::toneBass)) != 0)
+    bassKnob.setTargetValue(parameterSnapshot.get(P::toneBass));
+  if ((changed & P::maskOf(P::toneMid)) != 0)
+    midKnob.setTargetValue(parameterSnapshot.get(P::toneMid));
+  if ((changed & P::maskOf(P::toneTreble)) != 0)
+    trebleKnob.setTargetValue(parameterSnapshot.get(P::toneTreble));
+  if ((changed & P::maskOf(P::toneStackModel)) != 0)
+    toneStack.setModel(static_cast<ToneStack::Model>(juce::jlimit(
+        0, ToneStack::numModels - 1, juce::roundToInt(parameterSnapshot.get(P::toneStackModel)))));
+  if ((changed & P::maskOf(P::noiseGateThreshold)) != 0)
+    noiseGateThresholdGain =
+        juce::Decibels::decibelsToGain(parameterSnapshot.get(P::noiseGateThreshold));
+  if ((changed & P::maskOf(P::modelBlend)) != 0)
+    modelBlender.setBlend(parameterSnapshot.get(P::modelBlend));
+  if ((changed & P::maskOf(P::irBlend)) != 0)
+    irConvolver.setBlend(parameterSnapshot.get(P::irBlend));
+  // The loader converts the IRs and reports the new latency
+  if ((changed & P::maskOf(P::liveMonitoring)) != 0)
+    subBlockScheduler.setUseFifo(SubBlockScheduler::defaultUseFifo &&
+                                 !parameterSnapshot.isOn(P::liveMonitoring));
+}
 
-  auto tgtLoud = parameters.getRawParameterValue("targetLoudness")->load();
-  if (std::abs(tgtLoud - cTargetLoudness) > epsilon)
-    cTargetLoudness = tgtLoud;
+void NeuralAmpProcessor::updateToneStack() {
+  // Interpolated from the table built in prepareToPlay(), so this never allocates
+  toneStack.setControls(bassKnob.getCurrentValue(), midKnob.getCurrentValue(),
+                        trebleKnob.getCurrentValue());
 }
 
 void NeuralAmpProcessor::processBlock(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midi) {
+  NEURALAMP_REALTIME_SECTION;
   juce::ScopedNoDenormals noDenormals;
   juce::ignoreUnused(midi);
 
@@ -368,139 +420,211 @@ void NeuralAmpProcessor::processBlock(juce::AudioBuffer<float>& buffer, juce::Mi
   const size_t numChannels = static_cast<size_t>(buffer.getNumChannels());
 
   if (numSamples <= 0 || numChannels <= 0) {
-    DBG("Invalid buffer: samples=" << numSamples << ", channels=" << numChannels);
     buffer.clear();
     return;
   }
 
-  updateCachedParameters();
+  // A control socket batch lands whole, before anything reads the parameters this block
+  controlServer.applyPendingChanges();
 
-  float bassGain = cToneBass / 5.0f;
-  float midGain = cToneMid / 5.0f;
-  float trebleGain = cToneTreble / 5.0f;
+  // Raw DI, before any gain
+  captureRecorder.setRecording(captureEnabled->load() > 0.5f, captureOutput->load() > 0.5f,
+                               captureFormat->load() > 0.5f ? CaptureRecorder::Format::flac
+                                                            : CaptureRecorder::Format::wav);
+  captureRecorder.pushInput(buffer);
 
-  // Apply input gain
-  for (size_t channel = 0; channel < numChannels; ++channel) {
-    auto* channelData = buffer.getWritePointer(static_cast<int>(channel));
-    for (int i = 0; i < numSamples; ++i) {
-      channelData[i] *= cInputLevel;
-    }
+  juce::AudioProcessLoadMeasurer::ScopedTimer loadTimer(loadMeasurer, numSamples);
+  applyParameterChanges(parameterSnapshot.update());
+
+  // A new model or IR invalidates the loudness measured so far
+  if (loudnessResetPending.exchange(false)) {
+    outputLoudnessMeter.reset();
+    modelLoudnessMeter.reset();
+    if (modelLoudnessPending.exchange(false))
+      loudnessEstimate = pendingModelLoudness.load();
   }
 
+  // publishModel() won't free the models read here until the sequence moves on again
+  audioBlockSequence.fetch_add(1);
+  ModelBlender::Models models{};
+  for (size_t slot = 0; slot < numModelSlots; ++slot)
+    models[slot] = modelLoaded[slot].load() ? activeDsps[slot].load() : nullptr;
+
+  // Feed the chain in fixed-size chunks whatever block size the host sends
+  subBlockScheduler.process(buffer, [this, &models](juce::dsp::AudioBlock<float> block) {
+    processChunk(block, models);
+  });
+  audioBlockSequence.fetch_add(1);
+  captureRecorder.pushOutput(buffer);
+
+  // The load reported is the smoothed figure up to the previous block
+  telemetry.finishBlock(numSamples, static_cast<float>(loadMeasurer.getLoadAsProportion()),
+                        loadMeasurer.getXRunCount(), static_cast<int>(getNonFiniteRecoveries()),
+                        faultedModelSlots.load(std::memory_order_relaxed),
+                        refusedModelSlots.load(std::memory_order_relaxed));
+}
+
+void NeuralAmpProcessor::processChunk(juce::dsp::AudioBlock<float>& block,
+                                      const ModelBlender::Models& models) {
+  const int numSamples = static_cast<int>(block.getNumSamples());
+  const size_t numChannels = block.getNumChannels();
+
+  // Apply input gain
+  inputGain.apply(block);
+  telemetry.measureInput(block);
+
   // Noise gate
-  if (cNoiseGateToggle) {
+  if (parameterSnapshot.isOn(ParameterSnapshot::noiseGateToggle)) {
+    const float threshold = noiseGateThresholdGain;
+    bool gateOpen = false;
     for (size_t channel = 0; channel < numChannels; ++channel) {
-      auto* channelData = buffer.getWritePointer(static_cast<int>(channel));
+      auto* channelData = block.getChannelPointer(channel);
       for (int i = 0; i < numSamples; ++i) {
-        if (std::abs(channelData[i]) < juce::Decibels::decibelsToGain(cNoiseGateThreshold))
-          channelData[i] = 0.0f;
+        const bool passes = std::abs(channelData[i]) >= threshold;
+        channelData[i] = passes ? channelData[i] : 0.0f;
+        gateOpen = gateOpen || passes;
       }
     }
+    telemetry.setGateOpen(gateOpen);
+  } else {
+    telemetry.setGateOpen(true);
   }
 
-  // Lock guard
-  std::shared_ptr<nam::DSP> localDsp;
-  {
-    std::lock_guard<std::mutex> lock(dspMutex);
-    localDsp = dsp;
+  // NAM Processing. Models that produced NaN or infinity keep the stage muted until the loader
+  // thread has replaced them, then it fades back in.
+  bool replaced = false;
+  bool faulted = false;
+  for (size_t slot = 0; slot < numModelSlots; ++slot) {
+    if (faultedDsps[slot] != nullptr && faultedDsps[slot] != models[slot]) {
+      faultedDsps[slot] = nullptr;
+      replaced = true;
+    }
+    faulted = faulted || faultedDsps[slot] != nullptr;
   }
-
-  // NAM Processing
-  if (modelLoaded.load() && localDsp) {
+  if (replaced && !faulted)
+    modelGuard.recover();
+
+  const bool anyModel =
+      models[ModelBlender::slotA] != nullptr || models[ModelBlender::slotB] != nullptr;
+  if (anyModel && faulted) {
+    block.clear();
+  } else if (anyModel) {
+    // A model that throws is handled like one that produced NaN: muted until it is reloaded
+    bool threw = false;
     try {
       // Process directly at DAW's sample rate
-      std::vector<double> input(static_cast<size_t>(numSamples));
-      for (size_t i = 0; i < static_cast<size_t>(numSamples); ++i) {
-        float l = buffer.getSample(0, static_cast<int>(i));
-        float r = (numChannels > 1) ? buffer.getSample(1, static_cast<int>(i)) : l;
-        input[i] = 0.5 * (l + r);
-      }
-
-      std::vector<double> output(static_cast<size_t>(numSamples));
-      localDsp->process(input.data(), output.data(), static_cast<size_t>(numSamples));
+      float* left = block.getChannelPointer(0);
+      const float* right = numChannels > 1 ? block.getChannelPointer(1) : left;
+      for (int i = 0; i < numSamples; ++i)
+        left[i] = 0.5f * (left[i] + right[i]);
+
+      modelBlender.process(left, left, numSamples, models);
+
+      if (numChannels > 1)
+        std::copy(left, left + numSamples, block.getChannelPointer(1));
+    } catch (const std::exception&) {
+      threw = true;
+      modelGuard.clear(block);
+    }
 
-      for (size_t i = 0; i < static_cast<size_t>(numSamples); ++i) {
-        float s = static_cast<float>(output[i]);
-        buffer.setSample(0, static_cast<int>(i), s);
-        if (numChannels > 1)
-          buffer.setSample(1, static_cast<int>(i), s);
+    // Either running model may be the culprit, so both are reloaded
+    if (threw || modelGuard.clearIfNonFinite(block)) {
+      for (const auto slot : {ModelBlender::slotA, ModelBlender::slotB}) {
+        const auto index = static_cast<size_t>(slot);
+        if (models[index] != nullptr && modelBlender.isRunning(slot)) {
+          faultedDsps[index] = models[index];
+          modelResetPending.fetch_or(1 << slot);
+        }
       }
-    } catch (const std::exception& e) {
-      DBG("Error in DSP processing: " << e.what());
-      buffer.clear();
-      return;
     }
   }
+  modelGuard.apply(block);
 
   // DC blocker
-  juce::dsp::AudioBlock<float> block(buffer);
   juce::dsp::ProcessContextReplacing<float> context(block);
   dcBlockerLeft.process(context);
   if (numChannels > 1)
     dcBlockerRight.process(context);
 
-  // Normalizer
-  if (cNormalizeNamOutput == 1 && localDsp) {
-    float modelLoudness = static_cast<float>(localDsp->GetLoudness());
-    float targetLoudness = *parameters.getRawParameterValue("targetLoudness");
-
-    if (!std::isfinite(modelLoudness) || modelLoudness < -120.0f || modelLoudness > 0.0f) {
-      DBG("Invalid model loudness: " << modelLoudness);
-      modelLoudness = targetLoudness;
-    }
-
-    float gainAdjustmentDb = targetLoudness - modelLoudness;
-    float targetGain = juce::Decibels::decibelsToGain(gainAdjustmentDb);
-    normalizationGainSmoother.setTargetValue(targetGain);
-
-    for (int i = 0; i < numSamples; ++i) {
-      float currentGain = normalizationGainSmoother.getNextValue();
-      for (size_t channel = 0; channel < numChannels; ++channel) {
-        auto* channelData = buffer.getWritePointer(static_cast<int>(channel));
-        channelData[i] *= currentGain;
-      }
+  // The loudness remembered per model is the model's own, as in its .nam metadata, so it holds
+  // under any IR or none
+  const bool normalize = parameterSnapshot.isOn(ParameterSnapshot::normalizeNamOutput) && anyModel;
+  const float* meteredChannels[2] = {block.getChannelPointer(0),
+                                     numChannels > 1 ? block.getChannelPointer(1) : nullptr};
+  const int numMeteredChannels = juce::jmin(static_cast<int>(numChannels), 2);
+  if (normalize) {
+    modelLoudnessMeter.process(meteredChannels, numMeteredChannels, numSamples);
+    if (!loudnessResetPending.load()) {
+      publishedLoudness.store(modelLoudnessMeter.getIntegratedLoudness());
+      publishedLoudnessSeconds.store(modelLoudnessMeter.getGatedSeconds());
     }
   }
 
   // IR processing
-  bool irToggleOn = *parameters.getRawParameterValue("irToggle") > 0.5f;
-  if (irToggleOn && irLoaded) {
-    juce::dsp::AudioBlock<float> irBlock(buffer);
-    auto leftBlock = irBlock.getSingleChannelBlock(0);
-    auto rightBlock = numChannels > 1 ? irBlock.getSingleChannelBlock(1) : leftBlock;
-    irConvolverLeft.process(juce::dsp::ProcessContextReplacing<float>(leftBlock));
-    if (numChannels > 1) {
-      irConvolverRight.process(juce::dsp::ProcessContextReplacing<float>(rightBlock));
+  if (parameterSnapshot.isOn(ParameterSnapshot::irToggle) && irLoaded)
+    irConvolver.process(block);
+
+  // Normalizer. The meter sits before the gain so the loop never measures its own correction.
+  if (normalize) {
+    outputLoudnessMeter.process(meteredChannels, numMeteredChannels, numSamples);
+
+    const float measuredLoudness = outputLoudnessMeter.getIntegratedLoudness();
+    const float measuredSeconds = outputLoudnessMeter.getGatedSeconds();
+    if (measuredSeconds >= minMeasuredLoudnessSeconds) {
+      // Slew towards the measurement so model and IR changes converge smoothly
+      const float alpha = juce::jmin(
+          1.0f, static_cast<float>(numSamples / (loudnessConvergenceSeconds * getSampleRate())));
+      if (std::isfinite(loudnessEstimate))
+        loudnessEstimate += (measuredLoudness - loudnessEstimate) * alpha;
+      else
+        loudnessEstimate = measuredLoudness;
     }
+
+    float targetLoudness = parameterSnapshot.get(ParameterSnapshot::targetLoudness);
+    float modelLoudness = std::isfinite(loudnessEstimate) ? loudnessEstimate : targetLoudness;
+    float gainAdjustmentDb = juce::jlimit(-maxNormalizationDb, maxNormalizationDb,
+                                          targetLoudness - modelLoudness);
+    normalizationGain.setTargetDecibels(gainAdjustmentDb);
+    normalizationGain.apply(block);
   }
 
-  // EQ
-  if (cEqToggle) {
-    auto bassCoeffs =
-        juce::dsp::IIR::Coefficients<float>::makeLowShelf(getSampleRate(), 100.0f, 1.0f, bassGain);
-    auto midCoeffs = juce::dsp::IIR::Coefficients<float>::makePeakFilter(getSampleRate(), 1000.0f,
-                                                                         1.0f, midGain);
-    auto trebleCoeffs = juce::dsp::IIR::Coefficients<float>::makeHighShelf(getSampleRate(), 4000.0f,
-                                                                           1.0f, trebleGain);
+  // Tone ramps step the tone stack coefficients once per chunk
+  if (bassKnob.isSmoothing() || midKnob.isSmoothing() || trebleKnob.isSmoothing()) {
+    for (auto* smoother : {&bassKnob, &midKnob, &trebleKnob})
+      smoother->skip(numSamples);
+    updateToneStack();
+  }
 
-    *bassFilter.state = *bassCoeffs;
-    *midFilter.state = *midCoeffs;
-    *trebleFilter.state = *trebleCoeffs;
+  // EQ
+  if (parameterSnapshot.isOn(ParameterSnapshot::eqToggle)) {
+    float* channels[2] = {block.getChannelPointer(0),
+                          numChannels > 1 ? block.getChannelPointer(1) : nullptr};
+    toneStack.process(channels, juce::jmin(static_cast<int>(numChannels), 2), numSamples);
+  }
 
-    juce::dsp::AudioBlock<float> eqBlock(buffer);
-    juce::dsp::ProcessContextReplacing<float> eqContext(eqBlock);
-    bassFilter.process(eqContext);
-    midFilter.process(eqContext);
-    trebleFilter.process(eqContext);
+  // The model's output was finite, so NaN or infinity here came from the filters, IR or normaliser
+  if (chainGuard.clearIfNonFinite(block)) {
+    resetFilterChain();
+    chainGuard.recover();
   }
+  chainGuard.apply(block);
 
   // Apply output gain
-  for (size_t channel = 0; channel < numChannels; ++channel) {
-    auto* channelData = buffer.getWritePointer(static_cast<int>(channel));
-    for (int i = 0; i < numSamples; ++i) {
-      channelData[i] *= cOutputLevel;
-    }
-  }
+  outputGain.apply(block);
+  telemetry.measureOutput(block);
+}
+
+void NeuralAmpProcessor::resetFilterChain() {
+  dcBlockerLeft.reset();
+  dcBlockerRight.reset();
+  irConvolver.reset();
+  toneStack.reset();
+  outputLoudnessMeter.reset();
+  modelLoudnessMeter.reset();
+}
+
+juce::uint32 NeuralAmpProcessor::getNonFiniteRecoveries() const {
+  return modelGuard.getFaultCount() + chainGuard.getFaultCount();
 }
 
 bool NeuralAmpProcessor::hasEditor() const {
@@ -523,42 +647,441 @@ void NeuralAmpProcessor::setStateInformation(const void* data, int sizeInBytes)
   juce::ignoreUnused(data, sizeInBytes);
 }
 
-void NeuralAmpProcessor::loadNamFile(const juce::String& filePath) {
+bool NeuralAmpProcessor::loadNamFile(const juce::String& filePath, ModelBlender::Slot slot) {
+  const auto index = static_cast<size_t>(slot);
   juce::File file(filePath);
   if (!file.existsAsFile()) {
     DBG("Error: File does not exist: " << filePath);
-    modelLoaded.store(false);
-    return;
+    return false;
   }
   DBG("Loading NAM model from: " << filePath);
+  // Serialises loads from the loader thread, fault resets and direct calls
+  const juce::ScopedLock lock(modelLoadLock);
   try {
-    std::unique_ptr<nam::DSP> rawDsp = nam::get_dsp(filePath.toStdString());
+#if NEURALAMP_REFUSE_OVER_BUDGET
+    const auto profile = libraryIndex.getCpuProfile(file);
+    if (profile && profile->overBudget && profile->matches(modelSampleRate, modelBlockSize)) {
+      juce::Logger::writeToLog("[Processor] " + file.getFileName() + " is over the CPU budget (" +
+                               ModelProfiler::describe(*profile) + "); keeping the current model");
+      refusedModelSlots.fetch_or(1 << slot);
+      return false;
+    }
+#endif
+    std::unique_ptr<nam::DSP> rawDsp = createModel(file);
     if (rawDsp) {
-      rawDsp->Reset(modelSampleRate, getBlockSize());
-      {
-        std::lock_guard<std::mutex> lock(dspMutex);
-        dsp = std::move(rawDsp);
+      warmUpModel(*rawDsp, modelBlockSize.load());
+      const float initialLoudness = getInitialLoudness(file, *rawDsp);
+      if (!pinModel(*rawDsp)) {
+        juce::Logger::writeToLog("[Processor] " + file.getFileName() +
+                                 " doesn't fit under the memory cap; keeping the current model");
+        refusedModelSlots.fetch_or(1 << slot);
+        return false;
       }
-      modelLoaded.store(true);
-      DBG("Model loaded successfully: " << filePath);
-    } else {
-      {
-        std::lock_guard<std::mutex> lock(dspMutex);
-        dsp = nullptr;
+      publishModel(std::move(rawDsp), slot);
+      modelLoaded[index].store(true);
+      currentModelFiles[index] = file;
+      clearModelFaults(slot);
+      refusedModelSlots.fetch_and(~(1 << slot));
+      publishedLoudnessSeconds.store(0.0f);
+      // A model's own loudness only predicts the output while it plays alone
+      if (getSoloModelSlot() == slot) {
+        pendingModelLoudness.store(initialLoudness);
+        modelLoudnessPending.store(true);
       }
-      modelLoaded.store(false);
-      DBG("Failed to load model: null DSP returned");
+      loudnessResetPending.store(true);
+      DBG("Model loaded successfully: " << filePath);
+      logMemoryUsage();
+      return true;
     }
+    DBG("Failed to load model: null DSP returned");
   } catch (const std::exception& e) {
     DBG("Error loading model: " << e.what());
-    modelLoaded.store(false);
   }
+  return false;
 }
 
-void NeuralAmpProcessor::loadIrFile(const juce::File& irFile) {
+// The engine a load runs for file: NAM's model, or the quantised or SIMD engine the library index
+// allows, reset for the current sample rate and chunk size. Null if NAM can't read the file.
+std::unique_ptr<nam::DSP> NeuralAmpProcessor::createModel(const juce::File& file) {
+  std::unique_ptr<nam::DSP> model = nam::get_dsp(file.getFullPathName().toStdString());
+  if (!model)
+    return nullptr;
+  model->Reset(modelSampleRate, modelBlockSize.load());
+  return applyInferenceMode(file, std::move(model));
+}
+
+void NeuralAmpProcessor::publishModel(std::unique_ptr<nam::DSP> model, ModelBlender::Slot slot) {
+  const auto index = static_cast<size_t>(slot);
+  std::unique_ptr<nam::DSP> retired;
+  {
+    std::lock_guard<std::mutex> lock(dspMutex);
+    activeDsps[index].store(model.get());
+    retired = std::exchange(dsps[index], std::move(model));
+  }
+
+  // A block that started before the store may still be running the old model
+  const auto sequence = audioBlockSequence.load();
+  if ((sequence & 1) != 0) {
+    while (audioBlockSequence.load() == sequence)
+      juce::Thread::sleep(1);
+  }
+  memoryArena.unpin(retired.get());
+}
+
+// Counts a model's buffers against the memory cap and locks them in place. NAM's own models can't
+// list their buffers, so they run uncounted.
+bool NeuralAmpProcessor::pinModel(const nam::DSP& model) {
+  const auto* resident = dynamic_cast<const ResidentModel*>(&model);
+  if (resident == nullptr) {
+    juce::Logger::writeToLog("[Processor] NAM model buffers aren't counted against the memory cap");
+    return true;
+  }
+  return memoryArena.pin(&model, [resident](const MemoryArena::BufferVisitor& visit) {
+    resident->forEachBuffer(visit);
+  });
+}
+
+void NeuralAmpProcessor::logMemoryUsage() const {
+  juce::Logger::writeToLog("[Memory] " + juce::String(memoryArena.getUsage().toString()));
+}
+
+// Runs silence through a freshly loaded model on the calling (loader) thread so that the first
+// audio-thread blocks after the swap run at steady-state cost: the receptive field has settled,
+// the Eigen buffers have grown to the chunk size and every weight page has been touched.
+void NeuralAmpProcessor::warmUpModel(nam::DSP& model, int blockSize) const {
+  const int numFrames = juce::jmax(1, blockSize);
+  const int warmUpSamples = static_cast<int>(modelSampleRate * modelWarmUpSeconds);
+
+  std::vector<NAM_SAMPLE> input(static_cast<size_t>(numFrames), 0.0);
+  std::vector<NAM_SAMPLE> output(static_cast<size_t>(numFrames), 0.0);
+
+  // Always run at least one full-size block so no buffer is resized on the audio thread
+  int processed = 0;
+  do {
+    model.process(input.data(), output.data(), numFrames);
+    processed += numFrames;
+  } while (processed < warmUpSamples);
+
+  DBG("Model warmed up with " << processed << " samples");
+}
+
+// Swaps the float model for a quantised one if the library index asks for it and the quantised
+// model tracks the float one within maxQuantisationEsr. ESRs are cached per file and format, so a
+// model that failed the check once is not re-measured on every load. Float models run on the SIMD
+// engines where the architecture is covered.
+std::unique_ptr<nam::DSP> NeuralAmpProcessor::applyInferenceMode(const juce::File& modelFile,
+                                                                 std::unique_ptr<nam::DSP> model) {
+  const auto mode = libraryIndex.getInferenceMode(modelFile);
+  if (mode == "float")
+    return applySimdEngine(modelFile, std::move(model));
+
+  std::vector<std::pair<juce::String, WeightFormat>> formats;
+  if (mode == "int8" || mode == "auto")
+    formats.emplace_back("int8", WeightFormat::int8);
+  if (mode == "int16" || mode == "auto")
+    formats.emplace_back("int16", WeightFormat::int16);
+
+  for (const auto& [name, format] : formats) {
+    if (auto cachedEsr = libraryIndex.getBackendEsr(modelFile, name);
+        cachedEsr && *cachedEsr > maxQuantisationEsr) {
+      continue;
+    }
+
+    double esr = 0.0;
+    auto quantised = makeQuantisedModel(modelFile.getFullPathName().toStdString(), format, *model,
+                                        maxQuantisationEsr, esr);
+    if (std::isfinite(esr))
+      libraryIndex.setBackendEsr(modelFile, name, esr);
+
+    if (quantised) {
+      juce::Logger::writeToLog("[Processor] Using " + name + " inference for " +
+                               modelFile.getFileName() + " (ESR " + juce::String(esr) + ")");
+      quantised->Reset(modelSampleRate, modelBlockSize.load());
+      return quantised;
+    }
+  }
+
+  juce::Logger::writeToLog("[Processor] Quantised inference refused for " +
+                           modelFile.getFileName() + ", using float model");
+  return applySimdEngine(modelFile, std::move(model));
+}
+
+std::unique_ptr<nam::DSP> NeuralAmpProcessor::applySimdEngine(const juce::File& modelFile,
+                                                              std::unique_ptr<nam::DSP> model) {
+  const auto cachedEsr = libraryIndex.getBackendEsr(modelFile, "simd");
+  if (!cachedEsr || *cachedEsr <= maxSimdEsr) {
+    double esr = 0.0;
+    auto engine =
+        makeSimdModel(modelFile.getFullPathName().toStdString(), *model, maxSimdEsr, esr);
+    if (std::isfinite(esr))
+      libraryIndex.setBackendEsr(modelFile, "simd", esr);
+
+    if (engine) {
+      juce::Logger::writeToLog("[Processor] Using " + juce::String(getSimdKernels().name) +
+                               " kernels for " + modelFile.getFileName() + " (ESR " +
+                               juce::String(esr) + ")");
+      engine->Reset(modelSampleRate, modelBlockSize.load());
+      return engine;
+    }
+  }
+
+  model->Reset(modelSampleRate, modelBlockSize.load());
+  return model;
+}
+
+void NeuralAmpProcessor::setModelInferenceMode(int index, const juce::String& mode) {
+  const auto& paths = getModelPaths();
+  if (index <= 0 || index >= static_cast<int>(paths.size()))
+    return;
+
+  libraryIndex.setInferenceMode(juce::File(paths[static_cast<size_t>(index)]), mode);
+  for (const auto slot : {ModelBlender::slotA, ModelBlender::slotB}) {
+    if (index == getCurrentModelIndex(slot))
+      modelReloadPending.fetch_or(1 << slot);
+  }
+}
+
+// Best known loudness for a freshly loaded model: what we measured at its output (before the IR)
+// last time it was played, else the loudness stored in the .nam metadata. NaN means unknown until
+// the meter has converged.
+float NeuralAmpProcessor::getInitialLoudness(const juce::File& modelFile, nam::DSP& model) {
+  if (auto cached = libraryIndex.getLoudness(modelFile))
+    return *cached;
+
+  if (model.HasLoudness())
+    return static_cast<float>(model.GetLoudness());
+
+  juce::Logger::writeToLog("[Processor] No loudness metadata in " + modelFile.getFileName() +
+                           ", normalising from measured output");
+  return std::numeric_limits<float>::quiet_NaN();
+}
+
+std::optional<ModelBlender::Slot> NeuralAmpProcessor::getSoloModelSlot() const {
+  const bool loadedA = modelLoaded[ModelBlender::slotA].load();
+  const bool loadedB = modelLoaded[ModelBlender::slotB].load();
+  const float blend = *parameters.getRawParameterValue("modelBlend");
+  if (loadedA && (!loadedB || blend <= 0.0f))
+    return ModelBlender::slotA;
+  if (loadedB && (!loadedA || blend >= 1.0f))
+    return ModelBlender::slotB;
+  return std::nullopt;
+}
+
+// Called periodically from the loader thread to remember what the meter measured for the current
+// model, so the right normalisation gain is applied as soon as it is loaded again.
+void NeuralAmpProcessor::updateLibraryIndex() {
+  const auto soloSlot = getSoloModelSlot();
+  const auto soloFile =
+      soloSlot ? currentModelFiles[static_cast<size_t>(*soloSlot)] : juce::File();
+  if (soloFile != juce::File() && publishedLoudnessSeconds.load() >= cacheLoudnessAfterSeconds) {
+    const float loudness = publishedLoudness.load();
+    if (std::isfinite(loudness))
+      libraryIndex.setLoudness(soloFile, loudness);
+  }
+
+  const auto now = juce::Time::getMillisecondCounter();
+  if (now - lastLibraryIndexSave >= libraryIndexSaveIntervalMs) {
+    libraryIndex.saveIfNeeded();
+    lastLibraryIndexSave = now;
+  }
+}
+
+// Builds each model as a load would and times it at the current sample rate and chunk size. Runs
+// beside the loader rather than under modelLoadLock, so selections keep loading meanwhile.
+int NeuralAmpProcessor::profileLibrary(bool force, const std::function<bool()>& shouldExit) {
+  const double sampleRate = getSampleRate();
+  const int blockSize = modelBlockSize.load();
+  if (sampleRate <= 0.0)
+    return 0;
+
+  int profiled = 0;
+  const auto paths = getModelPaths();
+  for (size_t i = 1; i < paths.size(); ++i) {
+    if (shouldExit && shouldExit())
+      break;
+    const juce::File file(paths[i]);
+    if (const auto profile = libraryIndex.getCpuProfile(file);
+        !force && profile && profile->matches(sampleRate, blockSize)) {
+      continue;
+    }
+
+    try {
+      auto model = createModel(file);
+      if (!model)
+        continue;
+      const auto profile = ModelProfiler::measure(*model, sampleRate, blockSize);
+      libraryIndex.setCpuProfile(file, profile);
+      juce::Logger::writeToLog("[Profiler] " + file.getFileName() + ": " +
+                               ModelProfiler::describe(profile));
+      ++profiled;
+    } catch (const std::exception& e) {
+      juce::Logger::writeToLog("[Profiler] " + file.getFileName() + " failed: " + e.what());
+    }
+  }
+  libraryIndex.saveIfNeeded();
+  return profiled;
+}
+
+void NeuralAmpProcessor::requestLibraryProfiling(bool force) {
+  loaderThread.requestProfiling(force);
+}
+
+bool NeuralAmpProcessor::isProfilingLibrary() const {
+  return loaderThread.isProfiling();
+}
+
+void NeuralAmpProcessor::refreshCatalogues(const std::function<bool()>& shouldExit) {
+  if (modelCatalogue.refresh(shouldExit))
+    irCatalogue.refresh(shouldExit);
+}
+
+void NeuralAmpProcessor::requestModel(const juce::String& id, ModelBlender::Slot slot) {
+  const juce::ScopedLock lock(requestLock);
+  requestedModelIds[static_cast<size_t>(slot)] = id;
+}
+
+void NeuralAmpProcessor::requestIr(const juce::String& id, DualIrConvolver::Slot slot) {
+  const juce::ScopedLock lock(requestLock);
+  requestedIrIds[static_cast<size_t>(slot)] = id;
+}
+
+// Loader thread. A requested file stays loaded until the selection parameters change again.
+void NeuralAmpProcessor::loadRequestedFiles() {
+  std::array<std::optional<juce::String>, numModelSlots> modelIds;
+  std::array<std::optional<juce::String>, DualIrConvolver::numSlots> irIds;
+  {
+    const juce::ScopedLock lock(requestLock);
+    std::swap(modelIds, requestedModelIds);
+    std::swap(irIds, requestedIrIds);
+  }
+
+  for (const auto slot : {ModelBlender::slotA, ModelBlender::slotB}) {
+    const auto& modelId = modelIds[static_cast<size_t>(slot)];
+    if (!modelId)
+      continue;
+    const auto file = juce::File::isAbsolutePath(*modelId) ? juce::File(*modelId)
+                                                           : modelCatalogue.getFile(*modelId);
+    if (file.existsAsFile())
+      loadNamFile(file.getFullPathName(), slot);
+    else
+      DBG("Unknown model ID: " << *modelId);
+  }
+
+  for (auto slot : {DualIrConvolver::slotA, DualIrConvolver::slotB}) {
+    const auto& irId = irIds[static_cast<size_t>(slot)];
+    if (!irId)
+      continue;
+    const auto file = juce::File::isAbsolutePath(*irId) ? juce::File(*irId)
+                                                        : irCatalogue.getFile(*irId);
+    if (file.existsAsFile())
+      loadIrFile(file, slot);
+    else
+      DBG("Unknown IR ID: " << *irId);
+  }
+}
+
+void NeuralAmpProcessor::loadModelAtIndex(int index, ModelBlender::Slot slot) {
+  const auto slotIndex = static_cast<size_t>(slot);
+  attemptedModelIndices[slotIndex].store(index);
+
+  // Past the listing (a saved selection from a larger library): keep whatever is playing
+  const auto& paths = getModelPaths();
+  if (index >= static_cast<int>(paths.size())) {
+    juce::Logger::writeToLog("[Processor] Model selection " + juce::String(index) +
+                             " is past the end of the library listing (" +
+                             juce::String(paths.size() - 1) + " models); ignored");
+    return;
+  }
+  if (index <= 0) {
+    publishModel(nullptr, slot);
+    modelLoaded[slotIndex].store(false);
+    currentModelFiles[slotIndex] = juce::File();
+    clearModelFaults(slot);
+    refusedModelSlots.fetch_and(~(1 << slot));
+    currentModelIndices[slotIndex].store(index);
+    return;
+  }
+
+  // Only a model that is now playing changes the index the editor and status report
+  if (loadNamFile(paths[static_cast<size_t>(index)], slot))
+    currentModelIndices[slotIndex].store(index);
+}
+
+void NeuralAmpProcessor::reloadCurrentModel(ModelBlender::Slot slot) {
+  const juce::ScopedLock lock(modelLoadLock);
+  const auto index = static_cast<size_t>(slot);
+  const auto file = currentModelFiles[index];
+  if (!file.existsAsFile())
+    return;
+  // Still the same model, so its faults in a row carry on
+  const auto faults = modelFaults[index];
+  loadNamFile(file.getFullPathName(), slot);
+  modelFaults[index] = faults;
+  modelFaults[index].reloadedAtMs = juce::Time::getMillisecondCounter();
+}
+
+void NeuralAmpProcessor::handleModelFault(ModelBlender::Slot slot, bool faultReported) {
+  const juce::ScopedLock lock(modelLoadLock);
+  auto& faults = modelFaults[static_cast<size_t>(slot)];
+  const auto now = juce::Time::getMillisecondCounter();
+  if (faultReported && !isModelFaulted(slot)) {
+    if (faults.count > 0 && now - faults.reloadedAtMs >= modelFaultMemoryMs)
+      faults.count = 0;
+    const auto name = currentModelFiles[static_cast<size_t>(slot)].getFileName();
+    if (++faults.count >= maxModelFaults) {
+      faults.retryPending = false;
+      faultedModelSlots.fetch_or(1 << slot);
+      juce::Logger::writeToLog("[Processor] " + name + " failed (NaN, infinity or an exception) " +
+                               juce::String(faults.count) + " times in a row; leaving it muted");
+      return;
+    }
+    faults.retryPending = true;
+    faults.retryAtMs = now + (modelResetBackoffMs << (faults.count - 1));
+  }
+  if (faults.retryPending && static_cast<juce::int32>(now - faults.retryAtMs) >= 0) {
+    faults.retryPending = false;
+    reloadCurrentModel(slot);
+  }
+}
+
+void NeuralAmpProcessor::clearModelFaults(ModelBlender::Slot slot) {
+  const juce::ScopedLock lock(modelLoadLock);
+  modelFaults[static_cast<size_t>(slot)] = ModelFaults();
+  faultedModelSlots.fetch_and(~(1 << slot));
+}
+
+void NeuralAmpProcessor::loadIrAtIndex(int index, DualIrConvolver::Slot slot) {
+  attemptedIrIndices[static_cast<size_t>(slot)].store(index);
+
+  const auto& paths = getIrPaths();
+  if (index >= static_cast<int>(paths.size())) {
+    juce::Logger::writeToLog("[Processor] IR selection " + juce::String(index) +
+                             " is past the end of the library listing (" +
+                             juce::String(paths.size() - 1) + " IRs); ignored");
+    return;
+  }
+
+  currentIrIndices[static_cast<size_t>(slot)].store(index);
+  if (index <= 0) {
+    irConvolver.clearIr(slot);
+    irLoaded = irConvolver.hasAnyIr();
+    return;
+  }
+
+  loadIrFile(juce::File(paths[static_cast<size_t>(index)]), slot);
+}
+
+// A file that can't be used empties the slot, so the other IR keeps playing on its own
+void NeuralAmpProcessor::loadIrFile(const juce::File& irFile, DualIrConvolver::Slot slot) {
+  const juce::ScopedLock lock(irLoadLock);
+  const auto fail = [this, slot] {
+    irConvolver.clearIr(slot);
+    irLoaded = irConvolver.hasAnyIr();
+  };
+
   if (!irFile.existsAsFile() || !irFile.hasFileExtension(".wav")) {
     DBG("Invalid IR file: " << irFile.getFullPathName());
-    irLoaded = false;
+    fail();
     return;
   }
 
@@ -568,40 +1091,80 @@ void NeuralAmpProcessor::loadIrFile(const juce::File& irFile) {
 
   if (!reader) {
     DBG("Failed to read IR file: " << irFile.getFullPathName());
-    irLoaded = false;
+    fail();
     return;
   }
 
   if (std::abs(reader->sampleRate - getSampleRate()) > 0.1) {
     DBG("IR sample rate (" << reader->sampleRate << ") does not match plugin sample rate ("
                            << getSampleRate() << ")");
-    irLoaded = false;
+    fail();
     return;
   }
 
-  const juce::ScopedLock lock(irLoadLock);
   DBG("Loading IR file: " << irFile.getFullPathName());
 
   try {
     bool normalize = *parameters.getRawParameterValue("normalizeIrOutput") > 0.5f;
-    const size_t maxIrLength = 32768;  // Reduced for RPi4 memory efficiency
-
-    irConvolverLeft.loadImpulseResponse(
-        irFile, juce::dsp::Convolution::Stereo::no, juce::dsp::Convolution::Trim::yes, maxIrLength,
-        normalize ? juce::dsp::Convolution::Normalise::yes : juce::dsp::Convolution::Normalise::no);
-
-    irConvolverRight.loadImpulseResponse(
-        irFile, juce::dsp::Convolution::Stereo::no, juce::dsp::Convolution::Trim::yes, maxIrLength,
-        normalize ? juce::dsp::Convolution::Normalise::yes : juce::dsp::Convolution::Normalise::no);
-
-    irLoaded = true;
+    const auto maxLength = static_cast<juce::int64>(DualIrConvolver::maxIrLength);
+    const int length = static_cast<int>(juce::jmin(reader->lengthInSamples, maxLength));
+    juce::AudioBuffer<float> impulse(1, length);
+    reader->read(&impulse, 0, length, 0, true, false);
+    irConvolver.loadIr(slot, impulse, reader->sampleRate, normalize);
+
+    irLoaded = irConvolver.hasAnyIr();
+    loudnessResetPending.store(true);
     DBG("IR loaded successfully");
+    logMemoryUsage();
   } catch (const std::exception& e) {
     DBG("Error loading IR: " << e.what());
-    irLoaded = false;
+    fail();
   }
 }
 
+bool NeuralAmpProcessor::isLiveMonitoring() const {
+  return *parameters.getRawParameterValue("liveMonitoring") > 0.5f;
+}
+
+// Polyphase IIR half-bands add no delay at the cost of phase distortion near Nyquist; the FIR
+// ones are linear phase but delay the signal by half their length
+std::unique_ptr<juce::dsp::Oversampling<float>> NeuralAmpProcessor::createOversampler(
+    bool liveMonitoring) {
+  return std::make_unique<juce::dsp::Oversampling<float>>(
+      2, 0,
+      liveMonitoring ? juce::dsp::Oversampling<float>::filterHalfBandPolyphaseIIR
+                     : juce::dsp::Oversampling<float>::filterHalfBandFIREquiripple);
+}
+
+// The models, tone stack and convolution are all zero-latency; only the sub-block FIFO and the
+// oversampler (when it runs) delay the signal
+int NeuralAmpProcessor::getChainLatencyInSamples(bool liveMonitoring) const {
+  const int fifo = SubBlockScheduler::defaultUseFifo && !liveMonitoring
+                       ? subBlockScheduler.getChunkSize()
+                       : 0;
+  const int resampling =
+      bypassResampling ? 0 : juce::roundToInt(oversampler->getLatencyInSamples());
+  return fifo + resampling;
+}
+
+void NeuralAmpProcessor::updateLatencyMode() {
+  const bool liveMonitoring = isLiveMonitoring();
+  if (liveMonitoring == irConvolver.isMinimumPhase())
+    return;
+  irConvolver.setMinimumPhase(liveMonitoring);
+  const int latency = getChainLatencyInSamples(liveMonitoring);
+  setLatencySamples(latency);
+  juce::Logger::writeToLog(juce::String("[Processor] Live monitoring ") +
+                           (liveMonitoring ? "on" : "off") + ", latency " +
+                           juce::String(latency) + " samples");
+}
+
+void NeuralAmpProcessor::updateIrAlignment() {
+  const float alignMs = *parameters.getRawParameterValue("irAlign");
+  irConvolver.setAlignment(juce::roundToInt(alignMs * 0.001 * getSampleRate()));
+  irConvolver.freeRetiredEngines();
+}
+
 juce::AudioProcessor* JUCE_CALLTYPE createPluginFilter() {
   return new NeuralAmpProcessor();
 }
\ No newline at end of file
@@ -0,0 +1,333 @@
+#include "quantised_lstm.h"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <limits>
+#include "json.hpp"
+#include "quantised_wavenet.h"
+
+#if defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#define NEURALAMP_QUANTISED_NEON 1
+#else
+#define NEURALAMP_QUANTISED_NEON 0
+#endif
+
+std::optional<LstmWeights> LstmWeights::fromNamFile(const std::filesystem::path& path) {
+  std::ifstream stream(path);
+  if (!stream)
+    return std::nullopt;
+
+  const auto json = nlohmann::json::parse(stream, nullptr, false);
+  if (json.is_discarded() || json.value("architecture", "") != "LSTM")
+    return std::nullopt;
+
+  const auto& config = json["config"];
+  const int numLayers = config.value("num_layers", 0);
+  const int inputSize = config.value("input_size", 1);
+  const int hiddenSize = config.value("hidden_size", 0);
+  if (numLayers <= 0 || inputSize <= 0 || hiddenSize <= 0 || !json["weights"].is_array())
+    return std::nullopt;
+
+  const auto flat = json["weights"].get<std::vector<float>>();
+  size_t position = 0;
+  auto take = [&](size_t count, std::vector<float>& destination) {
+    if (position + count > flat.size())
+      return false;
+    destination.assign(flat.begin() + static_cast<std::ptrdiff_t>(position),
+                       flat.begin() + static_cast<std::ptrdiff_t>(position + count));
+    position += count;
+    return true;
+  };
+
+  LstmWeights weights;
+  const auto hidden = static_cast<size_t>(hiddenSize);
+  for (int i = 0; i < numLayers; ++i) {
+    Layer layer;
+    layer.inputSize = i == 0 ? inputSize : hiddenSize;
+    layer.hiddenSize = hiddenSize;
+    const auto columns = static_cast<size_t>(layer.inputSize + hiddenSize);
+    if (!take(4 * hidden * columns, layer.weights) || !take(4 * hidden, layer.bias) ||
+        !take(hidden, layer.initialHidden) || !take(hidden, layer.initialCell))
+      return std::nullopt;
+    weights.layers.push_back(std::move(layer));
+  }
+
+  if (!take(hidden, weights.headWeight) || position + 1 != flat.size())
+    return std::nullopt;
+  weights.headBias = flat[position];
+  return weights;
+}
+
+namespace {
+float sigmoid(float x) {
+  return 1.0f / (1.0f + std::exp(-x));
+}
+
+// Deterministic test signal: a log sweep followed by decaying noise "plucks"
+std::vector<NAM_SAMPLE> makeReferenceSignal(double sampleRate) {
+  const int sweepLength = static_cast<int>(sampleRate);
+  const int plucksLength = static_cast<int>(sampleRate * 0.5);
+  std::vector<NAM_SAMPLE> signal(static_cast<size_t>(sweepLength + plucksLength));
+
+  const double f0 = 40.0;
+  const double f1 = 8000.0;
+  const double k = std::log(f1 / f0);
+  for (int i = 0; i < sweepLength; ++i) {
+    const double t = static_cast<double>(i) / sweepLength;
+    const double phase = 2.0 * 3.14159265358979323846 * f0 * sweepLength / sampleRate *
+                         (std::exp(t * k) - 1.0) / k;
+    signal[static_cast<size_t>(i)] = 0.5 * std::sin(phase);
+  }
+
+  std::uint32_t seed = 0x12345678u;
+  const int pluckPeriod = plucksLength / 4;
+  for (int i = 0; i < plucksLength; ++i) {
+    seed = seed * 1664525u + 1013904223u;
+    const double noise = static_cast<double>(seed) / 4294967296.0 * 2.0 - 1.0;
+    const double envelope = std::exp(-8.0 * (i % pluckPeriod) / pluckPeriod);
+    signal[static_cast<size_t>(sweepLength + i)] = 0.7 * envelope * noise;
+  }
+  return signal;
+}
+}  // namespace
+
+// Armv8.0 (Cortex-A72) has no SDOT, so the NEON paths widen and multiply-accumulate instead
+std::int64_t quantisedDot(const std::int8_t* w, const std::int16_t* x, int n) {
+  int i = 0;
+  std::int32_t sum = 0;
+#if NEURALAMP_QUANTISED_NEON
+  int32x4_t acc = vdupq_n_s32(0);
+  for (; i + 8 <= n; i += 8) {
+    const int16x8_t wv = vmovl_s8(vld1_s8(w + i));
+    const int16x8_t xv = vld1q_s16(x + i);
+    acc = vmlal_s16(acc, vget_low_s16(wv), vget_low_s16(xv));
+    acc = vmlal_high_s16(acc, wv, xv);
+  }
+  sum = vaddvq_s32(acc);
+#endif
+  // int8 x int16 products accumulate safely in 32 bits for any realistic row length
+  for (; i < n; ++i)
+    sum += static_cast<std::int32_t>(w[i]) * x[i];
+  return sum;
+}
+
+std::int64_t quantisedDot(const std::int16_t* w, const std::int16_t* x, int n) {
+  int i = 0;
+  std::int64_t sum = 0;
+#if NEURALAMP_QUANTISED_NEON
+  int64x2_t acc = vdupq_n_s64(0);
+  for (; i + 8 <= n; i += 8) {
+    const int16x8_t wv = vld1q_s16(w + i);
+    const int16x8_t xv = vld1q_s16(x + i);
+    acc = vpadalq_s32(acc, vmull_s16(vget_low_s16(wv), vget_low_s16(xv)));
+    acc = vpadalq_s32(acc, vmull_high_s16(wv, xv));
+  }
+  sum = vaddvq_s64(acc);
+#endif
+  for (; i < n; ++i)
+    sum += static_cast<std::int32_t>(w[i]) * x[i];
+  return sum;
+}
+
+template <typename WeightType>
+void quantiseRows(const std::vector<float>& matrix,
+                  int rows,
+                  int columns,
+                  std::vector<WeightType>& weights,
+                  std::vector<float>& scales) {
+  constexpr float maxWeight = static_cast<float>(std::numeric_limits<WeightType>::max());
+  weights.resize(static_cast<size_t>(rows * columns));
+  scales.resize(static_cast<size_t>(rows));
+  for (int r = 0; r < rows; ++r) {
+    const float* row = matrix.data() + static_cast<size_t>(r * columns);
+    float maxAbs = 0.0f;
+    for (int c = 0; c < columns; ++c)
+      maxAbs = std::max(maxAbs, std::abs(row[c]));
+
+    const float scale = maxAbs > 0.0f ? maxAbs / maxWeight : 1.0f;
+    scales[static_cast<size_t>(r)] = scale;
+    for (int c = 0; c < columns; ++c) {
+      const float q = std::round(row[c] / scale);
+      weights[static_cast<size_t>(r * columns + c)] =
+          static_cast<WeightType>(std::clamp(q, -maxWeight, maxWeight));
+    }
+  }
+}
+
+template void quantiseRows<std::int8_t>(const std::vector<float>&, int, int,
+                                        std::vector<std::int8_t>&, std::vector<float>&);
+template void quantiseRows<std::int16_t>(const std::vector<float>&, int, int,
+                                         std::vector<std::int16_t>&, std::vector<float>&);
+
+float quantiseActivations(const float* x, int n, std::int16_t* quantised) {
+  float maxAbs = 0.0f;
+  for (int i = 0; i < n; ++i)
+    maxAbs = std::max(maxAbs, std::abs(x[i]));
+  const float scale = maxAbs > 0.0f ? maxAbs / 32767.0f : 1.0f;
+  const float inverseScale = 1.0f / scale;
+  for (int i = 0; i < n; ++i)
+    quantised[i] = static_cast<std::int16_t>(std::lrint(x[i] * inverseScale));
+  return scale;
+}
+
+template <typename WeightType>
+QuantisedLstm<WeightType>::QuantisedLstm(const LstmWeights& weights, double expectedSampleRate)
+    : nam::DSP(expectedSampleRate), headWeight(weights.headWeight), headBias(weights.headBias) {
+  for (const auto& source : weights.layers) {
+    Layer layer;
+    layer.inputSize = source.inputSize;
+    layer.hiddenSize = source.hiddenSize;
+    const int rows = 4 * source.hiddenSize;
+    const int columns = source.inputSize + source.hiddenSize;
+
+    quantiseRows(source.weights, rows, columns, layer.weights, layer.rowScales);
+    layer.bias = source.bias;
+    layer.xh.assign(static_cast<size_t>(columns), 0.0f);
+    std::copy(source.initialHidden.begin(), source.initialHidden.end(),
+              layer.xh.begin() + source.inputSize);
+    layer.cell = source.initialCell;
+    layer.xhQuantised.assign(static_cast<size_t>(columns), 0);
+    layer.gates.assign(static_cast<size_t>(rows), 0.0f);
+    layers.push_back(std::move(layer));
+  }
+}
+
+template <typename WeightType>
+void QuantisedLstm<WeightType>::process(NAM_SAMPLE* input, NAM_SAMPLE* output,
+                                        const int num_frames) {
+  for (int i = 0; i < num_frames; ++i)
+    output[i] = static_cast<NAM_SAMPLE>(processSample(static_cast<float>(input[i])));
+}
+
+template <typename WeightType>
+void QuantisedLstm<WeightType>::forEachBuffer(const MemoryArena::BufferVisitor& visit) const {
+  for (const auto& layer : layers) {
+    MemoryArena::visitVector(visit, MemoryArena::modelWeights, layer.weights);
+    MemoryArena::visitVector(visit, MemoryArena::modelWeights, layer.rowScales);
+    MemoryArena::visitVector(visit, MemoryArena::modelWeights, layer.bias);
+    MemoryArena::visitVector(visit, MemoryArena::modelBuffers, layer.xh);
+    MemoryArena::visitVector(visit, MemoryArena::modelBuffers, layer.cell);
+    MemoryArena::visitVector(visit, MemoryArena::modelBuffers, layer.xhQuantised);
+    MemoryArena::visitVector(visit, MemoryArena::modelBuffers, layer.gates);
+  }
+  MemoryArena::visitVector(visit, MemoryArena::modelWeights, headWeight);
+}
+
+template <typename WeightType>
+float QuantisedLstm<WeightType>::processSample(float x) {
+  if (layers.empty())
+    return x;
+
+  processLayer(layers[0], &x);
+  for (size_t i = 1; i < layers.size(); ++i) {
+    const auto& previous = layers[i - 1];
+    processLayer(layers[i], previous.xh.data() + previous.inputSize);
+  }
+
+  const auto& last = layers.back();
+  const float* hidden = last.xh.data() + last.inputSize;
+  float y = headBias;
+  for (int i = 0; i < last.hiddenSize; ++i)
+    y += headWeight[static_cast<size_t>(i)] * hidden[i];
+  return y;
+}
+
+template <typename WeightType>
+void QuantisedLstm<WeightType>::processLayer(Layer& layer, const float* input) {
+  const int hiddenSize = layer.hiddenSize;
+  const int columns = layer.inputSize + hiddenSize;
+  std::copy(input, input + layer.inputSize, layer.xh.begin());
+
+  // One int16 scale for the whole [x, h] vector; h is bounded by 1, x by the input level
+  const float activationScale =
+      quantiseActivations(layer.xh.data(), columns, layer.xhQuantised.data());
+
+  for (int r = 0; r < 4 * hiddenSize; ++r) {
+    const auto row = static_cast<size_t>(r);
+    const auto acc = quantisedDot(layer.weights.data() + row * static_cast<size_t>(columns),
+                                layer.xhQuantised.data(), columns);
+    layer.gates[row] =
+        static_cast<float>(acc) * layer.rowScales[row] * activationScale + layer.bias[row];
+  }
+
+  const float* gates = layer.gates.data();
+  float* hidden = layer.xh.data() + layer.inputSize;
+  for (int i = 0; i < hiddenSize; ++i) {
+    const auto h = static_cast<size_t>(i);
+    const float inputGate = sigmoid(gates[i]);
+    const float forgetGate = sigmoid(gates[i + hiddenSize]);
+    const float cellGate = std::tanh(gates[i + 2 * hiddenSize]);
+    const float outputGate = sigmoid(gates[i + 3 * hiddenSize]);
+    layer.cell[h] = forgetGate * layer.cell[h] + inputGate * cellGate;
+    hidden[i] = outputGate * std::tanh(layer.cell[h]);
+  }
+}
+
+template class QuantisedLstm<std::int8_t>;
+template class QuantisedLstm<std::int16_t>;
+
+double measureEsr(nam::DSP& reference, nam::DSP& candidate) {
+  const double sampleRate =
+      reference.GetExpectedSampleRate() > 0.0 ? reference.GetExpectedSampleRate() : 48000.0;
+  auto signal = makeReferenceSignal(sampleRate);
+  std::vector<NAM_SAMPLE> expected(signal.size());
+  std::vector<NAM_SAMPLE> actual(signal.size());
+
+  // Settle both models on silence first: NAM prewarms its models on Reset, ours start from the
+  // file's initial state (LSTM) or empty history (WaveNet)
+  constexpr int blockSize = 256;
+  std::vector<NAM_SAMPLE> silence(blockSize, 0.0);
+  std::vector<NAM_SAMPLE> discard(blockSize);
+  for (int settled = 0; settled < static_cast<int>(sampleRate * 0.5); settled += blockSize) {
+    reference.process(silence.data(), discard.data(), blockSize);
+    candidate.process(silence.data(), discard.data(), blockSize);
+  }
+
+  for (size_t offset = 0; offset < signal.size(); offset += blockSize) {
+    const int n = static_cast<int>(std::min<size_t>(blockSize, signal.size() - offset));
+    reference.process(signal.data() + offset, expected.data() + offset, n);
+    candidate.process(signal.data() + offset, actual.data() + offset, n);
+  }
+
+  double error = 0.0;
+  double energy = 0.0;
+  for (size_t i = 0; i < signal.size(); ++i) {
+    const double difference = expected[i] - actual[i];
+    error += difference * difference;
+    energy += expected[i] * expected[i];
+  }
+  return energy > 0.0 ? error / energy : (error > 0.0 ? 1.0 : 0.0);
+}
+
+std::unique_ptr<nam::DSP> makeQuantisedModel(const std::filesystem::path& path,
+                                             WeightFormat format,
+                                             nam::DSP& reference,
+                                             double maxEsr,
+                                             double& esr) {
+  esr = std::numeric_limits<double>::quiet_NaN();
+  const auto weights = LstmWeights::fromNamFile(path);
+  if (!weights)
+    return makeQuantisedWaveNet(path, format, reference, maxEsr, esr);
+
+  const double sampleRate = reference.GetExpectedSampleRate();
+  std::unique_ptr<nam::DSP> model;
+  if (format == WeightFormat::int8)
+    model = std::make_unique<QuantisedLstm<std::int8_t>>(*weights, sampleRate);
+  else
+    model = std::make_unique<QuantisedLstm<std::int16_t>>(*weights, sampleRate);
+
+  esr = measureEsr(reference, *model);
+  if (!(esr <= maxEsr))
+    return nullptr;
+
+  // Start the caller off from the file's initial state rather than after the test signal
+  if (format == WeightFormat::int8)
+    model = std::make_unique<QuantisedLstm<std::int8_t>>(*weights, sampleRate);
+  else
+    model = std::make_unique<QuantisedLstm<std::int16_t>>(*weights, sampleRate);
+
+  if (reference.HasLoudness())
+    model->SetLoudness(reference.GetLoudness());
+  return model;
+}
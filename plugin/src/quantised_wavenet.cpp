@@ -0,0 +1,247 @@
+#include "quantised_wavenet.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+float sigmoid(float x) {
+  return 1.0f / (1.0f + std::exp(-x));
+}
+
+// y = matrix (rows x columns, row-major) * x, added to y
+void multiplyAccumulate(const std::vector<float>& matrix,
+                        int rows,
+                        int columns,
+                        const float* x,
+                        float* y) {
+  for (int r = 0; r < rows; ++r) {
+    const float* row = matrix.data() + static_cast<size_t>(r * columns);
+    float sum = 0.0f;
+    for (int c = 0; c < columns; ++c)
+      sum += row[c] * x[c];
+    y[r] += sum;
+  }
+}
+}  // namespace
+
+template <typename WeightType>
+QuantisedWaveNet<WeightType>::QuantisedWaveNet(const WaveNetWeights& weights,
+                                               double expectedSampleRate)
+    : nam::DSP(expectedSampleRate), headScale(weights.headScale) {
+  for (const auto& config : weights.arrays) {
+    LayerArray array;
+    array.config = config;
+    array.config.layers.clear();
+    const int channels = config.channels;
+    const int convRows = config.convRows();
+    const int kernelSize = config.kernelSize;
+
+    for (const auto& source : config.layers) {
+      Layer layer;
+      layer.dilation = source.dilation;
+      layer.historyLength = (kernelSize - 1) * source.dilation + 1;
+      layer.history.assign(static_cast<size_t>(layer.historyLength * channels), 0.0f);
+
+      // One row per conv output across all taps, to match the gathered tap vector
+      std::vector<float> rows(source.conv.size());
+      for (int r = 0; r < convRows; ++r) {
+        for (int k = 0; k < kernelSize; ++k) {
+          for (int c = 0; c < channels; ++c) {
+            rows[static_cast<size_t>((r * kernelSize + k) * channels + c)] =
+                source.conv[static_cast<size_t>((k * convRows + r) * channels + c)];
+          }
+        }
+      }
+      quantiseRows(rows, convRows, kernelSize * channels, layer.conv, layer.convScales);
+      quantiseRows(source.conv1x1, channels, channels, layer.conv1x1, layer.scales1x1);
+      layer.convBias = source.convBias;
+      layer.mixin = source.mixin;
+      layer.bias1x1 = source.bias1x1;
+      array.layers.push_back(std::move(layer));
+    }
+
+    array.taps.assign(static_cast<size_t>(kernelSize * channels), 0.0f);
+    array.tapsQuantised.assign(array.taps.size(), 0);
+    array.z.assign(static_cast<size_t>(convRows), 0.0f);
+    array.zQuantised.assign(static_cast<size_t>(channels), 0);
+    array.head.assign(static_cast<size_t>(channels), 0.0f);
+    array.output.assign(static_cast<size_t>(channels), 0.0f);
+    array.headOutput.assign(static_cast<size_t>(config.headSize), 0.0f);
+    arrays.push_back(std::move(array));
+  }
+}
+
+template <typename WeightType>
+void QuantisedWaveNet<WeightType>::process(NAM_SAMPLE* input, NAM_SAMPLE* output,
+                                           const int num_frames) {
+  for (int i = 0; i < num_frames; ++i)
+    output[i] = static_cast<NAM_SAMPLE>(processSample(static_cast<float>(input[i])));
+}
+
+template <typename WeightType>
+void QuantisedWaveNet<WeightType>::forEachBuffer(const MemoryArena::BufferVisitor& visit) const {
+  for (const auto& array : arrays) {
+    MemoryArena::visitVector(visit, MemoryArena::modelWeights, array.config.rechannel);
+    MemoryArena::visitVector(visit, MemoryArena::modelWeights, array.config.headRechannel);
+    MemoryArena::visitVector(visit, MemoryArena::modelWeights, array.config.headBias);
+    for (const auto& layer : array.layers) {
+      MemoryArena::visitVector(visit, MemoryArena::modelWeights, layer.conv);
+      MemoryArena::visitVector(visit, MemoryArena::modelWeights, layer.convScales);
+      MemoryArena::visitVector(visit, MemoryArena::modelWeights, layer.convBias);
+      MemoryArena::visitVector(visit, MemoryArena::modelWeights, layer.mixin);
+      MemoryArena::visitVector(visit, MemoryArena::modelWeights, layer.conv1x1);
+      MemoryArena::visitVector(visit, MemoryArena::modelWeights, layer.scales1x1);
+      MemoryArena::visitVector(visit, MemoryArena::modelWeights, layer.bias1x1);
+      MemoryArena::visitVector(visit, MemoryArena::modelBuffers, layer.history);
+    }
+    MemoryArena::visitVector(visit, MemoryArena::modelBuffers, array.taps);
+    MemoryArena::visitVector(visit, MemoryArena::modelBuffers, array.tapsQuantised);
+    MemoryArena::visitVector(visit, MemoryArena::modelBuffers, array.z);
+    MemoryArena::visitVector(visit, MemoryArena::modelBuffers, array.zQuantised);
+    MemoryArena::visitVector(visit, MemoryArena::modelBuffers, array.head);
+    MemoryArena::visitVector(visit, MemoryArena::modelBuffers, array.output);
+    MemoryArena::visitVector(visit, MemoryArena::modelBuffers, array.headOutput);
+  }
+}
+
+template <typename WeightType>
+float QuantisedWaveNet<WeightType>::processSample(float x) {
+  const LayerArray* previous = nullptr;
+  for (auto& array : arrays) {
+    processArray(array, previous != nullptr ? previous->output.data() : &x,
+                 previous != nullptr ? previous->headOutput.data() : nullptr, x);
+    previous = &array;
+  }
+  return headScale * arrays.back().headOutput[0];
+}
+
+// Same dataflow as WaveNetEngine::processArray(), one sample at a time
+template <typename WeightType>
+void QuantisedWaveNet<WeightType>::processArray(LayerArray& array,
+                                                const float* input,
+                                                const float* headInput,
+                                                float x) {
+  const auto& config = array.config;
+  std::fill(array.output.begin(), array.output.end(), 0.0f);
+  multiplyAccumulate(config.rechannel, config.channels, config.inputSize, input,
+                     array.output.data());
+
+  // The first array's head starts from zero, later ones from the previous array's head output
+  if (headInput != nullptr)
+    std::copy_n(headInput, config.channels, array.head.begin());
+  else
+    std::fill(array.head.begin(), array.head.end(), 0.0f);
+
+  for (auto& layer : array.layers)
+    processLayer(array, layer, x);
+
+  if (config.headBias.empty())
+    std::fill(array.headOutput.begin(), array.headOutput.end(), 0.0f);
+  else
+    std::copy(config.headBias.begin(), config.headBias.end(), array.headOutput.begin());
+  multiplyAccumulate(config.headRechannel, config.headSize, config.channels, array.head.data(),
+                     array.headOutput.data());
+}
+
+// Reads the layer's input from array.output and leaves its residual output there
+template <typename WeightType>
+void QuantisedWaveNet<WeightType>::processLayer(LayerArray& array, Layer& layer, float x) {
+  const auto& config = array.config;
+  const int channels = config.channels;
+  const int kernelSize = config.kernelSize;
+  float* input = array.output.data();
+  std::copy_n(input, channels, layer.history.begin() + layer.position * channels);
+
+  // Dilated conv: tap k reads dilation * (kernelSize - 1 - k) samples back
+  for (int k = 0; k < kernelSize; ++k) {
+    const int back = layer.dilation * (kernelSize - 1 - k);
+    const int slot = (layer.position - back + layer.historyLength) % layer.historyLength;
+    std::copy_n(layer.history.begin() + slot * channels, channels,
+                array.taps.begin() + k * channels);
+  }
+  const int columns = kernelSize * channels;
+  const float tapScale =
+      quantiseActivations(array.taps.data(), columns, array.tapsQuantised.data());
+  for (int r = 0; r < config.convRows(); ++r) {
+    const auto row = static_cast<size_t>(r);
+    const auto acc = quantisedDot(layer.conv.data() + row * static_cast<size_t>(columns),
+                                  array.tapsQuantised.data(), columns);
+    array.z[row] = static_cast<float>(acc) * layer.convScales[row] * tapScale +
+                   layer.convBias[row] + layer.mixin[row] * x;
+  }
+  applyActivation(config, array.z.data());
+
+  for (int c = 0; c < channels; ++c)
+    array.head[static_cast<size_t>(c)] += array.z[static_cast<size_t>(c)];
+
+  // Residual: input + 1x1(z), in place
+  const float zScale = quantiseActivations(array.z.data(), channels, array.zQuantised.data());
+  for (int c = 0; c < channels; ++c) {
+    const auto row = static_cast<size_t>(c);
+    const auto acc = quantisedDot(layer.conv1x1.data() + row * static_cast<size_t>(channels),
+                                  array.zQuantised.data(), channels);
+    input[c] += static_cast<float>(acc) * layer.scales1x1[row] * zScale + layer.bias1x1[row];
+  }
+
+  layer.position = (layer.position + 1) % layer.historyLength;
+}
+
+template <typename WeightType>
+void QuantisedWaveNet<WeightType>::applyActivation(const WaveNetWeights::LayerArray& config,
+                                                   float* z) {
+  using Activation = WaveNetWeights::Activation;
+  for (int c = 0; c < config.channels; ++c) {
+    switch (config.activation) {
+      case Activation::tanh:
+        z[c] = std::tanh(z[c]);
+        break;
+      case Activation::sigmoid:
+        z[c] = sigmoid(z[c]);
+        break;
+      case Activation::relu:
+        z[c] = std::max(z[c], 0.0f);
+        break;
+      case Activation::hardtanh:
+        z[c] = std::clamp(z[c], -1.0f, 1.0f);
+        break;
+    }
+  }
+
+  // Gated layers multiply the activated top half by the sigmoid of the bottom half
+  if (config.gated) {
+    for (int c = 0; c < config.channels; ++c)
+      z[c] *= sigmoid(z[c + config.channels]);
+  }
+}
+
+template class QuantisedWaveNet<std::int8_t>;
+template class QuantisedWaveNet<std::int16_t>;
+
+std::unique_ptr<nam::DSP> makeQuantisedWaveNet(const std::filesystem::path& path,
+                                               WeightFormat format,
+                                               nam::DSP& reference,
+                                               double maxEsr,
+                                               double& esr) {
+  esr = std::numeric_limits<double>::quiet_NaN();
+  const auto weights = WaveNetWeights::fromNamFile(path);
+  if (!weights)
+    return nullptr;
+
+  const double sampleRate = reference.GetExpectedSampleRate();
+  auto makeModel = [&]() -> std::unique_ptr<nam::DSP> {
+    if (format == WeightFormat::int8)
+      return std::make_unique<QuantisedWaveNet<std::int8_t>>(*weights, sampleRate);
+    return std::make_unique<QuantisedWaveNet<std::int16_t>>(*weights, sampleRate);
+  };
+
+  auto model = makeModel();
+  esr = measureEsr(reference, *model);
+  if (!(esr <= maxEsr))
+    return nullptr;
+
+  // Start the caller off from empty history rather than after the test signal
+  model = makeModel();
+  if (reference.HasLoudness())
+    model->SetLoudness(reference.GetLoudness());
+  return model;
+}
@@ -0,0 +1,292 @@
+#include "realtime_audit.h"
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+
+#if defined(__GLIBC__)
+#include <dlfcn.h>
+#include <errno.h>
+#include <execinfo.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <unistd.h>
+#define NEURALAMP_AUDIT_HOOKS 1
+#else
+#define NEURALAMP_AUDIT_HOOKS 0
+#endif
+
+namespace {
+constexpr int maxCallSites = 64;
+constexpr int maxFrames = 16;
+
+// Initial-exec TLS never allocates on first access, which the allocator hooks rely on
+#if defined(__GNUC__)
+thread_local bool inSection __attribute__((tls_model("initial-exec"))) = false;
+thread_local bool inHook __attribute__((tls_model("initial-exec"))) = false;
+#else
+thread_local bool inSection = false;
+thread_local bool inHook = false;
+#endif
+
+std::atomic<RealtimeAudit::Mode> auditMode{RealtimeAudit::Mode::count};
+std::array<std::atomic<int>, RealtimeAudit::numViolationKinds> violationCounts{};
+
+struct Site {
+  std::atomic<bool> ready{false};
+  RealtimeViolation kind = RealtimeViolation::allocation;
+  int depth = 0;
+  void* frames[maxFrames] = {};
+  std::atomic<int> hits{0};
+};
+std::array<Site, maxCallSites> sites;
+std::atomic<int> numSites{0};
+
+#if NEURALAMP_AUDIT_HOOKS
+// backtrace() loads libgcc on first use, which allocates; get that over with before main()
+const bool backtraceLoaded = [] {
+  void* frame = nullptr;
+  return backtrace(&frame, 1) >= 0;
+}();
+
+void addSite(RealtimeViolation kind, void* const* frames, int depth) {
+  const int known = std::min(numSites.load(), maxCallSites);
+  for (int i = 0; i < known; ++i) {
+    auto& site = sites[static_cast<size_t>(i)];
+    if (site.ready.load(std::memory_order_acquire) && site.kind == kind && site.depth == depth &&
+        std::memcmp(site.frames, frames, static_cast<size_t>(depth) * sizeof(void*)) == 0) {
+      site.hits.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+  }
+
+  const int index = numSites.fetch_add(1);
+  if (index >= maxCallSites)
+    return;  // Counted, but there's no room left to say where
+
+  auto& site = sites[static_cast<size_t>(index)];
+  site.kind = kind;
+  site.depth = depth;
+  std::memcpy(site.frames, frames, static_cast<size_t>(depth) * sizeof(void*));
+  site.hits.store(1, std::memory_order_relaxed);
+  site.ready.store(true, std::memory_order_release);
+}
+
+__attribute__((noinline)) void recordViolation(RealtimeViolation kind) {
+  if (!inSection || inHook)
+    return;
+
+  inHook = true;
+  violationCounts[static_cast<size_t>(kind)].fetch_add(1, std::memory_order_relaxed);
+  void* frames[maxFrames + 1];
+  const int depth = backtrace(frames, maxFrames + 1);
+  // Frame 0 is this function
+  addSite(kind, frames + 1, std::max(0, depth - 1));
+  inHook = false;
+
+  if (auditMode.load(std::memory_order_relaxed) == RealtimeAudit::Mode::trap)
+    raise(SIGTRAP);
+}
+
+template <typename Function>
+Function findNext(std::atomic<Function>& cache, const char* name) {
+  auto function = cache.load(std::memory_order_relaxed);
+  if (function == nullptr) {
+    function = reinterpret_cast<Function>(dlsym(RTLD_NEXT, name));
+    cache.store(function, std::memory_order_relaxed);
+  }
+  return function;
+}
+#endif
+}  // namespace
+
+int RealtimeAudit::Report::getTotal() const {
+  int total = 0;
+  for (int count : counts)
+    total += count;
+  return total;
+}
+
+std::string RealtimeAudit::Report::toString() const {
+  std::ostringstream out;
+  out << "Realtime audit:";
+  for (int kind = 0; kind < numViolationKinds; ++kind)
+    out << " " << getViolationName(static_cast<RealtimeViolation>(kind)) << "=" << counts[kind];
+  out << "\n";
+  for (const auto& site : callSites) {
+    out << getViolationName(site.kind) << " x" << site.hits << "\n";
+    for (const auto& frame : site.frames)
+      out << "    " << frame << "\n";
+  }
+  return out.str();
+}
+
+bool RealtimeAudit::isSupported() {
+  return NEURALAMP_AUDIT_HOOKS != 0;
+}
+
+void RealtimeAudit::setMode(Mode mode) {
+  auditMode.store(mode);
+}
+
+void RealtimeAudit::reset() {
+  for (auto& count : violationCounts)
+    count.store(0);
+  for (auto& site : sites)
+    site.ready.store(false);
+  numSites.store(0);
+}
+
+RealtimeAudit::Report RealtimeAudit::getReport() {
+  Report report;
+  for (size_t kind = 0; kind < violationCounts.size(); ++kind)
+    report.counts[kind] = violationCounts[kind].load();
+
+  const int known = std::min(numSites.load(), maxCallSites);
+  for (int i = 0; i < known; ++i) {
+    const auto& site = sites[static_cast<size_t>(i)];
+    if (!site.ready.load(std::memory_order_acquire))
+      continue;
+
+    CallSite callSite{site.kind, site.hits.load(), {}};
+#if NEURALAMP_AUDIT_HOOKS
+    if (char** symbols = backtrace_symbols(site.frames, site.depth)) {
+      callSite.frames.assign(symbols, symbols + site.depth);
+      free(symbols);
+    }
+#endif
+    report.callSites.push_back(std::move(callSite));
+  }
+  return report;
+}
+
+const char* RealtimeAudit::getViolationName(RealtimeViolation kind) {
+  switch (kind) {
+    case RealtimeViolation::allocation:
+      return "allocation";
+    case RealtimeViolation::deallocation:
+      return "deallocation";
+    case RealtimeViolation::lock:
+      return "lock";
+    case RealtimeViolation::fileIo:
+      return "file I/O";
+  }
+  return "unknown";
+}
+
+RealtimeAudit::ScopedSection::ScopedSection() : wasInSection(inSection) {
+  inSection = true;
+}
+
+RealtimeAudit::ScopedSection::~ScopedSection() {
+  inSection = wasInSection;
+}
+
+#if NEURALAMP_AUDIT_HOOKS
+// glibc exports its allocator under these names too, so the hooks can forward without dlsym(),
+// which itself allocates
+extern "C" {
+void* __libc_malloc(size_t size);
+void __libc_free(void* p);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* p, size_t size);
+void* __libc_memalign(size_t alignment, size_t size);
+
+void* malloc(size_t size) noexcept {
+  recordViolation(RealtimeViolation::allocation);
+  return __libc_malloc(size);
+}
+
+void free(void* p) noexcept {
+  if (p != nullptr)
+    recordViolation(RealtimeViolation::deallocation);
+  __libc_free(p);
+}
+
+void* calloc(size_t count, size_t size) noexcept {
+  recordViolation(RealtimeViolation::allocation);
+  return __libc_calloc(count, size);
+}
+
+void* realloc(void* p, size_t size) noexcept {
+  recordViolation(RealtimeViolation::allocation);
+  return __libc_realloc(p, size);
+}
+
+void* aligned_alloc(size_t alignment, size_t size) noexcept {
+  recordViolation(RealtimeViolation::allocation);
+  return __libc_memalign(alignment, size);
+}
+
+int posix_memalign(void** out, size_t alignment, size_t size) noexcept {
+  if (alignment % sizeof(void*) != 0 || (alignment & (alignment - 1)) != 0)
+    return EINVAL;
+  recordViolation(RealtimeViolation::allocation);
+  void* p = __libc_memalign(alignment, size);
+  if (p == nullptr)
+    return ENOMEM;
+  *out = p;
+  return 0;
+}
+
+int pthread_mutex_lock(pthread_mutex_t* mutex) noexcept {
+  static std::atomic<int (*)(pthread_mutex_t*)> next{nullptr};
+  recordViolation(RealtimeViolation::lock);
+  return findNext(next, "pthread_mutex_lock")(mutex);
+}
+
+int open(const char* path, int flags, ...) {
+  static std::atomic<int (*)(const char*, int, ...)> next{nullptr};
+  mode_t mode = 0;
+  if ((flags & O_CREAT) != 0 || (flags & O_TMPFILE) == O_TMPFILE) {
+    va_list args;
+    va_start(args, flags);
+    mode = static_cast<mode_t>(va_arg(args, int));
+    va_end(args);
+  }
+  recordViolation(RealtimeViolation::fileIo);
+  return findNext(next, "open")(path, flags, mode);
+}
+
+int openat(int directory, const char* path, int flags, ...) {
+  static std::atomic<int (*)(int, const char*, int, ...)> next{nullptr};
+  mode_t mode = 0;
+  if ((flags & O_CREAT) != 0 || (flags & O_TMPFILE) == O_TMPFILE) {
+    va_list args;
+    va_start(args, flags);
+    mode = static_cast<mode_t>(va_arg(args, int));
+    va_end(args);
+  }
+  recordViolation(RealtimeViolation::fileIo);
+  return findNext(next, "openat")(directory, path, flags, mode);
+}
+
+FILE* fopen(const char* path, const char* fileMode) {
+  static std::atomic<FILE* (*)(const char*, const char*)> next{nullptr};
+  recordViolation(RealtimeViolation::fileIo);
+  return findNext(next, "fopen")(path, fileMode);
+}
+
+// libstdc++ streams and large-file builds go through the 64-bit names
+FILE* fopen64(const char* path, const char* fileMode) {
+  static std::atomic<FILE* (*)(const char*, const char*)> next{nullptr};
+  recordViolation(RealtimeViolation::fileIo);
+  return findNext(next, "fopen64")(path, fileMode);
+}
+
+ssize_t read(int fd, void* buffer, size_t size) {
+  static std::atomic<ssize_t (*)(int, void*, size_t)> next{nullptr};
+  recordViolation(RealtimeViolation::fileIo);
+  return findNext(next, "read")(fd, buffer, size);
+}
+
+ssize_t write(int fd, const void* buffer, size_t size) {
+  static std::atomic<ssize_t (*)(int, const void*, size_t)> next{nullptr};
+  recordViolation(RealtimeViolation::fileIo);
+  return findNext(next, "write")(fd, buffer, size);
+}
+}
+#endif
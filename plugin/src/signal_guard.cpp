@@ -0,0 +1,42 @@
+#include "signal_guard.h"
+#include <cstdint>
+#include <cstring>
+
+void SignalGuard::prepare(double sampleRate, double rampSeconds) {
+  gain.setTargetGain(1.0f);
+  gain.prepare(sampleRate, rampSeconds);
+}
+
+bool SignalGuard::clearIfNonFinite(juce::dsp::AudioBlock<float>& block) {
+  bool found = false;
+  for (size_t channel = 0; channel < block.getNumChannels(); ++channel)
+    found = found || containsNonFinite(block.getChannelPointer(channel), block.getNumSamples());
+  if (!found)
+    return false;
+
+  clear(block);
+  return true;
+}
+
+void SignalGuard::clear(juce::dsp::AudioBlock<float>& block) {
+  block.clear();
+  gain.setTargetGain(0.0f);
+  gain.snapToTarget();
+  faults.fetch_add(1, std::memory_order_relaxed);
+}
+
+void SignalGuard::apply(juce::dsp::AudioBlock<float>& block) {
+  if (gain.isSmoothing() || gain.getTargetGain() != 1.0f)
+    gain.apply(block);
+}
+
+bool SignalGuard::containsNonFinite(const float* samples, size_t numSamples) {
+  constexpr std::uint32_t exponentMask = 0x7f800000;
+  std::uint32_t found = 0;
+  for (size_t i = 0; i < numSamples; ++i) {
+    std::uint32_t bits;
+    std::memcpy(&bits, samples + i, sizeof(bits));
+    found |= static_cast<std::uint32_t>((bits & exponentMask) == exponentMask);
+  }
+  return found != 0;
+}
@@ -0,0 +1,435 @@
+#include "simd_engines.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include "json.hpp"
+#include "specialised_engines.h"
+
+LstmEngine::LstmEngine(const LstmWeights& weights,
+                       double expectedSampleRate,
+                       const SimdKernels& simdKernels)
+    : nam::DSP(expectedSampleRate),
+      kernels(simdKernels),
+      headWeight(weights.headWeight),
+      headBias(weights.headBias) {
+  for (const auto& source : weights.layers) {
+    Layer layer;
+    layer.inputSize = source.inputSize;
+    layer.hiddenSize = source.hiddenSize;
+    const auto rows = static_cast<size_t>(4 * source.hiddenSize);
+    const auto columns = static_cast<size_t>(source.inputSize + source.hiddenSize);
+
+    layer.weights.resize(rows * columns);
+    for (size_t r = 0; r < rows; ++r) {
+      for (size_t c = 0; c < columns; ++c)
+        layer.weights[c * rows + r] = source.weights[r * columns + c];
+    }
+    layer.bias = source.bias;
+    layer.xh.assign(columns, 0.0f);
+    std::copy(source.initialHidden.begin(), source.initialHidden.end(),
+              layer.xh.begin() + source.inputSize);
+    layer.cell = source.initialCell;
+    layer.gates.resize(rows);
+    layers.push_back(std::move(layer));
+  }
+}
+
+void LstmEngine::process(NAM_SAMPLE* input, NAM_SAMPLE* output, const int num_frames) {
+  for (int i = 0; i < num_frames; ++i)
+    output[i] = static_cast<NAM_SAMPLE>(processSample(static_cast<float>(input[i])));
+}
+
+void LstmEngine::forEachBuffer(const MemoryArena::BufferVisitor& visit) const {
+  for (const auto& layer : layers) {
+    MemoryArena::visitVector(visit, MemoryArena::modelWeights, layer.weights);
+    MemoryArena::visitVector(visit, MemoryArena::modelWeights, layer.bias);
+    MemoryArena::visitVector(visit, MemoryArena::modelBuffers, layer.xh);
+    MemoryArena::visitVector(visit, MemoryArena::modelBuffers, layer.cell);
+    MemoryArena::visitVector(visit, MemoryArena::modelBuffers, layer.gates);
+  }
+  MemoryArena::visitVector(visit, MemoryArena::modelWeights, headWeight);
+}
+
+float LstmEngine::processSample(float x) {
+  const float* input = &x;
+  for (auto& layer : layers) {
+    std::copy(input, input + layer.inputSize, layer.xh.begin());
+    const int rows = 4 * layer.hiddenSize;
+    kernels.gemv(layer.weights.data(), layer.xh.data(), layer.bias.data(), layer.gates.data(), rows,
+                 layer.inputSize + layer.hiddenSize);
+    float* hidden = layer.xh.data() + layer.inputSize;
+    kernels.lstmPointwise(layer.gates.data(), layer.cell.data(), hidden, layer.hiddenSize);
+    input = hidden;
+  }
+
+  float y = headBias;
+  for (size_t i = 0; i < headWeight.size(); ++i)
+    y += headWeight[i] * input[i];
+  return y;
+}
+
+std::optional<WaveNetWeights> WaveNetWeights::fromNamFile(const std::filesystem::path& path) {
+  std::ifstream stream(path);
+  if (!stream)
+    return std::nullopt;
+
+  const auto json = nlohmann::json::parse(stream, nullptr, false);
+  if (json.is_discarded() || json.value("architecture", "") != "WaveNet")
+    return std::nullopt;
+
+  const auto& config = json["config"];
+  if (!config["layers"].is_array() || config["layers"].empty() || !json["weights"].is_array())
+    return std::nullopt;
+  if (config.contains("head") && !config["head"].is_null())
+    return std::nullopt;
+
+  const auto flat = json["weights"].get<std::vector<float>>();
+  size_t position = 0;
+  auto take = [&](size_t count, std::vector<float>& destination) {
+    if (position + count > flat.size())
+      return false;
+    destination.assign(flat.begin() + static_cast<std::ptrdiff_t>(position),
+                       flat.begin() + static_cast<std::ptrdiff_t>(position + count));
+    position += count;
+    return true;
+  };
+
+  WaveNetWeights weights;
+  for (const auto& arrayConfig : config["layers"]) {
+    LayerArray array;
+    array.inputSize = arrayConfig.value("input_size", 0);
+    array.conditionSize = arrayConfig.value("condition_size", 0);
+    array.headSize = arrayConfig.value("head_size", 0);
+    array.channels = arrayConfig.value("channels", 0);
+    array.kernelSize = arrayConfig.value("kernel_size", 0);
+    array.gated = arrayConfig.value("gated", false);
+
+    const auto activation = arrayConfig.value("activation", "");
+    if (activation == "Tanh")
+      array.activation = Activation::tanh;
+    else if (activation == "Sigmoid")
+      array.activation = Activation::sigmoid;
+    else if (activation == "ReLU")
+      array.activation = Activation::relu;
+    else if (activation == "Hardtanh")
+      array.activation = Activation::hardtanh;
+    else
+      return std::nullopt;
+
+    // The condition is always the mono input signal, and each array must chain onto the last
+    const auto* previous = weights.arrays.empty() ? nullptr : &weights.arrays.back();
+    if (array.conditionSize != 1 || array.channels <= 0 || array.headSize <= 0 ||
+        array.kernelSize <= 0 || !arrayConfig["dilations"].is_array() ||
+        array.inputSize != (previous != nullptr ? previous->channels : 1) ||
+        (previous != nullptr && previous->headSize != array.channels)) {
+      return std::nullopt;
+    }
+
+    const auto channels = static_cast<size_t>(array.channels);
+    const auto convRows = static_cast<size_t>(array.convRows());
+    const auto kernelSize = static_cast<size_t>(array.kernelSize);
+    if (!take(channels * static_cast<size_t>(array.inputSize), array.rechannel))
+      return std::nullopt;
+
+    for (const auto& dilation : arrayConfig["dilations"]) {
+      Layer layer;
+      layer.dilation = dilation.get<int>();
+      if (layer.dilation <= 0)
+        return std::nullopt;
+
+      // NAM serialises conv weights as (out, in, tap); regroup them into one matrix per tap
+      std::vector<float> conv;
+      if (!take(convRows * channels * kernelSize, conv))
+        return std::nullopt;
+      layer.conv.resize(conv.size());
+      for (size_t i = 0; i < convRows; ++i) {
+        for (size_t j = 0; j < channels; ++j) {
+          for (size_t k = 0; k < kernelSize; ++k) {
+            layer.conv[(k * convRows + i) * channels + j] =
+                conv[(i * channels + j) * kernelSize + k];
+          }
+        }
+      }
+
+      if (!take(convRows, layer.convBias) || !take(convRows, layer.mixin) ||
+          !take(channels * channels, layer.conv1x1) || !take(channels, layer.bias1x1))
+        return std::nullopt;
+      array.layers.push_back(std::move(layer));
+    }
+
+    if (array.layers.empty() ||
+        !take(static_cast<size_t>(array.headSize) * channels, array.headRechannel) ||
+        (arrayConfig.value("head_bias", false) &&
+         !take(static_cast<size_t>(array.headSize), array.headBias)))
+      return std::nullopt;
+    weights.arrays.push_back(std::move(array));
+  }
+
+  // The final head must produce the single output channel
+  if (weights.arrays.back().headSize != 1 || position + 1 != flat.size())
+    return std::nullopt;
+  weights.headScale = flat[position];
+  return weights;
+}
+
+WaveNetEngine::WaveNetEngine(const WaveNetWeights& weights,
+                             double expectedSampleRate,
+                             const SimdKernels& simdKernels)
+    : nam::DSP(expectedSampleRate),
+      kernels(simdKernels),
+      headScale(weights.headScale),
+      condition(maxFrames, 0.0f) {
+  for (const auto& config : weights.arrays) {
+    LayerArray array;
+    array.config = config;
+    array.config.layers.clear();
+    for (const auto& source : config.layers) {
+      Layer layer;
+      layer.weights = source;
+      layer.lookBack = (config.kernelSize - 1) * source.dilation;
+      layer.stride = layer.lookBack + historyLength;
+      layer.input.assign(static_cast<size_t>(config.channels * layer.stride), 0.0f);
+      receptiveField += layer.lookBack;
+      array.layers.push_back(std::move(layer));
+    }
+    array.z.assign(static_cast<size_t>(config.convRows() * maxFrames), 0.0f);
+    array.head.assign(static_cast<size_t>(config.channels * maxFrames), 0.0f);
+    array.output.assign(static_cast<size_t>(config.channels * maxFrames), 0.0f);
+    array.headOutput.assign(static_cast<size_t>(config.headSize * maxFrames), 0.0f);
+    arrays.push_back(std::move(array));
+  }
+}
+
+void WaveNetEngine::process(NAM_SAMPLE* input, NAM_SAMPLE* output, const int num_frames) {
+  for (int offset = 0; offset < num_frames; offset += maxFrames)
+    processFrames(input + offset, output + offset, std::min(maxFrames, num_frames - offset));
+}
+
+void WaveNetEngine::forEachBuffer(const MemoryArena::BufferVisitor& visit) const {
+  for (const auto& array : arrays) {
+    MemoryArena::visitVector(visit, MemoryArena::modelWeights, array.config.rechannel);
+    MemoryArena::visitVector(visit, MemoryArena::modelWeights, array.config.headRechannel);
+    MemoryArena::visitVector(visit, MemoryArena::modelWeights, array.config.headBias);
+    for (const auto& layer : array.layers) {
+      MemoryArena::visitVector(visit, MemoryArena::modelWeights, layer.weights.conv);
+      MemoryArena::visitVector(visit, MemoryArena::modelWeights, layer.weights.convBias);
+      MemoryArena::visitVector(visit, MemoryArena::modelWeights, layer.weights.mixin);
+      MemoryArena::visitVector(visit, MemoryArena::modelWeights, layer.weights.conv1x1);
+      MemoryArena::visitVector(visit, MemoryArena::modelWeights, layer.weights.bias1x1);
+      MemoryArena::visitVector(visit, MemoryArena::modelBuffers, layer.input);
+    }
+    MemoryArena::visitVector(visit, MemoryArena::modelBuffers, array.z);
+    MemoryArena::visitVector(visit, MemoryArena::modelBuffers, array.head);
+    MemoryArena::visitVector(visit, MemoryArena::modelBuffers, array.output);
+    MemoryArena::visitVector(visit, MemoryArena::modelBuffers, array.headOutput);
+  }
+  MemoryArena::visitVector(visit, MemoryArena::modelBuffers, condition);
+}
+
+void WaveNetEngine::processFrames(const NAM_SAMPLE* input, NAM_SAMPLE* output, int frames) {
+  for (int i = 0; i < frames; ++i)
+    condition[static_cast<size_t>(i)] = static_cast<float>(input[i]);
+
+  const LayerArray* previous = nullptr;
+  for (auto& array : arrays) {
+    processArray(array, previous != nullptr ? previous->output.data() : condition.data(),
+                 previous != nullptr ? previous->headOutput.data() : nullptr,
+                 previous != nullptr ? previous->config.headSize : 0, frames);
+    previous = &array;
+  }
+
+  const float* head = arrays.back().headOutput.data();
+  for (int i = 0; i < frames; ++i)
+    output[i] = static_cast<NAM_SAMPLE>(headScale * head[i]);
+}
+
+void WaveNetEngine::processArray(LayerArray& array,
+                                 const float* input,
+                                 const float* headInput,
+                                 int headInputRows,
+                                 int frames) {
+  const auto& config = array.config;
+
+  // Move each layer's look-back to the start of its buffer once the history is used up
+  if (array.position + frames > historyLength) {
+    for (auto& layer : array.layers) {
+      for (int c = 0; c < config.channels; ++c) {
+        float* row = layer.input.data() + c * layer.stride;
+        std::memmove(row, row + array.position,
+                     static_cast<size_t>(layer.lookBack) * sizeof(float));
+      }
+    }
+    array.position = 0;
+  }
+
+  // Rechannel the array input into the first layer's history
+  auto& first = array.layers.front();
+  float* firstInput = first.input.data() + first.lookBack + array.position;
+  for (int c = 0; c < config.channels; ++c)
+    std::fill_n(firstInput + c * first.stride, frames, 0.0f);
+  kernels.matmulAccumulate(config.rechannel.data(), config.channels, config.inputSize, input,
+                           maxFrames, firstInput, first.stride, frames);
+
+  // The first array's head starts from zero, later ones from the previous array's head output
+  for (int c = 0; c < config.channels; ++c) {
+    float* row = array.head.data() + c * maxFrames;
+    if (headInput != nullptr && c < headInputRows)
+      std::copy_n(headInput + c * maxFrames, frames, row);
+    else
+      std::fill_n(row, frames, 0.0f);
+  }
+
+  for (size_t l = 0; l < array.layers.size(); ++l) {
+    float* next = array.output.data();
+    int nextStride = maxFrames;
+    if (l + 1 < array.layers.size()) {
+      auto& nextLayer = array.layers[l + 1];
+      next = nextLayer.input.data() + nextLayer.lookBack + array.position;
+      nextStride = nextLayer.stride;
+    }
+    processLayer(array, array.layers[l], next, nextStride, frames);
+  }
+
+  for (int r = 0; r < config.headSize; ++r) {
+    const float bias = config.headBias.empty() ? 0.0f : config.headBias[static_cast<size_t>(r)];
+    std::fill_n(array.headOutput.data() + r * maxFrames, frames, bias);
+  }
+  kernels.matmulAccumulate(config.headRechannel.data(), config.headSize, config.channels,
+                           array.head.data(), maxFrames, array.headOutput.data(), maxFrames,
+                           frames);
+
+  array.position += frames;
+}
+
+void WaveNetEngine::processLayer(LayerArray& array,
+                                 Layer& layer,
+                                 float* next,
+                                 int nextStride,
+                                 int frames) {
+  const auto& config = array.config;
+  const auto& weights = layer.weights;
+  const int channels = config.channels;
+  const int convRows = config.convRows();
+  const float* input = layer.input.data() + layer.lookBack + array.position;
+  float* z = array.z.data();
+
+  // Dilated conv: tap k reads dilation * (kernelSize - 1 - k) frames back
+  for (int r = 0; r < convRows; ++r)
+    std::fill_n(z + r * maxFrames, frames, weights.convBias[static_cast<size_t>(r)]);
+  const auto tapSize = static_cast<size_t>(convRows * channels);
+  for (int k = 0; k < config.kernelSize; ++k) {
+    const int offset = weights.dilation * (config.kernelSize - 1 - k);
+    kernels.matmulAccumulate(weights.conv.data() + static_cast<size_t>(k) * tapSize, convRows,
+                             channels, input - offset, layer.stride, z, maxFrames, frames);
+  }
+  kernels.matmulAccumulate(weights.mixin.data(), convRows, 1, condition.data(), maxFrames, z,
+                           maxFrames, frames);
+
+  applyActivation(config, z, frames);
+
+  float* head = array.head.data();
+  for (int c = 0; c < channels; ++c) {
+    const float* zRow = z + c * maxFrames;
+    float* headRow = head + c * maxFrames;
+    for (int f = 0; f < frames; ++f)
+      headRow[f] += zRow[f];
+  }
+
+  // Residual: next = input + 1x1(z)
+  for (int c = 0; c < channels; ++c) {
+    const float* inputRow = input + c * layer.stride;
+    float* nextRow = next + c * nextStride;
+    const float bias = weights.bias1x1[static_cast<size_t>(c)];
+    for (int f = 0; f < frames; ++f)
+      nextRow[f] = inputRow[f] + bias;
+  }
+  kernels.matmulAccumulate(weights.conv1x1.data(), channels, channels, z, maxFrames, next,
+                           nextStride, frames);
+}
+
+void WaveNetEngine::applyActivation(const WaveNetWeights::LayerArray& config,
+                                    float* z,
+                                    int frames) const {
+  using Activation = WaveNetWeights::Activation;
+  for (int c = 0; c < config.channels; ++c) {
+    float* row = z + c * maxFrames;
+    switch (config.activation) {
+      case Activation::tanh:
+        kernels.tanh(row, frames);
+        break;
+      case Activation::sigmoid:
+        kernels.sigmoid(row, frames);
+        break;
+      case Activation::relu:
+        for (int f = 0; f < frames; ++f)
+          row[f] = std::max(row[f], 0.0f);
+        break;
+      case Activation::hardtanh:
+        for (int f = 0; f < frames; ++f)
+          row[f] = std::clamp(row[f], -1.0f, 1.0f);
+        break;
+    }
+  }
+
+  if (!config.gated)
+    return;
+
+  // Gated layers multiply the activated top half by the sigmoid of the bottom half
+  for (int c = 0; c < config.channels; ++c) {
+    float* row = z + c * maxFrames;
+    float* gate = z + (c + config.channels) * maxFrames;
+    kernels.sigmoid(gate, frames);
+    for (int f = 0; f < frames; ++f)
+      row[f] *= gate[f];
+  }
+}
+
+namespace {
+template <typename MakeModel>
+std::unique_ptr<nam::DSP> makeCheckedModel(MakeModel makeModel,
+                                           nam::DSP& reference,
+                                           double maxEsr,
+                                           double& esr) {
+  auto model = makeModel();
+  esr = measureEsr(reference, *model);
+  if (!(esr <= maxEsr))
+    return nullptr;
+
+  // Start the caller off from a fresh state rather than after the test signal
+  model = makeModel();
+  if (reference.HasLoudness())
+    model->SetLoudness(reference.GetLoudness());
+  return model;
+}
+}  // namespace
+
+std::unique_ptr<nam::DSP> makeSimdModel(const std::filesystem::path& path,
+                                        nam::DSP& reference,
+                                        double maxEsr,
+                                        double& esr) {
+  esr = std::numeric_limits<double>::quiet_NaN();
+  const double sampleRate = reference.GetExpectedSampleRate();
+
+  // The standard trainer architectures get an engine sized at compile time, with the generic
+  // engine as the fallback for everything else
+  if (const auto lstm = LstmWeights::fromNamFile(path)) {
+    if (findSpecialisedArchitecture(*lstm) != SpecialisedArchitecture::none) {
+      if (auto model = makeCheckedModel([&] { return makeSpecialisedModel(*lstm, sampleRate); },
+                                        reference, maxEsr, esr))
+        return model;
+    }
+    return makeCheckedModel([&] { return std::make_unique<LstmEngine>(*lstm, sampleRate); },
+                            reference, maxEsr, esr);
+  }
+  if (const auto wavenet = WaveNetWeights::fromNamFile(path)) {
+    if (findSpecialisedArchitecture(*wavenet) != SpecialisedArchitecture::none) {
+      if (auto model = makeCheckedModel([&] { return makeSpecialisedModel(*wavenet, sampleRate); },
+                                        reference, maxEsr, esr))
+        return model;
+    }
+    return makeCheckedModel([&] { return std::make_unique<WaveNetEngine>(*wavenet, sampleRate); },
+                            reference, maxEsr, esr);
+  }
+  return nullptr;
+}
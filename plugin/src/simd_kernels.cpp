@@ -0,0 +1,131 @@
+#include "simd_kernels.h"
+#include <cmath>
+#include <cstddef>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <immintrin.h>
+#include <intrin.h>
+#endif
+
+#if NEURALAMP_HAVE_X86_KERNELS
+const SimdKernels& getAvx2Kernels();
+const SimdKernels& getAvx512Kernels();
+#endif
+#if NEURALAMP_HAVE_NEON_KERNELS
+const SimdKernels& getNeonKernels();
+#endif
+
+namespace {
+float sigmoid(float x) {
+  return 1.0f / (1.0f + std::exp(-x));
+}
+
+// Reference implementations. These follow NAM's Eigen path (std::exp/std::tanh activations) and
+// are what the vector variants are tested against.
+void gemvScalar(const float* w, const float* x, const float* bias, float* y, int rows, int cols) {
+  for (int r = 0; r < rows; ++r)
+    y[r] = bias != nullptr ? bias[r] : 0.0f;
+  for (int c = 0; c < cols; ++c) {
+    const float xc = x[c];
+    const float* column = w + static_cast<size_t>(c) * static_cast<size_t>(rows);
+    for (int r = 0; r < rows; ++r)
+      y[r] += column[r] * xc;
+  }
+}
+
+void matmulAccumulateScalar(const float* w,
+                            int rows,
+                            int cols,
+                            const float* in,
+                            int inStride,
+                            float* out,
+                            int outStride,
+                            int frames) {
+  for (int r = 0; r < rows; ++r) {
+    float* o = out + static_cast<ptrdiff_t>(r) * outStride;
+    for (int c = 0; c < cols; ++c) {
+      const float wrc = w[r * cols + c];
+      const float* i = in + static_cast<ptrdiff_t>(c) * inStride;
+      for (int f = 0; f < frames; ++f)
+        o[f] += wrc * i[f];
+    }
+  }
+}
+
+void lstmPointwiseScalar(const float* gates, float* cell, float* hidden, int hiddenSize) {
+  for (int i = 0; i < hiddenSize; ++i) {
+    cell[i] = sigmoid(gates[i + hiddenSize]) * cell[i] +
+              sigmoid(gates[i]) * std::tanh(gates[i + 2 * hiddenSize]);
+    hidden[i] = sigmoid(gates[i + 3 * hiddenSize]) * std::tanh(cell[i]);
+  }
+}
+
+void tanhScalar(float* x, int n) {
+  for (int i = 0; i < n; ++i)
+    x[i] = std::tanh(x[i]);
+}
+
+void sigmoidScalar(float* x, int n) {
+  for (int i = 0; i < n; ++i)
+    x[i] = sigmoid(x[i]);
+}
+
+#if NEURALAMP_HAVE_X86_KERNELS
+#if defined(_MSC_VER) && !defined(__clang__)
+bool cpuSupports(int leaf, int subleaf, int reg, int bit) {
+  int info[4];
+  __cpuidex(info, leaf, subleaf);
+  return (info[reg] & (1 << bit)) != 0;
+}
+
+// The OS must also save the wider register state on context switches
+bool osSavesRegisters(unsigned long long mask) {
+  return cpuSupports(1, 0, 2, 27) && (_xgetbv(0) & mask) == mask;
+}
+
+bool hasAvx2Fma() {
+  return osSavesRegisters(0x6) && cpuSupports(7, 0, 1, 5) && cpuSupports(1, 0, 2, 12);
+}
+
+bool hasAvx512() {
+  return osSavesRegisters(0xe6) && cpuSupports(7, 0, 1, 16) && hasAvx2Fma();
+}
+#else
+// libgcc/compiler-rt also check that the OS saves the wider register state
+bool hasAvx2Fma() {
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+}
+
+bool hasAvx512() {
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("avx512f") && hasAvx2Fma();
+}
+#endif
+#endif
+}  // namespace
+
+const SimdKernels& getScalarKernels() {
+  static const SimdKernels kernels{"scalar",          gemvScalar, matmulAccumulateScalar,
+                                   lstmPointwiseScalar, tanhScalar, sigmoidScalar};
+  return kernels;
+}
+
+std::vector<const SimdKernels*> getSupportedKernels() {
+  std::vector<const SimdKernels*> supported{&getScalarKernels()};
+#if NEURALAMP_HAVE_X86_KERNELS
+  if (hasAvx2Fma())
+    supported.push_back(&getAvx2Kernels());
+  if (hasAvx512())
+    supported.push_back(&getAvx512Kernels());
+#endif
+#if NEURALAMP_HAVE_NEON_KERNELS
+  supported.push_back(&getNeonKernels());  // Always present on aarch64
+#endif
+  return supported;
+}
+
+const SimdKernels& getSimdKernels() {
+  static const SimdKernels& kernels = *getSupportedKernels().back();
+  return kernels;
+}
@@ -0,0 +1,160 @@
+// Built with -mavx2 -mfma (or /arch:AVX2); only reached after getSupportedKernels() checked the
+// CPU. Inline library templates compiled here could be merged with baseline copies by the linker,
+// so the scalar tails call the C math functions rather than the std:: overloads.
+#include "simd_kernels.h"
+#include <immintrin.h>
+#include <math.h>
+#include <cstddef>
+
+namespace {
+// Cephes-style expf: range reduction to [-ln2/2, ln2/2] and a degree 6 polynomial, within a couple
+// of ulp of std::exp across the clamped range
+__m256 exp256(__m256 x) {
+  x = _mm256_min_ps(_mm256_max_ps(x, _mm256_set1_ps(-87.3f)), _mm256_set1_ps(88.3f));
+  const __m256 n = _mm256_round_ps(_mm256_mul_ps(x, _mm256_set1_ps(1.44269504088896341f)),
+                                   _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+  x = _mm256_fnmadd_ps(n, _mm256_set1_ps(0.693359375f), x);
+  x = _mm256_fnmadd_ps(n, _mm256_set1_ps(-2.12194440e-4f), x);
+
+  __m256 y = _mm256_set1_ps(1.9875691500e-4f);
+  y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(1.3981999507e-3f));
+  y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(8.3334519073e-3f));
+  y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(4.1665795894e-2f));
+  y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(1.6666665459e-1f));
+  y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(5.0000001201e-1f));
+  y = _mm256_fmadd_ps(y, _mm256_mul_ps(x, x), _mm256_add_ps(x, _mm256_set1_ps(1.0f)));
+
+  const __m256i exponent =
+      _mm256_slli_epi32(_mm256_add_epi32(_mm256_cvtps_epi32(n), _mm256_set1_epi32(127)), 23);
+  return _mm256_mul_ps(y, _mm256_castsi256_ps(exponent));
+}
+
+__m256 sigmoid256(__m256 x) {
+  const __m256 one = _mm256_set1_ps(1.0f);
+  return _mm256_div_ps(one, _mm256_add_ps(one, exp256(_mm256_sub_ps(_mm256_setzero_ps(), x))));
+}
+
+// tanh(x) = 2 * sigmoid(2x) - 1
+__m256 tanh256(__m256 x) {
+  const __m256 one = _mm256_set1_ps(1.0f);
+  const __m256 two = _mm256_set1_ps(2.0f);
+  return _mm256_fmsub_ps(two, sigmoid256(_mm256_mul_ps(x, two)), one);
+}
+
+float sigmoid(float x) {
+  return 1.0f / (1.0f + expf(-x));
+}
+
+void gemv(const float* w, const float* x, const float* bias, float* y, int rows, int cols) {
+  int r = 0;
+  // Two accumulators per pass keep both FMA ports busy
+  for (; r + 16 <= rows; r += 16) {
+    __m256 acc0 = bias != nullptr ? _mm256_loadu_ps(bias + r) : _mm256_setzero_ps();
+    __m256 acc1 = bias != nullptr ? _mm256_loadu_ps(bias + r + 8) : _mm256_setzero_ps();
+    for (int c = 0; c < cols; ++c) {
+      const float* column = w + static_cast<size_t>(c) * static_cast<size_t>(rows) + r;
+      const __m256 xc = _mm256_set1_ps(x[c]);
+      acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(column), xc, acc0);
+      acc1 = _mm256_fmadd_ps(_mm256_loadu_ps(column + 8), xc, acc1);
+    }
+    _mm256_storeu_ps(y + r, acc0);
+    _mm256_storeu_ps(y + r + 8, acc1);
+  }
+  for (; r + 8 <= rows; r += 8) {
+    __m256 acc = bias != nullptr ? _mm256_loadu_ps(bias + r) : _mm256_setzero_ps();
+    for (int c = 0; c < cols; ++c) {
+      const float* column = w + static_cast<size_t>(c) * static_cast<size_t>(rows) + r;
+      acc = _mm256_fmadd_ps(_mm256_loadu_ps(column), _mm256_set1_ps(x[c]), acc);
+    }
+    _mm256_storeu_ps(y + r, acc);
+  }
+  for (; r < rows; ++r) {
+    float acc = bias != nullptr ? bias[r] : 0.0f;
+    for (int c = 0; c < cols; ++c)
+      acc += w[static_cast<size_t>(c) * static_cast<size_t>(rows) + static_cast<size_t>(r)] * x[c];
+    y[r] = acc;
+  }
+}
+
+void matmulAccumulate(const float* w,
+                      int rows,
+                      int cols,
+                      const float* in,
+                      int inStride,
+                      float* out,
+                      int outStride,
+                      int frames) {
+  for (int r = 0; r < rows; ++r) {
+    const float* wr = w + r * cols;
+    float* o = out + static_cast<ptrdiff_t>(r) * outStride;
+    int f = 0;
+    for (; f + 16 <= frames; f += 16) {
+      __m256 acc0 = _mm256_loadu_ps(o + f);
+      __m256 acc1 = _mm256_loadu_ps(o + f + 8);
+      for (int c = 0; c < cols; ++c) {
+        const float* i = in + static_cast<ptrdiff_t>(c) * inStride + f;
+        const __m256 wrc = _mm256_broadcast_ss(wr + c);
+        acc0 = _mm256_fmadd_ps(wrc, _mm256_loadu_ps(i), acc0);
+        acc1 = _mm256_fmadd_ps(wrc, _mm256_loadu_ps(i + 8), acc1);
+      }
+      _mm256_storeu_ps(o + f, acc0);
+      _mm256_storeu_ps(o + f + 8, acc1);
+    }
+    for (; f + 8 <= frames; f += 8) {
+      __m256 acc = _mm256_loadu_ps(o + f);
+      for (int c = 0; c < cols; ++c) {
+        const float* i = in + static_cast<ptrdiff_t>(c) * inStride + f;
+        acc = _mm256_fmadd_ps(_mm256_broadcast_ss(wr + c), _mm256_loadu_ps(i), acc);
+      }
+      _mm256_storeu_ps(o + f, acc);
+    }
+    for (; f < frames; ++f) {
+      float acc = o[f];
+      for (int c = 0; c < cols; ++c)
+        acc += wr[c] * in[static_cast<ptrdiff_t>(c) * inStride + f];
+      o[f] = acc;
+    }
+  }
+}
+
+void lstmPointwise(const float* gates, float* cell, float* hidden, int hiddenSize) {
+  int i = 0;
+  for (; i + 8 <= hiddenSize; i += 8) {
+    const __m256 inputGate = sigmoid256(_mm256_loadu_ps(gates + i));
+    const __m256 forgetGate = sigmoid256(_mm256_loadu_ps(gates + i + hiddenSize));
+    const __m256 candidate = tanh256(_mm256_loadu_ps(gates + i + 2 * hiddenSize));
+    const __m256 outputGate = sigmoid256(_mm256_loadu_ps(gates + i + 3 * hiddenSize));
+    const __m256 c = _mm256_fmadd_ps(forgetGate, _mm256_loadu_ps(cell + i),
+                                     _mm256_mul_ps(inputGate, candidate));
+    _mm256_storeu_ps(cell + i, c);
+    _mm256_storeu_ps(hidden + i, _mm256_mul_ps(outputGate, tanh256(c)));
+  }
+  for (; i < hiddenSize; ++i) {
+    cell[i] = sigmoid(gates[i + hiddenSize]) * cell[i] +
+              sigmoid(gates[i]) * tanhf(gates[i + 2 * hiddenSize]);
+    hidden[i] = sigmoid(gates[i + 3 * hiddenSize]) * tanhf(cell[i]);
+  }
+}
+
+void tanhInPlace(float* x, int n) {
+  int i = 0;
+  for (; i + 8 <= n; i += 8)
+    _mm256_storeu_ps(x + i, tanh256(_mm256_loadu_ps(x + i)));
+  for (; i < n; ++i)
+    x[i] = tanhf(x[i]);
+}
+
+void sigmoidInPlace(float* x, int n) {
+  int i = 0;
+  for (; i + 8 <= n; i += 8)
+    _mm256_storeu_ps(x + i, sigmoid256(_mm256_loadu_ps(x + i)));
+  for (; i < n; ++i)
+    x[i] = sigmoid(x[i]);
+}
+}  // namespace
+
+const SimdKernels& getAvx2Kernels() {
+  static const SimdKernels kernels{"avx2",        gemv,        matmulAccumulate,
+                                   lstmPointwise, tanhInPlace, sigmoidInPlace};
+  return kernels;
+}
@@ -0,0 +1,123 @@
+// Built with -mavx512f -mfma (or /arch:AVX512); only reached after getSupportedKernels() checked
+// the CPU
+#include "simd_kernels.h"
+#include <immintrin.h>
+#include <cstddef>
+
+namespace {
+__mmask16 tailMask(int remaining) {
+  return static_cast<__mmask16>(remaining >= 16 ? 0xffff : (1u << remaining) - 1u);
+}
+
+// Same expf approximation as the AVX2 variant; scalef applies the 2^n without integer tricks
+__m512 exp512(__m512 x) {
+  x = _mm512_min_ps(_mm512_max_ps(x, _mm512_set1_ps(-87.3f)), _mm512_set1_ps(88.3f));
+  const __m512 n = _mm512_roundscale_ps(_mm512_mul_ps(x, _mm512_set1_ps(1.44269504088896341f)),
+                                        _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+  x = _mm512_fnmadd_ps(n, _mm512_set1_ps(0.693359375f), x);
+  x = _mm512_fnmadd_ps(n, _mm512_set1_ps(-2.12194440e-4f), x);
+
+  __m512 y = _mm512_set1_ps(1.9875691500e-4f);
+  y = _mm512_fmadd_ps(y, x, _mm512_set1_ps(1.3981999507e-3f));
+  y = _mm512_fmadd_ps(y, x, _mm512_set1_ps(8.3334519073e-3f));
+  y = _mm512_fmadd_ps(y, x, _mm512_set1_ps(4.1665795894e-2f));
+  y = _mm512_fmadd_ps(y, x, _mm512_set1_ps(1.6666665459e-1f));
+  y = _mm512_fmadd_ps(y, x, _mm512_set1_ps(5.0000001201e-1f));
+  y = _mm512_fmadd_ps(y, _mm512_mul_ps(x, x), _mm512_add_ps(x, _mm512_set1_ps(1.0f)));
+  return _mm512_scalef_ps(y, n);
+}
+
+__m512 sigmoid512(__m512 x) {
+  const __m512 one = _mm512_set1_ps(1.0f);
+  return _mm512_div_ps(one, _mm512_add_ps(one, exp512(_mm512_sub_ps(_mm512_setzero_ps(), x))));
+}
+
+__m512 tanh512(__m512 x) {
+  const __m512 one = _mm512_set1_ps(1.0f);
+  const __m512 two = _mm512_set1_ps(2.0f);
+  return _mm512_fmsub_ps(two, sigmoid512(_mm512_mul_ps(x, two)), one);
+}
+
+// Masked loads/stores handle the tails, so every element goes through the same arithmetic
+void gemv(const float* w, const float* x, const float* bias, float* y, int rows, int cols) {
+  for (int r = 0; r < rows; r += 16) {
+    const __mmask16 mask = tailMask(rows - r);
+    __m512 acc = bias != nullptr ? _mm512_maskz_loadu_ps(mask, bias + r) : _mm512_setzero_ps();
+    for (int c = 0; c < cols; ++c) {
+      const float* column = w + static_cast<size_t>(c) * static_cast<size_t>(rows) + r;
+      acc = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(mask, column), _mm512_set1_ps(x[c]), acc);
+    }
+    _mm512_mask_storeu_ps(y + r, mask, acc);
+  }
+}
+
+void matmulAccumulate(const float* w,
+                      int rows,
+                      int cols,
+                      const float* in,
+                      int inStride,
+                      float* out,
+                      int outStride,
+                      int frames) {
+  for (int r = 0; r < rows; ++r) {
+    const float* wr = w + r * cols;
+    float* o = out + static_cast<ptrdiff_t>(r) * outStride;
+    int f = 0;
+    for (; f + 32 <= frames; f += 32) {
+      __m512 acc0 = _mm512_loadu_ps(o + f);
+      __m512 acc1 = _mm512_loadu_ps(o + f + 16);
+      for (int c = 0; c < cols; ++c) {
+        const float* i = in + static_cast<ptrdiff_t>(c) * inStride + f;
+        const __m512 wrc = _mm512_set1_ps(wr[c]);
+        acc0 = _mm512_fmadd_ps(wrc, _mm512_loadu_ps(i), acc0);
+        acc1 = _mm512_fmadd_ps(wrc, _mm512_loadu_ps(i + 16), acc1);
+      }
+      _mm512_storeu_ps(o + f, acc0);
+      _mm512_storeu_ps(o + f + 16, acc1);
+    }
+    for (; f < frames; f += 16) {
+      const __mmask16 mask = tailMask(frames - f);
+      __m512 acc = _mm512_maskz_loadu_ps(mask, o + f);
+      for (int c = 0; c < cols; ++c) {
+        const float* i = in + static_cast<ptrdiff_t>(c) * inStride + f;
+        acc = _mm512_fmadd_ps(_mm512_set1_ps(wr[c]), _mm512_maskz_loadu_ps(mask, i), acc);
+      }
+      _mm512_mask_storeu_ps(o + f, mask, acc);
+    }
+  }
+}
+
+void lstmPointwise(const float* gates, float* cell, float* hidden, int hiddenSize) {
+  for (int i = 0; i < hiddenSize; i += 16) {
+    const __mmask16 mask = tailMask(hiddenSize - i);
+    const __m512 inputGate = sigmoid512(_mm512_maskz_loadu_ps(mask, gates + i));
+    const __m512 forgetGate = sigmoid512(_mm512_maskz_loadu_ps(mask, gates + i + hiddenSize));
+    const __m512 candidate = tanh512(_mm512_maskz_loadu_ps(mask, gates + i + 2 * hiddenSize));
+    const __m512 outputGate = sigmoid512(_mm512_maskz_loadu_ps(mask, gates + i + 3 * hiddenSize));
+    const __m512 c = _mm512_fmadd_ps(forgetGate, _mm512_maskz_loadu_ps(mask, cell + i),
+                                     _mm512_mul_ps(inputGate, candidate));
+    _mm512_mask_storeu_ps(cell + i, mask, c);
+    _mm512_mask_storeu_ps(hidden + i, mask, _mm512_mul_ps(outputGate, tanh512(c)));
+  }
+}
+
+void tanhInPlace(float* x, int n) {
+  for (int i = 0; i < n; i += 16) {
+    const __mmask16 mask = tailMask(n - i);
+    _mm512_mask_storeu_ps(x + i, mask, tanh512(_mm512_maskz_loadu_ps(mask, x + i)));
+  }
+}
+
+void sigmoidInPlace(float* x, int n) {
+  for (int i = 0; i < n; i += 16) {
+    const __mmask16 mask = tailMask(n - i);
+    _mm512_mask_storeu_ps(x + i, mask, sigmoid512(_mm512_maskz_loadu_ps(mask, x + i)));
+  }
+}
+}  // namespace
+
+const SimdKernels& getAvx512Kernels() {
+  static const SimdKernels kernels{"avx512",      gemv,        matmulAccumulate,
+                                   lstmPointwise, tanhInPlace, sigmoidInPlace};
+  return kernels;
+}
@@ -0,0 +1,133 @@
+// AArch64 only: Advanced SIMD is mandatory there, so this variant needs no runtime check
+#include "simd_kernels.h"
+#include <arm_neon.h>
+#include <cmath>
+#include <cstddef>
+
+namespace {
+// Same expf approximation as the x86 variants
+float32x4_t exp128(float32x4_t x) {
+  x = vminq_f32(vmaxq_f32(x, vdupq_n_f32(-87.3f)), vdupq_n_f32(88.3f));
+  const float32x4_t n = vrndnq_f32(vmulq_n_f32(x, 1.44269504088896341f));
+  x = vfmsq_f32(x, n, vdupq_n_f32(0.693359375f));
+  x = vfmsq_f32(x, n, vdupq_n_f32(-2.12194440e-4f));
+
+  float32x4_t y = vdupq_n_f32(1.9875691500e-4f);
+  y = vfmaq_f32(vdupq_n_f32(1.3981999507e-3f), y, x);
+  y = vfmaq_f32(vdupq_n_f32(8.3334519073e-3f), y, x);
+  y = vfmaq_f32(vdupq_n_f32(4.1665795894e-2f), y, x);
+  y = vfmaq_f32(vdupq_n_f32(1.6666665459e-1f), y, x);
+  y = vfmaq_f32(vdupq_n_f32(5.0000001201e-1f), y, x);
+  y = vfmaq_f32(vaddq_f32(x, vdupq_n_f32(1.0f)), y, vmulq_f32(x, x));
+
+  const int32x4_t exponent = vshlq_n_s32(vaddq_s32(vcvtq_s32_f32(n), vdupq_n_s32(127)), 23);
+  return vmulq_f32(y, vreinterpretq_f32_s32(exponent));
+}
+
+float32x4_t sigmoid128(float32x4_t x) {
+  const float32x4_t one = vdupq_n_f32(1.0f);
+  return vdivq_f32(one, vaddq_f32(one, exp128(vnegq_f32(x))));
+}
+
+float32x4_t tanh128(float32x4_t x) {
+  return vsubq_f32(vmulq_n_f32(sigmoid128(vmulq_n_f32(x, 2.0f)), 2.0f), vdupq_n_f32(1.0f));
+}
+
+float sigmoid(float x) {
+  return 1.0f / (1.0f + std::exp(-x));
+}
+
+void gemv(const float* w, const float* x, const float* bias, float* y, int rows, int cols) {
+  int r = 0;
+  for (; r + 8 <= rows; r += 8) {
+    float32x4_t acc0 = bias != nullptr ? vld1q_f32(bias + r) : vdupq_n_f32(0.0f);
+    float32x4_t acc1 = bias != nullptr ? vld1q_f32(bias + r + 4) : vdupq_n_f32(0.0f);
+    for (int c = 0; c < cols; ++c) {
+      const float* column = w + static_cast<size_t>(c) * static_cast<size_t>(rows) + r;
+      acc0 = vfmaq_n_f32(acc0, vld1q_f32(column), x[c]);
+      acc1 = vfmaq_n_f32(acc1, vld1q_f32(column + 4), x[c]);
+    }
+    vst1q_f32(y + r, acc0);
+    vst1q_f32(y + r + 4, acc1);
+  }
+  for (; r < rows; ++r) {
+    float acc = bias != nullptr ? bias[r] : 0.0f;
+    for (int c = 0; c < cols; ++c)
+      acc += w[static_cast<size_t>(c) * static_cast<size_t>(rows) + static_cast<size_t>(r)] * x[c];
+    y[r] = acc;
+  }
+}
+
+void matmulAccumulate(const float* w,
+                      int rows,
+                      int cols,
+                      const float* in,
+                      int inStride,
+                      float* out,
+                      int outStride,
+                      int frames) {
+  for (int r = 0; r < rows; ++r) {
+    const float* wr = w + r * cols;
+    float* o = out + static_cast<ptrdiff_t>(r) * outStride;
+    int f = 0;
+    for (; f + 8 <= frames; f += 8) {
+      float32x4_t acc0 = vld1q_f32(o + f);
+      float32x4_t acc1 = vld1q_f32(o + f + 4);
+      for (int c = 0; c < cols; ++c) {
+        const float* i = in + static_cast<ptrdiff_t>(c) * inStride + f;
+        acc0 = vfmaq_n_f32(acc0, vld1q_f32(i), wr[c]);
+        acc1 = vfmaq_n_f32(acc1, vld1q_f32(i + 4), wr[c]);
+      }
+      vst1q_f32(o + f, acc0);
+      vst1q_f32(o + f + 4, acc1);
+    }
+    for (; f < frames; ++f) {
+      float acc = o[f];
+      for (int c = 0; c < cols; ++c)
+        acc += wr[c] * in[static_cast<ptrdiff_t>(c) * inStride + f];
+      o[f] = acc;
+    }
+  }
+}
+
+void lstmPointwise(const float* gates, float* cell, float* hidden, int hiddenSize) {
+  int i = 0;
+  for (; i + 4 <= hiddenSize; i += 4) {
+    const float32x4_t inputGate = sigmoid128(vld1q_f32(gates + i));
+    const float32x4_t forgetGate = sigmoid128(vld1q_f32(gates + i + hiddenSize));
+    const float32x4_t candidate = tanh128(vld1q_f32(gates + i + 2 * hiddenSize));
+    const float32x4_t outputGate = sigmoid128(vld1q_f32(gates + i + 3 * hiddenSize));
+    const float32x4_t c =
+        vfmaq_f32(vmulq_f32(inputGate, candidate), forgetGate, vld1q_f32(cell + i));
+    vst1q_f32(cell + i, c);
+    vst1q_f32(hidden + i, vmulq_f32(outputGate, tanh128(c)));
+  }
+  for (; i < hiddenSize; ++i) {
+    cell[i] = sigmoid(gates[i + hiddenSize]) * cell[i] +
+              sigmoid(gates[i]) * std::tanh(gates[i + 2 * hiddenSize]);
+    hidden[i] = sigmoid(gates[i + 3 * hiddenSize]) * std::tanh(cell[i]);
+  }
+}
+
+void tanhInPlace(float* x, int n) {
+  int i = 0;
+  for (; i + 4 <= n; i += 4)
+    vst1q_f32(x + i, tanh128(vld1q_f32(x + i)));
+  for (; i < n; ++i)
+    x[i] = std::tanh(x[i]);
+}
+
+void sigmoidInPlace(float* x, int n) {
+  int i = 0;
+  for (; i + 4 <= n; i += 4)
+    vst1q_f32(x + i, sigmoid128(vld1q_f32(x + i)));
+  for (; i < n; ++i)
+    x[i] = sigmoid(x[i]);
+}
+}  // namespace
+
+const SimdKernels& getNeonKernels() {
+  static const SimdKernels kernels{"neon",        gemv,        matmulAccumulate,
+                                   lstmPointwise, tanhInPlace, sigmoidInPlace};
+  return kernels;
+}
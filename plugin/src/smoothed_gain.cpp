@@ -0,0 +1,56 @@
+#include "smoothed_gain.h"
+
+void SmoothedGain::prepare(double sampleRate, double rampSeconds) {
+  rampLength = juce::jmax(0, juce::roundToInt(sampleRate * rampSeconds));
+  snapToTarget();
+}
+
+void SmoothedGain::setTargetDecibels(float decibels) {
+  setTargetGain(juce::Decibels::decibelsToGain(decibels));
+}
+
+void SmoothedGain::setTargetGain(float gain) {
+  if (gain == target)
+    return;
+
+  target = gain;
+  if (rampLength == 0) {
+    snapToTarget();
+    return;
+  }
+  // A change mid-ramp starts a fresh ramp from wherever the gain has got to
+  remaining = rampLength;
+  step = (target - current) / static_cast<float>(rampLength);
+}
+
+void SmoothedGain::snapToTarget() {
+  current = target;
+  remaining = 0;
+}
+
+void SmoothedGain::apply(juce::dsp::AudioBlock<float>& block) {
+  const int numSamples = static_cast<int>(block.getNumSamples());
+  const size_t numChannels = block.getNumChannels();
+
+  int offset = 0;
+  while (remaining > 0 && offset < numSamples) {
+    const int n = juce::jmin(numSamples - offset, remaining, maxSegmentLength);
+    for (int i = 0; i < n; ++i)
+      ramp[static_cast<size_t>(i)] = current + step * static_cast<float>(i + 1);
+    remaining -= n;
+    if (remaining == 0)
+      ramp[static_cast<size_t>(n - 1)] = target;
+    current = ramp[static_cast<size_t>(n - 1)];
+
+    for (size_t channel = 0; channel < numChannels; ++channel)
+      juce::FloatVectorOperations::multiply(block.getChannelPointer(channel) + offset, ramp.data(),
+                                            n);
+    offset += n;
+  }
+
+  if (offset < numSamples && current != 1.0f) {
+    for (size_t channel = 0; channel < numChannels; ++channel)
+      juce::FloatVectorOperations::multiply(block.getChannelPointer(channel) + offset, current,
+                                            numSamples - offset);
+  }
+}
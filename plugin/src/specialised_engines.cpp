@@ -0,0 +1,113 @@
+#include "specialised_engines_impl.h"
+#include <cstring>
+
+#if NEURALAMP_HAVE_X86_KERNELS
+// Defined in specialised_engines_avx2.cpp and specialised_engines_avx512.cpp
+std::unique_ptr<nam::DSP> makeSpecialisedModelAvx2(SpecialisedArchitecture architecture,
+                                                   const WaveNetWeights& weights,
+                                                   double expectedSampleRate);
+std::unique_ptr<nam::DSP> makeSpecialisedModelAvx2(SpecialisedArchitecture architecture,
+                                                   const LstmWeights& weights,
+                                                   double expectedSampleRate);
+std::unique_ptr<nam::DSP> makeSpecialisedModelAvx512(SpecialisedArchitecture architecture,
+                                                     const WaveNetWeights& weights,
+                                                     double expectedSampleRate);
+std::unique_ptr<nam::DSP> makeSpecialisedModelAvx512(SpecialisedArchitecture architecture,
+                                                     const LstmWeights& weights,
+                                                     double expectedSampleRate);
+#endif
+
+namespace {
+// Follows the kernels picked for the generic engines, so both paths trust the same CPU check
+template <typename Weights>
+std::unique_ptr<nam::DSP> makeForCpu(SpecialisedArchitecture architecture,
+                                     const Weights& weights,
+                                     double expectedSampleRate) {
+#if NEURALAMP_HAVE_X86_KERNELS
+  const char* kernels = getSimdKernels().name;
+  if (std::strcmp(kernels, "avx512") == 0)
+    return makeSpecialisedModelAvx512(architecture, weights, expectedSampleRate);
+  if (std::strcmp(kernels, "avx2") == 0)
+    return makeSpecialisedModelAvx2(architecture, weights, expectedSampleRate);
+#endif
+  return specialised::makeModel(architecture, weights, expectedSampleRate);
+}
+}  // namespace
+
+const char* getArchitectureName(SpecialisedArchitecture architecture) {
+  switch (architecture) {
+    case SpecialisedArchitecture::wavenetStandard:
+      return "WaveNet standard";
+    case SpecialisedArchitecture::wavenetLite:
+      return "WaveNet lite";
+    case SpecialisedArchitecture::wavenetFeather:
+      return "WaveNet feather";
+    case SpecialisedArchitecture::wavenetNano:
+      return "WaveNet nano";
+    case SpecialisedArchitecture::lstm1x8:
+      return "LSTM 1x8";
+    case SpecialisedArchitecture::lstm1x12:
+      return "LSTM 1x12";
+    case SpecialisedArchitecture::lstm1x16:
+      return "LSTM 1x16";
+    case SpecialisedArchitecture::lstm1x24:
+      return "LSTM 1x24";
+    case SpecialisedArchitecture::lstm1x32:
+      return "LSTM 1x32";
+    case SpecialisedArchitecture::lstm2x8:
+      return "LSTM 2x8";
+    case SpecialisedArchitecture::lstm2x16:
+      return "LSTM 2x16";
+    case SpecialisedArchitecture::none:
+      break;
+  }
+  return "none";
+}
+
+SpecialisedArchitecture findSpecialisedArchitecture(const WaveNetWeights& weights) {
+  using namespace specialised;
+  if (StandardWaveNet::matches(weights))
+    return SpecialisedArchitecture::wavenetStandard;
+  if (LiteWaveNet::matches(weights))
+    return SpecialisedArchitecture::wavenetLite;
+  if (FeatherWaveNet::matches(weights))
+    return SpecialisedArchitecture::wavenetFeather;
+  if (NanoWaveNet::matches(weights))
+    return SpecialisedArchitecture::wavenetNano;
+  return SpecialisedArchitecture::none;
+}
+
+SpecialisedArchitecture findSpecialisedArchitecture(const LstmWeights& weights) {
+  using namespace specialised;
+  if (Lstm<1, 8>::matches(weights))
+    return SpecialisedArchitecture::lstm1x8;
+  if (Lstm<1, 12>::matches(weights))
+    return SpecialisedArchitecture::lstm1x12;
+  if (Lstm<1, 16>::matches(weights))
+    return SpecialisedArchitecture::lstm1x16;
+  if (Lstm<1, 24>::matches(weights))
+    return SpecialisedArchitecture::lstm1x24;
+  if (Lstm<1, 32>::matches(weights))
+    return SpecialisedArchitecture::lstm1x32;
+  if (Lstm<2, 8>::matches(weights))
+    return SpecialisedArchitecture::lstm2x8;
+  if (Lstm<2, 16>::matches(weights))
+    return SpecialisedArchitecture::lstm2x16;
+  return SpecialisedArchitecture::none;
+}
+
+std::unique_ptr<nam::DSP> makeSpecialisedModel(const WaveNetWeights& weights,
+                                               double expectedSampleRate) {
+  const auto architecture = findSpecialisedArchitecture(weights);
+  if (architecture == SpecialisedArchitecture::none)
+    return nullptr;
+  return makeForCpu(architecture, weights, expectedSampleRate);
+}
+
+std::unique_ptr<nam::DSP> makeSpecialisedModel(const LstmWeights& weights,
+                                               double expectedSampleRate) {
+  const auto architecture = findSpecialisedArchitecture(weights);
+  if (architecture == SpecialisedArchitecture::none)
+    return nullptr;
+  return makeForCpu(architecture, weights, expectedSampleRate);
+}
@@ -0,0 +1,15 @@
+// Built with -mavx2 -mfma (or /arch:AVX2); only called once getSimdKernels() has picked the
+// matching kernels
+#include "specialised_engines_impl.h"
+
+std::unique_ptr<nam::DSP> makeSpecialisedModelAvx2(SpecialisedArchitecture architecture,
+                                                   const WaveNetWeights& weights,
+                                                   double expectedSampleRate) {
+  return specialised::makeModel(architecture, weights, expectedSampleRate);
+}
+
+std::unique_ptr<nam::DSP> makeSpecialisedModelAvx2(SpecialisedArchitecture architecture,
+                                                   const LstmWeights& weights,
+                                                   double expectedSampleRate) {
+  return specialised::makeModel(architecture, weights, expectedSampleRate);
+}
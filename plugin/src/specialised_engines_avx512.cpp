@@ -0,0 +1,15 @@
+// Built with -mavx512f -mfma (or /arch:AVX512); only called once getSimdKernels() has picked the
+// matching kernels
+#include "specialised_engines_impl.h"
+
+std::unique_ptr<nam::DSP> makeSpecialisedModelAvx512(SpecialisedArchitecture architecture,
+                                                     const WaveNetWeights& weights,
+                                                     double expectedSampleRate) {
+  return specialised::makeModel(architecture, weights, expectedSampleRate);
+}
+
+std::unique_ptr<nam::DSP> makeSpecialisedModelAvx512(SpecialisedArchitecture architecture,
+                                                     const LstmWeights& weights,
+                                                     double expectedSampleRate) {
+  return specialised::makeModel(architecture, weights, expectedSampleRate);
+}
@@ -0,0 +1,24 @@
+#include "sub_block_scheduler.h"
+
+void SubBlockScheduler::prepare(int numChannels, int newChunkSize, bool shouldUseFifo) {
+  chunkSize = juce::jmax(1, newChunkSize);
+  useFifo = shouldUseFifo;
+
+  // Sized once here so odd host block sizes never reallocate on the audio thread
+  inputFifo.setSize(numChannels, chunkSize, false, true, false);
+  outputFifo.setSize(numChannels, chunkSize, false, true, false);
+  reset();
+}
+
+void SubBlockScheduler::reset() {
+  inputFifo.clear();
+  outputFifo.clear();
+  fifoPosition = 0;
+}
+
+void SubBlockScheduler::setUseFifo(bool shouldUseFifo) {
+  if (shouldUseFifo == useFifo)
+    return;
+  useFifo = shouldUseFifo;
+  reset();
+}
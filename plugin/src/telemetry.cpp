@@ -0,0 +1,88 @@
+#include "telemetry.h"
+#include <cmath>
+
+void Telemetry::prepare(double sampleRate) {
+  frameSamples = juce::jmax(1, juce::roundToInt(sampleRate * frameSeconds));
+  reset();
+}
+
+void Telemetry::reset() {
+  pending = {};
+  input = {};
+  output = {};
+}
+
+void Telemetry::measure(const juce::dsp::AudioBlock<float>& block, Levels& levels) {
+  const int numSamples = static_cast<int>(block.getNumSamples());
+  const size_t numChannels =
+      juce::jmin(block.getNumChannels(), static_cast<size_t>(TelemetryFrame::maxChannels));
+
+  for (size_t channel = 0; channel < numChannels; ++channel) {
+    const float* data = block.getChannelPointer(channel);
+    const auto range = juce::FloatVectorOperations::findMinAndMax(data, numSamples);
+    levels.peak[channel] = juce::jmax(levels.peak[channel], range.getEnd(), -range.getStart());
+
+    float sumSquares = 0.0f;
+    for (int i = 0; i < numSamples; ++i)
+      sumSquares += data[i] * data[i];
+    levels.sumSquares[channel] += sumSquares;
+  }
+}
+
+void Telemetry::measureInput(const juce::dsp::AudioBlock<float>& block) {
+  measure(block, input);
+}
+
+void Telemetry::measureOutput(const juce::dsp::AudioBlock<float>& block) {
+  measure(block, output);
+}
+
+void Telemetry::finishBlock(int numSamples, float load, int xruns, int recoveries,
+                            int faultedModels, int refusedModels) {
+  pending.numSamples += numSamples;
+  pending.load = juce::jmax(pending.load, load);
+  pending.xruns = xruns;
+  pending.recoveries = recoveries;
+  pending.faultedModels = faultedModels;
+  pending.refusedModels = refusedModels;
+  if (pending.numSamples < frameSamples)
+    return;
+
+  const float samples = static_cast<float>(pending.numSamples);
+  for (size_t channel = 0; channel < TelemetryFrame::maxChannels; ++channel) {
+    pending.inputPeak[channel] = input.peak[channel];
+    pending.inputRms[channel] = std::sqrt(input.sumSquares[channel] / samples);
+    pending.outputPeak[channel] = output.peak[channel];
+    pending.outputRms[channel] = std::sqrt(output.sumSquares[channel] / samples);
+  }
+
+  // A full queue means nobody is listening, so the frame is simply dropped
+  const auto scope = fifo.write(1);
+  if (scope.blockSize1 > 0)
+    frames[static_cast<size_t>(scope.startIndex1)] = pending;
+  reset();
+}
+
+void Telemetry::merge(TelemetryFrame& into, const TelemetryFrame& frame) {
+  const float total = static_cast<float>(into.numSamples + frame.numSamples);
+  if (total <= 0.0f)
+    return;
+
+  const float a = static_cast<float>(into.numSamples) / total;
+  const float b = static_cast<float>(frame.numSamples) / total;
+  auto powerMean = [a, b](float x, float y) { return std::sqrt(a * x * x + b * y * y); };
+
+  for (size_t channel = 0; channel < TelemetryFrame::maxChannels; ++channel) {
+    into.inputPeak[channel] = juce::jmax(into.inputPeak[channel], frame.inputPeak[channel]);
+    into.inputRms[channel] = powerMean(into.inputRms[channel], frame.inputRms[channel]);
+    into.outputPeak[channel] = juce::jmax(into.outputPeak[channel], frame.outputPeak[channel]);
+    into.outputRms[channel] = powerMean(into.outputRms[channel], frame.outputRms[channel]);
+  }
+  into.numSamples += frame.numSamples;
+  into.gateOpen = into.gateOpen || frame.gateOpen;
+  into.load = juce::jmax(into.load, frame.load);
+  into.xruns = frame.xruns;
+  into.recoveries = frame.recoveries;
+  into.faultedModels = frame.faultedModels;
+  into.refusedModels = frame.refusedModels;
+}
@@ -0,0 +1,206 @@
+#include "thread_manager.h"
+
+#if JUCE_LINUX
+#include <pthread.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace {
+constexpr int maxCores = 64;
+constexpr int defaultLoaderNice = 5;
+constexpr int defaultBackgroundNice = 10;
+constexpr int maxWorkers = 8;
+
+ThreadManager::CoreMask getAllCores(int numCores) {
+  return numCores >= maxCores ? ~ThreadManager::CoreMask{0}
+                              : (ThreadManager::CoreMask{1} << juce::jmax(1, numCores)) - 1;
+}
+
+int countCores(ThreadManager::CoreMask cores) {
+  int count = 0;
+  for (; cores != 0; cores &= cores - 1)
+    ++count;
+  return count;
+}
+
+const char* getRoleName(ThreadManager::Role role) {
+  switch (role) {
+    case ThreadManager::Role::loader:
+      return "loader";
+    case ThreadManager::Role::writer:
+      return "writer";
+    case ThreadManager::Role::worker:
+      return "worker";
+  }
+  return "unknown";
+}
+
+juce::var readConfig() {
+#if HEADLESS
+  const juce::File file(ThreadManager::configPath);
+  if (file.existsAsFile()) {
+    juce::var config;
+    const auto result = juce::JSON::parse(file.loadFileAsString(), config);
+    if (result.wasOk())
+      return config;
+    juce::Logger::writeToLog("[Threads] Ignoring " + file.getFullPathName() + ": " +
+                             result.getErrorMessage());
+  }
+#endif
+  return {};
+}
+
+// Elk isolates the cores its realtime audio threads are pinned to
+ThreadManager::CoreMask readIsolatedCores() {
+#if JUCE_LINUX
+  const juce::File isolated("/sys/devices/system/cpu/isolated");
+  if (isolated.existsAsFile())
+    return ThreadManager::parseCoreList(isolated.loadFileAsString());
+#endif
+  return 0;
+}
+}  // namespace
+
+ThreadManager::ThreadManager()
+    : ThreadManager(readConfig(), juce::SystemStats::getNumCpus(), readIsolatedCores()) {
+  juce::Logger::writeToLog("[Threads] " + describe());
+}
+
+ThreadManager::ThreadManager(const juce::var& config, int numCores, CoreMask isolatedCores) {
+  const CoreMask allCores = getAllCores(numCores);
+  const auto& configuredAudio = config["audioCores"];
+  audioCores = configuredAudio.isVoid() ? isolatedCores : parseCoreList(configuredAudio.toString());
+  audioCores &= allCores;
+  // With every core taken by audio there is nowhere else to go
+  CoreMask background = allCores & ~audioCores;
+  if (background == 0)
+    background = allCores;
+
+  // The loader's swaps are what the player waits on; the writer and workers can lag
+  numWorkers = juce::jlimit(1, 2, countCores(background) - 1);
+  if (config["workers"].isInt() || config["workers"].isDouble())
+    numWorkers = juce::jlimit(1, maxWorkers, static_cast<int>(config["workers"]));
+
+  for (const auto role : {Role::loader, Role::writer, Role::worker}) {
+    Placement defaults;
+    defaults.cores = background;
+    defaults.nice = role == Role::loader ? defaultLoaderNice : defaultBackgroundNice;
+
+    auto& placement = placements[static_cast<size_t>(role)];
+    placement = parsePlacement(config[getRoleName(role)], defaults);
+    const CoreMask configured = placement.cores;
+    placement.cores &= background;
+    if (placement.cores == 0) {
+      placement.cores = background;
+      juce::Logger::writeToLog(juce::String("[Threads] ") + getRoleName(role) + " cores " +
+                               formatCoreList(configured) + " overlap the audio cores; using " +
+                               formatCoreList(background));
+    }
+  }
+}
+
+ThreadManager::~ThreadManager() {
+  const juce::ScopedLock lock(workersLock);
+  if (workers != nullptr)
+    workers->removeAllJobs(true, 5000);
+}
+
+ThreadManager::Placement ThreadManager::parsePlacement(const juce::var& config,
+                                                       Placement placement) {
+  if (!config.isObject())
+    return placement;
+  if (config.hasProperty("cores"))
+    placement.cores = parseCoreList(config["cores"].toString());
+  if (config.hasProperty("policy"))
+    placement.fifo = config["policy"].toString().equalsIgnoreCase("fifo");
+  if (config.hasProperty("priority"))
+    placement.priority = juce::jlimit(1, 99, static_cast<int>(config["priority"]));
+  if (config.hasProperty("nice"))
+    placement.nice = juce::jlimit(-20, 19, static_cast<int>(config["nice"]));
+  return placement;
+}
+
+bool ThreadManager::placeCurrentThread(Role role) const {
+  const auto& placement = getPlacement(role);
+#if JUCE_LINUX
+  bool placed = true;
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  for (int core = 0; core < maxCores && core < CPU_SETSIZE; ++core) {
+    if ((placement.cores >> core & 1) != 0)
+      CPU_SET(core, &set);
+  }
+  placed = pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0 && placed;
+
+  sched_param param{};
+  param.sched_priority = placement.fifo ? placement.priority : 0;
+  placed = pthread_setschedparam(pthread_self(), placement.fifo ? SCHED_FIFO : SCHED_OTHER,
+                                 &param) == 0 && placed;
+  // Linux keeps a nice value per thread, addressed by thread ID
+  if (!placement.fifo) {
+    const auto thread = static_cast<id_t>(syscall(SYS_gettid));
+    placed = setpriority(PRIO_PROCESS, thread, placement.nice) == 0 && placed;
+  }
+  return placed;
+#else
+  juce::Thread::setCurrentThreadAffinityMask(static_cast<juce::uint32>(placement.cores));
+  return !placement.fifo;
+#endif
+}
+
+juce::ThreadPool& ThreadManager::getWorkers() {
+  const juce::ScopedLock lock(workersLock);
+  if (workers == nullptr) {
+    workers = std::make_unique<juce::ThreadPool>(juce::ThreadPoolOptions{}
+                                                     .withThreadName("NeuralAmp Worker")
+                                                     .withNumberOfThreads(numWorkers)
+                                                     .withDesiredThreadPriority(
+                                                         juce::Thread::Priority::low));
+  }
+  return *workers;
+}
+
+ThreadManager::CoreMask ThreadManager::parseCoreList(const juce::String& list) {
+  CoreMask cores = 0;
+  for (const auto& token : juce::StringArray::fromTokens(list.trim(), ",", "")) {
+    const auto range = token.trim();
+    if (range.isEmpty())
+      continue;
+    const int first = range.upToFirstOccurrenceOf("-", false, false).getIntValue();
+    const int last =
+        range.contains("-") ? range.fromFirstOccurrenceOf("-", false, false).getIntValue() : first;
+    for (int core = juce::jmax(0, first); core <= last && core < maxCores; ++core)
+      cores |= CoreMask{1} << core;
+  }
+  return cores;
+}
+
+juce::String ThreadManager::formatCoreList(CoreMask cores) {
+  juce::StringArray ranges;
+  for (int core = 0; core < maxCores; ++core) {
+    if ((cores >> core & 1) == 0)
+      continue;
+    int last = core;
+    while (last + 1 < maxCores && (cores >> (last + 1) & 1) != 0)
+      ++last;
+    ranges.add(last == core ? juce::String(core) : juce::String(core) + "-" + juce::String(last));
+    core = last;
+  }
+  return ranges.isEmpty() ? juce::String("none") : ranges.joinIntoString(",");
+}
+
+juce::String ThreadManager::describe() const {
+  juce::StringArray parts;
+  parts.add("audio cores " + formatCoreList(audioCores));
+  for (const auto role : {Role::loader, Role::writer, Role::worker}) {
+    const auto& placement = getPlacement(role);
+    parts.add(juce::String(getRoleName(role)) + " on " + formatCoreList(placement.cores) +
+              (placement.fifo ? " SCHED_FIFO " + juce::String(placement.priority)
+                              : " SCHED_OTHER nice " + juce::String(placement.nice)));
+  }
+  parts.add(juce::String(numWorkers) + (numWorkers == 1 ? " worker" : " workers"));
+  return parts.joinIntoString("; ");
+}
@@ -0,0 +1,234 @@
+#include "tone_stack.h"
+#include <algorithm>
+#include <cmath>
+#include <complex>
+
+namespace {
+constexpr double pi = 3.14159265358979323846;
+
+// Treble pot, bass pot, mid pot, slope resistor; treble, bass and mid capacitors
+struct Components {
+  double r1, r2, r3, r4, c1, c2, c3;
+};
+
+// In the order of ToneStack::Model
+constexpr std::array<Components, ToneStack::numModels> components{{
+    {250e3, 1e6, 25e3, 56e3, 250e-12, 20e-9, 20e-9},  // '59 Bassman
+    {220e3, 1e6, 22e3, 33e3, 470e-12, 22e-9, 22e-9},  // JCM800
+    {1e6, 1e6, 10e3, 100e3, 50e-12, 22e-9, 22e-9},    // AC30 Top Boost voicing
+}};
+
+// Analog transfer function (b1 s + b2 s^2 + b3 s^3) / (a0 + a1 s + a2 s^2 + a3 s^3) for pot
+// positions t (treble), m (mid) and l (bass), from Yeh and Smith, "Discretization of the '59
+// Fender Bassman Tone Stack" (DAFx 2006)
+struct Analog {
+  double b1, b2, b3, a0, a1, a2, a3;
+};
+
+Analog solveAnalog(const Components& c, double l, double m, double t) {
+  const double c1c2c3 = c.c1 * c.c2 * c.c3;
+  const double r3r3 = c.r3 * c.r3;
+  Analog h;
+  h.b1 = t * c.c1 * c.r1 + m * c.c3 * c.r3 + l * (c.c1 * c.r2 + c.c2 * c.r2) +
+         (c.c1 * c.r3 + c.c2 * c.r3);
+  h.b2 = t * (c.c1 * c.c2 * c.r1 * c.r4 + c.c1 * c.c3 * c.r1 * c.r4) -
+         m * m * (c.c1 * c.c3 * r3r3 + c.c2 * c.c3 * r3r3) +
+         m * (c.c1 * c.c3 * c.r1 * c.r3 + c.c1 * c.c3 * r3r3 + c.c2 * c.c3 * r3r3) +
+         l * (c.c1 * c.c2 * c.r1 * c.r2 + c.c1 * c.c2 * c.r2 * c.r4 + c.c1 * c.c3 * c.r2 * c.r4) +
+         l * m * (c.c1 * c.c3 * c.r2 * c.r3 + c.c2 * c.c3 * c.r2 * c.r3) +
+         (c.c1 * c.c2 * c.r1 * c.r3 + c.c1 * c.c2 * c.r3 * c.r4 + c.c1 * c.c3 * c.r3 * c.r4);
+  h.b3 = l * m * c1c2c3 * (c.r1 * c.r2 * c.r3 + c.r2 * c.r3 * c.r4) -
+         m * m * c1c2c3 * (c.r1 * r3r3 + r3r3 * c.r4) + m * c1c2c3 * (c.r1 * r3r3 + r3r3 * c.r4) +
+         t * c1c2c3 * c.r1 * c.r3 * c.r4 - t * m * c1c2c3 * c.r1 * c.r3 * c.r4 +
+         t * l * c1c2c3 * c.r1 * c.r2 * c.r4;
+  h.a0 = 1.0;
+  h.a1 = (c.c1 * c.r1 + c.c1 * c.r3 + c.c2 * c.r3 + c.c2 * c.r4 + c.c3 * c.r4) +
+         m * c.c3 * c.r3 + l * (c.c1 * c.r2 + c.c2 * c.r2);
+  h.a2 = m * (c.c1 * c.c3 * c.r1 * c.r3 - c.c2 * c.c3 * c.r3 * c.r4 + c.c1 * c.c3 * r3r3 +
+              c.c2 * c.c3 * r3r3) +
+         l * m * (c.c1 * c.c3 * c.r2 * c.r3 + c.c2 * c.c3 * c.r2 * c.r3) -
+         m * m * (c.c1 * c.c3 * r3r3 + c.c2 * c.c3 * r3r3) +
+         l * (c.c1 * c.c2 * c.r2 * c.r4 + c.c1 * c.c2 * c.r1 * c.r2 + c.c1 * c.c3 * c.r2 * c.r4 +
+              c.c2 * c.c3 * c.r2 * c.r4) +
+         (c.c1 * c.c2 * c.r1 * c.r4 + c.c1 * c.c3 * c.r1 * c.r4 + c.c1 * c.c2 * c.r3 * c.r4 +
+          c.c1 * c.c2 * c.r1 * c.r3 + c.c1 * c.c3 * c.r3 * c.r4 + c.c2 * c.c3 * c.r3 * c.r4);
+  h.a3 = l * m * c1c2c3 * (c.r1 * c.r2 * c.r3 + c.r2 * c.r3 * c.r4) -
+         m * m * c1c2c3 * (c.r1 * r3r3 + r3r3 * c.r4) +
+         m * c1c2c3 * (r3r3 * c.r4 + c.r1 * r3r3 - c.r1 * c.r3 * c.r4) +
+         l * c1c2c3 * c.r1 * c.r2 * c.r4 + c1c2c3 * c.r1 * c.r3 * c.r4;
+  return h;
+}
+
+double knobToPot(float knob) {
+  return std::clamp(static_cast<double>(knob) / ToneStack::maxKnob, 0.0, 1.0);
+}
+}  // namespace
+
+const char* ToneStack::getModelName(Model model) {
+  switch (model) {
+    case fender:
+      return "Fender";
+    case marshall:
+      return "Marshall";
+    case vox:
+      return "Vox";
+    case numModels:
+      break;
+  }
+  return "unknown";
+}
+
+// Bass pots are audio taper: a quarter of the resistance at noon
+double ToneStack::getBassPot(float knob) {
+  return std::exp((knobToPot(knob) - 1.0) * 3.4);
+}
+
+ToneStack::Terms ToneStack::solve(Model model, double sampleRate, double bassPot, double midPot,
+                                  double treblePot) {
+  const auto h = solveAnalog(components[static_cast<size_t>(model)], bassPot, midPot, treblePot);
+
+  // Bilinear transform, s = c (1 - z^-1) / (1 + z^-1)
+  const double c = 2.0 * sampleRate;
+  const double c2 = c * c;
+  const double c3 = c2 * c;
+  return {h.b1 * c + h.b2 * c2 + h.b3 * c3,
+          h.b1 * c - h.b2 * c2 - 3.0 * h.b3 * c3,
+          -h.b1 * c - h.b2 * c2 + 3.0 * h.b3 * c3,
+          -h.b1 * c + h.b2 * c2 - h.b3 * c3,
+          h.a0 + h.a1 * c + h.a2 * c2 + h.a3 * c3,
+          3.0 * h.a0 + h.a1 * c - h.a2 * c2 - 3.0 * h.a3 * c3,
+          3.0 * h.a0 - h.a1 * c - h.a2 * c2 + 3.0 * h.a3 * c3,
+          h.a0 - h.a1 * c + h.a2 * c2 - h.a3 * c3};
+}
+
+// A passive stack loses 10-20 dB; without this, changing model would change the level too
+double ToneStack::getMakeupGain(Model model) {
+  const auto h = solveAnalog(components[static_cast<size_t>(model)], getBassPot(maxKnob / 2),
+                             0.5, 0.5);
+  constexpr int numFrequencies = 128;
+  double peak = 0.0;
+  for (int i = 0; i < numFrequencies; ++i) {
+    const double frequency = 20.0 * std::pow(1000.0, i / (numFrequencies - 1.0));
+    const std::complex<double> s(0.0, 2.0 * pi * frequency);
+    const auto response =
+        (h.b1 * s + h.b2 * s * s + h.b3 * s * s * s) /
+        (h.a0 + h.a1 * s + h.a2 * s * s + h.a3 * s * s * s);
+    peak = std::max(peak, std::abs(response));
+  }
+  return peak > 0.0 ? 1.0 / peak : 1.0;
+}
+
+ToneStack::Coefficients ToneStack::design(Model model, double sampleRate, float bass, float mid,
+                                          float treble) {
+  const auto terms =
+      solve(model, sampleRate, getBassPot(bass), knobToPot(mid), knobToPot(treble));
+  const double gain = getMakeupGain(model);
+  Coefficients result;
+  for (size_t i = 0; i <= order; ++i) {
+    result.b[i] = gain * terms[i] / terms[order + 1];
+    result.a[i] = terms[order + 1 + i] / terms[order + 1];
+  }
+  return result;
+}
+
+void ToneStack::prepare(double newSampleRate, MemoryArena* memory) {
+  sampleRate = newSampleRate;
+  constexpr size_t entries = static_cast<size_t>(gridSize) * gridSize * gridSize * numTerms;
+  table = MemoryArena::Vector<double>(numModels * entries, 0.0, {memory, MemoryArena::scratch});
+
+  const float knobStep = maxKnob / (gridSize - 1);
+  auto entry = table.begin();
+  for (int index = 0; index < numModels; ++index) {
+    const auto current = static_cast<Model>(index);
+    const double gain = getMakeupGain(current);
+    for (int bass = 0; bass < gridSize; ++bass) {
+      for (int mid = 0; mid < gridSize; ++mid) {
+        for (int treble = 0; treble < gridSize; ++treble) {
+          auto terms = solve(current, sampleRate, getBassPot(bass * knobStep),
+                             knobToPot(mid * knobStep), knobToPot(treble * knobStep));
+          for (size_t i = 0; i <= order; ++i)
+            terms[i] *= gain;
+          entry = std::copy(terms.begin(), terms.end(), entry);
+        }
+      }
+    }
+  }
+  updateCoefficients();
+  reset();
+}
+
+void ToneStack::reset() {
+  for (auto& channel : state)
+    channel.fill(0.0);
+}
+
+void ToneStack::setModel(Model newModel) {
+  if (newModel == model)
+    return;
+  model = newModel;
+  updateCoefficients();
+}
+
+void ToneStack::setControls(float bass, float mid, float treble) {
+  const std::array<float, 3> newControls{bass, mid, treble};
+  if (newControls == controls)
+    return;
+  controls = newControls;
+  updateCoefficients();
+}
+
+void ToneStack::updateCoefficients() {
+  if (table.empty())
+    return;
+
+  // Grid cell and position within it on each axis
+  const float knobStep = maxKnob / (gridSize - 1);
+  std::array<int, 3> cell{};
+  std::array<double, 3> weight{};
+  for (size_t axis = 0; axis < 3; ++axis) {
+    const float position = std::clamp(controls[axis], 0.0f, maxKnob) / knobStep;
+    cell[axis] = std::min(static_cast<int>(position), gridSize - 2);
+    weight[axis] = position - cell[axis];
+  }
+  const double lower = getBassPot(cell[0] * knobStep);
+  const double upper = getBassPot((cell[0] + 1) * knobStep);
+  weight[0] = (getBassPot(controls[0]) - lower) / (upper - lower);
+
+  Terms terms{};
+  const size_t modelOffset =
+      static_cast<size_t>(model) * gridSize * gridSize * gridSize * numTerms;
+  for (int corner = 0; corner < 8; ++corner) {
+    double cornerWeight = 1.0;
+    size_t index = 0;
+    for (size_t axis = 0; axis < 3; ++axis) {
+      const int high = (corner >> axis) & 1;
+      cornerWeight *= high != 0 ? weight[axis] : 1.0 - weight[axis];
+      index = index * gridSize + static_cast<size_t>(cell[axis] + high);
+    }
+    const double* entry = table.data() + modelOffset + index * numTerms;
+    for (size_t i = 0; i < numTerms; ++i)
+      terms[i] += cornerWeight * entry[i];
+  }
+
+  for (size_t i = 0; i <= order; ++i) {
+    coefficients.b[i] = terms[i] / terms[order + 1];
+    coefficients.a[i] = terms[order + 1 + i] / terms[order + 1];
+  }
+}
+
+void ToneStack::process(float* const* channels, int numChannels, int numSamples) {
+  const auto& b = coefficients.b;
+  const auto& a = coefficients.a;
+  for (int channel = 0; channel < std::min(numChannels, maxChannels); ++channel) {
+    float* data = channels[channel];
+    auto& s = state[static_cast<size_t>(channel)];
+    for (int i = 0; i < numSamples; ++i) {
+      const double x = data[i];
+      const double y = b[0] * x + s[0];
+      s[0] = b[1] * x - a[1] * y + s[1];
+      s[1] = b[2] * x - a[2] * y + s[2];
+      s[2] = b[3] * x - a[3] * y;
+      data[i] = static_cast<float>(y);
+    }
+  }
+}
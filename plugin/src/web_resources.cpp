@@ -0,0 +1,68 @@
+#include "web_resources.h"
+#include "BinaryData.h"
+#include "WebAssetPaths.h"
+
+const WebResources& WebResources::getInstance() {
+  static const WebResources resources;
+  return resources;
+}
+
+WebResources::WebResources() {
+  entries.reserve(static_cast<size_t>(BinaryData::namedResourceListSize));
+  for (int i = 0; i < BinaryData::namedResourceListSize; ++i) {
+    // WebAssetPaths is generated from the same sorted asset list as BinaryData, so index i names
+    // the same file in both
+    const char* path = WebAssetPaths::paths[i];
+    const juce::String fileName(BinaryData::originalFilenames[i]);
+    const bool matches = path != nullptr &&
+                         juce::String(path).fromLastOccurrenceOf("/", false, false) == fileName;
+    jassert(matches);
+    if (!matches)
+      continue;
+
+    int size = 0;
+    const char* data = BinaryData::getNamedResource(BinaryData::namedResourceList[i], size);
+    if (data == nullptr || size <= 0)
+      continue;
+
+    const auto* begin = reinterpret_cast<const std::byte*>(data);
+    entries.emplace(path, juce::WebBrowserComponent::Resource{
+                              std::vector<std::byte>(begin, begin + size), getMimeType(fileName)});
+  }
+}
+
+std::optional<juce::WebBrowserComponent::Resource> WebResources::find(
+    const juce::String& url) const {
+  auto path = url.upToFirstOccurrenceOf("?", false, false).upToFirstOccurrenceOf("#", false, false);
+  path = path.trimCharactersAtStart("/");
+  if (path.isEmpty())
+    path = "index.html";
+
+  // The Resource owns its bytes and the provider returns it by value, so this copy is the only one
+  if (const auto it = entries.find(path); it != entries.end())
+    return it->second;
+  return std::nullopt;
+}
+
+// MIME types for the files the UI build emits
+const char* WebResources::getMimeType(const juce::String& fileName) {
+  static const std::unordered_map<juce::String, const char*> mimeMap = {
+      {"htm", "text/html"},
+      {"html", "text/html"},
+      {"txt", "text/plain"},
+      {"jpg", "image/jpeg"},
+      {"jpeg", "image/jpeg"},
+      {"svg", "image/svg+xml"},
+      {"ico", "image/vnd.microsoft.icon"},
+      {"json", "application/json"},
+      {"png", "image/png"},
+      {"css", "text/css"},
+      {"map", "application/json"},
+      {"js", "text/javascript"},
+      {"woff2", "font/woff2"}};
+
+  const auto extension = fileName.fromLastOccurrenceOf(".", false, false).toLowerCase();
+  if (const auto it = mimeMap.find(extension); it != mimeMap.end())
+    return it->second;
+  return "application/octet-stream";
+}
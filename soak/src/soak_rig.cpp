@@ -0,0 +1,650 @@
+// Plays several processors the way a live rig would, for hours or days at a time. Each runs on
+// its own realtime-priority thread, paced to the block period and fed a DI loop, while a control
+// thread keeps switching models, IRs, block sizes and parameters. Reports per-block processing
+// time, xruns, non-finite and denormal output, realtime violations and RSS growth, as text and
+// optionally as JSON for comparing builds. Exits with 1 if any output was non-finite or the audio
+// threads allocated, locked or touched files.
+//
+//   NeuralAmpSoak [--instances N] [--minutes M] [--di file.wav] [--models dir] [--irs dir]
+//                 [--change-seconds S] [--free-run] [--trap] [--report file.json]
+//
+// Without --models or --irs, random-weight models and synthetic IRs are generated. Without --di,
+// a synthetic pluck loop is played.
+#include <processor.h>
+#include <realtime_audit.h>
+#include <simd_kernels.h>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <csignal>
+#include <cstdio>
+#include <fstream>
+#include <random>
+#include <thread>
+#include <vector>
+#include <json.hpp>
+#if defined(__linux__)
+#include <unistd.h>
+#endif
+
+namespace {
+using Clock = std::chrono::steady_clock;
+
+constexpr double sampleRate = 48000.0;
+constexpr int initialBlockSize = 128;
+constexpr int blockSizes[] = {32, 64, 97, 128, 256, 512};
+constexpr int maxBlockSize = 512;
+constexpr int rssIntervalSeconds = 10;
+constexpr int progressIntervalSeconds = 60;
+
+std::atomic<bool> stopRequested{false};
+
+// Per-block processing time in 10 us bins up to 20 ms, plus one overflow bin
+class LatencyHistogram {
+public:
+  static constexpr double binMicroseconds = 10.0;
+  static constexpr int numBins = 2000;
+
+  void add(double microseconds) {
+    const auto bin = static_cast<size_t>(juce::jlimit(0.0, static_cast<double>(numBins),
+                                                      microseconds / binMicroseconds));
+    ++counts[bin];
+    ++total;
+    maxMicroseconds = std::max(maxMicroseconds, microseconds);
+  }
+
+  void merge(const LatencyHistogram& other) {
+    for (size_t bin = 0; bin < counts.size(); ++bin)
+      counts[bin] += other.counts[bin];
+    total += other.total;
+    maxMicroseconds = std::max(maxMicroseconds, other.maxMicroseconds);
+  }
+
+  // Upper edge of the bin that the given fraction of blocks finished within
+  double getPercentile(double fraction) const {
+    const double rank = std::ceil(fraction * static_cast<double>(total));
+    const auto target = static_cast<std::uint64_t>(rank);
+    std::uint64_t seen = 0;
+    for (size_t bin = 0; bin < static_cast<size_t>(numBins); ++bin) {
+      seen += counts[bin];
+      if (seen >= target && seen > 0)
+        return std::min(maxMicroseconds, static_cast<double>(bin + 1) * binMicroseconds);
+    }
+    return maxMicroseconds;
+  }
+
+  double getMax() const { return maxMicroseconds; }
+
+private:
+  std::array<std::uint64_t, numBins + 1> counts{};
+  std::uint64_t total = 0;
+  double maxMicroseconds = 0.0;
+};
+
+// One processor and the thread that plays it
+class RigInstance : public juce::Thread {
+public:
+  RigInstance(int index, const std::vector<float>& diLoop, bool freeRunning)
+      : juce::Thread("Soak instance " + juce::String(index)),
+        di(diLoop),
+        freeRun(freeRunning),
+        position(static_cast<size_t>(index) * diLoop.size() / 7 % diLoop.size()) {
+    processor.setPlayConfigDetails(2, 2, sampleRate, initialBlockSize);
+    processor.prepareToPlay(sampleRate, initialBlockSize);
+    buffer.setSize(2, maxBlockSize);
+  }
+
+  ~RigInstance() override {
+    stopThread(2000);
+    processor.releaseResources();
+  }
+
+  NeuralAmpProcessor& getProcessor() { return processor; }
+
+  // Stops playing, re-prepares at the new size and resumes, as a host does
+  void changeBlockSize(int newBlockSize) {
+    state = pauseRequested;
+    while (state.load() != paused && isThreadRunning())
+      juce::Thread::sleep(1);
+    processor.releaseResources();
+    processor.setPlayConfigDetails(2, 2, sampleRate, newBlockSize);
+    processor.prepareToPlay(sampleRate, newBlockSize);
+    blockSize = newBlockSize;
+    state = running;
+  }
+
+  // Audio thread results; read them once the thread has stopped
+  const LatencyHistogram& getHistogram() const { return histogram; }
+
+  std::atomic<std::uint64_t> blocks{0};
+  std::atomic<std::uint64_t> xruns{0};
+  std::atomic<std::uint64_t> nonFiniteSamples{0};
+  std::atomic<std::uint64_t> denormalSamples{0};
+
+private:
+  enum State { running, pauseRequested, paused };
+
+  void run() override {
+    auto nextCallback = Clock::now();
+    while (!threadShouldExit()) {
+      int expected = pauseRequested;
+      if (state.compare_exchange_strong(expected, paused)) {
+        while (state.load() == paused && !threadShouldExit())
+          juce::Thread::sleep(1);
+        nextCallback = Clock::now();
+        continue;
+      }
+
+      const auto period = std::chrono::duration_cast<Clock::duration>(
+          std::chrono::duration<double>(blockSize / sampleRate));
+      if (!freeRun)
+        std::this_thread::sleep_until(nextCallback);
+
+      fillFromDi();
+      const auto start = Clock::now();
+      {
+        RealtimeAudit::ScopedSection realtimeSection;
+        processor.processBlock(buffer, midi);
+      }
+      const auto end = Clock::now();
+
+      histogram.add(std::chrono::duration<double, std::micro>(end - start).count());
+      // The block is due when the next callback starts
+      if (end - start > period || (!freeRun && end > nextCallback + period))
+        ++xruns;
+      nextCallback += period;
+      if (freeRun || nextCallback < end)
+        nextCallback = end;  // Fell behind: drop the lost time like a host would
+
+      checkOutput();
+      ++blocks;
+    }
+  }
+
+  void fillFromDi() {
+    buffer.setSize(2, blockSize, false, false, true);
+    for (int i = 0; i < blockSize; ++i) {
+      buffer.setSample(0, i, di[position]);
+      buffer.setSample(1, i, di[position]);
+      position = (position + 1) % di.size();
+    }
+  }
+
+  void checkOutput() {
+    std::uint64_t nonFinite = 0;
+    std::uint64_t denormal = 0;
+    for (int channel = 0; channel < buffer.getNumChannels(); ++channel) {
+      const float* samples = buffer.getReadPointer(channel);
+      for (int i = 0; i < buffer.getNumSamples(); ++i) {
+        if (!std::isfinite(samples[i]))
+          ++nonFinite;
+        else if (std::fpclassify(samples[i]) == FP_SUBNORMAL)
+          ++denormal;
+      }
+    }
+    nonFiniteSamples += nonFinite;
+    denormalSamples += denormal;
+  }
+
+  NeuralAmpProcessor processor;
+  const std::vector<float>& di;
+  const bool freeRun;
+  size_t position;
+  int blockSize = initialBlockSize;  // Only changed while the audio thread is paused
+  std::atomic<int> state{running};
+  juce::AudioBuffer<float> buffer;
+  juce::MidiBuffer midi;
+  LatencyHistogram histogram;
+};
+
+// Switches models, IRs, block sizes and parameters on random instances at random intervals
+class ControlThread : public juce::Thread {
+public:
+  ControlThread(std::vector<std::unique_ptr<RigInstance>>& rigInstances,
+                const std::vector<juce::File>& modelFiles,
+                const std::vector<juce::File>& irFiles,
+                double changeSeconds)
+      : juce::Thread("Soak control"),
+        instances(rigInstances),
+        models(modelFiles),
+        irs(irFiles),
+        meanIntervalMs(static_cast<int>(changeSeconds * 1000.0)) {}
+
+  ~ControlThread() override { stopThread(10000); }
+
+  std::atomic<int> modelChanges{0};
+  std::atomic<int> irChanges{0};
+  std::atomic<int> blockSizeChanges{0};
+  std::atomic<int> parameterChanges{0};
+  std::atomic<double> maxModelLoadMs{0.0};
+
+private:
+  void run() override {
+    std::uniform_int_distribution<int> interval(meanIntervalMs / 2, meanIntervalMs * 3 / 2);
+    std::uniform_int_distribution<size_t> instance(0, instances.size() - 1);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    while (!threadShouldExit()) {
+      wait(interval(rng));
+      if (threadShouldExit())
+        break;
+
+      auto& rig = *instances[instance(rng)];
+      const float action = unit(rng);
+      if (action < 0.3f) {
+        const auto slot = unit(rng) < 0.5f ? ModelBlender::slotA : ModelBlender::slotB;
+        const auto start = Clock::now();
+        rig.getProcessor().loadNamFile(pick(models).getFullPathName(), slot);
+        const double ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+        maxModelLoadMs = std::max(maxModelLoadMs.load(), ms);
+        ++modelChanges;
+      } else if (action < 0.45f) {
+        const auto slot = unit(rng) < 0.5f ? DualIrConvolver::slotA : DualIrConvolver::slotB;
+        rig.getProcessor().loadIrFile(pick(irs), slot);
+        ++irChanges;
+      } else if (action < 0.55f) {
+        std::uniform_int_distribution<size_t> size(0, std::size(blockSizes) - 1);
+        rig.changeBlockSize(blockSizes[size(rng)]);
+        ++blockSizeChanges;
+      } else {
+        std::uniform_int_distribution<int> id(0, ParameterSnapshot::numParameters - 1);
+        const auto parameterId = ParameterSnapshot::getParameterId(
+            static_cast<ParameterSnapshot::Id>(id(rng)));
+        if (auto* parameter = rig.getProcessor().getParameters().getParameter(parameterId))
+          parameter->setValueNotifyingHost(unit(rng));
+        ++parameterChanges;
+      }
+    }
+  }
+
+  const juce::File& pick(const std::vector<juce::File>& files) {
+    std::uniform_int_distribution<size_t> index(0, files.size() - 1);
+    return files[index(rng)];
+  }
+
+  std::vector<std::unique_ptr<RigInstance>>& instances;
+  const std::vector<juce::File>& models;
+  const std::vector<juce::File>& irs;
+  const int meanIntervalMs;
+  std::mt19937 rng{7};
+};
+
+std::vector<float> randomWeights(size_t count, unsigned seed) {
+  std::mt19937 rng(seed);
+  std::normal_distribution<float> distribution(0.0f, 0.3f);
+  std::vector<float> weights(count);
+  for (auto& weight : weights)
+    weight = distribution(rng);
+  return weights;
+}
+
+nlohmann::json makeLstm(int numLayers, int hiddenSize, unsigned seed) {
+  size_t count = static_cast<size_t>(hiddenSize + 1);
+  for (int i = 0; i < numLayers; ++i) {
+    const int inputSize = i == 0 ? 1 : hiddenSize;
+    count += static_cast<size_t>(4 * hiddenSize * (inputSize + hiddenSize) + 6 * hiddenSize);
+  }
+  return {{"version", "0.5.4"},
+          {"architecture", "LSTM"},
+          {"config", {{"num_layers", numLayers}, {"input_size", 1}, {"hidden_size", hiddenSize}}},
+          {"weights", randomWeights(count, seed)},
+          {"sample_rate", sampleRate}};
+}
+
+// Two Tanh arrays with the trainer's "lite" dilations
+nlohmann::json makeWaveNet(int channels, unsigned seed) {
+  const std::vector<int> firstDilations{1, 2, 4, 8, 16, 32, 64};
+  const std::vector<int> secondDilations{128, 256, 512, 1, 2, 4, 8, 16, 32, 64, 128, 256, 512};
+  nlohmann::json layers = nlohmann::json::array();
+  size_t count = 1;  // head_scale
+  int inputSize = 1;
+  for (const auto& dilations : {firstDilations, secondDilations}) {
+    const int headSize = inputSize == 1 ? channels / 2 : 1;
+    layers.push_back({{"input_size", inputSize},
+                      {"condition_size", 1},
+                      {"head_size", headSize},
+                      {"channels", channels},
+                      {"kernel_size", 3},
+                      {"dilations", dilations},
+                      {"activation", "Tanh"},
+                      {"gated", false},
+                      {"head_bias", headSize == 1}});
+    count += static_cast<size_t>(channels * inputSize);
+    count += dilations.size() * static_cast<size_t>(4 * channels * channels + 3 * channels);
+    count += static_cast<size_t>(headSize * channels + (headSize == 1 ? 1 : 0));
+    inputSize = channels;
+    channels = headSize == 1 ? channels : channels / 2;
+  }
+  return {{"version", "0.5.4"},
+          {"architecture", "WaveNet"},
+          {"config", {{"layers", layers}, {"head", nullptr}, {"head_scale", 0.02}}},
+          {"weights", randomWeights(count, seed)},
+          {"sample_rate", sampleRate}};
+}
+
+// Specialised, generic SIMD and NAM-only architectures, so every engine path gets swapped in
+std::vector<juce::File> generateModels(const juce::File& directory) {
+  const std::pair<const char*, nlohmann::json> presets[] = {
+      {"lstm_1x16.nam", makeLstm(1, 16, 1)},
+      {"lstm_1x10.nam", makeLstm(1, 10, 2)},
+      {"wavenet_nano.nam", makeWaveNet(4, 3)},
+      {"wavenet_feather.nam", makeWaveNet(8, 4)},
+  };
+  std::vector<juce::File> files;
+  for (const auto& [name, model] : presets) {
+    const auto file = directory.getChildFile(name);
+    std::ofstream(file.getFullPathName().toStdString()) << model.dump();
+    files.push_back(file);
+  }
+  return files;
+}
+
+// Decaying noise cabinets of a few lengths
+std::vector<juce::File> generateIrs(const juce::File& directory) {
+  std::vector<juce::File> files;
+  std::mt19937 rng(5);
+  std::uniform_real_distribution<float> noise(-1.0f, 1.0f);
+  juce::WavAudioFormat wav;
+  for (const int length : {1024, 4096, 16384}) {
+    juce::AudioBuffer<float> ir(1, length);
+    for (int i = 0; i < length; ++i)
+      ir.setSample(0, i, noise(rng) * std::exp(-6.0f * static_cast<float>(i) / length));
+
+    const auto file = directory.getChildFile("cabinet_" + juce::String(length) + ".wav");
+    file.deleteFile();
+    auto stream = std::make_unique<juce::FileOutputStream>(file);
+    std::unique_ptr<juce::AudioFormatWriter> writer(
+        wav.createWriterFor(stream.get(), sampleRate, 1, 32, {}, 0));
+    if (writer == nullptr)
+      continue;
+    stream.release();  // Owned by the writer now
+    writer->writeFromAudioSampleBuffer(ir, 0, length);
+    files.push_back(file);
+  }
+  return files;
+}
+
+std::vector<juce::File> findFiles(const juce::String& directory, const juce::String& pattern) {
+  std::vector<juce::File> files;
+  for (const auto& entry : juce::RangedDirectoryIterator(juce::File(directory), true, pattern))
+    files.push_back(entry.getFile());
+  return files;
+}
+
+// First channel of the recording, or an empty vector if it can't be read
+std::vector<float> loadDi(const juce::File& file) {
+  juce::AudioFormatManager formats;
+  formats.registerBasicFormats();
+  std::unique_ptr<juce::AudioFormatReader> reader(formats.createReaderFor(file));
+  if (reader == nullptr || reader->lengthInSamples <= 0)
+    return {};
+  if (reader->sampleRate != sampleRate)
+    std::fprintf(stderr, "Warning: %s is %.0f Hz, played as %.0f Hz\n",
+                 file.getFileName().toRawUTF8(), reader->sampleRate, sampleRate);
+
+  const int length = static_cast<int>(std::min<juce::int64>(reader->lengthInSamples, 1 << 26));
+  juce::AudioBuffer<float> buffer(1, length);
+  reader->read(&buffer, 0, length, 0, true, false);
+  return {buffer.getReadPointer(0), buffer.getReadPointer(0) + length};
+}
+
+// Stand-in for a DI recording: eight seconds of Karplus-Strong plucks and rests
+std::vector<float> synthesiseDi() {
+  std::vector<float> signal(static_cast<size_t>(8.0 * sampleRate), 0.0f);
+  std::mt19937 rng(3);
+  std::uniform_real_distribution<float> noise(-1.0f, 1.0f);
+  const double notes[] = {82.41, 110.0, 146.83, 196.0, 246.94, 329.63};
+  for (int pluck = 0; pluck < 14; ++pluck) {
+    const double hz = notes[static_cast<size_t>(pluck) % std::size(notes)];
+    const float level = 0.1f + 0.7f * static_cast<float>(pluck % 4) / 3.0f;
+    std::vector<float> delay(static_cast<size_t>(sampleRate / hz));
+    for (auto& sample : delay)
+      sample = level * noise(rng);
+
+    const auto offset = static_cast<size_t>(pluck * 0.5 * sampleRate);
+    for (size_t i = 0; offset + i < signal.size(); ++i) {
+      const size_t index = i % delay.size();
+      const float next = delay[(index + 1) % delay.size()];
+      signal[offset + i] += delay[index];
+      delay[index] = 0.498f * (delay[index] + next);
+    }
+  }
+  return signal;
+}
+
+// Resident set size in MB, or -1 where it can't be read
+double readResidentMegabytes() {
+#if defined(__linux__)
+  std::ifstream statm("/proc/self/statm");
+  long pages = 0;
+  long resident = 0;
+  if (statm >> pages >> resident)
+    return static_cast<double>(resident) * static_cast<double>(sysconf(_SC_PAGESIZE)) / 1048576.0;
+#endif
+  return -1.0;
+}
+
+struct RssSample {
+  double minutes;
+  double megabytes;
+};
+
+// Least-squares slope over the second half of the run, once allocations have settled
+double getRssGrowthPerHour(const std::vector<RssSample>& samples) {
+  if (samples.size() < 4)
+    return 0.0;
+  const auto first = samples.begin() + static_cast<std::ptrdiff_t>(samples.size() / 2);
+  const double n = static_cast<double>(samples.end() - first);
+  double sumX = 0.0, sumY = 0.0, sumXX = 0.0, sumXY = 0.0;
+  for (auto sample = first; sample != samples.end(); ++sample) {
+    sumX += sample->minutes;
+    sumY += sample->megabytes;
+    sumXX += sample->minutes * sample->minutes;
+    sumXY += sample->minutes * sample->megabytes;
+  }
+  const double denominator = n * sumXX - sumX * sumX;
+  return denominator > 0.0 ? 60.0 * (n * sumXY - sumX * sumY) / denominator : 0.0;
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+  const juce::ArgumentList args(argc, argv);
+  const int numInstances = args.containsOption("--instances")
+                               ? args.getValueForOption("--instances").getIntValue()
+                               : 2;
+  const double minutes = args.containsOption("--minutes")
+                             ? args.getValueForOption("--minutes").getDoubleValue()
+                             : 60.0;
+  const double changeSeconds = args.containsOption("--change-seconds")
+                                   ? args.getValueForOption("--change-seconds").getDoubleValue()
+                                   : 5.0;
+  const bool freeRun = args.containsOption("--free-run");
+  if (numInstances <= 0 || minutes <= 0.0 || changeSeconds <= 0.0) {
+    std::fprintf(stderr,
+                 "Usage: %s [--instances N] [--minutes M] [--di file.wav] [--models dir] "
+                 "[--irs dir] [--change-seconds S] [--free-run] [--trap] [--report file.json]\n",
+                 argv[0]);
+    return 1;
+  }
+  if (args.containsOption("--trap"))
+    RealtimeAudit::setMode(RealtimeAudit::Mode::trap);
+
+  const auto scratch = juce::File::getSpecialLocation(juce::File::tempDirectory)
+                           .getChildFile("neuralamp_soak");
+  scratch.createDirectory();
+  const auto models = args.containsOption("--models")
+                          ? findFiles(args.getValueForOption("--models"), "*.nam")
+                          : generateModels(scratch);
+  const auto irs = args.containsOption("--irs")
+                       ? findFiles(args.getValueForOption("--irs"), "*.wav")
+                       : generateIrs(scratch);
+  const auto di = args.containsOption("--di")
+                      ? loadDi(juce::File(args.getValueForOption("--di")))
+                      : synthesiseDi();
+  if (models.empty() || irs.empty() || di.empty()) {
+    std::fprintf(stderr, "No models, IRs or DI audio to play\n");
+    return 1;
+  }
+
+  std::signal(SIGINT, [](int) { stopRequested = true; });
+  std::signal(SIGTERM, [](int) { stopRequested = true; });
+
+  std::vector<std::unique_ptr<RigInstance>> instances;
+  for (int i = 0; i < numInstances; ++i) {
+    auto rig = std::make_unique<RigInstance>(i, di, freeRun);
+    rig->getProcessor().loadNamFile(models[static_cast<size_t>(i) % models.size()]
+                                        .getFullPathName());
+    rig->getProcessor().loadIrFile(irs[static_cast<size_t>(i) % irs.size()]);
+    instances.push_back(std::move(rig));
+  }
+
+  RealtimeAudit::reset();
+  bool realtimePriority = true;
+  for (auto& rig : instances) {
+    if (!rig->startRealtimeThread(juce::Thread::RealtimeOptions{}.withPriority(8))) {
+      realtimePriority = false;
+      rig->startThread(juce::Thread::Priority::highest);
+    }
+  }
+  if (!realtimePriority)
+    std::fprintf(stderr, "Warning: no realtime scheduling permission, using normal priority\n");
+
+  ControlThread control(instances, models, irs, changeSeconds);
+  control.startThread(juce::Thread::Priority::normal);
+
+  std::printf("Soaking %d instance(s) for %.1f min with %zu models and %zu IRs (kernels %s, "
+              "sub-block %d)\n",
+              numInstances, minutes, models.size(), irs.size(), getSimdKernels().name,
+              NEURALAMP_SUB_BLOCK_SIZE);
+
+  const auto start = Clock::now();
+  const auto end = start + std::chrono::duration_cast<Clock::duration>(
+                               std::chrono::duration<double, std::ratio<60>>(minutes));
+  std::vector<RssSample> rss;
+  int seconds = 0;
+  while (!stopRequested && Clock::now() < end) {
+    if (seconds % rssIntervalSeconds == 0) {
+      const double elapsed = std::chrono::duration<double, std::ratio<60>>(Clock::now() - start)
+                                 .count();
+      rss.push_back({elapsed, readResidentMegabytes()});
+    }
+    if (seconds > 0 && seconds % progressIntervalSeconds == 0) {
+      std::uint64_t xruns = 0;
+      for (const auto& rig : instances)
+        xruns += rig->xruns;
+      std::printf("  %5d s  xruns %llu  RSS %.1f MB\n", seconds,
+                  static_cast<unsigned long long>(xruns), rss.back().megabytes);
+      std::fflush(stdout);
+    }
+    std::this_thread::sleep_for(std::chrono::seconds(1));
+    ++seconds;
+  }
+
+  control.stopThread(10000);
+  for (auto& rig : instances)
+    rig->stopThread(2000);
+  const double elapsedMinutes = std::chrono::duration<double, std::ratio<60>>(Clock::now() - start)
+                                    .count();
+  rss.push_back({elapsedMinutes, readResidentMegabytes()});
+
+  std::printf("\n%-10s %12s %8s %9s %9s %10s %9s %11s %9s\n", "instance", "blocks", "xruns",
+              "p50 (us)", "p99 (us)", "p99.9 (us)", "max (us)", "non-finite", "denormal");
+  juce::Array<juce::var> instancesJson;
+  LatencyHistogram total;
+  std::uint64_t totalBlocks = 0, totalXruns = 0, totalNonFinite = 0, totalDenormal = 0;
+  for (size_t i = 0; i < instances.size(); ++i) {
+    const auto& rig = *instances[i];
+    const auto& histogram = rig.getHistogram();
+    std::printf("%-10zu %12llu %8llu %9.0f %9.0f %10.0f %9.0f %11llu %9llu\n", i,
+                static_cast<unsigned long long>(rig.blocks.load()),
+                static_cast<unsigned long long>(rig.xruns.load()), histogram.getPercentile(0.5),
+                histogram.getPercentile(0.99), histogram.getPercentile(0.999), histogram.getMax(),
+                static_cast<unsigned long long>(rig.nonFiniteSamples.load()),
+                static_cast<unsigned long long>(rig.denormalSamples.load()));
+
+    auto* instanceJson = new juce::DynamicObject();
+    instanceJson->setProperty("blocks", static_cast<juce::int64>(rig.blocks.load()));
+    instanceJson->setProperty("xruns", static_cast<juce::int64>(rig.xruns.load()));
+    instanceJson->setProperty("p50Us", histogram.getPercentile(0.5));
+    instanceJson->setProperty("p99Us", histogram.getPercentile(0.99));
+    instanceJson->setProperty("p999Us", histogram.getPercentile(0.999));
+    instanceJson->setProperty("maxUs", histogram.getMax());
+    instanceJson->setProperty("nonFiniteSamples",
+                              static_cast<juce::int64>(rig.nonFiniteSamples.load()));
+    instanceJson->setProperty("denormalSamples",
+                              static_cast<juce::int64>(rig.denormalSamples.load()));
+    instancesJson.add(juce::var(instanceJson));
+
+    total.merge(histogram);
+    totalBlocks += rig.blocks;
+    totalXruns += rig.xruns;
+    totalNonFinite += rig.nonFiniteSamples;
+    totalDenormal += rig.denormalSamples;
+  }
+  std::printf("%-10s %12llu %8llu %9.0f %9.0f %10.0f %9.0f %11llu %9llu\n", "all",
+              static_cast<unsigned long long>(totalBlocks),
+              static_cast<unsigned long long>(totalXruns), total.getPercentile(0.5),
+              total.getPercentile(0.99), total.getPercentile(0.999), total.getMax(),
+              static_cast<unsigned long long>(totalNonFinite),
+              static_cast<unsigned long long>(totalDenormal));
+
+  std::printf("\nChanges: %d models (slowest load %.0f ms), %d IRs, %d block sizes, "
+              "%d parameters\n",
+              control.modelChanges.load(), control.maxModelLoadMs.load(), control.irChanges.load(),
+              control.blockSizeChanges.load(), control.parameterChanges.load());
+
+  double peakRss = 0.0;
+  for (const auto& sample : rss)
+    peakRss = std::max(peakRss, sample.megabytes);
+  const double rssGrowth = getRssGrowthPerHour(rss);
+  std::printf("RSS: start %.1f MB, end %.1f MB, peak %.1f MB, growth %.2f MB/h\n",
+              rss.front().megabytes, rss.back().megabytes, peakRss, rssGrowth);
+
+  const auto audit = RealtimeAudit::getReport();
+  if (!RealtimeAudit::isSupported())
+    std::printf("Realtime audit: not available on this platform\n");
+  else
+    std::printf("%s", audit.toString().c_str());
+
+  if (args.containsOption("--report")) {
+    auto* report = new juce::DynamicObject();
+    report->setProperty("kernels", getSimdKernels().name);
+    report->setProperty("subBlockSize", NEURALAMP_SUB_BLOCK_SIZE);
+    report->setProperty("instances", numInstances);
+    report->setProperty("minutes", elapsedMinutes);
+    report->setProperty("freeRun", freeRun);
+    report->setProperty("realtimePriority", realtimePriority);
+    report->setProperty("perInstance", instancesJson);
+    report->setProperty("blocks", static_cast<juce::int64>(totalBlocks));
+    report->setProperty("xruns", static_cast<juce::int64>(totalXruns));
+    report->setProperty("p50Us", total.getPercentile(0.5));
+    report->setProperty("p99Us", total.getPercentile(0.99));
+    report->setProperty("p999Us", total.getPercentile(0.999));
+    report->setProperty("maxUs", total.getMax());
+    report->setProperty("nonFiniteSamples", static_cast<juce::int64>(totalNonFinite));
+    report->setProperty("denormalSamples", static_cast<juce::int64>(totalDenormal));
+    report->setProperty("modelChanges", control.modelChanges.load());
+    report->setProperty("maxModelLoadMs", control.maxModelLoadMs.load());
+    report->setProperty("irChanges", control.irChanges.load());
+    report->setProperty("blockSizeChanges", control.blockSizeChanges.load());
+    report->setProperty("parameterChanges", control.parameterChanges.load());
+    report->setProperty("rssStartMb", rss.front().megabytes);
+    report->setProperty("rssEndMb", rss.back().megabytes);
+    report->setProperty("rssPeakMb", peakRss);
+    report->setProperty("rssGrowthMbPerHour", rssGrowth);
+    report->setProperty("realtimeViolations", audit.getTotal());
+
+    juce::Array<juce::var> rssJson;
+    for (const auto& sample : rss)
+      rssJson.add(juce::Array<juce::var>{sample.minutes, sample.megabytes});
+    report->setProperty("rss", rssJson);
+
+    const juce::File file(args.getValueForOption("--report"));
+    if (!file.replaceWithText(juce::JSON::toString(juce::var(report))))
+      std::fprintf(stderr, "Couldn't write %s\n", file.getFullPathName().toRawUTF8());
+  }
+
+  instances.clear();
+  scratch.deleteRecursively();
+  return totalNonFinite > 0 || audit.getTotal() > 0 ? 1 : 0;
+}
@@ -1,8 +1,908 @@
-#include <plugin_processor.h>
+#include <processor.h>
 #include <gtest/gtest.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <complex>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <random>
+#include <json.hpp>
+#include "realtime_audit.h"
 
-namespace audio_plugin_test {
-TEST(AudioProcessor, Foo) {
-  audio_plugin::AudioPluginAudioProcessor processor{};
+#if JUCE_LINUX || JUCE_MAC
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <cstring>
+#endif
+
+namespace neuralamp_test {
+// Library folders, library index and capture folder for a processor under a fresh temporary
+// folder, so tests never scan or write the device's. Declare it before the processor it serves.
+struct TestLibrary {
+  TestLibrary() : directory(juce::File::createTempFile("neuralamp_library")) {
+    directory.createDirectory();
+  }
+  ~TestLibrary() { directory.deleteRecursively(); }
+
+  NeuralAmpProcessor::Locations getLocations() const {
+    return {directory.getChildFile("NAM"), directory.getChildFile("IR"),
+            directory.getChildFile("Captures"), directory.getChildFile("library-index.json"),
+            directory.getChildFile("Presets")};
+  }
+
+  juce::File directory;
+};
+
+// Renders reference signals through the whole chain (gate, model, DC blocker, IR, normaliser, EQ,
+// gains) and compares them with the outputs stored in NEURALAMP_GOLDEN_DIR. Models and IRs are
+// generated from fixed seeds with a portable generator, so the goldens don't depend on the
+// standard library. A missing golden fails the test; set NEURALAMP_UPDATE_GOLDEN to record them
+// all (after an intended change in sound, or for a new test) and commit the files it writes.
+class ProcessorGoldenTest : public testing::Test {
+protected:
+  static constexpr double sampleRate = 48000.0;
+  static constexpr int blockSize = 256;
+  // SIMD variants differ from each other by rounding only
+  static constexpr float tolerance = 1e-4f;
+
+  void SetUp() override {
+    directory = juce::File::getSpecialLocation(juce::File::tempDirectory)
+                    .getChildFile("neuralamp_golden_test");
+    directory.createDirectory();
+  }
+
+  void TearDown() override {
+    processor.reset();
+    directory.deleteRecursively();
+  }
+
+  // Uniform in [-scale, scale), identical on every platform
+  static std::vector<float> portableNoise(size_t size, std::uint32_t seed, float scale) {
+    std::mt19937 rng(seed);
+    std::vector<float> values(size);
+    for (auto& value : values)
+      value = scale * (2.0f * static_cast<float>(rng() >> 8) / 16777216.0f - 1.0f);
+    return values;
+  }
+
+  juce::File writeModel(const juce::String& name, const nlohmann::json& model) {
+    const auto file = directory.getChildFile(name + ".nam");
+    file.replaceWithText(model.dump());
+    return file;
+  }
+
+  static nlohmann::json makeLstm() {
+    constexpr int hiddenSize = 8;
+    const size_t count = static_cast<size_t>(4 * hiddenSize * (1 + hiddenSize) + 6 * hiddenSize +
+                                             hiddenSize + 1);
+    return {{"version", "0.5.4"},
+            {"architecture", "LSTM"},
+            {"config", {{"num_layers", 1}, {"input_size", 1}, {"hidden_size", hiddenSize}}},
+            {"weights", portableNoise(count, 11, 0.3f)},
+            {"sample_rate", 48000}};
+  }
+
+  // Every weight close to FLT_MAX, so the head overflows to infinity whatever the input
+  static nlohmann::json makeOverflowingLstm() {
+    auto model = makeLstm();
+    for (auto& weight : model["weights"])
+      weight = 3e38f;
+    return model;
+  }
+
+  static nlohmann::json makeWaveNet() {
+    const std::vector<int> dilations{1, 2, 4, 8, 16, 32};
+    nlohmann::json layers = nlohmann::json::array();
+    size_t count = 0;
+    int inputSize = 1;
+    for (const auto [channels, headSize] : {std::pair{6, 3}, std::pair{3, 1}}) {
+      layers.push_back({{"input_size", inputSize},
+                        {"condition_size", 1},
+                        {"head_size", headSize},
+                        {"channels", channels},
+                        {"kernel_size", 3},
+                        {"dilations", dilations},
+                        {"activation", "Tanh"},
+                        {"gated", false},
+                        {"head_bias", headSize == 1}});
+      count += static_cast<size_t>(channels * inputSize);
+      count += dilations.size() *
+               static_cast<size_t>(channels * channels * 3 + 2 * channels + channels * channels +
+                                   channels);
+      count += static_cast<size_t>(headSize * channels + (headSize == 1 ? headSize : 0));
+      inputSize = channels;
+    }
+    return {{"version", "0.5.4"},
+            {"architecture", "WaveNet"},
+            {"config", {{"layers", layers}, {"head", nullptr}, {"head_scale", 0.02}}},
+            {"weights", portableNoise(count + 1, 12, 0.3f)},
+            {"sample_rate", 48000}};
+  }
+
+  // Mono 32-bit float WAV of exponentially decaying noise
+  juce::File writeIr() {
+    constexpr int length = 4096;
+    auto samples = portableNoise(length, 13, 1.0f);
+    for (int i = 0; i < length; ++i)
+      samples[static_cast<size_t>(i)] *= std::exp(-6.0f * static_cast<float>(i) / length);
+
+    const auto file = directory.getChildFile("cabinet.wav");
+    juce::MemoryOutputStream wav;
+    const auto dataBytes = static_cast<std::uint32_t>(length * sizeof(float));
+    wav.write("RIFF", 4);
+    wav.writeInt(static_cast<int>(36 + dataBytes));
+    wav.write("WAVEfmt ", 8);
+    wav.writeInt(16);
+    wav.writeShort(3);  // IEEE float
+    wav.writeShort(1);
+    wav.writeInt(static_cast<int>(sampleRate));
+    wav.writeInt(static_cast<int>(sampleRate) * static_cast<int>(sizeof(float)));
+    wav.writeShort(4);  // Bytes per frame
+    wav.writeShort(32);
+    wav.write("data", 4);
+    wav.writeInt(static_cast<int>(dataBytes));
+    for (float sample : samples)
+      wav.writeFloat(sample);
+    file.replaceWithData(wav.getData(), wav.getDataSize());
+    return file;
+  }
+
+  static std::vector<float> sineSweep() {
+    constexpr double seconds = 2.0;
+    constexpr double startHz = 20.0;
+    constexpr double endHz = 20000.0;
+    const int length = static_cast<int>(seconds * sampleRate);
+    const double rate = std::log(endHz / startHz) / seconds;
+    std::vector<float> signal(static_cast<size_t>(length));
+    for (int i = 0; i < length; ++i) {
+      const double t = i / sampleRate;
+      const double phase = 2.0 * juce::MathConstants<double>::pi * startHz *
+                           (std::exp(rate * t) - 1.0) / rate;
+      signal[static_cast<size_t>(i)] = static_cast<float>(0.5 * std::sin(phase));
+    }
+    return signal;
+  }
+
+  static std::vector<float> impulse() {
+    std::vector<float> signal(static_cast<size_t>(sampleRate), 0.0f);
+    signal[0] = 1.0f;
+    return signal;
+  }
+
+  // Stand-in for a DI recording: Karplus-Strong plucks at a few pitches and levels
+  static std::vector<float> diSnippet() {
+    std::vector<float> signal(static_cast<size_t>(2.0 * sampleRate), 0.0f);
+    std::uint32_t seed = 21;
+    for (const auto [start, hz, level] : {std::tuple{0.0, 82.41, 0.6f},
+                                          std::tuple{0.5, 110.0, 0.3f},
+                                          std::tuple{1.0, 146.83, 0.8f},
+                                          std::tuple{1.5, 196.0, 0.15f}}) {
+      const auto period = static_cast<size_t>(sampleRate / hz);
+      auto delay = portableNoise(period, seed++, level);
+      const auto offset = static_cast<size_t>(start * sampleRate);
+      for (size_t i = 0; offset + i < signal.size(); ++i) {
+        const size_t index = i % period;
+        const float next = delay[(index + 1) % period];
+        signal[offset + i] += delay[index];
+        delay[index] = 0.498f * (delay[index] + next);
+      }
+    }
+    return signal;
+  }
+
+  void setParameter(const juce::String& id, float value) {
+    auto* parameter = processor->getParameters().getParameter(id);
+    parameter->setValueNotifyingHost(parameter->convertTo0to1(value));
+  }
+
+  void processSilence(int numSamples) {
+    juce::AudioBuffer<float> buffer(2, blockSize);
+    juce::MidiBuffer midi;
+    for (int done = 0; done < numSamples; done += blockSize) {
+      buffer.clear();
+      processor->processBlock(buffer, midi);
+    }
+  }
+
+  // Prepares a processor running the model and IR, settled on silence so that nothing loaded
+  // asynchronously is still fading in when the signal starts
+  void prepare(const juce::File& model, const juce::File& ir) {
+    processor = std::make_unique<NeuralAmpProcessor>(library.getLocations());
+    processor->setPlayConfigDetails(2, 2, sampleRate, blockSize);
+    processor->prepareToPlay(sampleRate, blockSize);
+
+    // The loader applies the (empty) parameter selections first; load only after it has
+    const auto deadline = juce::Time::getMillisecondCounter() + 5000;
+    while ((processor->getCurrentModelIndex() != 0 || processor->getCurrentIrIndex() != 0) &&
+           juce::Time::getMillisecondCounter() < deadline) {
+      juce::Thread::sleep(1);
+    }
+
+    processor->loadNamFile(model.getFullPathName());
+    ASSERT_TRUE(processor->isModelLoaded());
+    processor->loadIrFile(ir);
+    ASSERT_TRUE(processor->isIrLoaded());
+
+    while (!processor->isIrActive() && juce::Time::getMillisecondCounter() < deadline + 5000) {
+      processSilence(blockSize);
+      juce::Thread::sleep(1);
+    }
+    ASSERT_TRUE(processor->isIrActive());
+    processSilence(static_cast<int>(0.5 * sampleRate));
+  }
+
+  juce::AudioBuffer<float> render(const std::vector<float>& signal, int hostBlockSize) {
+    const int length = static_cast<int>(signal.size());
+    juce::AudioBuffer<float> output(2, length);
+    juce::AudioBuffer<float> buffer(2, hostBlockSize);
+    juce::MidiBuffer midi;
+    for (int start = 0; start < length; start += hostBlockSize) {
+      const int n = juce::jmin(hostBlockSize, length - start);
+      buffer.setSize(2, n, false, false, true);
+      for (int channel = 0; channel < 2; ++channel)
+        buffer.copyFrom(channel, 0, signal.data() + start, n);
+      processor->processBlock(buffer, midi);
+      for (int channel = 0; channel < 2; ++channel)
+        output.copyFrom(channel, start, buffer, channel, 0, n);
+    }
+    return output;
+  }
+
+  // Goldens are raw little-endian float32, channels one after the other
+  static void expectMatchesGolden(const juce::String& name,
+                                  const juce::AudioBuffer<float>& actual) {
+    const auto file = juce::File(NEURALAMP_GOLDEN_DIR).getChildFile(name + ".f32");
+    if (std::getenv("NEURALAMP_UPDATE_GOLDEN") != nullptr) {
+      file.getParentDirectory().createDirectory();
+      juce::FileOutputStream stream(file);
+      stream.setPosition(0);
+      stream.truncate();
+      for (int channel = 0; channel < actual.getNumChannels(); ++channel) {
+        for (int i = 0; i < actual.getNumSamples(); ++i)
+          stream.writeFloat(actual.getSample(channel, i));
+      }
+      GTEST_SKIP() << "Recorded golden output " << file.getFullPathName();
+    }
+    if (!file.existsAsFile()) {
+      FAIL() << "No golden output " << file.getFullPathName()
+             << "; run with NEURALAMP_UPDATE_GOLDEN=1 to record it";
+    }
+
+    juce::FileInputStream stream(file);
+    ASSERT_TRUE(stream.openedOk());
+    ASSERT_EQ(stream.getTotalLength(),
+              static_cast<juce::int64>(actual.getNumChannels()) * actual.getNumSamples() * 4)
+        << name << " changed length";
+
+    float maxError = 0.0f;
+    int firstFailure = -1;
+    for (int channel = 0; channel < actual.getNumChannels(); ++channel) {
+      for (int i = 0; i < actual.getNumSamples(); ++i) {
+        const float error = std::abs(actual.getSample(channel, i) - stream.readFloat());
+        if (error > tolerance && firstFailure < 0)
+          firstFailure = i;
+        maxError = juce::jmax(maxError, error);
+      }
+    }
+    EXPECT_LE(maxError, tolerance) << name << " first differs at sample " << firstFailure;
+  }
+
+  juce::ScopedJuceInitialiser_GUI juceInitialiser;
+  juce::File directory;
+  TestLibrary library;
+  std::unique_ptr<NeuralAmpProcessor> processor;
+};
+
+TEST_F(ProcessorGoldenTest, WaveNetSineSweep) {
+  ASSERT_NO_FATAL_FAILURE(prepare(writeModel("wavenet", makeWaveNet()), writeIr()));
+  expectMatchesGolden("wavenet_sweep", render(sineSweep(), blockSize));
+}
+
+TEST_F(ProcessorGoldenTest, WaveNetImpulse) {
+  ASSERT_NO_FATAL_FAILURE(prepare(writeModel("wavenet", makeWaveNet()), writeIr()));
+  expectMatchesGolden("wavenet_impulse", render(impulse(), blockSize));
+}
+
+TEST_F(ProcessorGoldenTest, WaveNetDiSnippet) {
+  ASSERT_NO_FATAL_FAILURE(prepare(writeModel("wavenet", makeWaveNet()), writeIr()));
+  expectMatchesGolden("wavenet_di", render(diSnippet(), blockSize));
+}
+
+TEST_F(ProcessorGoldenTest, LstmDiSnippet) {
+  ASSERT_NO_FATAL_FAILURE(prepare(writeModel("lstm", makeLstm()), writeIr()));
+  expectMatchesGolden("lstm_di", render(diSnippet(), blockSize));
+}
+
+// The sub-block scheduler must make the host block size inaudible
+TEST_F(ProcessorGoldenTest, HostBlockSizeDoesNotChangeOutput) {
+  ASSERT_NO_FATAL_FAILURE(prepare(writeModel("wavenet", makeWaveNet()), writeIr()));
+  const auto expected = render(diSnippet(), blockSize);
+  ASSERT_NO_FATAL_FAILURE(prepare(writeModel("wavenet", makeWaveNet()), writeIr()));
+  const auto actual = render(diSnippet(), 97);
+  for (int channel = 0; channel < 2; ++channel) {
+    for (int i = 0; i < expected.getNumSamples(); ++i)
+      ASSERT_NEAR(actual.getSample(channel, i), expected.getSample(channel, i), tolerance) << i;
+  }
+}
+
+TEST_F(ProcessorGoldenTest, ProcessBlockIsRealtimeSafe) {
+  ASSERT_NO_FATAL_FAILURE(prepare(writeModel("wavenet", makeWaveNet()), writeIr()));
+  const auto signal = diSnippet();
+  juce::AudioBuffer<float> buffer(2, blockSize);
+  juce::MidiBuffer midi;
+
+  RealtimeAudit::reset();
+  for (int start = 0; start + blockSize <= static_cast<int>(signal.size()); start += blockSize) {
+    // Parameter changes between blocks exercise the smoothing and coefficient updates too
+    if (start % (16 * blockSize) == 0) {
+      setParameter("toneBass", static_cast<float>((start / blockSize) % 10));
+      setParameter("outputLevel", -4.0f - static_cast<float>((start / blockSize) % 6));
+    }
+    for (int channel = 0; channel < 2; ++channel)
+      buffer.copyFrom(channel, 0, signal.data() + start, blockSize);
+
+    RealtimeAudit::ScopedSection realtimeSection;
+    processor->processBlock(buffer, midi);
+  }
+
+  if (!RealtimeAudit::isSupported())
+    GTEST_SKIP() << "Realtime audit hooks are only available on glibc";
+  const auto report = RealtimeAudit::getReport();
+  EXPECT_EQ(report.getTotal(), 0) << report.toString();
+}
+
+TEST_F(ProcessorGoldenTest, NonFiniteModelOutputIsContained) {
+  ASSERT_NO_FATAL_FAILURE(prepare(writeModel("overflowing", makeOverflowingLstm()), writeIr()));
+  const auto faulty = render(diSnippet(), blockSize);
+  for (int channel = 0; channel < 2; ++channel) {
+    for (int i = 0; i < faulty.getNumSamples(); ++i)
+      ASSERT_TRUE(std::isfinite(faulty.getSample(channel, i))) << i;
+  }
+  EXPECT_GT(processor->getNonFiniteRecoveries(), 0u);
+
+  // A model that faults every time it is reloaded is given up on and left muted
+  const auto deadline = juce::Time::getMillisecondCounter() + 10000;
+  while (!processor->isModelFaulted() && juce::Time::getMillisecondCounter() < deadline) {
+    processSilence(blockSize);
+    juce::Thread::sleep(1);
+  }
+  ASSERT_TRUE(processor->isModelFaulted());
+  const auto recoveries = processor->getNonFiniteRecoveries();
+  processSilence(static_cast<int>(0.2 * sampleRate));
+  juce::Thread::sleep(static_cast<int>(4 * NeuralAmpProcessor::modelResetBackoffMs));
+  processSilence(static_cast<int>(0.2 * sampleRate));
+  EXPECT_EQ(processor->getNonFiniteRecoveries(), recoveries);
+
+  // The filters and convolver weren't poisoned: a sane model is heard again once it fades in
+  processor->loadNamFile(writeModel("lstm", makeLstm()).getFullPathName());
+  EXPECT_FALSE(processor->isModelFaulted());
+  processSilence(static_cast<int>(0.2 * sampleRate));
+  const auto recovered = render(diSnippet(), blockSize);
+  EXPECT_GT(recovered.getMagnitude(0, recovered.getNumSamples()), 1e-4f);
+  for (int channel = 0; channel < 2; ++channel) {
+    for (int i = 0; i < recovered.getNumSamples(); ++i)
+      ASSERT_TRUE(std::isfinite(recovered.getSample(channel, i))) << i;
+  }
+}
+
+TEST(CaptureRecorderTest, RecordsDiAndOutputToWav) {
+  const auto folder = juce::File::getSpecialLocation(juce::File::tempDirectory)
+                          .getChildFile("neuralamp_capture_test");
+  folder.deleteRecursively();
+  constexpr int blockSize = 256;
+  constexpr int numBlocks = 40;
+
+  {
+    CaptureRecorder recorder(folder);
+    recorder.prepare(48000.0, 2);
+    recorder.setRecording(true, true, CaptureRecorder::Format::wav);
+    juce::AudioBuffer<float> buffer(2, blockSize);
+    for (int block = 0; block < numBlocks; ++block) {
+      for (int i = 0; i < blockSize; ++i) {
+        buffer.setSample(0, i, 0.5f * std::sin(0.01f * static_cast<float>(block * blockSize + i)));
+        buffer.setSample(1, i, -buffer.getSample(0, i));
+      }
+      recorder.pushInput(buffer);
+      buffer.applyGain(0.25f);  // Stands in for processing
+      recorder.pushOutput(buffer);
+    }
+    recorder.setRecording(false, true, CaptureRecorder::Format::wav);
+
+    const auto deadline = juce::Time::getMillisecondCounter() + 5000;
+    while (recorder.getStatus().seconds * 48000.0 < numBlocks * blockSize &&
+           juce::Time::getMillisecondCounter() < deadline) {
+      juce::Thread::sleep(5);
+    }
+    EXPECT_EQ(recorder.getStatus().droppedSamples, 0);
+  }
+
+  juce::AudioFormatManager formats;
+  formats.registerBasicFormats();
+  const auto files = folder.findChildFiles(juce::File::findFiles, false, "*.wav");
+  ASSERT_EQ(files.size(), 2);
+  for (const auto& file : files) {
+    std::unique_ptr<juce::AudioFormatReader> reader(formats.createReaderFor(file));
+    ASSERT_NE(reader, nullptr);
+    ASSERT_EQ(reader->lengthInSamples, numBlocks * blockSize);
+    ASSERT_EQ(reader->numChannels, 2u);
+
+    const float gain = file.getFileName().contains("_output") ? 0.25f : 1.0f;
+    juce::AudioBuffer<float> recorded(2, numBlocks * blockSize);
+    reader->read(&recorded, 0, recorded.getNumSamples(), 0, true, true);
+    for (int i = 0; i < recorded.getNumSamples(); ++i) {
+      const float expected = gain * 0.5f * std::sin(0.01f * static_cast<float>(i));
+      ASSERT_NEAR(recorded.getSample(0, i), expected, 1e-6f) << file.getFileName() << " " << i;
+      ASSERT_NEAR(recorded.getSample(1, i), -expected, 1e-6f) << file.getFileName() << " " << i;
+    }
+  }
+  folder.deleteRecursively();
+}
+
+// The blended, aligned pair must sound exactly like one IR holding the mix, for any chunking
+TEST(DualIrConvolverTest, BlendMatchesDirectConvolution) {
+  constexpr int lengthA = 700;
+  constexpr int lengthB = 450;
+  constexpr int alignment = 13;
+  constexpr float blend = 0.3f;
+  constexpr int maxBlockSize = 64;
+
+  std::mt19937 rng(7);
+  std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+  juce::AudioBuffer<float> irA(1, lengthA);
+  juce::AudioBuffer<float> irB(1, lengthB);
+  for (int i = 0; i < lengthA; ++i)
+    irA.setSample(0, i, unit(rng) * std::exp(-static_cast<float>(i) / 150.0f));
+  for (int i = 0; i < lengthB; ++i)
+    irB.setSample(0, i, unit(rng) * std::exp(-static_cast<float>(i) / 90.0f));
+
+  DualIrConvolver convolver;
+  convolver.prepare(48000.0, maxBlockSize, 2);
+  convolver.setBlend(blend);
+  convolver.setAlignment(alignment);
+  convolver.loadIr(DualIrConvolver::slotA, irA, 48000.0, false);
+  convolver.loadIr(DualIrConvolver::slotB, irB, 48000.0, false);
+  convolver.prepare(48000.0, maxBlockSize, 2);  // Starts on the pair without a crossfade
+
+  std::vector<float> mix(static_cast<size_t>(juce::jmax(lengthA, lengthB + alignment)), 0.0f);
+  for (int i = 0; i < lengthA; ++i)
+    mix[static_cast<size_t>(i)] += (1.0f - blend) * irA.getSample(0, i);
+  for (int i = 0; i < lengthB; ++i)
+    mix[static_cast<size_t>(i + alignment)] += blend * irB.getSample(0, i);
+
+  constexpr int length = 4000;
+  std::vector<float> input(length);
+  for (auto& sample : input)
+    sample = unit(rng);
+
+  juce::AudioBuffer<float> buffer(2, maxBlockSize);
+  const int chunkSizes[] = {64, 7, 33, 64, 1, 63, 20};
+  float maxError = 0.0f;
+  for (int start = 0, chunk = 0; start < length; ++chunk) {
+    const int n = juce::jmin(chunkSizes[chunk % 7], length - start);
+    for (int i = 0; i < n; ++i) {
+      buffer.setSample(0, i, input[static_cast<size_t>(start + i)]);
+      buffer.setSample(1, i, -input[static_cast<size_t>(start + i)]);
+    }
+    auto block = juce::dsp::AudioBlock<float>(buffer).getSubBlock(0, static_cast<size_t>(n));
+    convolver.process(block);
+
+    for (int i = 0; i < n; ++i) {
+      double expected = 0.0;
+      for (int j = 0; j < static_cast<int>(mix.size()) && j <= start + i; ++j)
+        expected += mix[static_cast<size_t>(j)] * input[static_cast<size_t>(start + i - j)];
+      const auto target = static_cast<float>(expected);
+      maxError = juce::jmax(maxError, std::abs(buffer.getSample(0, i) - target),
+                            std::abs(buffer.getSample(1, i) + target));
+    }
+    start += n;
+  }
+  EXPECT_LT(maxError, 1e-4f);
+}
+
+// Live monitoring: the cab plays from the first sample with the same magnitude response, and
+// the chain reports no latency
+TEST(DualIrConvolverTest, MinimumPhaseKeepsTheMagnitudeWithoutTheDelay) {
+  constexpr int delay = 40;  // Mic distance
+  constexpr int length = 1500;
+  std::mt19937 rng(11);
+  std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+  std::vector<float> ir(length, 0.0f);
+  for (int i = delay; i < length; ++i)
+    ir[static_cast<size_t>(i)] = 0.3f * unit(rng) * std::exp(-static_cast<float>(i - delay) / 200);
+
+  const auto minimumPhase = DualIrConvolver::makeMinimumPhase(ir, 2400);
+  ASSERT_FALSE(minimumPhase.empty());
+
+  double energy = 0.0;
+  double early = 0.0;
+  for (size_t i = 0; i < minimumPhase.size(); ++i) {
+    energy += minimumPhase[i] * minimumPhase[i];
+    early += i < static_cast<size_t>(delay) ? minimumPhase[i] * minimumPhase[i] : 0.0;
+  }
+  EXPECT_GT(early / energy, 0.5);
+
+  auto magnitude = [](const std::vector<float>& impulse, double frequency) {
+    const double step = -juce::MathConstants<double>::twoPi * frequency;
+    std::complex<double> sum;
+    for (size_t i = 0; i < impulse.size(); ++i)
+      sum += static_cast<double>(impulse[i]) * std::polar(1.0, step * static_cast<double>(i));
+    return std::abs(sum);
+  };
+  for (double frequency = 0.005; frequency < 0.5; frequency += 0.01) {
+    const double ratio = magnitude(minimumPhase, frequency) / magnitude(ir, frequency);
+    EXPECT_NEAR(juce::Decibels::gainToDecibels(ratio), 0.0, 0.5) << frequency;
+  }
+
+  TestLibrary library;
+  NeuralAmpProcessor processor(library.getLocations());
+  processor.getParameters().getParameter("liveMonitoring")->setValueNotifyingHost(1.0f);
+  processor.setPlayConfigDetails(2, 2, 48000.0, 64);
+  processor.prepareToPlay(48000.0, 64);
+  EXPECT_EQ(processor.getLatencySamples(), 0);
+}
+
+// Multiplies by a constant and counts the frames it was asked for
+class GainModel : public nam::DSP {
+public:
+  explicit GainModel(double gain) : nam::DSP(48000.0), gain(gain) {}
+
+  void process(NAM_SAMPLE* input, NAM_SAMPLE* output, const int num_frames) override {
+    for (int i = 0; i < num_frames; ++i)
+      output[i] = gain * input[i];
+    frames += num_frames;
+  }
+
+  double gain;
+  long frames = 0;
+};
+
+TEST(ModelBlenderTest, BlendsAndIdlesTheSilentModel) {
+  constexpr int blockSize = 64;
+  GainModel modelA(1.0);
+  GainModel modelB(2.0);
+  const ModelBlender::Models models{&modelA, &modelB};
+  const std::vector<float> input(blockSize, 0.5f);
+  std::vector<float> output(blockSize);
+
+  ModelBlender blender;
+  blender.prepare(48000.0, blockSize);
+  const auto run = [&](double seconds) {
+    for (int i = 0; i < static_cast<int>(seconds * 48000.0) / blockSize; ++i)
+      blender.process(input.data(), output.data(), blockSize, models);
+  };
+
+  // Fully on A: B is never evaluated
+  run(0.2);
+  EXPECT_EQ(modelB.frames, 0);
+  EXPECT_FLOAT_EQ(output.back(), 0.5f);
+
+  // Moving towards B wakes it unheard before the blend starts to move
+  blender.setBlend(0.5f);
+  run(ModelBlender::wakeSeconds / 2);
+  EXPECT_GT(modelB.frames, 0);
+  EXPECT_FLOAT_EQ(output.back(), 0.5f);
+  run(ModelBlender::wakeSeconds + ModelBlender::blendRampSeconds);
+  EXPECT_FLOAT_EQ(blender.getBlend(), 0.5f);
+  EXPECT_FLOAT_EQ(output.back(), 0.75f);
+
+  // Back on A, B stops costing anything once it has been silent for idleSeconds
+  blender.setBlend(0.0f);
+  run(ModelBlender::blendRampSeconds + ModelBlender::idleSeconds + 0.01);
+  EXPECT_FALSE(blender.isRunning(ModelBlender::slotB));
+  const long framesB = modelB.frames;
+  run(0.1);
+  EXPECT_EQ(modelB.frames, framesB);
+  EXPECT_FLOAT_EQ(output.back(), 0.5f);
+  EXPECT_TRUE(blender.isRunning(ModelBlender::slotA));
+}
+
+TEST(MemoryArenaTest, CountsSubsystemsAndEnforcesTheCap) {
+  MemoryArena arena(size_t{1} << 20, false);
+  using Floats = MemoryArena::Vector<float>;
+
+  Floats partitions(4096, 0.0f, {&arena, MemoryArena::convolution});
+  {
+    Floats scratch(1024, 0.0f, {&arena, MemoryArena::scratch});
+    EXPECT_EQ(arena.getUsage().bytes[MemoryArena::scratch], 4096u);
+  }
+  EXPECT_EQ(arena.getUsage().bytes[MemoryArena::scratch], 0u);
+  EXPECT_EQ(arena.getUsage().bytes[MemoryArena::convolution], 16384u);
+
+  // Freed space is reused rather than grown into
+  const auto committed = arena.getUsage().committedBytes;
+  Floats reused(512, 0.0f, {&arena, MemoryArena::scratch});
+  EXPECT_EQ(arena.getUsage().committedBytes, committed);
+
+  // Buffers owned elsewhere count against the same cap
+  const std::vector<float> weights(65536);
+  ASSERT_TRUE(arena.pin(&weights, [&](const MemoryArena::BufferVisitor& visit) {
+    MemoryArena::visitVector(visit, MemoryArena::modelWeights, weights);
+  }));
+  EXPECT_EQ(arena.getUsage().bytes[MemoryArena::modelWeights], 262144u);
+  EXPECT_THROW(Floats(200000, 0.0f, {&arena, MemoryArena::convolution}), std::bad_alloc);
+
+  arena.unpin(&weights);
+  EXPECT_EQ(arena.getUsage().bytes[MemoryArena::modelWeights], 0u);
+  EXPECT_NO_THROW(Floats(200000, 0.0f, {&arena, MemoryArena::convolution}));
+
+TEST(ThreadManagerTest, KeepsBackgroundThreadsOffTheAudioCores) {
+  using Role = ThreadManager::Role;
+
+  // Four cores with the last isolated for audio: every role shares the other three
+  const ThreadManager defaults({}, 4, ThreadManager::parseCoreList("3"));
+  for (const auto role : {Role::loader, Role::writer, Role::worker})
+    EXPECT_EQ(defaults.getPlacement(role).cores, ThreadManager::parseCoreList("0-2"));
+  EXPECT_FALSE(defaults.getPlacement(Role::loader).fifo);
+  EXPECT_EQ(defaults.getNumWorkers(), 2);
+
+  juce::var config;
+  ASSERT_TRUE(juce::JSON::parse(R"({"audioCores": "2-3", "workers": 1,
+                                    "loader": {"cores": "0,2", "policy": "fifo", "priority": 10},
+                                    "writer": {"cores": "3", "nice": 15}})",
+                                config)
+                  .wasOk());
+  const ThreadManager configured(config, 4, 0);
+  const auto& loader = configured.getPlacement(Role::loader);
+  EXPECT_EQ(loader.cores, ThreadManager::parseCoreList("0"));
+  EXPECT_TRUE(loader.fifo);
+  EXPECT_EQ(loader.priority, 10);
+  // Only an audio core asked for, so the writer falls back to the others
+  const auto& writer = configured.getPlacement(Role::writer);
+  EXPECT_EQ(writer.cores, ThreadManager::parseCoreList("0-1"));
+  EXPECT_EQ(writer.nice, 15);
+  EXPECT_EQ(configured.getNumWorkers(), 1);
+
+  EXPECT_EQ(ThreadManager::formatCoreList(ThreadManager::parseCoreList("5,0-2")), "0-2,5");
+}
+
+double toneStackResponseDb(const ToneStack::Coefficients& coefficients, double frequency) {
+  const auto z = std::polar(1.0, -2.0 * 3.14159265358979323846 * frequency / 48000.0);
+  std::complex<double> numerator = 0.0;
+  std::complex<double> denominator = 0.0;
+  std::complex<double> power = 1.0;
+  for (size_t i = 0; i <= ToneStack::order; ++i) {
+    numerator += coefficients.b[i] * power;
+    denominator += coefficients.a[i] * power;
+    power *= z;
+  }
+  return 20.0 * std::log10(std::abs(numerator / denominator));
+}
+
+TEST(ToneStackTest, InterpolatedTableMatchesTheCircuit) {
+  ToneStack toneStack;
+  toneStack.prepare(48000.0);
+  std::mt19937 rng(7);
+  std::uniform_real_distribution<float> knob(0.0f, ToneStack::maxKnob);
+
+  for (int index = 0; index < ToneStack::numModels; ++index) {
+    const auto model = static_cast<ToneStack::Model>(index);
+    toneStack.setModel(model);
+    for (int trial = 0; trial < 50; ++trial) {
+      const float bass = knob(rng);
+      const float mid = knob(rng);
+      const float treble = knob(rng);
+      toneStack.setControls(bass, mid, treble);
+      const auto exact = ToneStack::design(model, 48000.0, bass, mid, treble);
+      for (double frequency : {50.0, 200.0, 800.0, 3000.0, 10000.0}) {
+        EXPECT_NEAR(toneStackResponseDb(toneStack.getCoefficients(), frequency),
+                    toneStackResponseDb(exact, frequency), 0.1)
+            << ToneStack::getModelName(model) << " " << bass << "/" << mid << "/" << treble;
+      }
+    }
+
+    // The controls interact: the mid knob's scoop, and the bass and treble ends
+    const auto noon = ToneStack::design(model, 48000.0, 5.0f, 5.0f, 5.0f);
+    EXPECT_LT(toneStackResponseDb(ToneStack::design(model, 48000.0, 5.0f, 0.0f, 5.0f), 500.0),
+              toneStackResponseDb(noon, 500.0));
+    EXPECT_GT(toneStackResponseDb(ToneStack::design(model, 48000.0, 10.0f, 5.0f, 5.0f), 100.0),
+              toneStackResponseDb(noon, 100.0));
+    EXPECT_GT(toneStackResponseDb(ToneStack::design(model, 48000.0, 5.0f, 5.0f, 10.0f), 5000.0),
+              toneStackResponseDb(noon, 5000.0));
+  }
+
+  // Stable at the corners of the table
+  toneStack.setControls(0.0f, 0.0f, 0.0f);
+  std::vector<float> impulse(48000, 0.0f);
+  impulse[0] = 1.0f;
+  float* channels[1] = {impulse.data()};
+  toneStack.process(channels, 1, static_cast<int>(impulse.size()));
+  EXPECT_LT(std::abs(impulse.back()), 1e-6f);
+
+// Passes its input through after busy-waiting for a fixed share of the block's duration
+class BusyModel : public nam::DSP {
+public:
+  explicit BusyModel(double load) : nam::DSP(48000.0), load(load) {}
+
+  void process(NAM_SAMPLE* input, NAM_SAMPLE* output, const int num_frames) override {
+    const auto until = std::chrono::steady_clock::now() +
+                       std::chrono::duration<double>(load * num_frames / 48000.0);
+    while (std::chrono::steady_clock::now() < until) {
+    }
+    std::copy(input, input + num_frames, output);
+  }
+
+  double load;
+};
+
+TEST(ModelProfilerTest, FlagsModelsOverBudgetAndKeepsTheirProfiles) {
+  // Long blocks, so a scheduler hiccup can't make a light model's peak overrun one
+  constexpr int blockSize = 1024;
+  BusyModel light(0.1);
+  const auto lightProfile = ModelProfiler::measure(light, 48000.0, blockSize, 0.2);
+  EXPECT_FALSE(lightProfile.overBudget) << ModelProfiler::describe(lightProfile);
+  BusyModel heavy(0.8);
+  const auto heavyProfile = ModelProfiler::measure(heavy, 48000.0, blockSize, 0.2);
+  EXPECT_TRUE(heavyProfile.overBudget) << ModelProfiler::describe(heavyProfile);
+  EXPECT_GT(lightProfile.realTimeFactor, heavyProfile.realTimeFactor);
+
+  const auto directory = juce::File::getSpecialLocation(juce::File::tempDirectory)
+                             .getChildFile("neuralamp_profiler_test");
+  directory.createDirectory();
+  const auto model = directory.getChildFile("heavy.nam");
+  model.replaceWithText("{}");
+  const auto indexFile = directory.getChildFile("library-index.json");
+  {
+    LibraryIndex index(indexFile);
+    index.setCpuProfile(model, heavyProfile);
+    index.saveIfNeeded();
+  }
+
+  LibraryIndex index(indexFile);
+  index.load();
+  const auto stored = index.getCpuProfile(model);
+  ASSERT_TRUE(stored.has_value());
+  EXPECT_TRUE(stored->matches(48000.0, blockSize));
+  EXPECT_FALSE(stored->matches(44100.0, blockSize));
+  EXPECT_TRUE(stored->overBudget);
+  EXPECT_DOUBLE_EQ(stored->realTimeFactor, heavyProfile.realTimeFactor);
+
+  // Another engine will run the model, so its profile no longer applies
+  index.setInferenceMode(model, "int8");
+  EXPECT_FALSE(index.getCpuProfile(model).has_value());
+  directory.deleteRecursively();
+}
+
+// Large models are read from their head and tail only; keys either side of the weights count
+TEST(LibraryCatalogueTest, ReadsModelHeadersAroundTheWeights) {
+  const auto directory = juce::File::getSpecialLocation(juce::File::tempDirectory)
+                             .getChildFile("neuralamp_catalogue_test");
+  directory.deleteRecursively();
+  directory.createDirectory();
+
+  // In the order the trainer writes them, sample_rate after the weights
+  const std::vector<float> weights(100000, 0.125f);
+  const nlohmann::ordered_json large{{"version", "0.5.4"},
+                                     {"metadata", {{"name", "\"weights\": ["}}},
+                                     {"architecture", "WaveNet"},
+                                     {"config", {{"layers", nlohmann::json::array()}}},
+                                     {"weights", weights},
+                                     {"sample_rate", 44100}};
+  directory.getChildFile("large.nam").replaceWithText(large.dump());
+  const nlohmann::json small{{"architecture", "LSTM"}, {"weights", {0.5}}, {"sample_rate", 96000}};
+  directory.getChildFile("small.nam").replaceWithText(small.dump());
+
+  LibraryIndex index(directory.getChildFile("library-index.json"));
+  LibraryCatalogue catalogue(LibraryCatalogue::Kind::model, directory, index);
+  ASSERT_TRUE(catalogue.refresh());
+  const auto page = catalogue.query({});
+  ASSERT_EQ(page.total, 2);
+  EXPECT_EQ(page.items[0].id, "large.nam");
+  EXPECT_EQ(page.items[0].architecture, "WaveNet");
+  EXPECT_DOUBLE_EQ(page.items[0].sampleRate, 44100.0);
+  EXPECT_EQ(page.items[1].architecture, "LSTM");
+  EXPECT_DOUBLE_EQ(page.items[1].sampleRate, 96000.0);
+
+  // An interrupted refresh keeps the previous listing
+  directory.getChildFile("another.nam").replaceWithText(small.dump());
+  EXPECT_FALSE(catalogue.refresh([] { return true; }));
+  EXPECT_EQ(catalogue.query({}).total, 2);
+  directory.deleteRecursively();
+}
+
+// A request's parameters reach the audio thread together at the next block, and a bad entry
+// leaves all of them alone
+TEST(ControlServerTest, AppliesEachBatchAtOneBlockBoundary) {
+  TestLibrary library;
+  NeuralAmpProcessor processor(library.getLocations());
+  processor.setPlayConfigDetails(2, 2, 48000.0, 64);
+  processor.prepareToPlay(48000.0, 64);
+  auto& control = processor.getControlServer();
+  auto& parameters = processor.getParameters();
+  auto value = [&parameters](const char* id) {
+    return parameters.getRawParameterValue(id)->load();
+  };
+  auto request = [&control](const juce::String& line) {
+    return juce::JSON::parse(control.handleRequest(line));
+  };
+  juce::AudioBuffer<float> buffer(2, 64);
+  juce::MidiBuffer midi;
+  auto processBlock = [&] {
+    buffer.clear();
+    processor.processBlock(buffer, midi);
+  };
+
+  auto reply = request(R"({"command": "set", "id": 7, "parameters":
+                           {"inputLevel": -6, "toneStackModel": 2, "eqToggle": false}})");
+  EXPECT_TRUE(static_cast<bool>(reply["ok"])) << reply["error"].toString();
+  EXPECT_EQ(static_cast<int>(reply["id"]), 7);
+  EXPECT_FLOAT_EQ(value("inputLevel"), -14.0f);
+  processBlock();
+  EXPECT_FLOAT_EQ(value("inputLevel"), -6.0f);
+  EXPECT_FLOAT_EQ(value("toneStackModel"), 2.0f);
+  EXPECT_FLOAT_EQ(value("eqToggle"), 0.0f);
+
+  reply = request(R"({"command": "set", "parameters": {"toneBass": 8, "noSuchParameter": 1}})");
+  EXPECT_FALSE(static_cast<bool>(reply["ok"]));
+  processBlock();
+  EXPECT_FLOAT_EQ(value("toneBass"), 5.0f);
+
+  for (const auto* bad : {R"({"command": "load", "model": "/no/such.nam"})",
+                          R"({"command": "preset", "preset": {"irs": [1, 2, 3]}})",
+                          R"({"command": "reboot"})", "not json"})
+    EXPECT_FALSE(static_cast<bool>(request(bad)["ok"])) << bad;
+
+  // Preset files are read from the preset folder only
+  const auto presets = library.getLocations().presetFolder;
+  ASSERT_TRUE(presets.createDirectory());
+  const juce::String preset = R"({"parameters": {"toneMid": 7}})";
+  presets.getChildFile("Mid.json").replaceWithText(preset);
+  const auto outside = library.directory.getChildFile("Outside.json");
+  outside.replaceWithText(preset);
+  for (const auto& file : {juce::String("../Outside.json"), outside.getFullPathName()}) {
+    reply = request(R"({"command": "preset", "file": )" + juce::JSON::toString(file) + "}");
+    EXPECT_FALSE(static_cast<bool>(reply["ok"])) << file;
+  }
+  reply = request(R"({"command": "preset", "file": "Mid.json"})");
+  EXPECT_TRUE(static_cast<bool>(reply["ok"])) << reply["error"].toString();
+  processBlock();
+  EXPECT_FLOAT_EQ(value("toneMid"), 7.0f);
+
+  reply = request(R"({"command": "status"})");
+  ASSERT_TRUE(static_cast<bool>(reply["ok"]));
+  EXPECT_DOUBLE_EQ(static_cast<double>(reply["sampleRate"]), 48000.0);
+  EXPECT_FLOAT_EQ(static_cast<float>(reply["parameters"]["inputLevel"]), -6.0f);
+  EXPECT_TRUE(reply["meters"].hasProperty("outputPeakDb"));
+
+#if JUCE_LINUX || JUCE_MAC
+  // The same over the socket, one reply line per request line
+  control.start(juce::File::getSpecialLocation(juce::File::tempDirectory)
+                    .getChildFile("neuralamp_control_test.sock"));
+  const auto path = control.getSocketFile().getFullPathName().toStdString();
+  ASSERT_FALSE(path.empty());
+  sockaddr_un address{};
+  address.sun_family = AF_UNIX;
+  std::strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+  const int client = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  ASSERT_EQ(::connect(client, reinterpret_cast<const sockaddr*>(&address), sizeof(address)), 0);
+  const std::string lines = R"({"command": "set", "parameters": {"outputLevel": 3}})"
+                            "\n"
+                            R"({"command": "status", "id": "second"})"
+                            "\n";
+  ASSERT_EQ(::send(client, lines.data(), lines.size(), 0), static_cast<ssize_t>(lines.size()));
+
+  std::string received;
+  const auto deadline = juce::Time::getMillisecondCounter() + 5000;
+  while (std::count(received.begin(), received.end(), '\n') < 2 &&
+         juce::Time::getMillisecondCounter() < deadline) {
+    char chunk[4096];
+    const auto n = ::recv(client, chunk, sizeof(chunk), 0);
+    if (n <= 0)
+      break;
+    received.append(chunk, static_cast<size_t>(n));
+  }
+  ::close(client);
+  juce::StringArray replies;
+  replies.addLines(juce::String(received));
+  replies.removeEmptyStrings();
+  ASSERT_EQ(replies.size(), 2);
+  EXPECT_TRUE(static_cast<bool>(juce::JSON::parse(replies[0])["ok"]));
+  EXPECT_EQ(juce::JSON::parse(replies[1])["id"].toString(), "second");
+  processBlock();
+  EXPECT_FLOAT_EQ(value("outputLevel"), 3.0f);
+  control.stop();
+#endif
 }
-}  // namespace audio_plugin_test
+}  // namespace neuralamp_test
@@ -0,0 +1,400 @@
+#include <simd_engines.h>
+#include <simd_kernels.h>
+#include <specialised_engines.h>
+#include <gtest/gtest.h>
+#include <Eigen/Dense>
+#include <NAM/get_dsp.h>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <json.hpp>
+
+namespace neuralamp_test {
+using RowMajorMatrix = Eigen::Matrix<float, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>;
+using StridedMap = Eigen::Map<RowMajorMatrix, 0, Eigen::OuterStride<>>;
+
+std::vector<float> randomVector(size_t size, std::mt19937& rng, float scale = 1.0f) {
+  std::normal_distribution<float> distribution(0.0f, scale);
+  std::vector<float> values(size);
+  for (auto& value : values)
+    value = distribution(rng);
+  return values;
+}
+
+float sigmoid(float x) {
+  return 1.0f / (1.0f + std::exp(-x));
+}
+
+// Every variant the machine supports is checked against Eigen, so CI on an AVX-512 host covers
+// all x86 paths and an aarch64 host covers NEON
+class SimdKernelsTest : public testing::TestWithParam<const SimdKernels*> {};
+
+TEST_P(SimdKernelsTest, GemvMatchesEigen) {
+  const auto& kernels = *GetParam();
+  std::mt19937 rng(1);
+  for (const auto [rows, cols] : {std::pair{64, 17}, std::pair{80, 21}, std::pair{13, 5}}) {
+    const auto w = randomVector(static_cast<size_t>(rows * cols), rng);
+    const auto x = randomVector(static_cast<size_t>(cols), rng);
+    const auto bias = randomVector(static_cast<size_t>(rows), rng);
+    std::vector<float> y(static_cast<size_t>(rows));
+
+    kernels.gemv(w.data(), x.data(), bias.data(), y.data(), rows, cols);
+
+    const Eigen::Map<const Eigen::MatrixXf> matrix(w.data(), rows, cols);
+    const Eigen::VectorXf expected = matrix * Eigen::Map<const Eigen::VectorXf>(x.data(), cols) +
+                                     Eigen::Map<const Eigen::VectorXf>(bias.data(), rows);
+    for (int r = 0; r < rows; ++r)
+      EXPECT_NEAR(y[static_cast<size_t>(r)], expected(r), 1e-4f) << rows << "x" << cols;
+  }
+}
+
+TEST_P(SimdKernelsTest, MatmulAccumulateMatchesEigen) {
+  const auto& kernels = *GetParam();
+  std::mt19937 rng(2);
+  for (const auto [rows, cols, frames] : {std::tuple{16, 16, 128}, std::tuple{8, 16, 64},
+                                          std::tuple{3, 5, 37}, std::tuple{32, 1, 7}}) {
+    const int inStride = frames + 11;
+    const int outStride = frames + 5;
+    const auto w = randomVector(static_cast<size_t>(rows * cols), rng);
+    const auto in = randomVector(static_cast<size_t>(cols * inStride), rng);
+    auto out = randomVector(static_cast<size_t>(rows * outStride), rng);
+    const auto initial = out;
+
+    kernels.matmulAccumulate(w.data(), rows, cols, in.data(), inStride, out.data(), outStride,
+                             frames);
+
+    const Eigen::Map<const RowMajorMatrix> matrix(w.data(), rows, cols);
+    const StridedMap input(const_cast<float*>(in.data()), cols, frames,
+                           Eigen::OuterStride<>(inStride));
+    const StridedMap before(const_cast<float*>(initial.data()), rows, frames,
+                            Eigen::OuterStride<>(outStride));
+    const RowMajorMatrix expected = before + matrix * input;
+    for (int r = 0; r < rows; ++r) {
+      for (int f = 0; f < frames; ++f)
+        EXPECT_NEAR(out[static_cast<size_t>(r * outStride + f)], expected(r, f), 1e-4f);
+      // Padding past the last frame is left alone
+      for (int f = frames; f < outStride; ++f)
+        EXPECT_EQ(out[static_cast<size_t>(r * outStride + f)],
+                  initial[static_cast<size_t>(r * outStride + f)]);
+    }
+  }
+}
+
+TEST_P(SimdKernelsTest, LstmPointwiseMatchesReference) {
+  const auto& kernels = *GetParam();
+  std::mt19937 rng(3);
+  for (const int hiddenSize : {16, 20, 3}) {
+    const auto gates = randomVector(static_cast<size_t>(4 * hiddenSize), rng, 3.0f);
+    auto cell = randomVector(static_cast<size_t>(hiddenSize), rng);
+    const auto initialCell = cell;
+    std::vector<float> hidden(static_cast<size_t>(hiddenSize));
+
+    kernels.lstmPointwise(gates.data(), cell.data(), hidden.data(), hiddenSize);
+
+    for (size_t i = 0; i < static_cast<size_t>(hiddenSize); ++i) {
+      const auto h = static_cast<size_t>(hiddenSize);
+      const float c = sigmoid(gates[i + h]) * initialCell[i] +
+                      sigmoid(gates[i]) * std::tanh(gates[i + 2 * h]);
+      EXPECT_NEAR(cell[i], c, 1e-5f);
+      EXPECT_NEAR(hidden[i], sigmoid(gates[i + 3 * h]) * std::tanh(c), 1e-5f);
+    }
+  }
+}
+
+TEST_P(SimdKernelsTest, ActivationsMatchEigen) {
+  const auto& kernels = *GetParam();
+  std::mt19937 rng(4);
+  const auto input = randomVector(1003, rng, 4.0f);
+  const Eigen::Map<const Eigen::ArrayXf> x(input.data(), static_cast<Eigen::Index>(input.size()));
+  const Eigen::ArrayXf expectedTanh = x.tanh();
+  const Eigen::ArrayXf expectedSigmoid = 1.0f / (1.0f + (-x).exp());
+
+  auto tanhOut = input;
+  auto sigmoidOut = input;
+  kernels.tanh(tanhOut.data(), static_cast<int>(tanhOut.size()));
+  kernels.sigmoid(sigmoidOut.data(), static_cast<int>(sigmoidOut.size()));
+
+  for (size_t i = 0; i < input.size(); ++i) {
+    const auto index = static_cast<Eigen::Index>(i);
+    EXPECT_NEAR(tanhOut[i], expectedTanh(index), 1e-6f) << input[i];
+    EXPECT_NEAR(sigmoidOut[i], expectedSigmoid(index), 1e-6f) << input[i];
+  }
+}
+
+INSTANTIATE_TEST_SUITE_P(SupportedVariants,
+                         SimdKernelsTest,
+                         testing::ValuesIn(getSupportedKernels()),
+                         [](const auto& info) { return std::string(info.param->name); });
+
+// The engines must reproduce NAM's own models, which run on Eigen
+class SimdEnginesTest : public testing::Test {
+protected:
+  std::filesystem::path writeModel(const nlohmann::json& model) {
+    const auto path = std::filesystem::temp_directory_path() /
+                      ("neuralamp_" + std::to_string(files.size()) + ".nam");
+    std::ofstream(path) << model.dump();
+    files.push_back(path);
+    return path;
+  }
+
+  void TearDown() override {
+    for (const auto& file : files)
+      std::filesystem::remove(file);
+  }
+
+  static nlohmann::json makeLstm(int numLayers, int hiddenSize) {
+    std::mt19937 rng(5);
+    size_t count = 0;
+    for (int i = 0; i < numLayers; ++i) {
+      const int inputSize = i == 0 ? 1 : hiddenSize;
+      count += static_cast<size_t>(4 * hiddenSize * (inputSize + hiddenSize) + 6 * hiddenSize);
+    }
+    count += static_cast<size_t>(hiddenSize + 1);
+    return {{"version", "0.5.4"},
+            {"architecture", "LSTM"},
+            {"config", {{"num_layers", numLayers}, {"input_size", 1}, {"hidden_size", hiddenSize}}},
+            {"weights", randomVector(count, rng, 0.3f)},
+            {"sample_rate", 48000}};
+  }
+
+  struct ArrayConfig {
+    int channels;
+    int headSize;
+    std::vector<int> dilations;
+  };
+
+  static nlohmann::json makeWaveNet(bool gated) {
+    const std::vector<int> dilations{1, 2, 4, 8, 16};
+    return makeWaveNet({{6, 3, dilations}, {3, 1, dilations}}, gated);
+  }
+
+  static nlohmann::json makeWaveNet(const std::vector<ArrayConfig>& arrays, bool gated) {
+    nlohmann::json layers = nlohmann::json::array();
+    size_t count = 0;
+    int inputSize = 1;
+    for (const auto& [channels, headSize, dilations] : arrays) {
+      const int convRows = gated ? 2 * channels : channels;
+      layers.push_back({{"input_size", inputSize},
+                        {"condition_size", 1},
+                        {"head_size", headSize},
+                        {"channels", channels},
+                        {"kernel_size", 3},
+                        {"dilations", dilations},
+                        {"activation", "Tanh"},
+                        {"gated", gated},
+                        {"head_bias", headSize == 1}});
+      count += static_cast<size_t>(channels * inputSize);
+      count += dilations.size() * static_cast<size_t>(convRows * channels * 3 + 2 * convRows +
+                                                      channels * channels + channels);
+      count += static_cast<size_t>(headSize * channels + (headSize == 1 ? headSize : 0));
+      inputSize = channels;
+    }
+    std::mt19937 rng(6);
+    return {{"version", "0.5.4"},
+            {"architecture", "WaveNet"},
+            {"config", {{"layers", layers}, {"head", nullptr}, {"head_scale", 0.02}}},
+            {"weights", randomVector(count + 1, rng, 0.3f)},
+            {"sample_rate", 48000}};
+  }
+
+  // The trainer's "lite", "feather" and "nano" presets differ only in channel counts
+  static nlohmann::json makeLiteShapedWaveNet(int channels) {
+    return makeWaveNet({{channels, channels / 2, {1, 2, 4, 8, 16, 32, 64}},
+                        {channels / 2, 1, {128, 256, 512, 1, 2, 4, 8, 16, 32, 64, 128, 256, 512}}},
+                       false);
+  }
+
+  static void expectSameOutput(nam::DSP& reference, nam::DSP& candidate) {
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<double> distribution(-0.8, 0.8);
+    std::vector<NAM_SAMPLE> silence(4096, 0.0);
+    std::vector<NAM_SAMPLE> discard(silence.size());
+    std::vector<NAM_SAMPLE> input(100);
+    std::vector<NAM_SAMPLE> expected(input.size());
+    std::vector<NAM_SAMPLE> actual(input.size());
+
+    // NAM prewarms its models on Reset; bring the engine to the same settled state
+    reference.process(silence.data(), discard.data(), static_cast<int>(silence.size()));
+    candidate.process(silence.data(), discard.data(), static_cast<int>(silence.size()));
+    for (int block = 0; block < 40; ++block) {
+      for (auto& sample : input)
+        sample = distribution(rng);
+      reference.process(input.data(), expected.data(), static_cast<int>(input.size()));
+      candidate.process(input.data(), actual.data(), static_cast<int>(input.size()));
+      for (size_t i = 0; i < input.size(); ++i)
+        ASSERT_NEAR(actual[i], expected[i], 1e-4) << "block " << block << ", frame " << i;
+    }
+  }
+
+  std::vector<std::filesystem::path> files;
+};
+
+TEST_F(SimdEnginesTest, LstmMatchesNam) {
+  const auto path = writeModel(makeLstm(2, 12));
+  const auto weights = LstmWeights::fromNamFile(path);
+  ASSERT_TRUE(weights.has_value());
+  for (const auto* kernels : getSupportedKernels()) {
+    SCOPED_TRACE(kernels->name);
+    auto reference = nam::get_dsp(path);
+    reference->Reset(48000.0, 100);
+    LstmEngine engine(*weights, 48000.0, *kernels);
+    expectSameOutput(*reference, engine);
+  }
+}
+
+TEST_F(SimdEnginesTest, WaveNetMatchesNam) {
+  for (const bool gated : {false, true}) {
+    const auto path = writeModel(makeWaveNet(gated));
+    const auto weights = WaveNetWeights::fromNamFile(path);
+    ASSERT_TRUE(weights.has_value());
+    for (const auto* kernels : getSupportedKernels()) {
+      SCOPED_TRACE(std::string(kernels->name) + (gated ? " gated" : ""));
+      auto reference = nam::get_dsp(path);
+      reference->Reset(48000.0, 100);
+      WaveNetEngine engine(*weights, 48000.0, *kernels);
+      expectSameOutput(*reference, engine);
+    }
+  }
+}
+
+TEST_F(SimdEnginesTest, MakeSimdModelAcceptsCoveredArchitectures) {
+  const auto path = writeModel(makeWaveNet(false));
+  auto reference = nam::get_dsp(path);
+  reference->Reset(48000.0, 256);
+  double esr = 0.0;
+  EXPECT_NE(makeSimdModel(path, *reference, 1e-6, esr), nullptr);
+  EXPECT_LT(esr, 1e-6);
+
+  auto unsupported = makeWaveNet(false);
+  unsupported["config"]["layers"][0]["activation"] = "Fasttanh";
+  const auto unsupportedPath = writeModel(unsupported);
+  EXPECT_EQ(makeSimdModel(unsupportedPath, *reference, 1e-6, esr), nullptr);
+  EXPECT_TRUE(std::isnan(esr));
+}
+
+TEST_F(SimdEnginesTest, QuantisedWaveNetTracksTheFloatModel) {
+  for (const bool gated : {false, true}) {
+    SCOPED_TRACE(gated ? "gated" : "");
+    const auto path = writeModel(makeWaveNet(gated));
+    auto reference = nam::get_dsp(path);
+    reference->Reset(48000.0, 256);
+
+    double esr = 0.0;
+    auto int16 = makeQuantisedModel(path, WeightFormat::int16, *reference, 1e-3, esr);
+    EXPECT_NE(int16, nullptr);
+    EXPECT_LT(esr, 1e-5);
+
+    reference->Reset(48000.0, 256);
+    makeQuantisedModel(path, WeightFormat::int8, *reference, 1e-3, esr);
+    EXPECT_LT(esr, 1e-2);
+
+    // The ESR gate refuses a model that doesn't match closely enough
+    reference->Reset(48000.0, 256);
+    EXPECT_EQ(makeQuantisedModel(path, WeightFormat::int8, *reference, 1e-12, esr), nullptr);
+    EXPECT_TRUE(std::isfinite(esr));
+  }
+}
+
+TEST_F(SimdEnginesTest, SpecialisedWaveNetMatchesNam) {
+  const std::vector<int> dilations{1, 2, 4, 8, 16, 32, 64, 128, 256, 512};
+  const std::vector<std::pair<nlohmann::json, SpecialisedArchitecture>> presets{
+      {makeWaveNet({{16, 8, dilations}, {8, 1, dilations}}, false),
+       SpecialisedArchitecture::wavenetStandard},
+      {makeLiteShapedWaveNet(12), SpecialisedArchitecture::wavenetLite},
+      {makeLiteShapedWaveNet(8), SpecialisedArchitecture::wavenetFeather},
+      {makeLiteShapedWaveNet(4), SpecialisedArchitecture::wavenetNano}};
+
+  for (const auto& [model, architecture] : presets) {
+    SCOPED_TRACE(getArchitectureName(architecture));
+    const auto path = writeModel(model);
+    const auto weights = WaveNetWeights::fromNamFile(path);
+    ASSERT_TRUE(weights.has_value());
+    EXPECT_EQ(findSpecialisedArchitecture(*weights), architecture);
+
+    auto reference = nam::get_dsp(path);
+    reference->Reset(48000.0, 100);
+    auto engine = makeSpecialisedModel(*weights, 48000.0);
+    ASSERT_NE(engine, nullptr);
+    expectSameOutput(*reference, *engine);
+  }
+}
+
+// The config exactly as the trainer writes it for its "standard" preset
+TEST_F(SimdEnginesTest, TrainerStandardConfigTakesTheSpecialisedEngine) {
+  const std::vector<int> dilations{1, 2, 4, 8, 16, 32, 64, 128, 256, 512};
+  const nlohmann::json layers = nlohmann::json::array(
+      {{{"input_size", 1},
+        {"condition_size", 1},
+        {"channels", 16},
+        {"head_size", 8},
+        {"kernel_size", 3},
+        {"dilations", dilations},
+        {"activation", "Tanh"},
+        {"gated", false},
+        {"head_bias", false}},
+       {{"input_size", 16},
+        {"condition_size", 1},
+        {"channels", 8},
+        {"head_size", 1},
+        {"kernel_size", 3},
+        {"dilations", dilations},
+        {"activation", "Tanh"},
+        {"gated", false},
+        {"head_bias", true}}});
+  // Per array: rechannel, then per layer the dilated conv with bias, the condition mixer and the
+  // 1x1 with bias, then the head rechannel (with bias on the second array); then head_scale
+  const size_t layerCount = dilations.size();
+  const size_t count = 16 * 1 + layerCount * (16 * 16 * 3 + 16 + 16 + 16 * 16 + 16) + 8 * 16 +
+                       8 * 16 + layerCount * (8 * 8 * 3 + 8 + 8 + 8 * 8 + 8) + 1 * 8 + 1 + 1;
+  std::mt19937 rng(8);
+  const nlohmann::json model{
+      {"version", "0.5.4"},
+      {"architecture", "WaveNet"},
+      {"config", {{"layers", layers}, {"head", nullptr}, {"head_scale", 0.02}}},
+      {"weights", randomVector(count, rng, 0.3f)},
+      {"sample_rate", 48000}};
+
+  const auto path = writeModel(model);
+  const auto weights = WaveNetWeights::fromNamFile(path);
+  ASSERT_TRUE(weights.has_value());
+  ASSERT_EQ(findSpecialisedArchitecture(*weights), SpecialisedArchitecture::wavenetStandard);
+
+  auto reference = nam::get_dsp(path);
+  reference->Reset(48000.0, 100);
+  auto engine = makeSpecialisedModel(*weights, 48000.0);
+  ASSERT_NE(engine, nullptr);
+  expectSameOutput(*reference, *engine);
+}
+
+TEST_F(SimdEnginesTest, SpecialisedLstmMatchesNam) {
+  for (const auto [numLayers, hiddenSize] : {std::pair{1, 16}, std::pair{2, 8}}) {
+    const auto path = writeModel(makeLstm(numLayers, hiddenSize));
+    const auto weights = LstmWeights::fromNamFile(path);
+    ASSERT_TRUE(weights.has_value());
+    SCOPED_TRACE(getArchitectureName(findSpecialisedArchitecture(*weights)));
+
+    auto reference = nam::get_dsp(path);
+    reference->Reset(48000.0, 100);
+    auto engine = makeSpecialisedModel(*weights, 48000.0);
+    ASSERT_NE(engine, nullptr);
+    expectSameOutput(*reference, *engine);
+  }
+}
+
+TEST_F(SimdEnginesTest, OtherArchitecturesAreNotSpecialised) {
+  // Same shape as "nano" but gated, and an LSTM size no preset uses
+  auto gated = makeWaveNet({{4, 2, {1, 2, 4, 8, 16, 32, 64}},
+                            {2, 1, {128, 256, 512, 1, 2, 4, 8, 16, 32, 64, 128, 256, 512}}},
+                           true);
+  const auto wavenet = WaveNetWeights::fromNamFile(writeModel(gated));
+  ASSERT_TRUE(wavenet.has_value());
+  EXPECT_EQ(findSpecialisedArchitecture(*wavenet), SpecialisedArchitecture::none);
+  EXPECT_EQ(makeSpecialisedModel(*wavenet, 48000.0), nullptr);
+
+  const auto lstm = LstmWeights::fromNamFile(writeModel(makeLstm(2, 12)));
+  ASSERT_TRUE(lstm.has_value());
+  EXPECT_EQ(findSpecialisedArchitecture(*lstm), SpecialisedArchitecture::none);
+  EXPECT_EQ(makeSpecialisedModel(*lstm, 48000.0), nullptr);
+}
+}  // namespace neuralamp_test